@@ -2286,12 +2286,29 @@ reset_counters (GstCCConverter * self)
   gst_clear_buffer (&self->previous_buffer);
 }
 
+/* Every output packet fits in MAX_CDP_PACKET_LEN bytes, so output buffers
+ * come from a pool instead of being allocated for each frame. Buffers that
+ * were shrunk to their payload size are restored when they are released */
+static GstBuffer *
+gst_cc_converter_alloc_output (GstCCConverter * self)
+{
+  GstBuffer *outbuf = NULL;
+
+  if (self->out_pool &&
+      gst_buffer_pool_acquire_buffer (self->out_pool, &outbuf,
+          NULL) == GST_FLOW_OK)
+    return outbuf;
+
+  return gst_buffer_new_allocate (NULL, MAX_CDP_PACKET_LEN, NULL);
+}
+
 static GstFlowReturn
 drain_input (GstCCConverter * self)
 {
   GstBaseTransformClass *bclass = GST_BASE_TRANSFORM_GET_CLASS (self);
   GstBaseTransform *trans = GST_BASE_TRANSFORM (self);
   GstFlowReturn ret = GST_FLOW_OK;
+  GstBufferList *list = NULL;
 
   while (self->scratch_ccp_len > 0 || self->scratch_cea608_1_len > 0
       || self->scratch_cea608_2_len > 0 || can_generate_output (self)) {
@@ -2300,10 +2317,10 @@ drain_input (GstCCConverter * self)
     if (!self->previous_buffer) {
       GST_WARNING_OBJECT (self, "Attempt to draining without a previous "
           "buffer.  Aborting");
-      return GST_FLOW_OK;
+      break;
     }
 
-    outbuf = gst_buffer_new_allocate (NULL, MAX_CDP_PACKET_LEN, NULL);
+    outbuf = gst_cc_converter_alloc_output (self);
 
     if (bclass->copy_metadata) {
       if (!bclass->copy_metadata (trans, self->previous_buffer, outbuf)) {
@@ -2321,13 +2338,22 @@ drain_input (GstCCConverter * self)
       continue;
     } else if (ret != GST_FLOW_OK) {
       gst_buffer_unref (outbuf);
-      return ret;
+      break;
     }
 
-    ret = gst_pad_push (GST_BASE_TRANSFORM_SRC_PAD (trans), outbuf);
-    if (ret != GST_FLOW_OK) {
-      return ret;
-    }
+    /* Draining can produce many packets at once (e.g. at EOS when the
+     * framerate was reduced), push them downstream in one go */
+    if (!list)
+      list = gst_buffer_list_new ();
+    gst_buffer_list_add (list, outbuf);
+  }
+
+  if (list) {
+    GstFlowReturn push_ret;
+
+    push_ret = gst_pad_push_list (GST_BASE_TRANSFORM_SRC_PAD (trans), list);
+    if (ret == GST_FLOW_OK)
+      ret = push_ret;
   }
 
   return ret;
@@ -2358,7 +2384,7 @@ gst_cc_converter_generate_output (GstBaseTransform * base, GstBuffer ** outbuf)
         return ret;
     }
 
-    *outbuf = gst_buffer_new_allocate (NULL, MAX_CDP_PACKET_LEN, NULL);
+    *outbuf = gst_cc_converter_alloc_output (self);
     if (*outbuf == NULL)
       goto no_buffer;
 
@@ -2432,6 +2458,19 @@ gst_cc_converter_start (GstBaseTransform * base)
   self->scratch_cea608_1_len = 0;
   self->scratch_cea608_2_len = 0;
 
+  if (!self->out_pool) {
+    GstStructure *config;
+
+    self->out_pool = gst_buffer_pool_new ();
+    config = gst_buffer_pool_get_config (self->out_pool);
+    gst_buffer_pool_config_set_params (config, NULL, MAX_CDP_PACKET_LEN, 0, 0);
+    if (!gst_buffer_pool_set_config (self->out_pool, config) ||
+        !gst_buffer_pool_set_active (self->out_pool, TRUE)) {
+      GST_WARNING_OBJECT (self, "Failed to set up output buffer pool");
+      gst_clear_object (&self->out_pool);
+    }
+  }
+
   return TRUE;
 }
 
@@ -2443,6 +2482,11 @@ gst_cc_converter_stop (GstBaseTransform * base)
   gst_video_time_code_clear (&self->current_output_timecode);
   gst_clear_buffer (&self->previous_buffer);
 
+  if (self->out_pool) {
+    gst_buffer_pool_set_active (self->out_pool, FALSE);
+    gst_clear_object (&self->out_pool);
+  }
+
   return TRUE;
 }
 
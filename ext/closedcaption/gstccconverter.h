@@ -71,6 +71,9 @@ struct _GstCCConverter
   GstVideoTimeCode current_output_timecode;
   /* previous buffer for copying metas onto */
   GstBuffer *previous_buffer;
+
+  /* recycles the fixed size output buffers */
+  GstBufferPool *out_pool;
 };
 
 struct _GstCCConverterClass
@@ -37,6 +37,18 @@
 GST_DEBUG_CATEGORY_STATIC (gst_line_21_decoder_debug);
 #define GST_CAT_DEFAULT gst_line_21_decoder_debug
 
+/* The CEA-608 clock run-in is 7 cycles of a ~0.5 MHz sine wave, about 27
+ * pixels per cycle at 13.5 MHz, close to the start of the line. These are
+ * deliberately loose so that only lines that clearly can't carry CC (flat
+ * blanking lines, picture content) are rejected before the zvbi slicer */
+#define RUN_IN_WINDOW 320
+#define RUN_IN_MIN_AMPLITUDE 32
+#define RUN_IN_MIN_TRANSITIONS 8
+
+/* How many frames to keep the current line 21 offset if it still looks
+ * like a CC line but failed to decode */
+#define MAX_LOCK_MISSES 1
+
 #define CAPS "video/x-raw, format={ I420, YUY2, YVYU, UYVY, VYUY, v210 }, interlace-mode=interleaved"
 
 static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
@@ -147,6 +159,25 @@ gst_line_21_decoder_set_info (GstVideoFilter * filter,
       &self->convert_v210);
 
   GST_DEBUG_OBJECT (filter, "caps %" GST_PTR_FORMAT, incaps);
+
+  switch (GST_VIDEO_INFO_FORMAT (in_info)) {
+    case GST_VIDEO_FORMAT_YUY2:
+    case GST_VIDEO_FORMAT_YVYU:
+      self->luma_offset = 0;
+      self->luma_pstride = 2;
+      break;
+    case GST_VIDEO_FORMAT_UYVY:
+    case GST_VIDEO_FORMAT_VYUY:
+      self->luma_offset = 1;
+      self->luma_pstride = 2;
+      break;
+    default:
+      /* I420, and v210 which is converted to I420 luma */
+      self->luma_offset = 0;
+      self->luma_pstride = 1;
+      break;
+  }
+
   GST_DEBUG_OBJECT (filter, "plane_stride:%u , comp_stride:%u , pstride:%u",
       GST_VIDEO_INFO_PLANE_STRIDE (in_info, 0),
       GST_VIDEO_INFO_COMP_STRIDE (in_info, 0),
@@ -164,6 +195,7 @@ gst_line_21_decoder_set_info (GstVideoFilter * filter,
 
   /* Scan the next frame from the first line */
   self->line21_offset = -1;
+  self->lock_misses = 0;
 
   if (GST_VIDEO_INFO_WIDTH (in_info) != 720) {
     GST_DEBUG_OBJECT (filter, "Only 720 pixel wide formats are supported");
@@ -293,44 +325,123 @@ convert_line_v210_luma (const guint8 * orig, guint8 * dest, guint width)
   guint32 a, b, c, d;
   guint8 *y = dest;
 
-  for (i = 0; i < width - 5; i += 6) {
-    a = GST_READ_UINT32_LE (orig + (i / 6) * 16 + 0);
-    b = GST_READ_UINT32_LE (orig + (i / 6) * 16 + 4);
-    c = GST_READ_UINT32_LE (orig + (i / 6) * 16 + 8);
-    d = GST_READ_UINT32_LE (orig + (i / 6) * 16 + 12);
-
-    *y++ = (a >> 12) & 0xff;
-    *y++ = (b >> 2) & 0xff;
-
-    *y++ = (b >> 22) & 0xff;
-    *y++ = (c >> 12) & 0xff;
-
-    *y++ = (d >> 2) & 0xff;
-    *y++ = (d >> 22) & 0xff;
+  /* Each 16 byte block holds 6 pixels, only the upper 8 bits of the 10 bit
+   * luma samples are kept */
+  for (i = 0; i + 6 <= width; i += 6) {
+    a = GST_READ_UINT32_LE (orig + 0);
+    b = GST_READ_UINT32_LE (orig + 4);
+    c = GST_READ_UINT32_LE (orig + 8);
+    d = GST_READ_UINT32_LE (orig + 12);
+
+    y[0] = a >> 12;
+    y[1] = b >> 2;
+    y[2] = b >> 22;
+    y[3] = c >> 12;
+    y[4] = d >> 2;
+    y[5] = d >> 22;
+
+    orig += 16;
+    y += 6;
   }
 }
 
+/* Returns the data for @line, which will be fed to zvbi as field @field.
+ * v210 lines are converted into the I420 scratch lines first */
 static guint8 *
-get_video_data (GstLine21Decoder * self, GstVideoFrame * frame, gint line)
+get_line_data (GstLine21Decoder * self, GstVideoFrame * frame, gint line,
+    guint field)
 {
-  guint8 *data = self->converted_lines;
+  guint8 *data;
   guint8 *v210;
 
   if (!self->convert_v210)
     return (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (frame,
         0) + line * GST_VIDEO_INFO_COMP_STRIDE (self->info, 0);
 
+  data = self->converted_lines +
+      field * GST_VIDEO_INFO_COMP_STRIDE (self->info, 0);
+
   v210 = (guint8 *)
       GST_VIDEO_FRAME_PLANE_DATA (frame,
       0) + line * GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
 
   /* Convert v210 to I420 */
   convert_line_v210_luma (v210, data, GST_VIDEO_FRAME_WIDTH (frame));
-  v210 += GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
-  convert_line_v210_luma (v210, data + GST_VIDEO_INFO_COMP_STRIDE (self->info,
-          0), GST_VIDEO_FRAME_WIDTH (frame));
-  GST_MEMDUMP ("converted", self->converted_lines, 64);
-  return self->converted_lines;
+  return data;
+}
+
+/* Cheap pre-check whether a line could contain a CC clock run-in: the
+ * luma has to swing far enough and cross its mid level several times
+ * near the start of the line */
+static gboolean
+line_has_clock_run_in (GstLine21Decoder * self, const guint8 * data)
+{
+  const guint8 *luma = data + self->luma_offset;
+  const guint pstride = self->luma_pstride;
+  guint8 min = 255, max = 0, lo, hi;
+  guint x, transitions = 0;
+  gint state = 0;
+
+  for (x = 0; x < RUN_IN_WINDOW; x += 2) {
+    guint8 y = luma[x * pstride];
+
+    min = MIN (min, y);
+    max = MAX (max, y);
+  }
+
+  if (max - min < RUN_IN_MIN_AMPLITUDE)
+    return FALSE;
+
+  /* Count swings between the lower and upper quarter of the range */
+  lo = min + (max - min) / 4;
+  hi = max - (max - min) / 4;
+  for (x = 0; x < RUN_IN_WINDOW; x += 2) {
+    guint8 y = luma[x * pstride];
+
+    if (y >= hi && state <= 0) {
+      if (state < 0)
+        transitions++;
+      state = 1;
+    } else if (y <= lo && state >= 0) {
+      if (state > 0)
+        transitions++;
+      state = -1;
+    }
+  }
+
+  return transitions >= RUN_IN_MIN_TRANSITIONS;
+}
+
+typedef enum
+{
+  PROBE_NO_RUN_IN,
+  PROBE_NO_CC,
+  PROBE_FOUND,
+} ProbeResult;
+
+/* Try to decode CC from the line pair starting at @line */
+static ProbeResult
+gst_line_21_decoder_probe (GstLine21Decoder * self, GstVideoFrame * frame,
+    gint line, vbi_sliced * sliced)
+{
+  guint8 *data;
+  gint n_lines;
+
+  /* Both fields need to carry CC, so only look at the second line if the
+   * first one looks promising */
+  data = get_line_data (self, frame, line, 0);
+  if (!line_has_clock_run_in (self, data))
+    return PROBE_NO_RUN_IN;
+
+  if (!line_has_clock_run_in (self, get_line_data (self, frame, line + 1, 1)))
+    return PROBE_NO_RUN_IN;
+
+  GST_MEMDUMP ("line data", data, 64);
+
+  n_lines = vbi_raw_decode (&self->zvbi_decoder, data, sliced);
+  GST_DEBUG_OBJECT (self, "i:%d n_lines:%d", line, n_lines);
+
+  return n_lines == 2 ? PROBE_FOUND : PROBE_NO_CC;
 }
 
 /* Call this to scan for CC
@@ -341,39 +452,51 @@ gst_line_21_decoder_scan (GstLine21Decoder * self, GstVideoFrame * frame)
   gint i;
   vbi_sliced sliced[52];
   gboolean found = FALSE;
-  guint8 *data;
 
   GST_DEBUG_OBJECT (self, "Starting probing. max_line_probes:%d",
       self->max_line_probes);
 
   i = self->line21_offset;
-  if (i == -1) {
-    GST_DEBUG_OBJECT (self, "Scanning from the beginning");
-    i = 0;
+  if (i != -1 && i + 1 < GST_VIDEO_FRAME_HEIGHT (frame)) {
+    switch (gst_line_21_decoder_probe (self, frame, i, sliced)) {
+      case PROBE_FOUND:
+        found = TRUE;
+        self->lock_misses = 0;
+        break;
+      case PROBE_NO_CC:
+        /* The line still looks like CC, this is most likely a glitch in
+         * this frame. Don't rescan the whole VBI for it */
+        if (self->lock_misses < MAX_LOCK_MISSES) {
+          GST_DEBUG_OBJECT (self, "Failed decoding CC at offset %d, keeping "
+              "it", i);
+          self->lock_misses++;
+          return FALSE;
+        }
+        break;
+      case PROBE_NO_RUN_IN:
+        break;
+    }
   }
 
-  for (; i < self->max_line_probes && i < GST_VIDEO_FRAME_HEIGHT (frame); i++) {
-    gint n_lines;
-    data = get_video_data (self, frame, i);
-    /* Scan until we get n_lines == 2 */
-    n_lines = vbi_raw_decode (&self->zvbi_decoder, data, sliced);
-    GST_DEBUG_OBJECT (self, "i:%d n_lines:%d", i, n_lines);
-    if (n_lines == 2) {
-      GST_DEBUG_OBJECT (self, "Found 2 CC lines at offset %d", i);
-      self->line21_offset = i;
-      found = TRUE;
-      break;
-    } else if (i == self->line21_offset) {
-      /* Otherwise if this was the previously probed line offset,
-       * reset and start searching again from the beginning */
-      i = -1;
-      self->line21_offset = -1;
+  if (!found) {
+    GST_DEBUG_OBJECT (self, "Scanning from the beginning");
+    self->line21_offset = -1;
+    self->lock_misses = 0;
+
+    for (i = 0; i < self->max_line_probes
+        && i + 1 < GST_VIDEO_FRAME_HEIGHT (frame); i++) {
+      /* Scan until we get n_lines == 2 */
+      if (gst_line_21_decoder_probe (self, frame, i, sliced) == PROBE_FOUND) {
+        GST_DEBUG_OBJECT (self, "Found 2 CC lines at offset %d", i);
+        self->line21_offset = i;
+        found = TRUE;
+        break;
+      }
     }
   }
 
   if (!found) {
     GST_DEBUG_OBJECT (self, "No CC found");
-    self->line21_offset = -1;
   } else {
     guint base_line1 = 0, base_line2 = 0;
     guint8 ccdata[6] = { 0x80, 0x80, 0x80, 0x00, 0x80, 0x80 };  /* Initialize the ccdata */
@@ -54,6 +54,15 @@ struct _GstLine21Decoder
   /* Maximum number of lines to probe when looking for CC */
   gint max_line_probes;
 
+  /* Number of consecutive frames in which line21_offset still carried a
+   * clock run-in but no CC could be decoded */
+  guint lock_misses;
+
+  /* Location of the luma samples in a line, used to quickly check
+   * lines for a CC clock run-in */
+  guint luma_offset;
+  guint luma_pstride;
+
   /* Whether input data is v210 and needs to be converted before
    * processing */
   gboolean convert_v210;
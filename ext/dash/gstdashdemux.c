@@ -409,6 +409,8 @@ gst_dash_demux_stream_fragment_finished (GstAdaptiveDemux * demux,
     GstAdaptiveDemuxStream * stream);
 static gboolean gst_dash_demux_need_another_chunk (GstAdaptiveDemuxStream *
     stream);
+static GstFlowReturn gst_dash_demux_parse_isobmff (GstAdaptiveDemux * demux,
+    GstDashDemuxStream * dash_stream, gboolean * sidx_seek_needed);
 
 /* GstDashDemux */
 static gboolean gst_dash_demux_setup_all_streams (GstDashDemux * demux);
@@ -1057,6 +1059,9 @@ gst_dash_demux_process_manifest (GstAdaptiveDemux * demux, GstBuffer * buf)
   if (ret)
     ret = gst_dash_demux_setup_streams (demux);
 
+  if (ret)
+    gst_buffer_replace (&dashdemux->last_manifest, buf);
+
   return ret;
 }
 
@@ -1114,6 +1119,7 @@ gst_dash_demux_reset (GstAdaptiveDemux * ademux)
     gst_mpd_client_free (demux->client);
     demux->client = NULL;
   }
+  gst_buffer_replace (&demux->last_manifest, NULL);
   gst_dash_demux_clock_drift_free (demux->clock_drift);
   demux->clock_drift = NULL;
   demux->client = gst_mpd_client_new ();
@@ -2391,6 +2397,39 @@ gst_dash_demux_get_manifest_update_interval (GstAdaptiveDemux * demux)
       SLOW_CLOCK_UPDATE_INTERVAL);
 }
 
+/* Live MPDs are refetched every few seconds, and those only using
+ * SegmentTemplate@duration often come back byte for byte identical. The
+ * current client is still up to date then and parsing can be skipped,
+ * unless it pulls in content through xlink, which can change on its own */
+static gboolean
+gst_dash_demux_manifest_unchanged (GstDashDemux * dashdemux,
+    GstBuffer * buffer)
+{
+  GstAdaptiveDemux *demux = GST_ADAPTIVE_DEMUX_CAST (dashdemux);
+  GstMapInfo mapinfo;
+  gboolean unchanged;
+
+  if (dashdemux->last_manifest == NULL ||
+      gst_buffer_get_size (dashdemux->last_manifest) !=
+      gst_buffer_get_size (buffer))
+    return FALSE;
+
+  if (dashdemux->client->has_external_resources)
+    return FALSE;
+
+  /* relative URLs would resolve differently after a redirect */
+  if (g_strcmp0 (dashdemux->client->mpd_base_uri,
+          demux->manifest_base_uri) != 0)
+    return FALSE;
+
+  if (!gst_buffer_map (dashdemux->last_manifest, &mapinfo, GST_MAP_READ))
+    return FALSE;
+  unchanged = gst_buffer_memcmp (buffer, 0, mapinfo.data, mapinfo.size) == 0;
+  gst_buffer_unmap (dashdemux->last_manifest, &mapinfo);
+
+  return unchanged;
+}
+
 static GstFlowReturn
 gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
     GstBuffer * buffer)
@@ -2399,6 +2438,14 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
   GstMPDClient *new_client = NULL;
   GstMapInfo mapinfo;
 
+  if (gst_dash_demux_manifest_unchanged (dashdemux, buffer)) {
+    GST_DEBUG_OBJECT (demux, "Manifest unchanged, keeping current one");
+    if (dashdemux->clock_drift) {
+      gst_dash_demux_poll_clock_drift (dashdemux);
+    }
+    return GST_FLOW_OK;
+  }
+
   GST_DEBUG_OBJECT (demux, "Updating manifest file from URL");
 
   /* parse the manifest file */
@@ -2510,6 +2557,7 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
 
     gst_mpd_client_free (dashdemux->client);
     dashdemux->client = new_client;
+    gst_buffer_replace (&dashdemux->last_manifest, buffer);
 
     GST_DEBUG_OBJECT (demux, "Manifest file successfully updated");
     if (dashdemux->clock_drift) {
@@ -2795,6 +2843,120 @@ gst_dash_demux_need_another_chunk (GstAdaptiveDemuxStream * stream)
   return stream->fragment.chunk_size != 0;
 }
 
+/* Called once the sidx of @dash_stream has been completely parsed. Returns
+ * TRUE if the stream needs to jump to the selected sidx entry */
+static gboolean
+gst_dash_demux_stream_handle_sidx (GstAdaptiveDemux * demux,
+    GstDashDemuxStream * dash_stream)
+{
+  GstAdaptiveDemuxStream *stream = (GstAdaptiveDemuxStream *) dash_stream;
+  guint64 first_offset = dash_stream->sidx_parser.sidx.first_offset;
+  GstSidxBox *sidx = SIDX (dash_stream);
+  guint i;
+
+  if (first_offset) {
+    GST_LOG_OBJECT (stream->pad,
+        "non-zero sidx first offset %" G_GUINT64_FORMAT, first_offset);
+    dash_stream->sidx_base_offset += first_offset;
+  }
+
+  for (i = 0; i < sidx->entries_count; i++) {
+    GstSidxBoxEntry *entry = &sidx->entries[i];
+
+    if (entry->ref_type != 0) {
+      GST_FIXME_OBJECT (stream->pad, "SIDX ref_type 1 not supported yet");
+      dash_stream->sidx_position = GST_CLOCK_TIME_NONE;
+      gst_isoff_sidx_parser_clear (&dash_stream->sidx_parser);
+      break;
+    }
+  }
+
+  /* We might've cleared the index above */
+  if (sidx->entries_count > 0) {
+    if (GST_CLOCK_TIME_IS_VALID (dash_stream->pending_seek_ts)) {
+      /* FIXME, preserve seek flags */
+      if (gst_dash_demux_stream_sidx_seek (dash_stream,
+              demux->segment.rate >= 0, 0, dash_stream->pending_seek_ts,
+              NULL) != GST_FLOW_OK) {
+        GST_ERROR_OBJECT (stream->pad, "Couldn't find position in sidx");
+        dash_stream->sidx_position = GST_CLOCK_TIME_NONE;
+        gst_isoff_sidx_parser_clear (&dash_stream->sidx_parser);
+      }
+      dash_stream->pending_seek_ts = GST_CLOCK_TIME_NONE;
+    } else {
+      if (dash_stream->sidx_position == GST_CLOCK_TIME_NONE) {
+        SIDX (dash_stream)->entry_index = 0;
+      } else {
+        if (gst_dash_demux_stream_sidx_seek (dash_stream,
+                demux->segment.rate >= 0, GST_SEEK_FLAG_SNAP_BEFORE,
+                dash_stream->sidx_position, NULL) != GST_FLOW_OK) {
+          GST_ERROR_OBJECT (stream->pad,
+              "Couldn't find position in sidx");
+          dash_stream->sidx_position = GST_CLOCK_TIME_NONE;
+          gst_isoff_sidx_parser_clear (&dash_stream->sidx_parser);
+        }
+      }
+      dash_stream->sidx_position =
+          SIDX (dash_stream)->entries[SIDX (dash_stream)->entry_index].pts;
+    }
+  }
+
+  return dash_stream->sidx_parser.status == GST_ISOFF_SIDX_PARSER_FINISHED &&
+      SIDX (dash_stream)->entry_index != 0;
+}
+
+/* Parses and pushes a complete sidx box of @size bytes at the start of the
+ * adapter. The box is parsed directly from the memories in the adapter,
+ * which can be megabytes for long single-file representations, without
+ * merging them. */
+static GstFlowReturn
+gst_dash_demux_parse_sidx (GstAdaptiveDemux * demux,
+    GstDashDemuxStream * dash_stream, guint64 size, gboolean * sidx_seek_needed)
+{
+  GstAdaptiveDemuxStream *stream = (GstAdaptiveDemuxStream *) dash_stream;
+  GstIsoffParserResult res;
+  GstFlowReturn ret;
+  GstBuffer *buffer;
+  guint64 buffer_offset = dash_stream->current_offset;
+  guint dummy;
+
+  buffer = gst_adapter_take_buffer_fast (dash_stream->adapter, size);
+
+  GST_LOG_OBJECT (stream->pad,
+      "box %" GST_FOURCC_FORMAT " at offset %" G_GUINT64_FORMAT " size %"
+      G_GUINT64_FORMAT, GST_FOURCC_ARGS (GST_ISOFF_FOURCC_SIDX), buffer_offset,
+      size);
+
+  dash_stream->isobmff_parser.current_start_offset = buffer_offset;
+  dash_stream->isobmff_parser.current_fourcc = GST_ISOFF_FOURCC_SIDX;
+  dash_stream->sidx_base_offset = buffer_offset + size;
+  dash_stream->allow_sidx = FALSE;
+
+  res = gst_isoff_sidx_parser_add_buffer (&dash_stream->sidx_parser, buffer,
+      &dummy);
+  if (res == GST_ISOFF_PARSER_DONE &&
+      gst_dash_demux_stream_handle_sidx (demux, dash_stream)) {
+    /* Need to jump to the requested SIDX entry. Push the SIDX box and let
+     * the caller handle everything else */
+    *sidx_seek_needed = TRUE;
+  } else {
+    dash_stream->isobmff_parser.current_fourcc = 0;
+    dash_stream->isobmff_parser.current_start_offset += size;
+  }
+
+  dash_stream->current_offset += size;
+  GST_BUFFER_OFFSET (buffer) = buffer_offset;
+  GST_BUFFER_OFFSET_END (buffer) = buffer_offset + size;
+  ret = gst_adaptive_demux_stream_push_buffer (stream, buffer);
+
+  if (ret != GST_FLOW_OK || *sidx_seek_needed ||
+      gst_adapter_available (dash_stream->adapter) == 0)
+    return ret;
+
+  /* Continue with the boxes following the sidx */
+  return gst_dash_demux_parse_isobmff (demux, dash_stream, sidx_seek_needed);
+}
+
 static GstFlowReturn
 gst_dash_demux_parse_isobmff (GstAdaptiveDemux * demux,
     GstDashDemuxStream * dash_stream, gboolean * sidx_seek_needed)
@@ -2820,12 +2982,41 @@ gst_dash_demux_parse_isobmff (GstAdaptiveDemux * demux,
       GST_ISOFF_FOURCC_MDAT);
 
   available = gst_adapter_available (dash_stream->adapter);
-  buffer = gst_adapter_take_buffer (dash_stream->adapter, available);
   buffer_offset = dash_stream->current_offset;
 
   /* Always at the start of a box here */
   g_assert (dash_stream->isobmff_parser.current_size == 0);
 
+  /* Peek at the first box header before taking anything from the adapter,
+   * so that boxes arriving in many pieces (e.g. a large sidx) don't get the
+   * whole adapter merged again for every piece */
+  {
+    guint8 header[32];
+    gsize header_len = MIN (available, sizeof (header));
+
+    gst_adapter_copy (dash_stream->adapter, header, 0, header_len);
+    gst_byte_reader_init (&reader, header, header_len);
+
+    if (gst_isoff_parse_box_header (&reader, &fourcc, NULL, &header_size,
+            &size) && size != 0 && fourcc != GST_ISOFF_FOURCC_MDAT) {
+      if (available < size) {
+        /* Not even a single complete, non-mdat box, wait */
+        dash_stream->isobmff_parser.current_start_offset = buffer_offset;
+        dash_stream->isobmff_parser.current_fourcc = fourcc;
+        return GST_FLOW_OK;
+      }
+
+      if (fourcc == GST_ISOFF_FOURCC_SIDX &&
+          gst_mpd_client_has_isoff_ondemand_profile (dashdemux->client) &&
+          dash_stream->allow_sidx &&
+          dash_stream->sidx_parser.status == GST_ISOFF_SIDX_PARSER_INIT)
+        return gst_dash_demux_parse_sidx (demux, dash_stream, size,
+            sidx_seek_needed);
+    }
+  }
+
+  buffer = gst_adapter_take_buffer (dash_stream->adapter, available);
+
   /* At the start of a box => Parse it */
   gst_buffer_map (buffer, &map, GST_MAP_READ);
   gst_byte_reader_init (&reader, map.data, map.size);
@@ -2910,67 +3101,12 @@ gst_dash_demux_parse_isobmff (GstAdaptiveDemux * demux,
           gst_isoff_sidx_parser_parse (&dash_stream->sidx_parser, &sub_reader,
           &dummy);
 
-      if (res == GST_ISOFF_PARSER_DONE) {
-        guint64 first_offset = dash_stream->sidx_parser.sidx.first_offset;
-        GstSidxBox *sidx = SIDX (dash_stream);
-        guint i;
-
-        if (first_offset) {
-          GST_LOG_OBJECT (stream->pad,
-              "non-zero sidx first offset %" G_GUINT64_FORMAT, first_offset);
-          dash_stream->sidx_base_offset += first_offset;
-        }
-
-        for (i = 0; i < sidx->entries_count; i++) {
-          GstSidxBoxEntry *entry = &sidx->entries[i];
-
-          if (entry->ref_type != 0) {
-            GST_FIXME_OBJECT (stream->pad, "SIDX ref_type 1 not supported yet");
-            dash_stream->sidx_position = GST_CLOCK_TIME_NONE;
-            gst_isoff_sidx_parser_clear (&dash_stream->sidx_parser);
-            break;
-          }
-        }
-
-        /* We might've cleared the index above */
-        if (sidx->entries_count > 0) {
-          if (GST_CLOCK_TIME_IS_VALID (dash_stream->pending_seek_ts)) {
-            /* FIXME, preserve seek flags */
-            if (gst_dash_demux_stream_sidx_seek (dash_stream,
-                    demux->segment.rate >= 0, 0, dash_stream->pending_seek_ts,
-                    NULL) != GST_FLOW_OK) {
-              GST_ERROR_OBJECT (stream->pad, "Couldn't find position in sidx");
-              dash_stream->sidx_position = GST_CLOCK_TIME_NONE;
-              gst_isoff_sidx_parser_clear (&dash_stream->sidx_parser);
-            }
-            dash_stream->pending_seek_ts = GST_CLOCK_TIME_NONE;
-          } else {
-
-            if (dash_stream->sidx_position == GST_CLOCK_TIME_NONE) {
-              SIDX (dash_stream)->entry_index = 0;
-            } else {
-              if (gst_dash_demux_stream_sidx_seek (dash_stream,
-                      demux->segment.rate >= 0, GST_SEEK_FLAG_SNAP_BEFORE,
-                      dash_stream->sidx_position, NULL) != GST_FLOW_OK) {
-                GST_ERROR_OBJECT (stream->pad,
-                    "Couldn't find position in sidx");
-                dash_stream->sidx_position = GST_CLOCK_TIME_NONE;
-                gst_isoff_sidx_parser_clear (&dash_stream->sidx_parser);
-              }
-            }
-            dash_stream->sidx_position =
-                SIDX (dash_stream)->entries[SIDX (dash_stream)->entry_index].
-                pts;
-          }
-        }
-
-        if (dash_stream->sidx_parser.status == GST_ISOFF_SIDX_PARSER_FINISHED &&
-            SIDX (dash_stream)->entry_index != 0) {
-          /* Need to jump to the requested SIDX entry. Push everything up to
-           * the SIDX box below and let the caller handle everything else */
-          *sidx_seek_needed = TRUE;
-          break;
-        }
+      if (res == GST_ISOFF_PARSER_DONE &&
+          gst_dash_demux_stream_handle_sidx (demux, dash_stream)) {
+        /* Need to jump to the requested SIDX entry. Push everything up to
+         * the SIDX box below and let the caller handle everything else */
+        *sidx_seek_needed = TRUE;
+        break;
       }
     } else {
       gst_byte_reader_skip (&reader, size - header_size);
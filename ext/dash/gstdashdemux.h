@@ -127,6 +127,7 @@ struct _GstDashDemux
 
   GstMPDClient *client;         /* MPD client */
   GMutex client_lock;
+  GstBuffer *last_manifest;     /* manifest the client was created from */
 
   GstDashDemuxClockDrift *clock_drift;
 
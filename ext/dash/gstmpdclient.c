@@ -474,6 +474,39 @@ gst_mpd_client_free (GstMPDClient * client)
     gst_object_unref (client);
 }
 
+/* Checks the MPD for xlink references, before they get resolved */
+static gboolean
+gst_mpd_client_has_xlink (GstMPDClient * client)
+{
+  GList *l, *m, *n;
+
+  for (l = client->mpd_root_node->Periods; l; l = l->next) {
+    GstMPDPeriodNode *period = l->data;
+
+    if (period->xlink_href || (period->SegmentList
+            && period->SegmentList->xlink_href))
+      return TRUE;
+
+    for (m = period->AdaptationSets; m; m = m->next) {
+      GstMPDAdaptationSetNode *adapt_set = m->data;
+
+      if (adapt_set->xlink_href || (adapt_set->SegmentList
+              && adapt_set->SegmentList->xlink_href))
+        return TRUE;
+
+      for (n = adapt_set->Representations; n; n = n->next) {
+        GstMPDRepresentationNode *representation = n->data;
+
+        if (representation->SegmentList
+            && representation->SegmentList->xlink_href)
+          return TRUE;
+      }
+    }
+  }
+
+  return FALSE;
+}
+
 gboolean
 gst_mpd_client_parse (GstMPDClient * client, const gchar * data, gint size)
 {
@@ -484,6 +517,7 @@ gst_mpd_client_parse (GstMPDClient * client, const gchar * data, gint size)
 
   if (ret) {
     gst_mpd_client_check_profiles (client);
+    client->has_external_resources = gst_mpd_client_has_xlink (client);
     gst_mpd_client_fetch_on_load_external_resources (client);
   }
 
@@ -46,6 +46,8 @@ struct _GstMPDClient
   /* profiles */
   gboolean profile_isoff_ondemand;
 
+  gboolean has_external_resources;            /* MPD references content through xlink */
+
   GstUriDownloader * downloader;
 };
 
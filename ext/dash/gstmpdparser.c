@@ -321,14 +321,45 @@ static void
 gst_mpdparser_parse_s_node (GQueue * queue, xmlNode * a_node)
 {
   GstMPDSNode *new_s_node;
+  xmlAttr *attr;
 
   new_s_node = gst_mpd_s_node_new ();
   g_queue_push_tail (queue, new_s_node);
 
+  /* Live SegmentTimelines can hold thousands of S nodes, so walk the
+   * attributes once and parse their text in place instead of looking up
+   * and copying each one by name. Anything unusual goes the generic way. */
   GST_LOG ("attributes of S node:");
-  gst_xml_helper_get_prop_unsigned_integer_64 (a_node, "t", 0, &new_s_node->t);
-  gst_xml_helper_get_prop_unsigned_integer_64 (a_node, "d", 0, &new_s_node->d);
-  gst_xml_helper_get_prop_signed_integer (a_node, "r", 0, &new_s_node->r);
+  for (attr = a_node->properties; attr; attr = attr->next) {
+    const gchar *name = (const gchar *) attr->name;
+    const gchar *value;
+    gint64 r;
+
+    if (attr->children == NULL || attr->children->next != NULL
+        || attr->children->type != XML_TEXT_NODE)
+      value = NULL;
+    else
+      value = (const gchar *) attr->children->content;
+
+    if (strcmp (name, "t") == 0) {
+      if (value == NULL || !g_ascii_string_to_unsigned (value, 10, 0,
+              G_MAXUINT64, &new_s_node->t, NULL))
+        gst_xml_helper_get_prop_unsigned_integer_64 (a_node, "t", 0,
+            &new_s_node->t);
+    } else if (strcmp (name, "d") == 0) {
+      if (value == NULL || !g_ascii_string_to_unsigned (value, 10, 0,
+              G_MAXUINT64, &new_s_node->d, NULL))
+        gst_xml_helper_get_prop_unsigned_integer_64 (a_node, "d", 0,
+            &new_s_node->d);
+    } else if (strcmp (name, "r") == 0) {
+      if (value != NULL && g_ascii_string_to_signed (value, 10, G_MININT,
+              G_MAXINT, &r, NULL))
+        new_s_node->r = r;
+      else
+        gst_xml_helper_get_prop_signed_integer (a_node, "r", 0,
+            &new_s_node->r);
+    }
+  }
 }
 
 
@@ -1227,7 +1258,9 @@ gst_mpdparser_get_mpd_root_node (GstMPDRootNode ** mpd_root_node,
     LIBXML_TEST_VERSION;
 
     /* parse "data" into a document (which is a libxml2 tree structure xmlDoc) */
-    doc = xmlReadMemory (data, size, "noname.xml", NULL, XML_PARSE_NONET);
+    /* the tree is only read, so let libxml2 store it compactly */
+    doc = xmlReadMemory (data, size, "noname.xml", NULL,
+        XML_PARSE_NONET | XML_PARSE_COMPACT);
     if (doc == NULL) {
       GST_ERROR ("failed to parse the MPD file");
       ret = FALSE;
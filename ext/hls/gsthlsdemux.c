@@ -106,6 +106,9 @@ static gboolean gst_hls_demux_stream_has_next_fragment (GstAdaptiveDemuxStream *
     stream);
 static GstFlowReturn gst_hls_demux_advance_fragment (GstAdaptiveDemuxStream *
     stream);
+static gboolean gst_hls_demux_stream_peek_fragment (GstAdaptiveDemuxStream *
+    stream, guint offset, gchar ** uri, gint64 * range_start,
+    gint64 * range_end);
 static GstFlowReturn gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream
     * stream);
 static gboolean gst_hls_demux_select_bitrate (GstAdaptiveDemuxStream * stream,
@@ -173,6 +176,8 @@ gst_hls_demux_class_init (GstHLSDemuxClass * klass)
   adaptivedemux_class->stream_has_next_fragment =
       gst_hls_demux_stream_has_next_fragment;
   adaptivedemux_class->stream_advance_fragment = gst_hls_demux_advance_fragment;
+  adaptivedemux_class->stream_peek_fragment =
+      gst_hls_demux_stream_peek_fragment;
   adaptivedemux_class->stream_update_fragment_info =
       gst_hls_demux_update_fragment_info;
   adaptivedemux_class->stream_select_bitrate = gst_hls_demux_select_bitrate;
@@ -1064,6 +1069,32 @@ gst_hls_demux_stream_has_next_fragment (GstAdaptiveDemuxStream * stream)
   return has_next;
 }
 
+static gboolean
+gst_hls_demux_stream_peek_fragment (GstAdaptiveDemuxStream * stream,
+    guint offset, gchar ** uri, gint64 * range_start, gint64 * range_end)
+{
+  GstM3U8MediaFile *file;
+  GstM3U8 *m3u8;
+
+  m3u8 = gst_hls_demux_stream_get_m3u8 (GST_HLS_DEMUX_STREAM_CAST (stream));
+
+  file = gst_m3u8_peek_fragment (m3u8, stream->demux->segment.rate > 0,
+      offset);
+  if (file == NULL)
+    return FALSE;
+
+  *uri = g_strdup (file->uri);
+  *range_start = file->offset;
+  if (file->size != -1)
+    *range_end = file->offset + file->size - 1;
+  else
+    *range_end = -1;
+
+  gst_m3u8_media_file_unref (file);
+
+  return TRUE;
+}
+
 static GstFlowReturn
 gst_hls_demux_advance_fragment (GstAdaptiveDemuxStream * stream)
 {
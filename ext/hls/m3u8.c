@@ -984,6 +984,32 @@ gst_m3u8_has_next_fragment (GstM3U8 * m3u8, gboolean forward)
   return have_next;
 }
 
+/* Returns the fragment @offset positions after the current one without
+ * advancing, or NULL if it is not in the playlist (yet) */
+GstM3U8MediaFile *
+gst_m3u8_peek_fragment (GstM3U8 * m3u8, gboolean forward, guint offset)
+{
+  GstM3U8MediaFile *file = NULL;
+  GList *cur;
+
+  g_return_val_if_fail (m3u8 != NULL, NULL);
+
+  GST_M3U8_LOCK (m3u8);
+
+  cur = m3u8->current_file;
+  while (cur && offset > 0) {
+    cur = forward ? cur->next : cur->prev;
+    offset--;
+  }
+
+  if (cur)
+    file = gst_m3u8_media_file_ref (cur->data);
+
+  GST_M3U8_UNLOCK (m3u8);
+
+  return file;
+}
+
 /* call with M3U8_LOCK held */
 static void
 m3u8_alternate_advance (GstM3U8 * m3u8, gboolean forward)
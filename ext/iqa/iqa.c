@@ -195,8 +195,6 @@ do_dssim (GstIqa * self, GstVideoFrame * ref, GstVideoFrame * cmp,
   dssim_attr *attr;
   gint y;
   unsigned char **ptrs, **ptrs2;
-  GstMapInfo ref_info;
-  GstMapInfo cmp_info;
   GstMapInfo out_info;
   dssim_image *ref_image;
   dssim_image *cmp_image;
@@ -227,28 +225,37 @@ do_dssim (GstIqa * self, GstVideoFrame * ref, GstVideoFrame * cmp,
   gst_structure_get (msg_structure, "dssim", GST_TYPE_STRUCTURE,
       &dssim_structure, NULL);
 
-  attr = dssim_create_attr ();
-  dssim_set_save_ssim_maps (attr, 1, 1);
+  /* The reference image only depends on the reference frame, so it is
+   * converted once per aggregated frame and shared by all compared pads */
+  if (!self->dssim_attr) {
+    self->dssim_attr = dssim_create_attr ();
+    dssim_set_save_ssim_maps (self->dssim_attr, 1, 1);
+  }
+  attr = self->dssim_attr;
 
-  gst_buffer_map (ref->buffer, &ref_info, GST_MAP_READ);
-  gst_buffer_map (cmp->buffer, &cmp_info, GST_MAP_READ);
   gst_buffer_map (outbuf, &out_info, GST_MAP_WRITE);
   out = (dssim_rgba *) out_info.data;
 
-  ptrs = g_malloc (sizeof (char **) * ref->info.height);
+  if (!self->dssim_ref_image) {
+    ptrs = g_malloc (sizeof (char **) * ref->info.height);
 
-  for (y = 0; y < ref->info.height; y++) {
-    ptrs[y] = ref_info.data + (ref->info.width * 4 * y);
-  }
+    for (y = 0; y < ref->info.height; y++) {
+      ptrs[y] = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (ref, 0) +
+          GST_VIDEO_FRAME_PLANE_STRIDE (ref, 0) * y;
+    }
 
-  ref_image =
-      dssim_create_image (attr, ptrs, DSSIM_RGBA, ref->info.width,
-      ref->info.height, 0.45455);
+    self->dssim_ref_image =
+        dssim_create_image (attr, ptrs, DSSIM_RGBA, ref->info.width,
+        ref->info.height, 0.45455);
+    g_free (ptrs);
+  }
+  ref_image = self->dssim_ref_image;
 
   ptrs2 = g_malloc (sizeof (char **) * cmp->info.height);
 
   for (y = 0; y < cmp->info.height; y++) {
-    ptrs2[y] = cmp_info.data + (cmp->info.width * 4 * y);
+    ptrs2[y] = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (cmp, 0) +
+        GST_VIDEO_FRAME_PLANE_STRIDE (cmp, 0) * y;
   }
 
   cmp_image =
@@ -302,17 +309,25 @@ cleanup_return:
   gst_structure_free (dssim_structure);
 
   free (map_meta.data);
-  g_free (ptrs);
   g_free (ptrs2);
-  gst_buffer_unmap (ref->buffer, &ref_info);
-  gst_buffer_unmap (cmp->buffer, &cmp_info);
   gst_buffer_unmap (outbuf, &out_info);
-  dssim_dealloc_image (ref_image);
   dssim_dealloc_image (cmp_image);
-  dssim_dealloc_attr (attr);
 
   return ret;
 }
+
+static void
+gst_iqa_clear_dssim (GstIqa * self)
+{
+  if (self->dssim_ref_image) {
+    dssim_dealloc_image (self->dssim_ref_image);
+    self->dssim_ref_image = NULL;
+  }
+  if (self->dssim_attr) {
+    dssim_dealloc_attr (self->dssim_attr);
+    self->dssim_attr = NULL;
+  }
+}
 #endif
 
 static gboolean
@@ -379,6 +394,9 @@ gst_iqa_aggregate_frames (GstVideoAggregator * vagg, GstBuffer * outbuf)
     }
   }
 
+#ifdef HAVE_DSSIM
+  gst_iqa_clear_dssim (self);
+#endif
   GST_OBJECT_UNLOCK (vagg);
 
   /* We only post the message here, because we can't post it while the object
@@ -390,6 +408,9 @@ gst_iqa_aggregate_frames (GstVideoAggregator * vagg, GstBuffer * outbuf)
   return GST_FLOW_OK;
 
 failed:
+#ifdef HAVE_DSSIM
+  gst_iqa_clear_dssim (self);
+#endif
   GST_OBJECT_UNLOCK (vagg);
 
   return GST_FLOW_ERROR;
@@ -52,6 +52,10 @@ struct _GstIqa
   gdouble ssim_threshold;
   gdouble max_dssim;
   gint mode;
+
+  /* dssim state shared by all pads compared against the same reference */
+  gpointer dssim_attr;
+  gpointer dssim_ref_image;
 };
 
 struct _GstIqaClass
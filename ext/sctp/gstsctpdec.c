@@ -411,13 +411,34 @@ gst_sctp_data_srcpad_loop (GstPad * pad)
 
   if (gst_data_queue_pop (sctpdec_pad->packet_queue, &item)) {
     GstBuffer *buffer;
+    GstBufferList *list = NULL;
     GstFlowReturn flow_ret;
 
     buffer = GST_BUFFER (item->object);
     GST_DEBUG_OBJECT (pad, "Forwarding buffer %" GST_PTR_FORMAT, buffer);
 
-    flow_ret = gst_pad_push (pad, buffer);
     item->object = NULL;
+    item->destroy (item);
+
+    /* Forward everything that is queued up already in one go */
+    while (!gst_data_queue_is_empty (sctpdec_pad->packet_queue)
+        && gst_data_queue_pop (sctpdec_pad->packet_queue, &item)) {
+      if (!list) {
+        list = gst_buffer_list_new ();
+        gst_buffer_list_add (list, buffer);
+      }
+      gst_buffer_list_add (list, GST_BUFFER (item->object));
+      item->object = NULL;
+      item->destroy (item);
+    }
+
+    if (list) {
+      GST_DEBUG_OBJECT (pad, "Forwarding %u buffers",
+          gst_buffer_list_length (list));
+      flow_ret = gst_pad_push_list (pad, list);
+    } else {
+      flow_ret = gst_pad_push (pad, buffer);
+    }
 
     GST_OBJECT_LOCK (self);
     gst_flow_combiner_update_pad_flow (self->flow_combiner, pad, flow_ret);
@@ -438,8 +459,6 @@ gst_sctp_data_srcpad_loop (GstPad * pad)
       gst_data_queue_flush (sctpdec_pad->packet_queue);
       gst_pad_pause_task (pad);
     }
-
-    item->destroy (item);
   } else {
     GST_OBJECT_LOCK (self);
     gst_flow_combiner_update_pad_flow (self->flow_combiner, pad,
@@ -515,11 +515,32 @@ gst_sctp_enc_srcpad_loop (GstPad * pad)
 
   if (gst_data_queue_pop (self->outbound_sctp_packet_queue, &item)) {
     GstBuffer *buffer = GST_BUFFER (item->object);
+    GstBufferList *list = NULL;
 
     GST_DEBUG_OBJECT (self, "Forwarding buffer %" GST_PTR_FORMAT, buffer);
 
-    flow_ret = gst_pad_push (self->src_pad, buffer);
     item->object = NULL;
+    item->destroy (item);
+
+    /* Forward everything that is queued up already in one go */
+    while (!gst_data_queue_is_empty (self->outbound_sctp_packet_queue)
+        && gst_data_queue_pop (self->outbound_sctp_packet_queue, &item)) {
+      if (!list) {
+        list = gst_buffer_list_new ();
+        gst_buffer_list_add (list, buffer);
+      }
+      gst_buffer_list_add (list, GST_BUFFER (item->object));
+      item->object = NULL;
+      item->destroy (item);
+    }
+
+    if (list) {
+      GST_DEBUG_OBJECT (self, "Forwarding %u buffers",
+          gst_buffer_list_length (list));
+      flow_ret = gst_pad_push_list (self->src_pad, list);
+    } else {
+      flow_ret = gst_pad_push (self->src_pad, buffer);
+    }
 
     GST_OBJECT_LOCK (self);
     self->src_ret = flow_ret;
@@ -540,8 +561,6 @@ gst_sctp_enc_srcpad_loop (GstPad * pad)
       gst_data_queue_flush (self->outbound_sctp_packet_queue);
       gst_pad_pause_task (pad);
     }
-
-    item->destroy (item);
   } else {
     GST_OBJECT_LOCK (self);
     self->src_ret = GST_FLOW_FLUSHING;
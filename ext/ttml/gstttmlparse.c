@@ -109,6 +109,8 @@ gst_ttml_parse_dispose (GObject * object)
     ttmlparse->textbuf = NULL;
   }
 
+  g_clear_pointer (&ttmlparse->parse_cache, ttml_parse_cache_free);
+
   GST_CALL_PARENT (G_OBJECT_CLASS, dispose, (object));
 }
 
@@ -156,6 +158,7 @@ gst_ttml_parse_init (GstTtmlParse * ttmlparse)
   ttmlparse->encoding = g_strdup (DEFAULT_ENCODING);
   ttmlparse->detected_encoding = NULL;
   ttmlparse->adapter = gst_adapter_new ();
+  ttmlparse->parse_cache = ttml_parse_cache_new ();
 }
 
 /*
@@ -412,6 +415,7 @@ feed_textbuf (GstTtmlParse * self, GstBuffer * buf)
     GST_INFO ("discontinuity");
     /* flush the parser state */
     g_string_truncate (self->textbuf, 0);
+    self->textbuf_scanned = 0;
     gst_adapter_clear (self->adapter);
     /* we could set a flag to make sure that the next buffer we push out also
      * has the DISCONT flag set, but there's no point really given that it's
@@ -477,7 +481,19 @@ handle_buffer (GstTtmlParse * self, GstBuffer * buf)
   }
 
   do {
-    consumed = ttml_parse (self->textbuf->str, begin, duration, &subtitle_list);
+    /* Long documents arrive in many buffers: only look for the end tag in
+     * the new data instead of having the whole document rescanned each time.
+     * The end tag may straddle the boundary, hence the overlap. */
+    if (!g_strstr_len (self->textbuf->str + self->textbuf_scanned,
+            self->textbuf->len - self->textbuf_scanned, "</tt>")) {
+      if (self->textbuf->len >= strlen ("</tt>"))
+        self->textbuf_scanned = self->textbuf->len - strlen ("</tt>") + 1;
+      GST_DEBUG_OBJECT (self, "need more data");
+      return ret;
+    }
+
+    consumed = ttml_parse (self->textbuf->str, begin, duration,
+        self->parse_cache, &subtitle_list);
 
     if (!consumed) {
       GST_DEBUG_OBJECT (self, "need more data");
@@ -485,6 +501,7 @@ handle_buffer (GstTtmlParse * self, GstBuffer * buf)
     }
 
     self->textbuf = g_string_erase (self->textbuf, 0, consumed);
+    self->textbuf_scanned = 0;
 
     for (iter = subtitle_list; iter; iter = g_list_next (iter)) {
       GstBuffer *op_buffer = GST_BUFFER (iter->data);
@@ -577,6 +594,7 @@ gst_ttml_parse_change_state (GstElement * element, GstStateChange transition)
       g_free (self->detected_encoding);
       self->detected_encoding = NULL;
       g_string_truncate (self->textbuf, 0);
+      self->textbuf_scanned = 0;
       gst_adapter_clear (self->adapter);
       break;
     default:
@@ -25,6 +25,8 @@
 #include <gst/gst.h>
 #include <gst/base/gstadapter.h>
 
+#include "ttmlparse.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_TTML_PARSE \
@@ -50,6 +52,11 @@ struct _GstTtmlParse {
   GstAdapter *adapter;
   /* contains the UTF-8 decoded input */
   GString *textbuf;
+  /* length of textbuf known not to contain the end of a document */
+  gsize textbuf_scanned;
+
+  /* styles and regions shared by consecutive documents */
+  TtmlParseCache *parse_cache;
 
   /* seek */
   guint64 offset;
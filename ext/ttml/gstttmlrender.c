@@ -142,6 +142,19 @@ typedef struct
 } UnifiedBlock;
 
 
+/* A rasterised run of pango markup. @ink_offset is the distance from the top
+ * of @image to the text baseline; @scene is the last scene that used the
+ * entry, so that entries not needed by the current scene can be evicted. */
+typedef struct
+{
+  GstBuffer *image;
+  guint width;
+  guint height;
+  gint ink_offset;
+  guint scene;
+} TextImageCacheEntry;
+
+
 static GstElementClass *parent_class = NULL;
 static void gst_ttml_render_base_init (gpointer g_class);
 static void gst_ttml_render_class_init (GstTtmlRenderClass * klass);
@@ -184,8 +197,6 @@ static gboolean gst_ttml_render_can_handle_caps (GstCaps * incaps);
 
 static GstTtmlRenderRenderedImage *gst_ttml_render_rendered_image_new
     (GstBuffer * image, gint x, gint y, guint width, guint height);
-static GstTtmlRenderRenderedImage *gst_ttml_render_rendered_image_new_empty
-    (void);
 static GstTtmlRenderRenderedImage *gst_ttml_render_rendered_image_copy
     (GstTtmlRenderRenderedImage * image);
 static void gst_ttml_render_rendered_image_free
@@ -196,6 +207,8 @@ static GstTtmlRenderRenderedImage *gst_ttml_render_stitch_images (GPtrArray *
     images, GstTtmlDirection direction);
 
 static gboolean gst_ttml_render_color_is_transparent (GstSubtitleColor * color);
+static void gst_ttml_render_text_image_cache_entry_free
+    (TextImageCacheEntry * entry);
 
 GType
 gst_ttml_render_get_type (void)
@@ -294,6 +307,11 @@ gst_ttml_render_finalize (GObject * object)
     render->layout = NULL;
   }
 
+  if (render->text_image_cache) {
+    g_hash_table_unref (render->text_image_cache);
+    render->text_image_cache = NULL;
+  }
+
   g_mutex_clear (&render->lock);
   g_cond_clear (&render->cond);
 
@@ -356,6 +374,9 @@ gst_ttml_render_init (GstTtmlRender * render, GstTtmlRenderClass * klass)
   render->compositions = NULL;
   render->layout =
       pango_layout_new (GST_TTML_RENDER_GET_CLASS (render)->pango_context);
+  render->text_image_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, (GDestroyNotify) gst_ttml_render_text_image_cache_entry_free);
+  render->scene = 0;
 
   g_mutex_init (&render->lock);
   g_cond_init (&render->cond);
@@ -1930,12 +1951,44 @@ gst_ttml_render_split_block (UnifiedBlock * block, GPtrArray * char_ranges)
 }
 
 
-/* Render the text in a pango-markup string. */
-static GstTtmlRenderRenderedImage *
-gst_ttml_render_draw_text (GstTtmlRender * render, const gchar * text,
-    guint line_height, guint baseline_offset)
+static void
+gst_ttml_render_text_image_cache_entry_free (TextImageCacheEntry * entry)
 {
-  GstTtmlRenderRenderedImage *ret;
+  gst_buffer_unref (entry->image);
+  g_slice_free (TextImageCacheEntry, entry);
+}
+
+
+static gboolean
+gst_ttml_render_text_image_cache_entry_is_stale (gpointer key, gpointer value,
+    gpointer user_data)
+{
+  TextImageCacheEntry *entry = value;
+  guint scene = GPOINTER_TO_UINT (user_data);
+
+  return entry->scene != scene;
+}
+
+
+/* Drop every cached text image that was not used by the current scene. */
+static void
+gst_ttml_render_expire_text_images (GstTtmlRender * render)
+{
+  guint removed;
+
+  removed = g_hash_table_foreach_remove (render->text_image_cache,
+      gst_ttml_render_text_image_cache_entry_is_stale,
+      GUINT_TO_POINTER (render->scene));
+  GST_CAT_LOG (ttmlrender_debug, "Expired %u cached text images, %u remain",
+      removed, g_hash_table_size (render->text_image_cache));
+}
+
+
+/* Rasterise the text in a pango-markup string. */
+static TextImageCacheEntry *
+gst_ttml_render_rasterise_text (GstTtmlRender * render, const gchar * text)
+{
+  TextImageCacheEntry *ret;
   cairo_surface_t *surface, *cropped_surface;
   cairo_t *cairo_state, *cropped_state;
   GstMapInfo map;
@@ -1945,7 +1998,7 @@ gst_ttml_render_draw_text (GstTtmlRender * render, const gchar * text,
   gint bounding_box_x1, bounding_box_x2, bounding_box_y1, bounding_box_y2;
   gint baseline;
 
-  ret = gst_ttml_render_rendered_image_new_empty ();
+  ret = g_slice_new0 (TextImageCacheEntry);
 
   pango_layout_set_markup (render->layout, text, strlen (text));
   GST_CAT_DEBUG (ttmlrender_debug, "Layout text: \"%s\"",
@@ -2001,12 +2054,38 @@ gst_ttml_render_draw_text (GstTtmlRender * render, const gchar * text,
 
   ret->width = buf_width;
   ret->height = buf_height;
-  ret->x = 0;
-  ret->y = MAX (0, (gint) baseline_offset - (baseline - ink_rect.y));
+  ret->ink_offset = baseline - ink_rect.y;
   return ret;
 }
 
 
+/*
+ * Render the text in a pango-markup string. Since the markup carries the
+ * text, its styling and its font size, rasterised images are cached by markup
+ * so that text persisting between scenes (e.g., roll-up and paint-on
+ * captions) does not have to be laid out and drawn again.
+ */
+static GstTtmlRenderRenderedImage *
+gst_ttml_render_draw_text (GstTtmlRender * render, const gchar * text,
+    guint line_height, guint baseline_offset)
+{
+  TextImageCacheEntry *entry;
+
+  entry = g_hash_table_lookup (render->text_image_cache, text);
+  if (entry) {
+    GST_CAT_LOG (ttmlrender_debug, "Reusing cached image for \"%s\"", text);
+  } else {
+    entry = gst_ttml_render_rasterise_text (render, text);
+    g_hash_table_insert (render->text_image_cache, g_strdup (text), entry);
+  }
+  entry->scene = render->scene;
+
+  return gst_ttml_render_rendered_image_new (gst_buffer_ref (entry->image), 0,
+      MAX (0, (gint) baseline_offset - entry->ink_offset), entry->width,
+      entry->height);
+}
+
+
 static GstTtmlRenderRenderedImage *
 gst_ttml_render_render_block_elements (GstTtmlRender * render,
     UnifiedBlock * block, BlockMetrics block_metrics)
@@ -2287,13 +2366,6 @@ gst_ttml_render_rendered_image_new (GstBuffer * image, gint x, gint y,
 }
 
 
-static GstTtmlRenderRenderedImage *
-gst_ttml_render_rendered_image_new_empty (void)
-{
-  return gst_ttml_render_rendered_image_new (NULL, 0, 0, 0, 0);
-}
-
-
 static inline GstTtmlRenderRenderedImage *
 gst_ttml_render_rendered_image_copy (GstTtmlRenderRenderedImage * image)
 {
@@ -2589,12 +2661,71 @@ gst_ttml_render_render_text_block (GstTtmlRender * render,
 }
 
 
+/*
+ * Looks for a composition from the previous scene whose single rectangle has
+ * the same geometry and pixels as @image. Reusing it rather than creating a
+ * new rectangle means that regions that did not change between scenes keep
+ * their rectangle, along with any converted pixel data cached within it, so
+ * only changed rectangles have to be converted and blended afresh.
+ */
 static GstVideoOverlayComposition *
-gst_ttml_render_compose_overlay (GstTtmlRenderRenderedImage * image)
+gst_ttml_render_find_composition (GList * compositions,
+    GstTtmlRenderRenderedImage * image)
+{
+  GList *l;
+
+  for (l = compositions; l; l = l->next) {
+    GstVideoOverlayComposition *composition = l->data;
+    GstVideoOverlayRectangle *rectangle;
+    GstBuffer *pixels;
+    GstMapInfo map;
+    gint x, y;
+    guint width, height;
+    gboolean equal;
+
+    if (gst_video_overlay_composition_n_rectangles (composition) != 1)
+      continue;
+
+    rectangle = gst_video_overlay_composition_get_rectangle (composition, 0);
+    gst_video_overlay_rectangle_get_render_rectangle (rectangle, &x, &y,
+        &width, &height);
+    if (x != image->x || y != image->y || width != image->width
+        || height != image->height)
+      continue;
+
+    pixels = gst_video_overlay_rectangle_get_pixels_unscaled_raw (rectangle,
+        GST_VIDEO_OVERLAY_FORMAT_FLAG_PREMULTIPLIED_ALPHA);
+    if (gst_buffer_get_size (pixels) != gst_buffer_get_size (image->image))
+      continue;
+
+    if (!gst_buffer_map (image->image, &map, GST_MAP_READ))
+      continue;
+    equal = (gst_buffer_memcmp (pixels, 0, map.data, map.size) == 0);
+    gst_buffer_unmap (image->image, &map);
+
+    if (equal)
+      return gst_video_overlay_composition_ref (composition);
+  }
+
+  return NULL;
+}
+
+
+static GstVideoOverlayComposition *
+gst_ttml_render_compose_overlay (GstTtmlRender * render,
+    GstTtmlRenderRenderedImage * image)
 {
   GstVideoOverlayRectangle *rectangle;
   GstVideoOverlayComposition *ret = NULL;
 
+  ret = gst_ttml_render_find_composition (render->compositions, image);
+  if (ret) {
+    GST_CAT_DEBUG (ttmlrender_debug, "Region at %d,%d (%ux%u) is unchanged, "
+        "reusing previous overlay rectangle", image->x, image->y,
+        image->width, image->height);
+    return ret;
+  }
+
   gst_buffer_add_video_meta (image->image, GST_VIDEO_FRAME_FLAG_NONE,
       GST_VIDEO_OVERLAY_COMPOSITION_FORMAT_RGB, image->width, image->height);
 
@@ -2746,7 +2877,7 @@ gst_ttml_render_render_text_region (GstTtmlRender * render,
   }
 
   if (region_image) {
-    ret = gst_ttml_render_compose_overlay (region_image);
+    ret = gst_ttml_render_compose_overlay (render, region_image);
     gst_ttml_render_rendered_image_free (region_image);
   }
 
@@ -2897,13 +3028,12 @@ wait_for_text_buf:
       if (render->need_render) {
         GstSubtitleRegion *region = NULL;
         GstSubtitleMeta *subtitle_meta = NULL;
+        GList *compositions = NULL;
         guint i;
 
-        if (render->compositions) {
-          g_list_free_full (render->compositions,
-              (GDestroyNotify) gst_video_overlay_composition_unref);
-          render->compositions = NULL;
-        }
+        /* The previous scene's compositions are kept around while the new
+         * scene is rendered, so that unchanged regions can reuse them. */
+        render->scene++;
 
         subtitle_meta = gst_buffer_get_subtitle_meta (render->text_buffer);
         if (!subtitle_meta) {
@@ -2914,12 +3044,18 @@ wait_for_text_buf:
             region = g_ptr_array_index (subtitle_meta->regions, i);
             composition = gst_ttml_render_render_text_region (render, region,
                 render->text_buffer);
-            if (composition) {
-              render->compositions = g_list_append (render->compositions,
-                  composition);
-            }
+            if (composition)
+              compositions = g_list_append (compositions, composition);
           }
         }
+
+        if (render->compositions) {
+          g_list_free_full (render->compositions,
+              (GDestroyNotify) gst_video_overlay_composition_unref);
+        }
+        render->compositions = compositions;
+
+        gst_ttml_render_expire_text_images (render);
         render->need_render = FALSE;
       }
 
@@ -3043,6 +3179,11 @@ gst_ttml_render_change_state (GstElement * element, GstStateChange transition)
     return ret;
 
   switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      GST_TTML_RENDER_LOCK (render);
+      g_hash_table_remove_all (render->text_image_cache);
+      GST_TTML_RENDER_UNLOCK (render);
+      break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
       GST_TTML_RENDER_LOCK (render);
       render->text_flushing = FALSE;
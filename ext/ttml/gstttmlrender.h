@@ -93,6 +93,10 @@ struct _GstTtmlRender {
 
     PangoLayout             *layout;
     GList * compositions;
+
+    /* pango markup -> rasterised text, see gst_ttml_render_draw_text() */
+    GHashTable              *text_image_cache;
+    guint                    scene;
 };
 
 struct _GstTtmlRenderClass {
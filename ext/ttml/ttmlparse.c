@@ -34,6 +34,7 @@
 #include <math.h>
 #include <libxml/xmlmemory.h>
 #include <libxml/parser.h>
+#include <libxml/xmlreader.h>
 
 #include "ttmlparse.h"
 #include "subtitle.h"
@@ -1917,40 +1918,144 @@ ttml_join_inline_elements (GList * scenes)
 }
 
 
-static xmlNodePtr
-ttml_find_child (xmlNodePtr parent, const gchar * name)
+/* Builds the element tree of the body the reader is positioned on. Only
+ * paragraphs and whatever else is found below body and div elements are
+ * expanded into a DOM subtree, so the DOM of processed paragraphs is
+ * released while the reader moves on and memory use does not grow with the
+ * length of the document. */
+static GNode *
+ttml_read_body (xmlTextReaderPtr reader)
+{
+  TtmlElement *element;
+  GNode *body, *parent;
+  gint ret;
+
+  element = ttml_parse_element (xmlTextReaderCurrentNode (reader));
+  if (!element)
+    return NULL;
+
+  body = parent = g_node_new (element);
+  if (xmlTextReaderIsEmptyElement (reader))
+    return body;
+
+  ret = xmlTextReaderRead (reader);
+  while (ret == 1) {
+    gint type = xmlTextReaderNodeType (reader);
+
+    if (type == XML_READER_TYPE_END_ELEMENT) {
+      if (parent == body)
+        break;
+      parent = parent->parent;
+      ret = xmlTextReaderRead (reader);
+    } else if (type == XML_READER_TYPE_ELEMENT &&
+        xmlStrcmp (xmlTextReaderConstLocalName (reader),
+            (const xmlChar *) "div") == 0) {
+      GNode *div;
+
+      element = ttml_parse_element (xmlTextReaderCurrentNode (reader));
+      div = g_node_append (parent, g_node_new (element));
+      if (!xmlTextReaderIsEmptyElement (reader))
+        parent = div;
+      ret = xmlTextReaderRead (reader);
+    } else {
+      xmlNodePtr node = xmlTextReaderExpand (reader);
+      GNode *descendants;
+
+      if (node && (descendants = ttml_parse_body (node)))
+        g_node_append (parent, descendants);
+      ret = xmlTextReaderNext (reader);
+    }
+  }
+
+  return body;
+}
+
+
+struct _TtmlParseCache
+{
+  /* document text up to the body element, from which the tables below were
+   * parsed */
+  gchar *prologue;
+  GHashTable *styles_table;
+  GHashTable *regions_table;
+};
+
+TtmlParseCache *
+ttml_parse_cache_new (void)
+{
+  return g_slice_new0 (TtmlParseCache);
+}
+
+static void
+ttml_parse_cache_clear (TtmlParseCache * cache)
+{
+  g_clear_pointer (&cache->prologue, g_free);
+  g_clear_pointer (&cache->styles_table, g_hash_table_unref);
+  g_clear_pointer (&cache->regions_table, g_hash_table_unref);
+}
+
+void
+ttml_parse_cache_free (TtmlParseCache * cache)
 {
-  xmlNodePtr child = parent->children;
-  while (child && xmlStrcmp (child->name, (const xmlChar *) name) != 0)
-    child = child->next;
-  return child;
+  if (!cache)
+    return;
+
+  ttml_parse_cache_clear (cache);
+  g_slice_free (TtmlParseCache, cache);
+}
+
+/* Returns the length of the text preceding the body start tag of @input, or
+ * 0 if it can't be found reliably. Comments and CDATA sections could hide a
+ * body tag, so documents containing any before the body are not cached. */
+static gsize
+ttml_get_prologue_length (const gchar * input, gsize len)
+{
+  const gchar *ptr = input, *end = input + len;
+
+  while ((ptr = memchr (ptr, '<', end - ptr))) {
+    const gchar *name = ++ptr, *local_name = ptr;
+
+    if (ptr < end && *ptr == '!' && (g_str_has_prefix (ptr, "!--")
+            || g_str_has_prefix (ptr, "![CDATA[")))
+      return 0;
+
+    while (ptr < end && !g_ascii_isspace (*ptr) && *ptr != '>' && *ptr != '/') {
+      if (*ptr == ':')
+        local_name = ptr + 1;
+      ptr++;
+    }
+
+    if (ptr - local_name == 4 && strncmp (local_name, "body", 4) == 0)
+      return name - 1 - input;
+  }
+
+  return 0;
 }
 
 #define TTML_END_TAG "</tt>"
 
 guint
 ttml_parse (const gchar * input, GstClockTime begin, GstClockTime duration,
-    GList ** parsed)
+    TtmlParseCache * cache, GList ** parsed)
 {
-  xmlDocPtr doc;
-  xmlNodePtr root_node, head_node, body_node;
+  xmlTextReaderPtr reader;
+  xmlNodePtr root_node;
 
-  GHashTable *styles_table, *regions_table;
+  GHashTable *styles_table = NULL, *regions_table = NULL;
   GList *output_buffers = NULL;
   gchar *value;
   guint cellres_x, cellres_y;
   TtmlWhitespaceMode doc_whitespace_mode = TTML_WHITESPACE_MODE_DEFAULT;
   guint consumed = 0;
+  gsize prologue_len = 0;
   gchar *end_tt;
+  gboolean have_head = FALSE;
+  GNode *body_tree = NULL;
+  gint ret;
 
   g_return_val_if_fail (parsed != NULL, 0);
 
   *parsed = NULL;
-  if (!g_utf8_validate (input, -1, NULL)) {
-    GST_CAT_ERROR (ttmlparse_debug, "Input isn't valid UTF-8.");
-    return 0;
-  }
-  GST_CAT_LOG (ttmlparse_debug, "Input:\n%s", input);
 
   end_tt = g_strrstr (input, TTML_END_TAG);
 
@@ -1961,24 +2066,38 @@ ttml_parse (const gchar * input, GstClockTime begin, GstClockTime duration,
 
   consumed = end_tt - input + strlen (TTML_END_TAG);
 
-  styles_table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
-      (GDestroyNotify) ttml_delete_element);
-  regions_table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
-      (GDestroyNotify) ttml_delete_element);
+  /* Only validate once the whole document is there, as the input grows */
+  if (!g_utf8_validate (input, consumed, NULL)) {
+    GST_CAT_ERROR (ttmlparse_debug, "Input isn't valid UTF-8.");
+    return 0;
+  }
+  GST_CAT_LOG (ttmlparse_debug, "Input:\n%.*s", (gint) consumed, input);
+
+  /* Fragmented EBU-TT-D carries a full document per sample, usually with the
+   * very same head, so reuse the styles and regions of the previous one. */
+  if (cache) {
+    prologue_len = ttml_get_prologue_length (input, consumed);
+    if (prologue_len > 0 && cache->prologue
+        && strlen (cache->prologue) == prologue_len
+        && strncmp (cache->prologue, input, prologue_len) == 0) {
+      GST_CAT_LOG (ttmlparse_debug, "Reusing styles and regions");
+      styles_table = g_hash_table_ref (cache->styles_table);
+      regions_table = g_hash_table_ref (cache->regions_table);
+    }
+  }
 
   /* Parse input. */
-  doc = xmlReadMemory (input, consumed, "any_doc_name", NULL, 0);
-  if (!doc) {
+  reader = xmlReaderForMemory (input, consumed, "any_doc_name", NULL, 0);
+  if (!reader || xmlTextReaderMoveToContent (reader) != 1) {
     GST_CAT_ERROR (ttmlparse_debug, "Failed to parse document.");
-    return 0;
+    goto error;
   }
 
-  root_node = xmlDocGetRootElement (doc);
+  root_node = xmlTextReaderCurrentNode (reader);
 
   if (xmlStrcmp (root_node->name, (const xmlChar *) "tt") != 0) {
     GST_CAT_ERROR (ttmlparse_debug, "Root element of document is not tt:tt.");
-    xmlFreeDoc (doc);
-    return 0;
+    goto error;
   }
 
   if ((value = ttml_get_xml_property (root_node, "cellResolution"))) {
@@ -2002,20 +2121,56 @@ ttml_parse (const gchar * input, GstClockTime begin, GstClockTime duration,
     g_free (value);
   }
 
-  if (!(head_node = ttml_find_child (root_node, "head"))) {
-    GST_CAT_ERROR (ttmlparse_debug, "No <head> element found.");
-    xmlFreeDoc (doc);
-    return 0;
+  /* Walk the children of the root element */
+  ret = xmlTextReaderRead (reader);
+  while (ret == 1 && xmlTextReaderDepth (reader) > 0) {
+    const xmlChar *name = xmlTextReaderConstLocalName (reader);
+
+    if (xmlTextReaderNodeType (reader) != XML_READER_TYPE_ELEMENT
+        || xmlTextReaderDepth (reader) != 1) {
+      ret = xmlTextReaderRead (reader);
+    } else if (!have_head && xmlStrcmp (name, (const xmlChar *) "head") == 0) {
+      xmlNodePtr head_node;
+
+      have_head = TRUE;
+      if (!styles_table) {
+        styles_table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+            (GDestroyNotify) ttml_delete_element);
+        regions_table = g_hash_table_new_full (g_str_hash, g_str_equal,
+            g_free, (GDestroyNotify) ttml_delete_element);
+        if ((head_node = xmlTextReaderExpand (reader)))
+          ttml_parse_head (head_node, styles_table, regions_table);
+
+        if (cache && prologue_len > 0) {
+          ttml_parse_cache_clear (cache);
+          cache->prologue = g_strndup (input, prologue_len);
+          cache->styles_table = g_hash_table_ref (styles_table);
+          cache->regions_table = g_hash_table_ref (regions_table);
+        }
+      }
+      ret = xmlTextReaderNext (reader);
+    } else if (!body_tree && xmlStrcmp (name, (const xmlChar *) "body") == 0) {
+      body_tree = ttml_read_body (reader);
+      ret = xmlTextReaderNext (reader);
+    } else {
+      ret = xmlTextReaderNext (reader);
+    }
   }
 
-  ttml_parse_head (head_node, styles_table, regions_table);
+  if (ret < 0) {
+    GST_CAT_ERROR (ttmlparse_debug, "Failed to parse document.");
+    goto error;
+  }
 
-  if ((body_node = ttml_find_child (root_node, "body"))) {
-    GNode *body_tree;
+  if (!have_head) {
+    GST_CAT_ERROR (ttmlparse_debug, "No <head> element found.");
+    goto error;
+  }
+
+  if (body_tree) {
     GList *region_trees = NULL;
     GList *scenes = NULL;
 
-    body_tree = ttml_parse_body (body_node);
     GST_CAT_LOG (ttmlparse_debug, "body_tree tree contains %u nodes.",
         g_node_n_nodes (body_tree, G_TRAVERSE_ALL));
     GST_CAT_LOG (ttmlparse_debug, "body_tree tree height is %u",
@@ -2044,11 +2199,22 @@ ttml_parse (const gchar * input, GstClockTime begin, GstClockTime duration,
     ttml_delete_tree (body_tree);
   }
 
-  xmlFreeDoc (doc);
-  g_hash_table_destroy (styles_table);
-  g_hash_table_destroy (regions_table);
+  xmlFreeTextReader (reader);
+  g_hash_table_unref (styles_table);
+  g_hash_table_unref (regions_table);
 
   *parsed = output_buffers;
 
   return consumed;
+
+error:
+  if (body_tree)
+    ttml_delete_tree (body_tree);
+  if (reader)
+    xmlFreeTextReader (reader);
+  if (styles_table)
+    g_hash_table_unref (styles_table);
+  if (regions_table)
+    g_hash_table_unref (regions_table);
+  return 0;
 }
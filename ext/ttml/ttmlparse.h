@@ -27,8 +27,14 @@
 
 G_BEGIN_DECLS
 
+typedef struct _TtmlParseCache TtmlParseCache;
+
+TtmlParseCache * ttml_parse_cache_new (void);
+
+void ttml_parse_cache_free (TtmlParseCache * cache);
+
 guint ttml_parse (const gchar * file, GstClockTime begin,
-    GstClockTime duration, GList **parsed);
+    GstClockTime duration, TtmlParseCache * cache, GList **parsed);
 
 G_END_DECLS
 #endif /* _TTML_PARSE_H_ */
@@ -368,7 +368,8 @@ enum
   PROP_BUNDLE_POLICY,
   PROP_ICE_TRANSPORT_POLICY,
   PROP_ICE_AGENT,
-  PROP_LATENCY
+  PROP_LATENCY,
+  PROP_SHARED_ICE_THREAD,
 };
 
 static guint gst_webrtc_bin_signals[LAST_SIGNAL] = { 0 };
@@ -5525,6 +5526,24 @@ error:
   goto out;
 }
 
+/* The storage only has to keep received packets around for ULPFEC
+ * recovery. With a size-time of 0 it does not store anything and packets
+ * pass straight through, so only enable it for sessions that use ULPFEC */
+static void
+_set_rtpstorage_latency (GstWebRTCBin * webrtc, TransportStream * stream,
+    GObject * storage)
+{
+  guint64 latency_ns = 0;
+
+  if (stream && transport_stream_get_pt (stream, "ULPFEC")) {
+    /* Add an extra 50 ms for safety */
+    latency_ns = webrtc->priv->jb_latency + RTPSTORAGE_EXTRA_TIME;
+    latency_ns *= GST_MSECOND;
+  }
+
+  g_object_set (storage, "size-time", latency_ns, NULL);
+}
+
 static GstElement *
 on_rtpbin_request_fec_decoder (GstElement * rtpbin, guint session_id,
     GstWebRTCBin * webrtc)
@@ -5532,7 +5551,7 @@ on_rtpbin_request_fec_decoder (GstElement * rtpbin, guint session_id,
   TransportStream *stream;
   GstElement *ret = NULL;
   gint pt = 0;
-  GObject *internal_storage;
+  GObject *internal_storage, *storage;
 
   stream = _find_transport_for_session (webrtc, session_id);
 
@@ -5558,6 +5577,12 @@ on_rtpbin_request_fec_decoder (GstElement * rtpbin, guint session_id,
 
     g_object_set (ret, "pt", pt, "storage", internal_storage, NULL);
     g_object_unref (internal_storage);
+
+    /* the storage may have been created before ULPFEC was negotiated */
+    g_signal_emit_by_name (webrtc->rtpbin, "get-storage", session_id,
+        &storage);
+    _set_rtpstorage_latency (webrtc, stream, storage);
+    g_object_unref (storage);
   }
 
   return ret;
@@ -5747,13 +5772,8 @@ static void
 on_rtpbin_new_storage (GstElement * rtpbin, GstElement * storage,
     guint session_id, GstWebRTCBin * webrtc)
 {
-  guint64 latency = webrtc->priv->jb_latency;
-
-  /* Add an extra 50 ms for safey */
-  latency += RTPSTORAGE_EXTRA_TIME;
-  latency *= GST_MSECOND;
-
-  g_object_set (storage, "size-time", latency, NULL);
+  _set_rtpstorage_latency (webrtc, _find_transport_for_session (webrtc,
+          session_id), G_OBJECT (storage));
 }
 
 static GstElement *
@@ -5951,11 +5971,6 @@ static void
 _update_rtpstorage_latency (GstWebRTCBin * webrtc)
 {
   guint i;
-  guint64 latency_ns;
-
-  /* Add an extra 50 ms for safety */
-  latency_ns = webrtc->priv->jb_latency + RTPSTORAGE_EXTRA_TIME;
-  latency_ns *= GST_MSECOND;
 
   for (i = 0; i < webrtc->priv->transports->len; i++) {
     TransportStream *stream = g_ptr_array_index (webrtc->priv->transports, i);
@@ -5964,7 +5979,7 @@ _update_rtpstorage_latency (GstWebRTCBin * webrtc)
     g_signal_emit_by_name (webrtc->rtpbin, "get-storage", stream->session_id,
         &storage);
 
-    g_object_set (storage, "size-time", latency_ns, NULL);
+    _set_rtpstorage_latency (webrtc, stream, storage);
 
     g_object_unref (storage);
   }
@@ -6003,6 +6018,9 @@ gst_webrtc_bin_set_property (GObject * object, guint prop_id,
       webrtc->priv->jb_latency = g_value_get_uint (value);
       _update_rtpstorage_latency (webrtc);
       break;
+    case PROP_SHARED_ICE_THREAD:
+      webrtc->priv->shared_ice_thread = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -6077,6 +6095,9 @@ gst_webrtc_bin_get_property (GObject * object, guint prop_id,
     case PROP_LATENCY:
       g_value_set_uint (value, webrtc->priv->jb_latency);
       break;
+    case PROP_SHARED_ICE_THREAD:
+      g_value_set_boolean (value, webrtc->priv->shared_ice_thread);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -6091,7 +6112,8 @@ gst_webrtc_bin_constructed (GObject * object)
   gchar *name;
 
   name = g_strdup_printf ("%s:ice", GST_OBJECT_NAME (webrtc));
-  webrtc->priv->ice = gst_webrtc_ice_new (name);
+  webrtc->priv->ice = gst_webrtc_ice_new (name,
+      webrtc->priv->shared_ice_thread);
 
   gst_webrtc_ice_set_on_ice_candidate (webrtc->priv->ice,
       (GstWebRTCIceOnCandidateFunc) _on_local_ice_candidate_cb, webrtc, NULL);
@@ -6360,6 +6382,27 @@ gst_webrtc_bin_class_init (GstWebRTCBinClass * klass)
           "Default duration to buffer in the jitterbuffers (in ms)",
           0, G_MAXUINT, 200, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstWebRTCBin:shared-ice-thread:
+   *
+   * Whether the ICE agent of this webrtcbin runs on a thread shared with
+   * the ICE agents of all other webrtcbin instances that have this set,
+   * instead of starting one ICE thread per webrtcbin. Useful for
+   * applications that handle many peer connections in one process.
+   *
+   * This can only be set when constructing the element, e.g. with
+   * g_object_new().
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_SHARED_ICE_THREAD,
+      g_param_spec_boolean ("shared-ice-thread", "Shared ICE thread",
+          "Whether to run the ICE agent on a thread shared with other "
+          "webrtcbin instances", FALSE,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+          G_PARAM_STATIC_STRINGS));
+
   /**
    * GstWebRTCBin::create-offer:
    * @object: the #webrtcbin
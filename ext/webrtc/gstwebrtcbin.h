@@ -110,6 +110,7 @@ struct _GstWebRTCBinPrivate
   TransportStream *data_channel_transport;
 
   GstWebRTCICE *ice;
+  gboolean shared_ice_thread;
   GArray *ice_stream_map;
   GMutex ice_lock;
   GArray *pending_remote_ice_candidates;
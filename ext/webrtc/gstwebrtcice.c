@@ -56,6 +56,7 @@ enum
   PROP_AGENT,
   PROP_ICE_TCP,
   PROP_ICE_UDP,
+  PROP_SHARED_THREAD,
 };
 
 static guint gst_webrtc_ice_signals[LAST_SIGNAL] = { 0 };
@@ -71,6 +72,7 @@ struct _GstWebRTCICEPrivate
   GMainLoop *loop;
   GMutex lock;
   GCond cond;
+  gboolean shared_thread;
 
   GstWebRTCIceOnCandidateFunc on_candidate;
   gpointer on_candidate_data;
@@ -138,6 +140,135 @@ _stop_thread (GstWebRTCICE * ice)
   g_thread_unref (ice->priv->thread);
 }
 
+/* A single thread and main context that all ICE agents constructed with
+ * shared-thread=TRUE run their libnice sources on, instead of one thread
+ * per agent. Started with the first user and stopped with the last one */
+struct SharedNiceThread
+{
+  guint refcount;
+  GThread *thread;
+  GMainContext *main_context;
+  GMainLoop *loop;
+};
+
+G_LOCK_DEFINE_STATIC (shared_thread);
+static struct SharedNiceThread *shared_thread = NULL;
+
+static gpointer
+_gst_shared_nice_thread (struct SharedNiceThread *shared)
+{
+  g_main_loop_run (shared->loop);
+
+  g_main_loop_unref (shared->loop);
+  g_main_context_unref (shared->main_context);
+  g_free (shared);
+
+  return NULL;
+}
+
+static gboolean
+_quit_shared_loop (GMainLoop * loop)
+{
+  g_main_loop_quit (loop);
+  return G_SOURCE_REMOVE;
+}
+
+static GMainContext *
+_shared_thread_ref (void)
+{
+  GMainContext *context;
+
+  G_LOCK (shared_thread);
+  if (!shared_thread) {
+    GST_DEBUG ("starting shared ICE thread");
+    shared_thread = g_new0 (struct SharedNiceThread, 1);
+    shared_thread->main_context = g_main_context_new ();
+    shared_thread->loop = g_main_loop_new (shared_thread->main_context, FALSE);
+    shared_thread->thread = g_thread_new ("webrtcice-shared",
+        (GThreadFunc) _gst_shared_nice_thread, shared_thread);
+  }
+  shared_thread->refcount++;
+  context = g_main_context_ref (shared_thread->main_context);
+  G_UNLOCK (shared_thread);
+
+  return context;
+}
+
+static void
+_shared_thread_unref (void)
+{
+  struct SharedNiceThread *shared = NULL;
+  GThread *thread;
+
+  G_LOCK (shared_thread);
+  g_assert (shared_thread != NULL);
+  if (--shared_thread->refcount == 0) {
+    shared = shared_thread;
+    shared_thread = NULL;
+  }
+  G_UNLOCK (shared_thread);
+
+  if (!shared)
+    return;
+
+  GST_DEBUG ("stopping shared ICE thread");
+
+  /* quit from inside the loop so that a quit before the thread got to
+   * g_main_loop_run() isn't lost. The thread frees everything itself, as
+   * the last agent may well be released from the shared thread */
+  thread = shared->thread;
+  g_main_context_invoke (shared->main_context,
+      (GSourceFunc) _quit_shared_loop, shared->loop);
+  g_thread_unref (thread);
+}
+
+struct UnrefAgent
+{
+  GMutex lock;
+  GCond cond;
+  NiceAgent *agent;
+  gboolean done;
+};
+
+static gboolean
+_unref_agent (struct UnrefAgent *data)
+{
+  g_object_unref (data->agent);
+
+  g_mutex_lock (&data->lock);
+  data->done = TRUE;
+  g_cond_signal (&data->cond);
+  g_mutex_unlock (&data->lock);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* The shared thread keeps running after the agent is gone and may be
+ * dispatching one of its sources right now. Release the agent from the
+ * shared thread, which also waits for any such dispatch to finish */
+static void
+_unref_agent_on_shared_thread (GstWebRTCICE * ice)
+{
+  struct UnrefAgent data;
+
+  g_mutex_init (&data.lock);
+  g_cond_init (&data.cond);
+  data.agent = ice->priv->nice_agent;
+  data.done = FALSE;
+  ice->priv->nice_agent = NULL;
+
+  g_main_context_invoke (ice->priv->main_context, (GSourceFunc) _unref_agent,
+      &data);
+
+  g_mutex_lock (&data.lock);
+  while (!data.done)
+    g_cond_wait (&data.cond, &data.lock);
+  g_mutex_unlock (&data.lock);
+
+  g_mutex_clear (&data.lock);
+  g_cond_clear (&data.cond);
+}
+
 #if 0
 static NiceComponentType
 _webrtc_component_to_nice (GstWebRTCICEComponent comp)
@@ -1018,6 +1149,9 @@ gst_webrtc_ice_set_property (GObject * object, guint prop_id,
       g_object_set_property (G_OBJECT (ice->priv->nice_agent),
           "ice-udp", value);
       break;
+    case PROP_SHARED_THREAD:
+      ice->priv->shared_thread = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1042,6 +1176,9 @@ gst_webrtc_ice_get_property (GObject * object, guint prop_id,
       g_object_get_property (G_OBJECT (ice->priv->nice_agent),
           "ice-udp", value);
       break;
+    case PROP_SHARED_THREAD:
+      g_value_set_boolean (value, ice->priv->shared_thread);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1055,7 +1192,10 @@ gst_webrtc_ice_finalize (GObject * object)
 
   g_signal_handlers_disconnect_by_data (ice->priv->nice_agent, ice);
 
-  _stop_thread (ice);
+  if (ice->priv->shared_thread)
+    _unref_agent_on_shared_thread (ice);
+  else
+    _stop_thread (ice);
 
   if (ice->priv->on_candidate_notify)
     ice->priv->on_candidate_notify (ice->priv->on_candidate_data);
@@ -1072,7 +1212,13 @@ gst_webrtc_ice_finalize (GObject * object)
 
   g_array_free (ice->priv->nice_stream_map, TRUE);
 
-  g_object_unref (ice->priv->nice_agent);
+  g_clear_object (&ice->priv->nice_agent);
+
+  if (ice->priv->shared_thread) {
+    g_main_context_unref (ice->priv->main_context);
+    ice->priv->main_context = NULL;
+    _shared_thread_unref ();
+  }
 
   g_hash_table_unref (ice->turn_servers);
 
@@ -1084,7 +1230,10 @@ gst_webrtc_ice_constructed (GObject * object)
 {
   GstWebRTCICE *ice = GST_WEBRTC_ICE (object);
 
-  _start_thread (ice);
+  if (ice->priv->shared_thread)
+    ice->priv->main_context = _shared_thread_ref ();
+  else
+    _start_thread (ice);
 
   ice->priv->nice_agent = nice_agent_new_full (ice->priv->main_context,
       NICE_COMPATIBILITY_RFC5245, NICE_AGENT_OPTION_ICE_TRICKLE);
@@ -1124,6 +1273,22 @@ gst_webrtc_ice_class_init (GstWebRTCICEClass * klass)
           "Whether the agent should use ICE-UDP when gathering candidates",
           TRUE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstWebRTCICE:shared-thread:
+   *
+   * Whether to run the ICE agent on a thread shared with all other ICE
+   * agents that have this set instead of starting a thread of its own.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_SHARED_THREAD,
+      g_param_spec_boolean ("shared-thread", "Shared thread",
+          "Whether to run the ICE agent on a thread shared with other ICE "
+          "agents", FALSE,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+          G_PARAM_STATIC_STRINGS));
+
   /**
    * GstWebRTCICE::add-local-ip-address:
    * @object: the #GstWebRTCICE
@@ -1161,7 +1326,8 @@ gst_webrtc_ice_init (GstWebRTCICE * ice)
 }
 
 GstWebRTCICE *
-gst_webrtc_ice_new (const gchar * name)
+gst_webrtc_ice_new (const gchar * name, gboolean shared_thread)
 {
-  return g_object_new (GST_TYPE_WEBRTC_ICE, "name", name, NULL);
+  return g_object_new (GST_TYPE_WEBRTC_ICE, "name", name, "shared-thread",
+      shared_thread, NULL);
 }
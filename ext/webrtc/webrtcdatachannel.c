@@ -238,7 +238,7 @@ _free_task (struct task *task)
   g_free (task);
 }
 
-static void
+static gboolean
 _channel_enqueue_task (WebRTCDataChannel * channel, ChannelTask func,
     gpointer user_data, GDestroyNotify notify)
 {
@@ -249,11 +249,73 @@ _channel_enqueue_task (WebRTCDataChannel * channel, ChannelTask func,
   task->user_data = user_data;
   task->notify = notify;
 
-  gst_webrtc_bin_enqueue_task (channel->webrtcbin,
+  return gst_webrtc_bin_enqueue_task (channel->webrtcbin,
       (GstWebRTCBinFunc) _execute_task, task, (GDestroyNotify) _free_task,
       NULL);
 }
 
+static void
+_free_message (struct task *task)
+{
+  if (task->notify)
+    task->notify (task->user_data);
+  g_free (task);
+}
+
+/* Received messages are emitted from a single task for everything that is
+ * pending, instead of scheduling one task per message */
+static void
+_emit_pending_messages (WebRTCDataChannel * channel, gpointer user_data)
+{
+  struct task *task;
+
+  while (TRUE) {
+    GST_WEBRTC_DATA_CHANNEL_LOCK (channel);
+    task = g_queue_pop_head (&channel->pending_messages);
+    GST_WEBRTC_DATA_CHANNEL_UNLOCK (channel);
+
+    if (!task)
+      break;
+
+    task->func (GST_WEBRTC_DATA_CHANNEL (channel), task->user_data);
+    _free_message (task);
+  }
+}
+
+static void
+_channel_enqueue_message (WebRTCDataChannel * channel, ChannelTask func,
+    gpointer user_data, GDestroyNotify notify)
+{
+  struct task *task = g_new0 (struct task, 1);
+  gboolean schedule;
+
+  task->func = func;
+  task->user_data = user_data;
+  task->notify = notify;
+
+  GST_WEBRTC_DATA_CHANNEL_LOCK (channel);
+  schedule = g_queue_is_empty (&channel->pending_messages);
+  g_queue_push_tail (&channel->pending_messages, task);
+  GST_WEBRTC_DATA_CHANNEL_UNLOCK (channel);
+
+  if (schedule && !_channel_enqueue_task (channel,
+          (ChannelTask) _emit_pending_messages, NULL, NULL)) {
+    GQueue pending;
+
+    /* webrtcbin is closed and nothing will ever emit the pending messages.
+     * Drop them, so that the next message finds an empty queue again */
+    GST_DEBUG_OBJECT (channel, "Dropping pending messages");
+
+    GST_WEBRTC_DATA_CHANNEL_LOCK (channel);
+    pending = channel->pending_messages;
+    g_queue_init (&channel->pending_messages);
+    GST_WEBRTC_DATA_CHANNEL_UNLOCK (channel);
+
+    while ((task = g_queue_pop_head (&pending)))
+      _free_message (task);
+  }
+}
+
 static void
 _channel_store_error (WebRTCDataChannel * channel, GError * error)
 {
@@ -510,23 +572,12 @@ _emit_have_string (GstWebRTCDataChannel * channel, gchar * str)
 }
 
 static GstFlowReturn
-_data_channel_have_sample (WebRTCDataChannel * channel, GstSample * sample,
+_data_channel_have_buffer (WebRTCDataChannel * channel, GstBuffer * buffer,
     GError ** error)
 {
   GstSctpReceiveMeta *receive;
-  GstBuffer *buffer;
   GstFlowReturn ret = GST_FLOW_OK;
 
-  GST_LOG_OBJECT (channel, "Received sample %" GST_PTR_FORMAT, sample);
-
-  g_return_val_if_fail (channel->sctp_transport != NULL, GST_FLOW_ERROR);
-
-  buffer = gst_sample_get_buffer (sample);
-  if (!buffer) {
-    g_set_error (error, GST_WEBRTC_BIN_ERROR,
-        GST_WEBRTC_BIN_ERROR_DATA_CHANNEL_FAILURE, "No buffer to handle");
-    return GST_FLOW_ERROR;
-  }
   receive = gst_sctp_buffer_get_receive_meta (buffer);
   if (!receive) {
     g_set_error (error, GST_WEBRTC_BIN_ERROR,
@@ -559,8 +610,8 @@ _data_channel_have_sample (WebRTCDataChannel * channel, GstSample * sample,
         ret = GST_FLOW_ERROR;
       } else {
         gchar *str = g_strndup ((gchar *) info.data, info.size);
-        _channel_enqueue_task (channel, (ChannelTask) _emit_have_string, str,
-            g_free);
+        _channel_enqueue_message (channel, (ChannelTask) _emit_have_string,
+            str, g_free);
         gst_buffer_unmap (buffer, &info);
       }
       break;
@@ -577,18 +628,18 @@ _data_channel_have_sample (WebRTCDataChannel * channel, GstSample * sample,
         GBytes *data = g_bytes_new_with_free_func (info->map_info.data,
             info->map_info.size, (GDestroyNotify) buffer_unmap_and_unref, info);
         info->buffer = gst_buffer_ref (buffer);
-        _channel_enqueue_task (channel, (ChannelTask) _emit_have_data, data,
-            (GDestroyNotify) g_bytes_unref);
+        _channel_enqueue_message (channel, (ChannelTask) _emit_have_data,
+            data, (GDestroyNotify) g_bytes_unref);
       }
       break;
     }
     case DATA_CHANNEL_PPID_WEBRTC_BINARY_EMPTY:
-      _channel_enqueue_task (channel, (ChannelTask) _emit_have_data, NULL,
+      _channel_enqueue_message (channel, (ChannelTask) _emit_have_data, NULL,
           NULL);
       break;
     case DATA_CHANNEL_PPID_WEBRTC_STRING_EMPTY:
-      _channel_enqueue_task (channel, (ChannelTask) _emit_have_string, NULL,
-          NULL);
+      _channel_enqueue_message (channel, (ChannelTask) _emit_have_string,
+          NULL, NULL);
       break;
     default:
       g_set_error (error, GST_WEBRTC_BIN_ERROR,
@@ -601,6 +652,40 @@ _data_channel_have_sample (WebRTCDataChannel * channel, GstSample * sample,
   return ret;
 }
 
+static GstFlowReturn
+_data_channel_have_sample (WebRTCDataChannel * channel, GstSample * sample,
+    GError ** error)
+{
+  GstBuffer *buffer;
+  GstBufferList *list;
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i, len;
+
+  GST_LOG_OBJECT (channel, "Received sample %" GST_PTR_FORMAT, sample);
+
+  g_return_val_if_fail (channel->sctp_transport != NULL, GST_FLOW_ERROR);
+
+  /* sctpdec pushes everything it has queued up as a buffer list */
+  list = gst_sample_get_buffer_list (sample);
+  if (list) {
+    len = gst_buffer_list_length (list);
+    for (i = 0; i < len && ret == GST_FLOW_OK; i++) {
+      ret = _data_channel_have_buffer (channel,
+          gst_buffer_list_get (list, i), error);
+    }
+    return ret;
+  }
+
+  buffer = gst_sample_get_buffer (sample);
+  if (!buffer) {
+    g_set_error (error, GST_WEBRTC_BIN_ERROR,
+        GST_WEBRTC_BIN_ERROR_DATA_CHANNEL_FAILURE, "No buffer to handle");
+    return GST_FLOW_ERROR;
+  }
+
+  return _data_channel_have_buffer (channel, buffer, error);
+}
+
 static GstFlowReturn
 on_sink_preroll (GstAppSink * sink, gpointer user_data)
 {
@@ -924,7 +1009,7 @@ gst_webrtc_data_channel_constructed (GObject * object)
   channel->appsink = gst_element_factory_make ("appsink", NULL);
   gst_object_ref_sink (channel->appsink);
   g_object_set (channel->appsink, "sync", FALSE, "async", FALSE, "caps", caps,
-      NULL);
+      "buffer-list", TRUE, NULL);
   gst_app_sink_set_callbacks (GST_APP_SINK (channel->appsink), &sink_callbacks,
       channel, NULL);
 
@@ -936,6 +1021,7 @@ static void
 gst_webrtc_data_channel_finalize (GObject * object)
 {
   WebRTCDataChannel *channel = WEBRTC_DATA_CHANNEL (object);
+  struct task *task;
 
   if (channel->src_probe) {
     GstPad *pad = gst_element_get_static_pad (channel->appsrc, "src");
@@ -951,6 +1037,9 @@ gst_webrtc_data_channel_finalize (GObject * object)
   g_clear_object (&channel->appsrc);
   g_clear_object (&channel->appsink);
 
+  while ((task = g_queue_pop_head (&channel->pending_messages)))
+    _free_message (task);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -972,6 +1061,7 @@ webrtc_data_channel_class_init (WebRTCDataChannelClass * klass)
 static void
 webrtc_data_channel_init (WebRTCDataChannel * channel)
 {
+  g_queue_init (&channel->pending_messages);
 }
 
 static void
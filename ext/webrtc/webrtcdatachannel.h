@@ -51,6 +51,7 @@ struct _WebRTCDataChannel
   gboolean                          opened;
   gulong                            src_probe;
   GError                           *stored_error;
+  GQueue                            pending_messages;
 
   gpointer                          _padding[GST_PADDING];
 };
@@ -129,8 +129,16 @@ GST_DEBUG_CATEGORY (adaptivedemux_debug);
 #define DEFAULT_FAILED_COUNT 3
 #define DEFAULT_CONNECTION_SPEED 0
 #define DEFAULT_BITRATE_LIMIT 0.8f
+#define DEFAULT_PREFETCH_FRAGMENTS 0
+#define MAX_PREFETCH_FRAGMENTS 16
+#define DEFAULT_BANDWIDTH_ESTIMATOR GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_MOVING_AVERAGE
+#define DEFAULT_BUFFER_TARGET_TIME 0
 #define SRC_QUEUE_MAX_BYTES 20 * 1024 * 1024    /* For safety. Large enough to hold a segment. */
 #define NUM_LOOKBACK_FRAGMENTS 3
+/* Amount of downloaded bytes for which a sample gets half of the weight in
+ * the byte-weighted moving average. Small fragments are mostly dominated by
+ * request latency and TCP slow-start and should not move the estimate much */
+#define EWMA_HALF_WEIGHT_BYTES (1024 * 1024)
 
 #define GST_MANIFEST_GET_LOCK(d) (&(GST_ADAPTIVE_DEMUX_CAST(d)->priv->manifest_lock))
 #define GST_MANIFEST_LOCK(d) G_STMT_START { \
@@ -157,9 +165,46 @@ enum
   PROP_0,
   PROP_CONNECTION_SPEED,
   PROP_BITRATE_LIMIT,
+  PROP_PREFETCH_FRAGMENTS,
+  PROP_BANDWIDTH_ESTIMATOR,
+  PROP_BUFFER_TARGET_TIME,
   PROP_LAST
 };
 
+typedef enum
+{
+  GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_MOVING_AVERAGE,
+  GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_EWMA,
+  GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_HARMONIC_MEAN,
+} GstAdaptiveDemuxBandwidthEstimator;
+
+#define GST_TYPE_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR \
+  (gst_adaptive_demux_bandwidth_estimator_get_type ())
+static GType
+gst_adaptive_demux_bandwidth_estimator_get_type (void)
+{
+  static GType type = 0;
+  static const GEnumValue values[] = {
+    {GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_MOVING_AVERAGE,
+        "Minimum of the last fragment and the moving average of the last "
+          "fragments", "moving-average"},
+    {GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_EWMA,
+        "Exponentially weighted moving average, weighted by fragment size",
+        "ewma"},
+    {GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_HARMONIC_MEAN,
+        "Harmonic mean of the last fragments", "harmonic-mean"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&type)) {
+    GType _type =
+        g_enum_register_static ("GstAdaptiveDemuxBandwidthEstimator", values);
+    g_once_init_leave (&type, _type);
+  }
+
+  return type;
+}
+
 /* Internal, so not using GST_FLOW_CUSTOM_SUCCESS_N */
 #define GST_ADAPTIVE_DEMUX_FLOW_SWITCH (GST_FLOW_CUSTOM_SUCCESS_2 + 1)
 
@@ -205,8 +250,32 @@ struct _GstAdaptiveDemuxPrivate
    * without needing to stop tasks when they just want to
    * update the segment boundaries */
   GMutex segment_lock;
+
+  guint prefetch_fragments;     /* protected by manifest_lock */
+
+  /* rate adaptation, protected by manifest_lock */
+  GstAdaptiveDemuxBandwidthEstimator bandwidth_estimator;
+  GstClockTime buffer_target_time;
 };
 
+/* A fragment downloaded ahead of time by the stream's prefetch pool.
+ * All fields are protected by the stream's prefetch_lock */
+typedef struct _GstAdaptiveDemuxPrefetch
+{
+  gint ref_count;
+
+  gchar *uri;
+  gint64 range_start;
+  gint64 range_end;
+
+  GstUriDownloader *downloader;
+
+  gboolean done;
+  gboolean cancelled;
+  GstBuffer *buffer;            /* NULL if the download failed */
+  GstClockTime download_time;
+} GstAdaptiveDemuxPrefetch;
+
 typedef struct _GstAdaptiveDemuxTimer
 {
   volatile gint ref_count;
@@ -269,6 +338,8 @@ static gboolean gst_adaptive_demux_has_next_period (GstAdaptiveDemux * demux);
 static void gst_adaptive_demux_advance_period (GstAdaptiveDemux * demux);
 
 static void gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream);
+static void gst_adaptive_demux_stream_clear_prefetch (GstAdaptiveDemuxStream *
+    stream);
 static GstFlowReturn
 gst_adaptive_demux_stream_push_event (GstAdaptiveDemuxStream * stream,
     GstEvent * event);
@@ -361,6 +432,15 @@ gst_adaptive_demux_set_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       demux->bitrate_limit = g_value_get_float (value);
       break;
+    case PROP_PREFETCH_FRAGMENTS:
+      demux->priv->prefetch_fragments = g_value_get_uint (value);
+      break;
+    case PROP_BANDWIDTH_ESTIMATOR:
+      demux->priv->bandwidth_estimator = g_value_get_enum (value);
+      break;
+    case PROP_BUFFER_TARGET_TIME:
+      demux->priv->buffer_target_time = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -385,6 +465,15 @@ gst_adaptive_demux_get_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       g_value_set_float (value, demux->bitrate_limit);
       break;
+    case PROP_PREFETCH_FRAGMENTS:
+      g_value_set_uint (value, demux->priv->prefetch_fragments);
+      break;
+    case PROP_BANDWIDTH_ESTIMATOR:
+      g_value_set_enum (value, demux->priv->bandwidth_estimator);
+      break;
+    case PROP_BUFFER_TARGET_TIME:
+      g_value_set_uint64 (value, demux->priv->buffer_target_time);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -430,6 +519,55 @@ gst_adaptive_demux_class_init (GstAdaptiveDemuxClass * klass)
           0, 1, DEFAULT_BITRATE_LIMIT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAdaptiveDemux:prefetch-fragments:
+   *
+   * Number of upcoming fragments of each stream to download in parallel
+   * while the current one is being pushed, so that the request latency of
+   * the next fragments is hidden. Requires support from the subclass.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PREFETCH_FRAGMENTS,
+      g_param_spec_uint ("prefetch-fragments", "Prefetch fragments",
+          "Number of upcoming fragments to download ahead of time per stream "
+          "(0 = disabled)", 0, MAX_PREFETCH_FRAGMENTS,
+          DEFAULT_PREFETCH_FRAGMENTS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAdaptiveDemux:bandwidth-estimator:
+   *
+   * How the available bandwidth is estimated from the measured download
+   * rate of the previous fragments.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_BANDWIDTH_ESTIMATOR,
+      g_param_spec_enum ("bandwidth-estimator", "Bandwidth estimator",
+          "Method used to estimate the available bandwidth",
+          GST_TYPE_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR,
+          DEFAULT_BANDWIDTH_ESTIMATOR,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAdaptiveDemux:buffer-target-time:
+   *
+   * Amount of data buffered ahead of the playback position at which the
+   * whole estimated bandwidth may be used when selecting a bitrate. Below
+   * that level #GstAdaptiveDemux:bitrate-limit is applied progressively,
+   * and the selection becomes more conservative when the buffer is almost
+   * drained. 0 disables buffer-based adaptation.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_BUFFER_TARGET_TIME,
+      g_param_spec_uint64 ("buffer-target-time", "Buffer target time",
+          "Buffered time ahead of playback above which the full estimated "
+          "bandwidth is used (0 = disabled)", 0, G_MAXUINT64,
+          DEFAULT_BUFFER_TARGET_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state = gst_adaptive_demux_change_state;
 
   gstbin_class->handle_message = gst_adaptive_demux_handle_message;
@@ -520,6 +658,9 @@ gst_adaptive_demux_init (GstAdaptiveDemux * demux,
   /* Properties */
   demux->bitrate_limit = DEFAULT_BITRATE_LIMIT;
   demux->connection_speed = DEFAULT_CONNECTION_SPEED;
+  demux->priv->prefetch_fragments = DEFAULT_PREFETCH_FRAGMENTS;
+  demux->priv->bandwidth_estimator = DEFAULT_BANDWIDTH_ESTIMATOR;
+  demux->priv->buffer_target_time = DEFAULT_BUFFER_TARGET_TIME;
 
   gst_element_add_pad (GST_ELEMENT (demux), demux->sinkpad);
 }
@@ -1336,6 +1477,8 @@ gst_adaptive_demux_stream_new (GstAdaptiveDemux * demux, GstPad * pad)
   gst_segment_init (&stream->segment, GST_FORMAT_TIME);
   g_cond_init (&stream->fragment_download_cond);
   g_mutex_init (&stream->fragment_download_lock);
+  g_cond_init (&stream->prefetch_cond);
+  g_mutex_init (&stream->prefetch_lock);
 
   demux->next_streams = g_list_append (demux->next_streams, stream);
 
@@ -1400,6 +1543,15 @@ gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream)
     stream->download_task = NULL;
   }
 
+  gst_adaptive_demux_stream_clear_prefetch (stream);
+  if (stream->prefetch_pool) {
+    /* queued downloads were cancelled above and return immediately */
+    GST_MANIFEST_UNLOCK (demux);
+    g_thread_pool_free (stream->prefetch_pool, FALSE, TRUE);
+    GST_MANIFEST_LOCK (demux);
+    stream->prefetch_pool = NULL;
+  }
+
   gst_adaptive_demux_stream_fragment_clear (&stream->fragment);
 
   if (stream->pending_segment) {
@@ -1435,6 +1587,8 @@ gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream)
 
   g_cond_clear (&stream->fragment_download_cond);
   g_mutex_clear (&stream->fragment_download_lock);
+  g_cond_clear (&stream->prefetch_cond);
+  g_mutex_clear (&stream->prefetch_lock);
   g_free (stream->fragment_bitrates);
 
   if (stream->pad) {
@@ -2142,6 +2296,8 @@ gst_adaptive_demux_stop_tasks (GstAdaptiveDemux * demux, gboolean stop_updates)
       gst_task_stop (stream->download_task);
       g_cond_signal (&stream->fragment_download_cond);
       g_mutex_unlock (&stream->fragment_download_lock);
+
+      gst_adaptive_demux_stream_clear_prefetch (stream);
     }
     list_to_process = demux->prepared_streams;
   }
@@ -2269,6 +2425,85 @@ _update_average_bitrate (GstAdaptiveDemux * demux,
   return stream->moving_bitrate / stream->moving_index;
 }
 
+/* must be called with manifest_lock taken */
+static guint64
+_update_ewma_bitrate (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, guint64 new_bitrate)
+{
+  guint64 bytes = stream->fragment_bytes_downloaded;
+  gdouble alpha;
+
+  if (stream->ewma_bitrate == 0 || bytes == 0) {
+    if (stream->ewma_bitrate == 0)
+      stream->ewma_bitrate = new_bitrate;
+    return stream->ewma_bitrate;
+  }
+
+  alpha = (gdouble) bytes / (bytes + EWMA_HALF_WEIGHT_BYTES);
+  stream->ewma_bitrate = alpha * new_bitrate +
+      (1.0 - alpha) * stream->ewma_bitrate;
+
+  GST_LOG_OBJECT (stream->pad, "EWMA weight %.3f for %" G_GUINT64_FORMAT
+      " bytes", alpha, bytes);
+
+  return stream->ewma_bitrate;
+}
+
+/* must be called with manifest_lock taken.
+ * Uses the samples collected by _update_average_bitrate() */
+static guint64
+_get_harmonic_mean_bitrate (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  guint i, n_samples = MIN (stream->moving_index, NUM_LOOKBACK_FRAGMENTS);
+  gdouble sum = 0.0;
+
+  for (i = 0; i < n_samples; i++) {
+    /* a stalled download counts as a very slow one */
+    sum += 1.0 / MAX (stream->fragment_bitrates[i], 1);
+  }
+
+  if (n_samples == 0)
+    return 0;
+
+  return n_samples / sum;
+}
+
+/* must be called with manifest_lock taken.
+ *
+ * Returns how much data of @stream is buffered ahead of the current
+ * playback position, or GST_CLOCK_TIME_NONE if it is unknown */
+static GstClockTime
+gst_adaptive_demux_stream_get_buffer_level (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstClock *clock;
+  GstClockTime now, position;
+
+  if (GST_STATE (demux) != GST_STATE_PLAYING || demux->segment.rate != 1.0)
+    return GST_CLOCK_TIME_NONE;
+
+  clock = gst_element_get_clock (GST_ELEMENT_CAST (demux));
+  if (clock == NULL)
+    return GST_CLOCK_TIME_NONE;
+
+  now = gst_clock_get_time (clock);
+  gst_object_unref (clock);
+  if (now < gst_element_get_base_time (GST_ELEMENT_CAST (demux)))
+    return GST_CLOCK_TIME_NONE;
+  now -= gst_element_get_base_time (GST_ELEMENT_CAST (demux));
+
+  GST_ADAPTIVE_DEMUX_SEGMENT_LOCK (demux);
+  position = gst_segment_to_running_time (&stream->segment, GST_FORMAT_TIME,
+      stream->segment.position);
+  GST_ADAPTIVE_DEMUX_SEGMENT_UNLOCK (demux);
+
+  if (!GST_CLOCK_TIME_IS_VALID (position))
+    return GST_CLOCK_TIME_NONE;
+
+  return position > now ? position - now : 0;
+}
+
 /* must be called with manifest_lock taken */
 static guint64
 gst_adaptive_demux_stream_update_current_bitrate (GstAdaptiveDemux * demux,
@@ -2276,6 +2511,8 @@ gst_adaptive_demux_stream_update_current_bitrate (GstAdaptiveDemux * demux,
 {
   guint64 average_bitrate;
   guint64 fragment_bitrate;
+  guint64 estimated_bitrate;
+  gfloat bitrate_limit = demux->bitrate_limit;
 
   if (demux->connection_speed) {
     GST_LOG_OBJECT (demux, "Connection-speed is set to %u kbps, using it",
@@ -2296,12 +2533,48 @@ gst_adaptive_demux_stream_update_current_bitrate (GstAdaptiveDemux * demux,
       "Last %u fragments average bitrate is %" G_GUINT64_FORMAT,
       NUM_LOOKBACK_FRAGMENTS, average_bitrate);
 
-  /* Conservative approach, make sure we don't upgrade too fast */
-  stream->current_download_rate = MIN (average_bitrate, fragment_bitrate);
+  switch (demux->priv->bandwidth_estimator) {
+    case GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_EWMA:
+      estimated_bitrate = _update_ewma_bitrate (demux, stream,
+          fragment_bitrate);
+      break;
+    case GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_HARMONIC_MEAN:
+      estimated_bitrate = _get_harmonic_mean_bitrate (demux, stream);
+      break;
+    case GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_MOVING_AVERAGE:
+    default:
+      /* Conservative approach, make sure we don't upgrade too fast */
+      estimated_bitrate = MIN (average_bitrate, fragment_bitrate);
+      break;
+  }
+
+  GST_DEBUG_OBJECT (stream->pad, "Estimated bandwidth is %" G_GUINT64_FORMAT
+      " bps", estimated_bitrate);
+
+  if (demux->priv->buffer_target_time > 0) {
+    GstClockTime target = demux->priv->buffer_target_time;
+    GstClockTime level =
+        gst_adaptive_demux_stream_get_buffer_level (demux, stream);
+
+    if (GST_CLOCK_TIME_IS_VALID (level)) {
+      gdouble fill = MIN ((gdouble) level / target, 1.0);
+
+      /* Nearly drained: never trust more than the last measurement */
+      if (level < target / 4)
+        estimated_bitrate = MIN (estimated_bitrate, fragment_bitrate);
+
+      /* Relax the bitrate limit as the buffer fills up */
+      bitrate_limit += (1.0 - bitrate_limit) * fill;
 
-  stream->current_download_rate *= demux->bitrate_limit;
+      GST_DEBUG_OBJECT (stream->pad, "Buffer level %" GST_TIME_FORMAT
+          " of %" GST_TIME_FORMAT ", bitrate limit %0.2f",
+          GST_TIME_ARGS (level), GST_TIME_ARGS (target), bitrate_limit);
+    }
+  }
+
+  stream->current_download_rate = estimated_bitrate * bitrate_limit;
   GST_DEBUG_OBJECT (demux, "Bitrate after bitrate limit (%0.2f): %"
-      G_GUINT64_FORMAT, demux->bitrate_limit, stream->current_download_rate);
+      G_GUINT64_FORMAT, bitrate_limit, stream->current_download_rate);
 
 #if 0
   /* Debugging code, modulate the bitrate every few fragments */
@@ -3380,6 +3653,325 @@ gst_adaptive_demux_stream_download_header_fragment (GstAdaptiveDemuxStream *
   return ret;
 }
 
+static GstAdaptiveDemuxPrefetch *
+gst_adaptive_demux_prefetch_new (GstAdaptiveDemux * demux, gchar * uri,
+    gint64 range_start, gint64 range_end)
+{
+  GstAdaptiveDemuxPrefetch *prefetch = g_new0 (GstAdaptiveDemuxPrefetch, 1);
+
+  prefetch->ref_count = 1;
+  prefetch->uri = uri;
+  prefetch->range_start = range_start;
+  prefetch->range_end = range_end;
+  prefetch->download_time = GST_CLOCK_TIME_NONE;
+  prefetch->downloader = gst_uri_downloader_new ();
+  gst_uri_downloader_set_parent (prefetch->downloader,
+      GST_ELEMENT_CAST (demux));
+
+  return prefetch;
+}
+
+/* must be called with the stream's prefetch_lock taken */
+static void
+gst_adaptive_demux_prefetch_unref (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  if (--prefetch->ref_count > 0)
+    return;
+
+  g_free (prefetch->uri);
+  gst_object_unref (prefetch->downloader);
+  if (prefetch->buffer)
+    gst_buffer_unref (prefetch->buffer);
+  g_free (prefetch);
+}
+
+/* must be called with the stream's prefetch_lock taken */
+static void
+gst_adaptive_demux_prefetch_cancel (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  if (!prefetch->done) {
+    prefetch->cancelled = TRUE;
+    gst_uri_downloader_cancel (prefetch->downloader);
+  }
+  gst_adaptive_demux_prefetch_unref (prefetch);
+}
+
+static gboolean
+gst_adaptive_demux_prefetch_matches (GstAdaptiveDemuxPrefetch * prefetch,
+    const gchar * uri, gint64 range_start, gint64 range_end)
+{
+  return prefetch->range_start == range_start &&
+      prefetch->range_end == range_end && g_str_equal (prefetch->uri, uri);
+}
+
+/* runs in the stream's prefetch_pool */
+static void
+gst_adaptive_demux_prefetch_func (GstAdaptiveDemuxPrefetch * prefetch,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstFragment *download;
+  GError *err = NULL;
+
+  /* Same request as the one gst_adaptive_demux_stream_download_uri() sets
+   * up on the stream's source: keep-alive, no compression, no referer and
+   * cache allowed. Cookies and user-agent come from the http-headers
+   * context, which the downloader requests through the demuxer.
+   * A cancelled downloader returns immediately */
+  download = gst_uri_downloader_fetch_uri_with_range (prefetch->downloader,
+      prefetch->uri, NULL, FALSE, FALSE, TRUE, prefetch->range_start,
+      prefetch->range_end, &err);
+
+  g_mutex_lock (&stream->prefetch_lock);
+  if (download) {
+    prefetch->buffer = gst_fragment_get_buffer (download);
+    prefetch->download_time =
+        download->download_stop_time - download->download_start_time;
+    g_object_unref (download);
+  } else if (!prefetch->cancelled) {
+    /* The download loop fetches it again through the normal path, which
+     * handles retries and posts errors */
+    GST_WARNING_OBJECT (stream->pad, "Failed to prefetch %s: %s",
+        prefetch->uri, err ? err->message : "unknown error");
+  }
+  g_clear_error (&err);
+
+  GST_LOG_OBJECT (stream->pad, "Prefetch of %s finished (%s)", prefetch->uri,
+      prefetch->buffer ? "ok" : "failed");
+
+  prefetch->done = TRUE;
+  g_cond_broadcast (&stream->prefetch_cond);
+  gst_adaptive_demux_prefetch_unref (prefetch);
+  g_mutex_unlock (&stream->prefetch_lock);
+}
+
+/* Cancels all pending prefetches and drops the ones already downloaded.
+ * Called on seeks, bitrate switches and when the stream is stopped */
+static void
+gst_adaptive_demux_stream_clear_prefetch (GstAdaptiveDemuxStream * stream)
+{
+  g_mutex_lock (&stream->prefetch_lock);
+  if (stream->prefetch_queue) {
+    GST_DEBUG_OBJECT (stream->pad, "Dropping %u prefetched fragments",
+        g_list_length (stream->prefetch_queue));
+    g_list_free_full (stream->prefetch_queue,
+        (GDestroyNotify) gst_adaptive_demux_prefetch_cancel);
+    stream->prefetch_queue = NULL;
+  }
+  g_cond_broadcast (&stream->prefetch_cond);
+  g_mutex_unlock (&stream->prefetch_lock);
+}
+
+/* must be called with manifest_lock taken.
+ *
+ * Makes sure the fragments following the current one are being downloaded
+ * in the background, and cancels the ones that are not upcoming anymore */
+static void
+gst_adaptive_demux_stream_prefetch (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+  guint n_prefetch = demux->priv->prefetch_fragments;
+  GList *queue = NULL, *iter;
+  guint i;
+
+  if (n_prefetch == 0 || klass->stream_peek_fragment == NULL) {
+    if (stream->prefetch_queue)
+      gst_adaptive_demux_stream_clear_prefetch (stream);
+    return;
+  }
+
+  if (stream->prefetch_pool == NULL) {
+    stream->prefetch_pool =
+        g_thread_pool_new ((GFunc) gst_adaptive_demux_prefetch_func, stream,
+        n_prefetch, FALSE, NULL);
+    if (stream->prefetch_pool == NULL)
+      return;
+  } else if (g_thread_pool_get_max_threads (stream->prefetch_pool) !=
+      n_prefetch) {
+    g_thread_pool_set_max_threads (stream->prefetch_pool, n_prefetch, NULL);
+  }
+
+  g_mutex_lock (&stream->prefetch_lock);
+
+  /* The current fragment stays around until download_fragment() takes it */
+  for (iter = stream->prefetch_queue; iter; iter = iter->next) {
+    GstAdaptiveDemuxPrefetch *prefetch = iter->data;
+
+    if (gst_adaptive_demux_prefetch_matches (prefetch, stream->fragment.uri,
+            stream->fragment.range_start, stream->fragment.range_end)) {
+      stream->prefetch_queue = g_list_delete_link (stream->prefetch_queue,
+          iter);
+      queue = g_list_append (queue, prefetch);
+      break;
+    }
+  }
+
+  for (i = 1; i <= n_prefetch; i++) {
+    GstAdaptiveDemuxPrefetch *prefetch = NULL;
+    gchar *uri = NULL;
+    gint64 range_start = 0, range_end = -1;
+
+    if (!klass->stream_peek_fragment (stream, i, &uri, &range_start,
+            &range_end))
+      break;
+
+    for (iter = stream->prefetch_queue; iter; iter = iter->next) {
+      if (gst_adaptive_demux_prefetch_matches (iter->data, uri, range_start,
+              range_end)) {
+        prefetch = iter->data;
+        stream->prefetch_queue =
+            g_list_delete_link (stream->prefetch_queue, iter);
+        break;
+      }
+    }
+
+    if (prefetch) {
+      g_free (uri);
+    } else {
+      GST_DEBUG_OBJECT (stream->pad, "Prefetching fragment +%u: %s %"
+          G_GINT64_FORMAT "-%" G_GINT64_FORMAT, i, uri, range_start,
+          range_end);
+      prefetch =
+          gst_adaptive_demux_prefetch_new (demux, uri, range_start, range_end);
+      /* one reference for the queue, one for the download */
+      prefetch->ref_count++;
+      g_thread_pool_push (stream->prefetch_pool, prefetch, NULL);
+    }
+    queue = g_list_append (queue, prefetch);
+  }
+
+  /* anything left is not upcoming anymore */
+  g_list_free_full (stream->prefetch_queue,
+      (GDestroyNotify) gst_adaptive_demux_prefetch_cancel);
+  stream->prefetch_queue = queue;
+
+  g_mutex_unlock (&stream->prefetch_lock);
+}
+
+/* must be called with manifest_lock taken.
+ * Can temporarily release manifest_lock
+ *
+ * Returns the prefetched data of the current fragment, waiting for its
+ * download to finish if needed, or NULL if it has to be downloaded normally */
+static GstBuffer *
+gst_adaptive_demux_stream_take_prefetched (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, GstClockTime * download_time)
+{
+  GstAdaptiveDemuxPrefetch *prefetch = NULL;
+  GstBuffer *buffer = NULL;
+  GList *iter;
+
+  g_mutex_lock (&stream->prefetch_lock);
+  for (iter = stream->prefetch_queue; iter; iter = iter->next) {
+    if (gst_adaptive_demux_prefetch_matches (iter->data, stream->fragment.uri,
+            stream->fragment.range_start, stream->fragment.range_end)) {
+      prefetch = iter->data;
+      break;
+    }
+  }
+
+  if (prefetch == NULL) {
+    g_mutex_unlock (&stream->prefetch_lock);
+    return NULL;
+  }
+
+  /* keep it in the queue while waiting so that it can still be cancelled */
+  prefetch->ref_count++;
+  if (!prefetch->done) {
+    GST_DEBUG_OBJECT (stream->pad, "Waiting for prefetch of %s",
+        prefetch->uri);
+    GST_MANIFEST_UNLOCK (demux);
+    while (!prefetch->done && !prefetch->cancelled)
+      g_cond_wait (&stream->prefetch_cond, &stream->prefetch_lock);
+    g_mutex_unlock (&stream->prefetch_lock);
+    GST_MANIFEST_LOCK (demux);
+    g_mutex_lock (&stream->prefetch_lock);
+  }
+
+  if (prefetch->done && prefetch->buffer) {
+    buffer = gst_buffer_ref (prefetch->buffer);
+    *download_time = prefetch->download_time;
+  } else if (prefetch->done) {
+    GST_DEBUG_OBJECT (stream->pad, "Prefetch of %s failed, downloading it "
+        "normally", prefetch->uri);
+  }
+
+  iter = g_list_find (stream->prefetch_queue, prefetch);
+  if (iter) {
+    stream->prefetch_queue = g_list_delete_link (stream->prefetch_queue, iter);
+    gst_adaptive_demux_prefetch_cancel (prefetch);
+  }
+  gst_adaptive_demux_prefetch_unref (prefetch);
+  g_mutex_unlock (&stream->prefetch_lock);
+
+  return buffer;
+}
+
+/* must be called with manifest_lock taken.
+ * Can temporarily release manifest_lock
+ *
+ * Pushes a prefetched fragment through the same path as data coming from
+ * the uri source */
+static GstFlowReturn
+gst_adaptive_demux_stream_push_prefetched (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, GstBuffer * buffer,
+    GstClockTime download_time)
+{
+  GstFlowReturn ret;
+  gsize size = gst_buffer_get_size (buffer);
+
+  GST_DEBUG_OBJECT (stream->pad, "Using prefetched fragment %s (%"
+      G_GSIZE_FORMAT " bytes)", stream->fragment.uri, size);
+
+  /* mimic what _uri_handler_probe() measures on the uri source */
+  stream->download_start_time =
+      GST_TIME_AS_USECONDS (gst_adaptive_demux_get_monotonic_time (demux));
+  stream->last_latency = 0;
+  if (GST_CLOCK_TIME_IS_VALID (download_time) && download_time > 0) {
+    stream->fragment_bytes_downloaded = size;
+    stream->last_download_time = download_time;
+    stream->last_bitrate =
+        gst_util_uint64_scale (size, 8 * GST_SECOND, download_time);
+  } else {
+    /* No usable measurement, keep the previous one. No bytes means the
+     * EWMA estimator ignores this fragment too */
+    GST_DEBUG_OBJECT (stream->pad, "No download time for prefetched "
+        "fragment, not updating the bitrate");
+    stream->fragment_bytes_downloaded = 0;
+  }
+
+  /* _src_chain() would query the (idle) uri source for the size */
+  if (stream->fragment.bitrate == 0 && stream->fragment.duration != 0) {
+    stream->fragment.bitrate = MIN (G_MAXUINT, gst_util_uint64_scale (size,
+            8 * GST_SECOND, stream->fragment.duration));
+  }
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  stream->download_finished = FALSE;
+  stream->downloading_first_buffer = TRUE;
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  GST_MANIFEST_UNLOCK (demux);
+  ret = _src_chain (stream->internal_pad, GST_OBJECT_CAST (demux), buffer);
+  if (ret == GST_FLOW_OK)
+    _src_event (stream->internal_pad, GST_OBJECT_CAST (demux),
+        gst_event_new_eos ());
+  GST_MANIFEST_LOCK (demux);
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  if (G_UNLIKELY (stream->cancelled)) {
+    g_mutex_unlock (&stream->fragment_download_lock);
+    return stream->last_ret = GST_FLOW_FLUSHING;
+  }
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  if (ret != GST_FLOW_OK && ret != GST_FLOW_EOS
+      && stream->last_ret == GST_FLOW_OK)
+    stream->last_ret = ret;
+
+  return stream->last_ret;
+}
+
 /* must be called with manifest_lock taken.
  * Can temporarily release manifest_lock
  */
@@ -3399,6 +3991,7 @@ gst_adaptive_demux_stream_download_fragment (GstAdaptiveDemuxStream * stream)
   stream->starting_fragment = TRUE;
   stream->last_ret = GST_FLOW_OK;
   stream->first_fragment_buffer = TRUE;
+  stream->fragment_prefetched = FALSE;
 
   GST_DEBUG_OBJECT (stream->pad, "Downloading %s%s%s",
       stream->fragment.uri ? "FRAGMENT " : "",
@@ -3498,9 +4091,32 @@ again:
         chunk_end = MIN (chunk_end, range_end);
     }
   } else {
-    ret =
-        gst_adaptive_demux_stream_download_uri (demux, stream, url,
-        stream->fragment.range_start, stream->fragment.range_end, &http_status);
+    GstBuffer *prefetched = NULL;
+    GstClockTime download_time = GST_CLOCK_TIME_NONE;
+
+    gst_adaptive_demux_stream_prefetch (demux, stream);
+    if (demux->priv->prefetch_fragments > 0 && klass->stream_peek_fragment
+        && stream->internal_pad) {
+      prefetched = gst_adaptive_demux_stream_take_prefetched (demux, stream,
+          &download_time);
+      if (prefetched)
+        stream->prefetch_hits++;
+      else
+        stream->prefetch_misses++;
+      GST_LOG_OBJECT (stream->pad, "Prefetch hits %u, misses %u",
+          stream->prefetch_hits, stream->prefetch_misses);
+    }
+
+    if (prefetched) {
+      stream->fragment_prefetched = TRUE;
+      ret = gst_adaptive_demux_stream_push_prefetched (demux, stream,
+          prefetched, download_time);
+    } else {
+      ret =
+          gst_adaptive_demux_stream_download_uri (demux, stream, url,
+          stream->fragment.range_start, stream->fragment.range_end,
+          &http_status);
+    }
     GST_DEBUG_OBJECT (stream->pad, "Fragment download result: %d (%d) %s",
         stream->last_ret, http_status, gst_flow_get_name (stream->last_ret));
   }
@@ -4246,7 +4862,11 @@ gst_adaptive_demux_stream_advance_fragment_unlocked (GstAdaptiveDemux * demux,
               "fragment-stop-time", GST_TYPE_CLOCK_TIME,
               gst_util_get_timestamp (), "fragment-size", G_TYPE_UINT64,
               stream->download_total_bytes, "fragment-download-time",
-              GST_TYPE_CLOCK_TIME, stream->last_download_time, NULL)));
+              GST_TYPE_CLOCK_TIME, stream->last_download_time,
+              "fragment-prefetched", G_TYPE_BOOLEAN,
+              stream->fragment_prefetched, "prefetch-hits", G_TYPE_UINT,
+              stream->prefetch_hits, "prefetch-misses", G_TYPE_UINT,
+              stream->prefetch_misses, NULL)));
 
   /* Don't update to the end of the segment if in reverse playback */
   GST_ADAPTIVE_DEMUX_SEGMENT_LOCK (demux);
@@ -4288,6 +4908,8 @@ gst_adaptive_demux_stream_advance_fragment_unlocked (GstAdaptiveDemux * demux,
   if (ret == GST_FLOW_OK) {
     if (gst_adaptive_demux_stream_select_bitrate (demux, stream,
             gst_adaptive_demux_stream_update_current_bitrate (demux, stream))) {
+      /* the upcoming fragments now come from another representation */
+      gst_adaptive_demux_stream_clear_prefetch (stream);
       stream->need_header = TRUE;
       ret = (GstFlowReturn) GST_ADAPTIVE_DEMUX_FLOW_SWITCH;
     }
@@ -183,6 +183,8 @@ struct _GstAdaptiveDemuxStream
   guint64 moving_bitrate;
   guint moving_index;
   guint64 *fragment_bitrates;
+  /* Byte-weighted exponential moving average of the download rate */
+  guint64 ewma_bitrate;
 
   /* QoS data */
   GstClockTime qos_earliest_time;
@@ -195,6 +197,15 @@ struct _GstAdaptiveDemuxStream
   gboolean eos;
 
   gboolean do_block; /* TRUE if stream should block on preroll */
+
+  /* fragment prefetching */
+  GMutex prefetch_lock;
+  GCond prefetch_cond;
+  GList *prefetch_queue;        /* protected by prefetch_lock */
+  GThreadPool *prefetch_pool;
+  gboolean fragment_prefetched;
+  guint prefetch_hits;
+  guint prefetch_misses;
 };
 
 /**
@@ -482,6 +493,27 @@ struct _GstAdaptiveDemuxClass
    * Return: %TRUE if the playlist needs to be refreshed periodically by the demuxer.
    */
   gboolean (*requires_periodical_playlist_update) (GstAdaptiveDemux * demux);
+
+  /**
+   * stream_peek_fragment:
+   * @stream: #GstAdaptiveDemuxStream
+   * @offset: position of the fragment relative to the current one, 1 being
+   *          the fragment that will be downloaded next
+   * @uri: (out) (transfer full): location to store the fragment URI
+   * @range_start: (out): location to store the start of the byte range
+   * @range_end: (out): location to store the (inclusive) end of the byte
+   *             range, or -1
+   *
+   * Optional. Looks up an upcoming fragment without advancing the stream so
+   * that the base class can fetch it ahead of time when the
+   * #GstAdaptiveDemux:prefetch-fragments property is set.
+   *
+   * Return: %TRUE if the fragment is known and can be prefetched.
+   *
+   * Since: 1.20
+   */
+  gboolean (*stream_peek_fragment) (GstAdaptiveDemuxStream * stream, guint offset,
+      gchar ** uri, gint64 * range_start, gint64 * range_end);
 };
 
 GST_ADAPTIVE_DEMUX_API
@@ -42,6 +42,11 @@ static gboolean initialized = FALSE;
     initialized = TRUE; \
   }
 
+/* Upper bound for the number of samples of a trun that has no per-sample
+ * fields, and hence nothing in the box itself to check sample_count
+ * against. Way more than any sane fragment contains */
+#define GST_ISOFF_MAX_TRUN_DEFAULT_SAMPLES (1 << 20)
+
 static const guint8 tfrf_uuid[] = {
   0xd4, 0x80, 0x7e, 0xf2, 0xca, 0x39, 0x46, 0x95,
   0x8e, 0x54, 0x26, 0xcb, 0x9e, 0x46, 0xa7, 0x9f
@@ -203,6 +208,7 @@ gst_isoff_tfhd_box_parse (GstTfhdBox * tfhd, GstByteReader * reader)
 static gboolean
 gst_isoff_trun_box_parse (GstTrunBox * trun, GstByteReader * reader)
 {
+  guint sample_size = 0;
   gint i;
 
   memset (trun, 0, sizeof (*trun));
@@ -219,10 +225,6 @@ gst_isoff_trun_box_parse (GstTrunBox * trun, GstByteReader * reader)
   if (!gst_byte_reader_get_uint32_be (reader, &trun->sample_count))
     return FALSE;
 
-  trun->samples =
-      g_array_sized_new (FALSE, FALSE, sizeof (GstTrunSample),
-      trun->sample_count);
-
   if ((trun->flags & GST_TRUN_FLAGS_DATA_OFFSET_PRESENT) &&
       !gst_byte_reader_get_uint32_be (reader, (guint32 *) & trun->data_offset))
     return FALSE;
@@ -231,34 +233,53 @@ gst_isoff_trun_box_parse (GstTrunBox * trun, GstByteReader * reader)
       !gst_byte_reader_get_uint32_be (reader, &trun->first_sample_flags))
     return FALSE;
 
-  for (i = 0; i < trun->sample_count; i++) {
-    GstTrunSample sample = { 0, };
+  if (trun->flags & GST_TRUN_FLAGS_SAMPLE_DURATION_PRESENT)
+    sample_size += 4;
+  if (trun->flags & GST_TRUN_FLAGS_SAMPLE_SIZE_PRESENT)
+    sample_size += 4;
+  if (trun->flags & GST_TRUN_FLAGS_SAMPLE_FLAGS_PRESENT)
+    sample_size += 4;
+  if (trun->flags & GST_TRUN_FLAGS_SAMPLE_COMPOSITION_TIME_OFFSETS_PRESENT)
+    sample_size += 4;
+
+  /* Check the whole sample table is there before allocating it, so that a
+   * bogus sample_count can't make us allocate huge amounts of memory, and so
+   * that the samples can be read without further bounds checks. Without any
+   * per-sample fields all samples use the tfhd defaults, and sample_count
+   * can only be checked against a fixed maximum */
+  if (sample_size > 0) {
+    if (gst_byte_reader_get_remaining (reader) / sample_size <
+        trun->sample_count)
+      return FALSE;
+  } else if (trun->sample_count > GST_ISOFF_MAX_TRUN_DEFAULT_SAMPLES) {
+    GST_WARNING ("trun without sample table has too many samples: %u",
+        trun->sample_count);
+    return FALSE;
+  }
 
-    if ((trun->flags & GST_TRUN_FLAGS_SAMPLE_DURATION_PRESENT) &&
-        !gst_byte_reader_get_uint32_be (reader, &sample.sample_duration))
-      goto error;
+  trun->samples =
+      g_array_sized_new (FALSE, TRUE, sizeof (GstTrunSample),
+      trun->sample_count);
+  g_array_set_size (trun->samples, trun->sample_count);
 
-    if ((trun->flags & GST_TRUN_FLAGS_SAMPLE_SIZE_PRESENT) &&
-        !gst_byte_reader_get_uint32_be (reader, &sample.sample_size))
-      goto error;
+  for (i = 0; i < trun->sample_count; i++) {
+    GstTrunSample *sample = &g_array_index (trun->samples, GstTrunSample, i);
 
-    if ((trun->flags & GST_TRUN_FLAGS_SAMPLE_FLAGS_PRESENT) &&
-        !gst_byte_reader_get_uint32_be (reader, &sample.sample_flags))
-      goto error;
+    if (trun->flags & GST_TRUN_FLAGS_SAMPLE_DURATION_PRESENT)
+      sample->sample_duration = gst_byte_reader_get_uint32_be_unchecked (reader);
 
-    if ((trun->flags & GST_TRUN_FLAGS_SAMPLE_COMPOSITION_TIME_OFFSETS_PRESENT)
-        && !gst_byte_reader_get_uint32_be (reader,
-            &sample.sample_composition_time_offset.u))
-      goto error;
+    if (trun->flags & GST_TRUN_FLAGS_SAMPLE_SIZE_PRESENT)
+      sample->sample_size = gst_byte_reader_get_uint32_be_unchecked (reader);
 
-    g_array_append_val (trun->samples, sample);
+    if (trun->flags & GST_TRUN_FLAGS_SAMPLE_FLAGS_PRESENT)
+      sample->sample_flags = gst_byte_reader_get_uint32_be_unchecked (reader);
+
+    if (trun->flags & GST_TRUN_FLAGS_SAMPLE_COMPOSITION_TIME_OFFSETS_PRESENT)
+      sample->sample_composition_time_offset.u =
+          gst_byte_reader_get_uint32_be_unchecked (reader);
   }
 
   return TRUE;
-
-error:
-  gst_isoff_trun_box_clear (trun);
-  return FALSE;
 }
 
 static gboolean
@@ -926,50 +947,110 @@ gst_isoff_sidx_parser_parse (GstSidxParser * parser,
   return res;
 }
 
+/* Parses as many complete records as possible from the memory of @buffer
+ * starting at @offset, without merging memories. Records that straddle a
+ * memory boundary are copied into a small scratch area first. */
+static GstIsoffParserResult
+gst_isoff_sidx_parser_parse_memories (GstSidxParser * parser,
+    GstBuffer * buffer, gsize offset, guint * consumed)
+{
+  GstIsoffParserResult res = GST_ISOFF_PARSER_OK;
+  gsize size = gst_buffer_get_size (buffer);
+
+  while (offset < size) {
+    GstByteReader reader;
+    GstMemory *mem;
+    GstMapInfo info;
+    guint idx, length;
+    gsize skip, avail;
+    guint8 scratch[64];
+    gsize scratch_size;
+    guint used = 0;
+
+    if (!gst_buffer_find_memory (buffer, offset, 1, &idx, &length, &skip))
+      break;
+
+    mem = gst_buffer_peek_memory (buffer, idx);
+    if (!gst_memory_map (mem, &info, GST_MAP_READ)) {
+      res = GST_ISOFF_PARSER_ERROR;
+      break;
+    }
+
+    avail = info.size - skip;
+    gst_byte_reader_init (&reader, info.data + skip, avail);
+    res = gst_isoff_sidx_parser_parse (parser, &reader, &used);
+    gst_memory_unmap (mem, &info);
+    offset += used;
+
+    if (res != GST_ISOFF_PARSER_OK)
+      break;
+    if (used == avail)
+      continue;
+
+    /* The next record continues in the following memory */
+    scratch_size = gst_buffer_extract (buffer, offset, scratch,
+        sizeof (scratch));
+    if (scratch_size <= avail - used)
+      break;
+
+    gst_byte_reader_init (&reader, scratch, scratch_size);
+    res = gst_isoff_sidx_parser_parse (parser, &reader, &used);
+    offset += used;
+    if (res != GST_ISOFF_PARSER_OK || used == 0)
+      break;
+  }
+
+  *consumed = offset;
+
+  return res;
+}
+
+/* gst_isoff_sidx_parser_add_buffer:
+ * @parser: a #GstSidxParser
+ * @buffer: data following the data consumed by previous calls
+ * @consumed: (out): number of bytes of @buffer that were consumed
+ *
+ * Parses as much of a sidx box as possible from @buffer. Parsing resumes
+ * from where the previous call stopped, so the box can be fed in pieces as
+ * it arrives; bytes that were not consumed must be passed again, followed by
+ * more data. @buffer may consist of several memories, which are parsed in
+ * place without being merged.
+ *
+ * Returns: %GST_ISOFF_PARSER_DONE once all entries were parsed
+ */
 GstIsoffParserResult
 gst_isoff_sidx_parser_add_buffer (GstSidxParser * parser, GstBuffer * buffer,
     guint * consumed)
 {
   GstIsoffParserResult res = GST_ISOFF_PARSER_OK;
   GstByteReader reader;
-  GstMapInfo info;
+  guint8 header[32 + 4];
+  gsize header_size;
   guint32 fourcc;
 
   INITIALIZE_DEBUG_CATEGORY;
-  if (!gst_buffer_map (buffer, &info, GST_MAP_READ)) {
-    *consumed = 0;
-    return GST_ISOFF_PARSER_ERROR;
-  }
+  *consumed = 0;
 
-  gst_byte_reader_init (&reader, info.data, info.size);
+  if (parser->status != GST_ISOFF_SIDX_PARSER_INIT)
+    return gst_isoff_sidx_parser_parse_memories (parser, buffer, 0, consumed);
 
-  if (parser->status == GST_ISOFF_SIDX_PARSER_INIT) {
-    if (!gst_isoff_parse_box_header (&reader, &fourcc, NULL, NULL,
-            &parser->size))
-      goto done;
+  header_size = gst_buffer_extract (buffer, 0, header, sizeof (header));
+  gst_byte_reader_init (&reader, header, header_size);
 
-    if (fourcc != GST_ISOFF_FOURCC_SIDX) {
-      res = GST_ISOFF_PARSER_UNEXPECTED;
-      gst_byte_reader_set_pos (&reader, 0);
-      goto done;
-    }
+  if (!gst_isoff_parse_box_header (&reader, &fourcc, NULL, NULL,
+          &parser->size))
+    return res;
 
-    if (parser->size == 0) {
-      res = GST_ISOFF_PARSER_ERROR;
-      gst_byte_reader_set_pos (&reader, 0);
-      goto done;
-    }
+  if (fourcc != GST_ISOFF_FOURCC_SIDX)
+    return GST_ISOFF_PARSER_UNEXPECTED;
 
-    /* Try again once we have enough data for the FullBox header */
-    if (gst_byte_reader_get_remaining (&reader) < 4) {
-      gst_byte_reader_set_pos (&reader, 0);
-      goto done;
-    }
-  }
+  if (parser->size == 0)
+    return GST_ISOFF_PARSER_ERROR;
 
-  res = gst_isoff_sidx_parser_parse (parser, &reader, consumed);
+  /* Try again once we have enough data for the FullBox header */
+  if (gst_byte_reader_get_remaining (&reader) < 4)
+    return res;
 
-done:
-  gst_buffer_unmap (buffer, &info);
-  return res;
+  return gst_isoff_sidx_parser_parse_memories (parser, buffer,
+      gst_byte_reader_get_pos (&reader), consumed);
 }
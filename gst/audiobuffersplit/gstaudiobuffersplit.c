@@ -394,6 +394,8 @@ gst_audio_buffer_split_output (GstAudioBufferSplit * self, gboolean force,
   gint size, avail;
   GstFlowReturn ret = GST_FLOW_OK;
   GstClockTime resync_pts;
+  GstBufferList *list = NULL;
+  GstBuffer *pending = NULL;
 
   resync_pts = self->resync_pts;
   size = samples_per_buffer * bpf;
@@ -410,7 +412,9 @@ gst_audio_buffer_split_output (GstAudioBufferSplit * self, gboolean force,
     GstClockTime resync_time_diff;
 
     size = MIN (size, avail);
-    buffer = gst_adapter_take_buffer (self->adapter, size);
+    /* Output buffers spanning multiple input buffers just reference the
+     * memories of both instead of merging them */
+    buffer = gst_adapter_take_buffer_fast (self->adapter, size);
     buffer = gst_buffer_make_writable (buffer);
 
     /* After a reset we have to set the discont flag */
@@ -457,9 +461,14 @@ gst_audio_buffer_split_output (GstAudioBufferSplit * self, gboolean force,
         GST_TIME_ARGS (GST_BUFFER_PTS (buffer)),
         GST_TIME_ARGS (GST_BUFFER_DURATION (buffer)), size / bpf);
 
-    ret = gst_pad_push (self->srcpad, buffer);
-    if (ret != GST_FLOW_OK)
-      break;
+    /* Everything produced from one input buffer is pushed downstream at
+     * once, as a buffer list if there is more than one output buffer */
+    if (pending) {
+      if (!list)
+        list = gst_buffer_list_new ();
+      gst_buffer_list_add (list, pending);
+    }
+    pending = buffer;
 
     /* Update the size based on the accumulated error we have now after
      * taking out a buffer. Same code as above */
@@ -469,6 +478,13 @@ gst_audio_buffer_split_output (GstAudioBufferSplit * self, gboolean force,
       size += bpf;
   }
 
+  if (list) {
+    gst_buffer_list_add (list, pending);
+    ret = gst_pad_push_list (self->srcpad, list);
+  } else if (pending) {
+    ret = gst_pad_push (self->srcpad, pending);
+  }
+
   return ret;
 }
 
@@ -21,10 +21,17 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include <gst/gst.h>
 #include <gst/base/gstbasesink.h>
+#include <gst/video/video.h>
 #include "gstchecksumsink.h"
 
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
 static void gst_checksum_sink_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_checksum_sink_get_property (GObject * object, guint prop_id,
@@ -34,6 +41,7 @@ static void gst_checksum_sink_finalize (GObject * object);
 
 static gboolean gst_checksum_sink_start (GstBaseSink * sink);
 static gboolean gst_checksum_sink_stop (GstBaseSink * sink);
+static gboolean gst_checksum_sink_set_caps (GstBaseSink * sink, GstCaps * caps);
 static GstFlowReturn
 gst_checksum_sink_render (GstBaseSink * sink, GstBuffer * buffer);
 
@@ -41,8 +49,17 @@ enum
 {
   PROP_0,
   PROP_HASH,
+  PROP_PLANES,
+  PROP_POST_MESSAGES,
 };
 
+#define DEFAULT_HASH G_CHECKSUM_SHA1
+#define DEFAULT_PLANES FALSE
+#define DEFAULT_POST_MESSAGES FALSE
+
+/* Not a GChecksumType, keep clear of the GLib values */
+#define GST_CHECKSUM_SINK_HASH_CRC32C 0x100
+
 static GstStaticPadTemplate gst_checksum_sink_sink_template =
 GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -63,6 +80,8 @@ gst_checksum_sink_hash_get_type (void)
       {G_CHECKSUM_SHA1, "SHA-1", "sha1"},
       {G_CHECKSUM_SHA256, "SHA-256", "sha256"},
       {G_CHECKSUM_SHA512, "SHA-512", "sha512"},
+      {GST_CHECKSUM_SINK_HASH_CRC32C, "CRC-32C (non-cryptographic)",
+          "crc32c"},
       {0, NULL, NULL},
     };
 
@@ -87,6 +106,7 @@ gst_checksum_sink_class_init (GstChecksumSinkClass * klass)
   gobject_class->finalize = gst_checksum_sink_finalize;
   base_sink_class->start = GST_DEBUG_FUNCPTR (gst_checksum_sink_start);
   base_sink_class->stop = GST_DEBUG_FUNCPTR (gst_checksum_sink_stop);
+  base_sink_class->set_caps = GST_DEBUG_FUNCPTR (gst_checksum_sink_set_caps);
   base_sink_class->render = GST_DEBUG_FUNCPTR (gst_checksum_sink_render);
 
   gst_element_class_add_static_pad_template (element_class,
@@ -94,9 +114,37 @@ gst_checksum_sink_class_init (GstChecksumSinkClass * klass)
 
   g_object_class_install_property (gobject_class, PROP_HASH,
       g_param_spec_enum ("hash", "Hash", "Checksum type",
-          gst_checksum_sink_hash_get_type (), G_CHECKSUM_SHA1,
+          gst_checksum_sink_hash_get_type (), DEFAULT_HASH,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstChecksumSink:planes:
+   *
+   * For raw video, compute one checksum per plane over the visible pixels
+   * only, ignoring any padding at the end of the lines or planes.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PLANES,
+      g_param_spec_boolean ("planes", "Planes",
+          "Checksum each plane of raw video separately, skipping padding",
+          DEFAULT_PLANES, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstChecksumSink:post-messages:
+   *
+   * Post an element message named "checksum" for every buffer, containing
+   * the buffer "timestamp" and its "checksum". When checksumming planes
+   * separately, the message also contains a "planes" array with the
+   * checksum of each plane.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_POST_MESSAGES,
+      g_param_spec_boolean ("post-messages", "Post Messages",
+          "Post an element message for every checksummed buffer",
+          DEFAULT_POST_MESSAGES, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (element_class, "Checksum sink",
       "Debug/Sink", "Calculates a checksum for buffers",
       "David Schleef <ds@schleef.org>");
@@ -108,7 +156,9 @@ static void
 gst_checksum_sink_init (GstChecksumSink * checksumsink)
 {
   gst_base_sink_set_sync (GST_BASE_SINK (checksumsink), FALSE);
-  checksumsink->hash = G_CHECKSUM_SHA1;
+  checksumsink->hash = DEFAULT_HASH;
+  checksumsink->planes = DEFAULT_PLANES;
+  checksumsink->post_messages = DEFAULT_POST_MESSAGES;
 }
 
 static void
@@ -121,6 +171,12 @@ gst_checksum_sink_set_property (GObject * object, guint prop_id,
     case PROP_HASH:
       checksumsink->hash = g_value_get_enum (value);
       break;
+    case PROP_PLANES:
+      checksumsink->planes = g_value_get_boolean (value);
+      break;
+    case PROP_POST_MESSAGES:
+      checksumsink->post_messages = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -137,6 +193,12 @@ gst_checksum_sink_get_property (GObject * object, guint prop_id,
     case PROP_HASH:
       g_value_set_enum (value, checksumsink->hash);
       break;
+    case PROP_PLANES:
+      g_value_set_boolean (value, checksumsink->planes);
+      break;
+    case PROP_POST_MESSAGES:
+      g_value_set_boolean (value, checksumsink->post_messages);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -158,6 +220,10 @@ gst_checksum_sink_finalize (GObject * object)
 static gboolean
 gst_checksum_sink_start (GstBaseSink * sink)
 {
+  GstChecksumSink *checksumsink = GST_CHECKSUM_SINK (sink);
+
+  checksumsink->have_video_info = FALSE;
+
   return TRUE;
 }
 
@@ -167,20 +233,255 @@ gst_checksum_sink_stop (GstBaseSink * sink)
   return TRUE;
 }
 
+static gboolean
+gst_checksum_sink_set_caps (GstBaseSink * sink, GstCaps * caps)
+{
+  GstChecksumSink *checksumsink = GST_CHECKSUM_SINK (sink);
+
+  /* Not being raw video is not an error, we just checksum the whole
+   * buffer in that case */
+  checksumsink->have_video_info =
+      gst_video_info_from_caps (&checksumsink->video_info, caps);
+
+  return TRUE;
+}
+
+/* CRC-32C (Castagnoli), slicing-by-8 */
+static guint32 crc32c_table[8][256];
+
+static gpointer
+crc32c_init_table (gpointer data)
+{
+  guint32 i, j, crc;
+
+  for (i = 0; i < 256; i++) {
+    crc = i;
+    for (j = 0; j < 8; j++)
+      crc = (crc >> 1) ^ ((crc & 1) ? 0x82f63b78 : 0);
+    crc32c_table[0][i] = crc;
+  }
+
+  for (i = 0; i < 256; i++) {
+    crc = crc32c_table[0][i];
+    for (j = 1; j < 8; j++) {
+      crc = crc32c_table[0][crc & 0xff] ^ (crc >> 8);
+      crc32c_table[j][i] = crc;
+    }
+  }
+
+  return NULL;
+}
+
+static guint32
+crc32c_update (guint32 crc, const guint8 * data, gsize size)
+{
+  crc = ~crc;
+
+#ifdef __SSE4_2__
+#if GLIB_SIZEOF_VOID_P == 8
+  for (; size >= 8; size -= 8, data += 8) {
+    guint64 v;
+
+    memcpy (&v, data, 8);
+    crc = (guint32) _mm_crc32_u64 (crc, v);
+  }
+#endif
+  for (; size >= 4; size -= 4, data += 4) {
+    guint32 v;
+
+    memcpy (&v, data, 4);
+    crc = _mm_crc32_u32 (crc, v);
+  }
+  for (; size > 0; size--, data++)
+    crc = _mm_crc32_u8 (crc, *data);
+#else
+  for (; size >= 8; size -= 8, data += 8) {
+    guint32 lo = crc ^ GST_READ_UINT32_LE (data);
+    guint32 hi = GST_READ_UINT32_LE (data + 4);
+
+    crc = crc32c_table[7][lo & 0xff] ^
+        crc32c_table[6][(lo >> 8) & 0xff] ^
+        crc32c_table[5][(lo >> 16) & 0xff] ^
+        crc32c_table[4][lo >> 24] ^
+        crc32c_table[3][hi & 0xff] ^
+        crc32c_table[2][(hi >> 8) & 0xff] ^
+        crc32c_table[1][(hi >> 16) & 0xff] ^ crc32c_table[0][hi >> 24];
+  }
+  for (; size > 0; size--, data++)
+    crc = crc32c_table[0][(crc ^ *data) & 0xff] ^ (crc >> 8);
+#endif
+
+  return ~crc;
+}
+
+/* Small wrapper so that GChecksum and our own hashes can be fed
+ * incrementally, e.g. line by line */
+typedef struct
+{
+  gint hash;
+  GChecksum *checksum;
+  guint32 crc;
+} GstChecksumSinkState;
+
+static void
+gst_checksum_sink_state_init (GstChecksumSinkState * state, gint hash)
+{
+  state->hash = hash;
+  state->checksum = NULL;
+  state->crc = 0;
+
+  if (hash == GST_CHECKSUM_SINK_HASH_CRC32C) {
+    static GOnce table_once = G_ONCE_INIT;
+
+    g_once (&table_once, crc32c_init_table, NULL);
+  } else {
+    state->checksum = g_checksum_new ((GChecksumType) hash);
+  }
+}
+
+static inline void
+gst_checksum_sink_state_update (GstChecksumSinkState * state,
+    const guint8 * data, gsize size)
+{
+  if (state->checksum)
+    g_checksum_update (state->checksum, data, size);
+  else
+    state->crc = crc32c_update (state->crc, data, size);
+}
+
+/* Returns the checksum as a string and frees the state */
+static gchar *
+gst_checksum_sink_state_finish (GstChecksumSinkState * state)
+{
+  gchar *s;
+
+  if (state->checksum) {
+    s = g_strdup (g_checksum_get_string (state->checksum));
+    g_checksum_free (state->checksum);
+    state->checksum = NULL;
+  } else {
+    s = g_strdup_printf ("%08x", state->crc);
+  }
+
+  return s;
+}
+
+static gchar *
+gst_checksum_sink_compute (GstChecksumSink * checksumsink, const guint8 * data,
+    gsize size)
+{
+  GstChecksumSinkState state;
+
+  if (checksumsink->hash != GST_CHECKSUM_SINK_HASH_CRC32C)
+    return g_compute_checksum_for_data (checksumsink->hash, data, size);
+
+  gst_checksum_sink_state_init (&state, checksumsink->hash);
+  gst_checksum_sink_state_update (&state, data, size);
+  return gst_checksum_sink_state_finish (&state);
+}
+
+/* Checksums the visible part of each plane, returns a NULL-terminated array
+ * of strings, or NULL if the buffer could not be mapped as a video frame */
+static gchar **
+gst_checksum_sink_compute_planes (GstChecksumSink * checksumsink,
+    GstBuffer * buffer)
+{
+  GstVideoFrame frame;
+  const GstVideoFormatInfo *finfo;
+  gchar **planes;
+  guint n_planes, p, c, y;
+
+  if (!gst_video_frame_map (&frame, &checksumsink->video_info, buffer,
+          GST_MAP_READ))
+    return NULL;
+
+  finfo = frame.info.finfo;
+  n_planes = GST_VIDEO_FRAME_N_PLANES (&frame);
+  planes = g_new0 (gchar *, n_planes + 1);
+
+  for (p = 0; p < n_planes; p++) {
+    GstChecksumSinkState state;
+    const guint8 *data = GST_VIDEO_FRAME_PLANE_DATA (&frame, p);
+    gint stride = GST_VIDEO_FRAME_PLANE_STRIDE (&frame, p);
+    gint comp[GST_VIDEO_MAX_COMPONENTS];
+    gint height, row_size;
+
+    gst_video_format_info_component (finfo, p, comp);
+    c = comp[0];
+
+    height = GST_VIDEO_FRAME_COMP_HEIGHT (&frame, c);
+    row_size = GST_VIDEO_FRAME_COMP_WIDTH (&frame, c) *
+        GST_VIDEO_FRAME_COMP_PSTRIDE (&frame, c);
+
+    /* Complex packed or tiled formats have no pixel stride, checksum
+     * whole lines in that case */
+    if (row_size <= 0 || row_size > ABS (stride) ||
+        GST_VIDEO_FORMAT_INFO_IS_TILED (finfo))
+      row_size = ABS (stride);
+
+    gst_checksum_sink_state_init (&state, checksumsink->hash);
+    for (y = 0; y < height; y++)
+      gst_checksum_sink_state_update (&state, data + y * stride, row_size);
+    planes[p] = gst_checksum_sink_state_finish (&state);
+  }
+
+  gst_video_frame_unmap (&frame);
+
+  return planes;
+}
+
 static GstFlowReturn
 gst_checksum_sink_render (GstBaseSink * sink, GstBuffer * buffer)
 {
-  gchar *s;
-  GstMapInfo map;
+  gchar *s = NULL;
+  gchar **planes = NULL;
   GstChecksumSink *checksumsink;
 
   checksumsink = GST_CHECKSUM_SINK (sink);
-  gst_buffer_map (buffer, &map, GST_MAP_READ);
-  s = g_compute_checksum_for_data (checksumsink->hash, map.data, map.size);
-  gst_buffer_unmap (buffer, &map);
+
+  if (checksumsink->planes && checksumsink->have_video_info)
+    planes = gst_checksum_sink_compute_planes (checksumsink, buffer);
+
+  if (planes) {
+    s = g_strjoinv (" ", planes);
+  } else {
+    GstMapInfo map;
+
+    gst_buffer_map (buffer, &map, GST_MAP_READ);
+    s = gst_checksum_sink_compute (checksumsink, map.data, map.size);
+    gst_buffer_unmap (buffer, &map);
+  }
+
   g_print ("%" GST_TIME_FORMAT " %s\n",
       GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buffer)), s);
 
+  if (checksumsink->post_messages) {
+    GstStructure *st;
+
+    st = gst_structure_new ("checksum",
+        "timestamp", GST_TYPE_CLOCK_TIME, GST_BUFFER_TIMESTAMP (buffer),
+        "checksum", G_TYPE_STRING, s, NULL);
+
+    if (planes) {
+      GValue arr = G_VALUE_INIT;
+      GValue val = G_VALUE_INIT;
+      guint i;
+
+      g_value_init (&arr, GST_TYPE_ARRAY);
+      g_value_init (&val, G_TYPE_STRING);
+      for (i = 0; planes[i]; i++) {
+        g_value_set_string (&val, planes[i]);
+        gst_value_array_append_value (&arr, &val);
+      }
+      g_value_unset (&val);
+      gst_structure_take_value (st, "planes", &arr);
+    }
+
+    gst_element_post_message (GST_ELEMENT_CAST (checksumsink),
+        gst_message_new_element (GST_OBJECT_CAST (checksumsink), st));
+  }
+
+  g_strfreev (planes);
   g_free (s);
 
   return GST_FLOW_OK;
@@ -22,6 +22,7 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstbasesink.h>
+#include <gst/video/video.h>
 
 G_BEGIN_DECLS
 
@@ -37,7 +38,12 @@ typedef struct _GstChecksumSinkClass GstChecksumSinkClass;
 struct _GstChecksumSink
 {
   GstBaseSink base_checksumsink;
-  GChecksumType hash;
+  gint hash;
+  gboolean planes;
+  gboolean post_messages;
+
+  gboolean have_video_info;
+  GstVideoInfo video_info;
 };
 
 struct _GstChecksumSinkClass
@@ -124,6 +124,7 @@ gst_compare_finalize (GObject * object)
   GstCompare *comp = GST_COMPARE (object);
 
   gst_object_unref (comp->cpads);
+  g_free (comp->ssim_blocks);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -348,12 +349,20 @@ gst_compare_max (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
   return delta;
 }
 
+typedef struct
+{
+  gint count;
+  gint sum1, sum2;
+  gint ssum1, ssum2;
+  gint acov;
+} GstCompareSsimBlock;
+
+#define SSIM_WINDOW 16
+#define SSIM_BLOCK (SSIM_WINDOW / 2)
+
 static double
-gst_compare_ssim_window (GstCompare * comp, guint8 * data1, guint8 * data2,
-    gint width, gint height, gint step, gint stride)
+gst_compare_ssim_window (GstCompare * comp, const GstCompareSsimBlock * b)
 {
-  gint count = 0, i, j;
-  gint sum1 = 0, sum2 = 0, ssum1 = 0, ssum2 = 0, acov = 0;
   gdouble avg1, avg2, var1, var2, cov;
 
   const gdouble k1 = 0.01;
@@ -363,55 +372,120 @@ gst_compare_ssim_window (GstCompare * comp, guint8 * data1, guint8 * data2,
   const gdouble c2 = (k2 * L) * (k2 * L);
 
   /* For empty images, return maximum similarity */
-  if (height <= 0 || width <= 0)
+  if (b->count <= 0)
     return 1.0;
 
-  /* plain and simple; no fancy optimizations */
-  for (i = 0; i < height; i++) {
-    for (j = 0; j < width; j++) {
-      sum1 += *data1;
-      sum2 += *data2;
-      ssum1 += *data1 * *data1;
-      ssum2 += *data2 * *data2;
-      acov += *data1 * *data2;
-      count++;
-      data1 += step;
-      data2 += step;
-    }
-    data1 -= j * step;
-    data2 -= j * step;
-    data1 += stride;
-    data2 += stride;
-  }
-
-  avg1 = sum1 / count;
-  avg2 = sum2 / count;
-  var1 = ssum1 / count - avg1 * avg1;
-  var2 = ssum2 / count - avg2 * avg2;
-  cov = acov / count - avg1 * avg2;
+  avg1 = b->sum1 / b->count;
+  avg2 = b->sum2 / b->count;
+  var1 = b->ssum1 / b->count - avg1 * avg1;
+  var2 = b->ssum2 / b->count - avg2 * avg2;
+  cov = b->acov / b->count - avg1 * avg2;
 
   return (2 * avg1 * avg2 + c1) * (2 * cov + c2) /
       ((avg1 * avg1 + avg2 * avg2 + c1) * (var1 + var2 + c2));
 }
 
+static inline void
+gst_compare_ssim_block_add (GstCompareSsimBlock * dest,
+    const GstCompareSsimBlock * src)
+{
+  dest->count += src->count;
+  dest->sum1 += src->sum1;
+  dest->sum2 += src->sum2;
+  dest->ssum1 += src->ssum1;
+  dest->ssum2 += src->ssum2;
+  dest->acov += src->acov;
+}
+
+/* Accumulates the per-pixel statistics of one component into a grid of
+ * half-window sized blocks. Windows overlap by half their size, so every
+ * window is exactly the union of 2x2 neighbouring blocks (possibly clipped
+ * at the right and bottom edges) and each pixel only has to be visited
+ * once instead of once per overlapping window. */
+static void
+gst_compare_ssim_blocks (GstCompareSsimBlock * blocks, gint n_bx,
+    const guint8 * data1, const guint8 * data2, gint width, gint height,
+    gint step, gint stride)
+{
+  gint x, y;
+
+  for (y = 0; y < height; y++) {
+    GstCompareSsimBlock *row = blocks + (y / SSIM_BLOCK) * n_bx;
+    const guint8 *d1 = data1 + y * stride;
+    const guint8 *d2 = data2 + y * stride;
+
+    for (x = 0; x < width; x += SSIM_BLOCK) {
+      GstCompareSsimBlock *b = row + x / SSIM_BLOCK;
+      gint n = MIN (SSIM_BLOCK, width - x);
+      gint sum1 = 0, sum2 = 0, ssum1 = 0, ssum2 = 0, acov = 0;
+      gint k;
+
+      for (k = 0; k < n; k++) {
+        gint p1 = d1[k * step];
+        gint p2 = d2[k * step];
+
+        sum1 += p1;
+        sum2 += p2;
+        ssum1 += p1 * p1;
+        ssum2 += p2 * p2;
+        acov += p1 * p2;
+      }
+
+      b->count += n;
+      b->sum1 += sum1;
+      b->sum2 += sum2;
+      b->ssum1 += ssum1;
+      b->ssum2 += ssum2;
+      b->acov += acov;
+
+      d1 += SSIM_BLOCK * step;
+      d2 += SSIM_BLOCK * step;
+    }
+  }
+}
+
 /* @width etc are for the particular component */
 static gdouble
 gst_compare_ssim_component (GstCompare * comp, guint8 * data1, guint8 * data2,
     gint width, gint height, gint step, gint stride)
 {
-  const gint window = 16;
   gdouble ssim_sum = 0;
   gint count = 0, i, j;
+  gint n_bx, n_by;
+  GstCompareSsimBlock *blocks;
+
+  if (width <= 0 || height <= 0)
+    return 1.0;
+
+  n_bx = (width + SSIM_BLOCK - 1) / SSIM_BLOCK;
+  n_by = (height + SSIM_BLOCK - 1) / SSIM_BLOCK;
+
+  if (comp->n_ssim_blocks < n_bx * n_by) {
+    g_free (comp->ssim_blocks);
+    comp->ssim_blocks = g_new (GstCompareSsimBlock, n_bx * n_by);
+    comp->n_ssim_blocks = n_bx * n_by;
+  }
+  blocks = comp->ssim_blocks;
+  memset (blocks, 0, sizeof (GstCompareSsimBlock) * n_bx * n_by);
 
-  for (j = 0; j + (window / 2) < height; j += (window / 2)) {
-    for (i = 0; i + (window / 2) < width; i += (window / 2)) {
+  gst_compare_ssim_blocks (blocks, n_bx, data1, data2, width, height, step,
+      stride);
+
+  for (j = 0; j + SSIM_BLOCK < height; j += SSIM_BLOCK) {
+    const GstCompareSsimBlock *top = blocks + (j / SSIM_BLOCK) * n_bx;
+    const GstCompareSsimBlock *bottom = top + n_bx;
+
+    for (i = 0; i + SSIM_BLOCK < width; i += SSIM_BLOCK) {
+      GstCompareSsimBlock window = top[i / SSIM_BLOCK];
       gdouble ssim;
 
-      ssim = gst_compare_ssim_window (comp, data1 + step * i + j * stride,
-          data2 + step * i + j * stride,
-          MIN (window, width - i), MIN (window, height - j), step, stride);
-      GST_LOG_OBJECT (comp, "ssim for %dx%d at (%d, %d) = %f", window, window,
-          i, j, ssim);
+      gst_compare_ssim_block_add (&window, &top[i / SSIM_BLOCK + 1]);
+      gst_compare_ssim_block_add (&window, &bottom[i / SSIM_BLOCK]);
+      gst_compare_ssim_block_add (&window, &bottom[i / SSIM_BLOCK + 1]);
+
+      ssim = gst_compare_ssim_window (comp, &window);
+      GST_LOG_OBJECT (comp, "ssim for %dx%d at (%d, %d) = %f", SSIM_WINDOW,
+          SSIM_WINDOW, i, j, ssim);
       ssim_sum += ssim;
       count++;
     }
@@ -56,6 +56,10 @@ struct _GstCompare {
 
   gint count;
 
+  /* scratch space for ssim block statistics */
+  gpointer ssim_blocks;
+  gint n_ssim_blocks;
+
   /* properties */
   GstBufferCopyFlags meta;
   gboolean offset_ts;
@@ -127,6 +127,7 @@ gst_watchdog_class_init (GstWatchdogClass * klass)
 static void
 gst_watchdog_init (GstWatchdog * watchdog)
 {
+  watchdog->deadline = -1;
 }
 
 static void
@@ -168,50 +169,177 @@ gst_watchdog_get_property (GObject * object, guint property_id,
   }
 }
 
+/* All watchdog instances share a single thread and main context. Each
+ * instance owns one source in that context whose ready time is only moved
+ * when it has to fire earlier; feeding the watchdog just pushes its deadline
+ * forward, and the source re-schedules itself lazily when it wakes up
+ * before the deadline.
+ *
+ * The deadline and the source are protected by the object lock of each
+ * instance. The global shared_context lock is only taken when an instance
+ * starts or stops. The shared thread never posts to the bus itself, the
+ * error is posted from the element's async call thread pool so that a slow
+ * bus handler of one pipeline can't delay the watchdogs of others. */
+G_LOCK_DEFINE_STATIC (shared_context);
+static GMainContext *shared_main_context = NULL;
+static GMainLoop *shared_main_loop = NULL;
+static GThread *shared_thread = NULL;
+static guint shared_context_users = 0;
+
 static gpointer
 gst_watchdog_thread (gpointer user_data)
 {
-  GstWatchdog *watchdog = GST_WATCHDOG (user_data);
+  GMainLoop *main_loop = user_data;
 
-  GST_DEBUG_OBJECT (watchdog, "thread starting");
+  GST_DEBUG ("thread starting");
 
-  g_main_loop_run (watchdog->main_loop);
+  g_main_loop_run (main_loop);
 
-  GST_DEBUG_OBJECT (watchdog, "thread exiting");
+  GST_DEBUG ("thread exiting");
 
   return NULL;
 }
 
 static gboolean
-gst_watchdog_trigger (gpointer ptr)
+gst_watchdog_quit_mainloop (gpointer ptr)
 {
-  GstWatchdog *watchdog = GST_WATCHDOG (ptr);
+  GMainLoop *main_loop = ptr;
 
-  GST_DEBUG_OBJECT (watchdog, "watchdog triggered");
+  GST_DEBUG ("watchdog quit");
 
-  GST_ELEMENT_ERROR (watchdog, STREAM, FAILED, ("Watchdog triggered"),
-      ("Watchdog triggered"));
+  g_main_loop_quit (main_loop);
 
   return FALSE;
 }
 
+static GMainContext *
+gst_watchdog_acquire_main_context (void)
+{
+  GMainContext *context;
+
+  G_LOCK (shared_context);
+  if (shared_context_users++ == 0) {
+    shared_main_context = g_main_context_new ();
+    shared_main_loop = g_main_loop_new (shared_main_context, TRUE);
+    shared_thread = g_thread_new ("watchdog", gst_watchdog_thread,
+        shared_main_loop);
+  }
+  context = g_main_context_ref (shared_main_context);
+  G_UNLOCK (shared_context);
+
+  return context;
+}
+
+static void
+gst_watchdog_release_main_context (GMainContext * context)
+{
+  G_LOCK (shared_context);
+  g_assert (context == shared_main_context);
+  g_main_context_unref (context);
+
+  if (--shared_context_users == 0) {
+    GSource *quit_source;
+
+    /* dispatch an idle event that trigger g_main_loop_quit to avoid race
+     * between g_main_loop_run and g_main_loop_quit */
+    quit_source = g_idle_source_new ();
+    g_source_set_callback (quit_source, gst_watchdog_quit_mainloop,
+        shared_main_loop, NULL);
+    g_source_attach (quit_source, shared_main_context);
+    g_source_unref (quit_source);
+
+    g_thread_join (shared_thread);
+    shared_thread = NULL;
+
+    g_main_loop_unref (shared_main_loop);
+    shared_main_loop = NULL;
+
+    g_main_context_unref (shared_main_context);
+    shared_main_context = NULL;
+  }
+  G_UNLOCK (shared_context);
+}
+
+static void
+gst_watchdog_post_error (GstElement * element, gpointer user_data)
+{
+  GST_ELEMENT_ERROR (element, STREAM, FAILED, ("Watchdog triggered"),
+      ("Watchdog triggered"));
+}
+
 static gboolean
-gst_watchdog_quit_mainloop (gpointer ptr)
+gst_watchdog_trigger (GSource * source, GstWatchdog * watchdog)
 {
-  GstWatchdog *watchdog = GST_WATCHDOG (ptr);
+  gint64 now;
 
-  GST_DEBUG_OBJECT (watchdog, "watchdog quit");
+  GST_OBJECT_LOCK (watchdog);
+  if (g_source_is_destroyed (source)) {
+    GST_OBJECT_UNLOCK (watchdog);
+    return G_SOURCE_REMOVE;
+  }
 
-  g_main_loop_quit (watchdog->main_loop);
+  if (watchdog->deadline == -1) {
+    /* disarmed since the source was scheduled */
+    g_source_set_ready_time (source, -1);
+    GST_OBJECT_UNLOCK (watchdog);
+    return G_SOURCE_CONTINUE;
+  }
 
-  return FALSE;
+  now = g_get_monotonic_time ();
+  if (now < watchdog->deadline) {
+    /* fed since the source was scheduled */
+    g_source_set_ready_time (source, watchdog->deadline);
+    GST_OBJECT_UNLOCK (watchdog);
+    return G_SOURCE_CONTINUE;
+  }
+
+  watchdog->deadline = -1;
+  g_source_set_ready_time (source, -1);
+  GST_OBJECT_UNLOCK (watchdog);
+
+  GST_DEBUG_OBJECT (watchdog, "watchdog triggered");
+
+  gst_element_call_async (GST_ELEMENT (watchdog),
+      gst_watchdog_post_error, NULL, NULL);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+gst_watchdog_source_dispatch (GSource * source, GSourceFunc callback,
+    gpointer user_data)
+{
+  return gst_watchdog_trigger (source, GST_WATCHDOG (user_data));
+}
+
+static GSourceFuncs gst_watchdog_source_funcs = {
+  NULL,                         /* prepare */
+  NULL,                         /* check */
+  gst_watchdog_source_dispatch,
+  NULL,                         /* finalize */
+};
+
+/*  Call with OBJECT_LOCK taken */
+static void
+gst_watchdog_arm (GstWatchdog * watchdog)
+{
+  gint64 ready_time;
+
+  watchdog->deadline = g_get_monotonic_time () +
+      (gint64) watchdog->timeout * G_TIME_SPAN_MILLISECOND;
+
+  /* Only touch the source if it has to wake up earlier than currently
+   * scheduled, otherwise it will notice the new deadline when it wakes up */
+  ready_time = g_source_get_ready_time (watchdog->source);
+  if (ready_time == -1 || ready_time > watchdog->deadline)
+    g_source_set_ready_time (watchdog->source, watchdog->deadline);
 }
 
 /*  Call with OBJECT_LOCK taken */
 static void
 gst_watchdog_feed (GstWatchdog * watchdog, gpointer mini_object, gboolean force)
 {
-  if (watchdog->source) {
+  if (watchdog->deadline != -1) {
     if (watchdog->waiting_for_flush_start) {
       if (mini_object && GST_IS_EVENT (mini_object) &&
           GST_EVENT_TYPE (mini_object) == GST_EVENT_FLUSH_START) {
@@ -238,24 +366,20 @@ gst_watchdog_feed (GstWatchdog * watchdog, gpointer mini_object, gboolean force)
         force = TRUE;
       }
     }
-    g_source_destroy (watchdog->source);
-    g_source_unref (watchdog->source);
-    watchdog->source = NULL;
 
+    /* disarmed lazily, the source notices when it wakes up */
+    watchdog->deadline = -1;
   }
 
   if (watchdog->timeout == 0) {
     GST_LOG_OBJECT (watchdog, "Timeout is 0 => nothing to do");
-  } else if (watchdog->main_context == NULL) {
-    GST_LOG_OBJECT (watchdog, "No maincontext => nothing to do");
+  } else if (watchdog->source == NULL) {
+    GST_LOG_OBJECT (watchdog, "No source => nothing to do");
   } else if ((GST_STATE (watchdog) != GST_STATE_PLAYING) && force == FALSE) {
     GST_LOG_OBJECT (watchdog,
         "Not in playing and force is FALSE => Nothing to do");
   } else {
-    watchdog->source = g_timeout_source_new (watchdog->timeout);
-    g_source_set_callback (watchdog->source, gst_watchdog_trigger,
-        gst_object_ref (watchdog), gst_object_unref);
-    g_source_attach (watchdog->source, watchdog->main_context);
+    gst_watchdog_arm (watchdog);
   }
 }
 
@@ -267,9 +391,14 @@ gst_watchdog_start (GstBaseTransform * trans)
   GST_DEBUG_OBJECT (watchdog, "start");
   GST_OBJECT_LOCK (watchdog);
 
-  watchdog->main_context = g_main_context_new ();
-  watchdog->main_loop = g_main_loop_new (watchdog->main_context, TRUE);
-  watchdog->thread = g_thread_new ("watchdog", gst_watchdog_thread, watchdog);
+  watchdog->main_context = gst_watchdog_acquire_main_context ();
+  watchdog->deadline = -1;
+  watchdog->source = g_source_new (&gst_watchdog_source_funcs,
+      sizeof (GSource));
+  g_source_set_name (watchdog->source, "GstWatchdog");
+  g_source_set_callback (watchdog->source, NULL, gst_object_ref (watchdog),
+      gst_object_unref);
+  g_source_attach (watchdog->source, watchdog->main_context);
 
   GST_OBJECT_UNLOCK (watchdog);
   return TRUE;
@@ -279,35 +408,26 @@ static gboolean
 gst_watchdog_stop (GstBaseTransform * trans)
 {
   GstWatchdog *watchdog = GST_WATCHDOG (trans);
-  GSource *quit_source;
+  GMainContext *main_context;
 
   GST_DEBUG_OBJECT (watchdog, "stop");
   GST_OBJECT_LOCK (watchdog);
 
+  watchdog->deadline = -1;
   if (watchdog->source) {
     g_source_destroy (watchdog->source);
     g_source_unref (watchdog->source);
     watchdog->source = NULL;
   }
 
-  /* dispatch an idle event that trigger g_main_loop_quit to avoid race
-   * between g_main_loop_run and g_main_loop_quit */
-  quit_source = g_idle_source_new ();
-  g_source_set_callback (quit_source, gst_watchdog_quit_mainloop, watchdog,
-      NULL);
-  g_source_attach (quit_source, watchdog->main_context);
-  g_source_unref (quit_source);
-
-  g_thread_join (watchdog->thread);
-  watchdog->thread = NULL;
-
-  g_main_loop_unref (watchdog->main_loop);
-  watchdog->main_loop = NULL;
-
-  g_main_context_unref (watchdog->main_context);
+  main_context = watchdog->main_context;
   watchdog->main_context = NULL;
 
   GST_OBJECT_UNLOCK (watchdog);
+
+  if (main_context)
+    gst_watchdog_release_main_context (main_context);
+
   return TRUE;
 }
 
@@ -405,11 +525,7 @@ gst_watchdog_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
       /* Disable the timer */
       GST_OBJECT_LOCK (watchdog);
-      if (watchdog->source) {
-        g_source_destroy (watchdog->source);
-        g_source_unref (watchdog->source);
-        watchdog->source = NULL;
-      }
+      watchdog->deadline = -1;
       GST_OBJECT_UNLOCK (watchdog);
       break;
     default:
@@ -42,9 +42,9 @@ struct _GstWatchdog
   int timeout;
 
   GMainContext *main_context;
-  GMainLoop *main_loop;
-  GThread *thread;
   GSource *source;
+  /* monotonic time at which the watchdog fires, -1 when disarmed */
+  gint64 deadline;
 
   gboolean waiting_for_a_buffer;
   gboolean waiting_for_flush_start;
@@ -22,13 +22,13 @@
 #endif
 
 #include <stdlib.h>
+#include <string.h>
 
 //#define HACK_2BIT /* Force 2-bit output by discarding colours */
 //#define HACK_4BIT /* Force 4-bit output by discarding colours */
 
 #include "gstdvbsubenc.h"
 #include <gst/base/gstbytewriter.h>
-#include <gst/base/gstbitwriter.h>
 
 #include "libimagequant/libimagequant.h"
 
@@ -53,21 +53,19 @@ enum DVBPixelDataType
   DVB_PIXEL_DATA_TYPE_END_OF_LINE = 0xF0
 };
 
-struct HistogramEntry
-{
-  guint32 colour;
-  guint32 count;
-  guint32 substitution;
-};
+/* Size of the open-addressing table used to collect the colours of images
+ * that already fit in the requested palette. Must be a power of two and
+ * comfortably larger than the 256 colour maximum */
+#define EXACT_PALETTE_TABLE_SIZE 1024
 
-struct ColourEntry
+struct ColourTableEntry
 {
   guint32 colour;
-  guint32 pix_index;
+  guint16 index;
+  gboolean used;
 };
 
-typedef struct HistogramEntry HistogramEntry;
-typedef struct ColourEntry ColourEntry;
+typedef struct ColourTableEntry ColourTableEntry;
 
 static gint
 compare_uint32 (gconstpointer a, gconstpointer b)
@@ -83,13 +81,10 @@ compare_uint32 (gconstpointer a, gconstpointer b)
 }
 
 static gint
-compare_colour_entry_colour (gconstpointer a, gconstpointer b)
+compare_colour_reverse (gconstpointer a, gconstpointer b)
 {
-  const ColourEntry *c1 = (ColourEntry *) (a);
-  const ColourEntry *c2 = (ColourEntry *) (b);
-
   /* Reverse order, so highest alpha comes first: */
-  return compare_uint32 (&c2->colour, &c1->colour);
+  return compare_uint32 (b, a);
 }
 
 static void
@@ -120,281 +115,312 @@ image_get_rgba_row_callback (liq_color row_out[], int row_index, int width,
   }
 }
 
-/*
- * Utility function to unintelligently extract a
- * (max) 256 colour image from an AYUV input
- * Dumb for now, but could be improved if needed. If there's
- * more than 256 colours in the input, it will reduce it 256
- * by taking the most common 255 colours + transparent and mapping all
- * remaining colours to the nearest neighbour.
+/* Try to map the source image directly onto a palette of at most
+ * max_colours entries. Rendered subtitles usually only contain a handful
+ * of colours, in which case no quantisation is needed at all.
  *
- * FIXME: Integrate a better palette selection algorithm.
- */
-gboolean
-gst_dvbsubenc_ayuv_to_ayuv8p (GstVideoFrame * src, GstVideoFrame * dest,
+ * Colours are collected in a small hash table while the pixel indices are
+ * written to the destination in order of first appearance. As soon as
+ * the image turns out to have too many colours, FALSE is returned and the
+ * caller has to quantise instead. Otherwise the palette is sorted by
+ * descending AYUV value (so highest alpha comes first) and the
+ * destination indices are remapped accordingly. */
+static gboolean
+ayuv_to_ayuv8p_exact (GstVideoFrame * src, GstVideoFrame * dest,
     int max_colours, guint32 * out_num_colours)
 {
-  /* Allocate a temporary array the size of the input frame, copy in
-   * the source pixels, sort them by value and then count the first
-   * up to 256 colours. */
-  gboolean ret = FALSE;
-
-  GArray *colours, *histogram;
-  gint i, num_pixels, dest_y_index, out_index;
-  guint num_colours, cur_count;
-  guint32 last;
-  guint8 *s;
-  HistogramEntry *h;
-  ColourEntry *c;
+  ColourTableEntry *table;
+  guint32 colours[256];
+  guint32 sorted[256];
+  guint8 remap[256];
+  guint num_colours = 0;
+  gint x, y, i;
+  const gint width = GST_VIDEO_INFO_WIDTH (&src->info);
+  const gint height = GST_VIDEO_INFO_HEIGHT (&src->info);
   const guint32 src_stride = GST_VIDEO_INFO_PLANE_STRIDE (&src->info, 0);
   const guint32 dest_stride = GST_VIDEO_INFO_PLANE_STRIDE (&dest->info, 0);
+  guint8 *s = (guint8 *) (src->data[0]);
+  guint8 *d = (guint8 *) (dest->data[0]);
+  guint8 *palette = (guint8 *) (dest->data[1]);
+  gboolean ret = FALSE;
 
-  if (GST_VIDEO_INFO_FORMAT (&src->info) != GST_VIDEO_FORMAT_AYUV)
-    return FALSE;
+  max_colours = CLAMP (max_colours, 1, 256);
 
-  if (GST_VIDEO_INFO_WIDTH (&src->info) != GST_VIDEO_INFO_WIDTH (&dest->info) ||
-      GST_VIDEO_INFO_HEIGHT (&src->info) != GST_VIDEO_INFO_HEIGHT (&dest->info))
-    return FALSE;
+  table = g_new0 (ColourTableEntry, EXACT_PALETTE_TABLE_SIZE);
 
-  num_pixels =
-      GST_VIDEO_INFO_WIDTH (&src->info) * GST_VIDEO_INFO_HEIGHT (&src->info);
-  s = (guint8 *) (src->data[0]);
+  for (y = 0; y < height; y++) {
+    const guint8 *p = s;
+    guint8 *out = d;
+    /* Runs of identical pixels are common, so remember the last lookup */
+    guint32 last_colour = 0;
+    guint8 last_index = 0;
+    gboolean have_last = FALSE;
 
-  colours = g_array_sized_new (FALSE, FALSE, sizeof (ColourEntry), num_pixels);
-  colours = g_array_set_size (colours, num_pixels);
+    for (x = 0; x < width; x++, p += 4) {
+      guint32 colour = GST_READ_UINT32_BE (p);
+      guint slot;
 
-  histogram =
-      g_array_sized_new (FALSE, TRUE, sizeof (HistogramEntry), num_pixels);
-  histogram = g_array_set_size (histogram, num_pixels);
+      if (have_last && colour == last_colour) {
+        out[x] = last_index;
+        continue;
+      }
 
-  /* Copy the pixels to an array we can sort, dropping any stride padding,
-   * and recording the output index into the destination bitmap in the
-   * pix_index field */
-  dest_y_index = 0;
-  out_index = 0;
-  for (i = 0; i < GST_VIDEO_INFO_HEIGHT (&src->info); i++) {
-    guint32 x_index;
-    gint x;
+      /* Multiplicative hash - the top bits are the best mixed */
+      slot = (colour * 2654435761u) >> 22;
+      while (table[slot].used && table[slot].colour != colour)
+        slot = (slot + 1) & (EXACT_PALETTE_TABLE_SIZE - 1);
 
-    for (x = 0, x_index = 0; x < GST_VIDEO_INFO_WIDTH (&src->info);
-        x++, x_index += 4) {
-      guint8 *pix = s + x_index;
+      if (!table[slot].used) {
+        if (num_colours == max_colours)
+          goto too_many_colours;
 
-      c = &g_array_index (colours, ColourEntry, out_index);
-      c->colour = GST_READ_UINT32_BE (pix);
-      c->pix_index = dest_y_index + x;
+        table[slot].used = TRUE;
+        table[slot].colour = colour;
+        table[slot].index = num_colours;
+        colours[num_colours++] = colour;
+      }
+
+      last_colour = colour;
+      last_index = table[slot].index;
+      have_last = TRUE;
 
-      out_index++;
+      out[x] = last_index;
     }
 
     s += src_stride;
-    dest_y_index += dest_stride;
+    d += dest_stride;
   }
 
-  /* Build a histogram of the highest colour counts: */
-  g_array_sort (colours, compare_colour_entry_colour);
-  c = &g_array_index (colours, ColourEntry, 0);
-  last = c->colour;
-  num_colours = 0;
-  cur_count = 1;
-  for (i = 1; i < num_pixels; i++) {
-    ColourEntry *c = &g_array_index (colours, ColourEntry, i);
-    guint32 cur = c->colour;
-
-    if (cur == last) {
-      cur_count++;
-      continue;
-    }
+  GST_LOG ("image has %u colours, using exact palette", num_colours);
 
-    /* Colour changed - add an entry to the histogram */
-    h = &g_array_index (histogram, HistogramEntry, num_colours);
-    h->colour = last;
-    h->count = cur_count;
+  /* Sort the palette and build a table from order of appearance to
+   * the sorted palette index */
+  memcpy (sorted, colours, num_colours * sizeof (guint32));
+  qsort (sorted, num_colours, sizeof (guint32), compare_colour_reverse);
 
-    num_colours++;
-    cur_count = 1;
-    last = cur;
+  for (i = 0; i < num_colours; i++) {
+    guint32 *found = bsearch (&colours[i], sorted, num_colours,
+        sizeof (guint32), compare_colour_reverse);
+
+    g_assert (found != NULL);
+    remap[i] = found - sorted;
+    GST_WRITE_UINT32_BE (palette + 4 * (found - sorted), colours[i]);
   }
-  h = &g_array_index (histogram, HistogramEntry, num_colours);
-  h->colour = last;
-  h->count = cur_count;
-  num_colours++;
-
-  GST_LOG ("image has %u colours", num_colours);
-  histogram = g_array_set_size (histogram, num_colours);
-
-  if (num_colours > max_colours) {
-    liq_image *image;
-    liq_result *res;
-    const liq_palette *pal;
-    int i;
-    int height = GST_VIDEO_INFO_HEIGHT (&src->info);
-    unsigned char **dest_rows = malloc (height * sizeof (void *));
-    guint8 *dest_palette = (guint8 *) (dest->data[1]);
-    liq_attr *attr = liq_attr_create ();
-    gint out_index = 0;
-
-    for (i = 0; i < height; i++) {
-      dest_rows[i] = (guint8 *) (dest->data[0]) + i * dest_stride;
-    }
 
-    liq_set_max_colors (attr, max_colours);
+  d = (guint8 *) (dest->data[0]);
+  for (y = 0; y < height; y++) {
+    for (x = 0; x < width; x++)
+      d[x] = remap[d[x]];
+    d += dest_stride;
+  }
 
-    image = liq_image_create_custom (attr, image_get_rgba_row_callback, src,
-        GST_VIDEO_INFO_WIDTH (&src->info), GST_VIDEO_INFO_HEIGHT (&src->info),
-        0);
+  if (out_num_colours)
+    *out_num_colours = num_colours;
+  ret = TRUE;
 
-    res = liq_quantize_image (attr, image);
+too_many_colours:
+  g_free (table);
+  return ret;
+}
+
+/*
+ * Utility function to extract a (max) 256 colour image from an AYUV input.
+ * If the input already fits in max_colours, its colours are used directly
+ * as the palette. Otherwise libimagequant picks the palette and remaps
+ * the image, with the given speed (1 = best quality, 10 = fastest).
+ */
+gboolean
+gst_dvbsubenc_ayuv_to_ayuv8p (GstVideoFrame * src, GstVideoFrame * dest,
+    int max_colours, int speed, guint32 * out_num_colours)
+{
+  liq_image *image;
+  liq_result *res;
+  const liq_palette *pal;
+  guint num_colours;
+  int i;
+  int height = GST_VIDEO_INFO_HEIGHT (&src->info);
+  const guint32 dest_stride = GST_VIDEO_INFO_PLANE_STRIDE (&dest->info, 0);
+  unsigned char **dest_rows;
+  guint8 *dest_palette = (guint8 *) (dest->data[1]);
+  liq_attr *attr;
+  gint out_index = 0;
+
+  if (GST_VIDEO_INFO_FORMAT (&src->info) != GST_VIDEO_FORMAT_AYUV)
+    return FALSE;
 
-    liq_write_remapped_image_rows (res, image, dest_rows);
+  if (GST_VIDEO_INFO_WIDTH (&src->info) != GST_VIDEO_INFO_WIDTH (&dest->info) ||
+      GST_VIDEO_INFO_HEIGHT (&src->info) != GST_VIDEO_INFO_HEIGHT (&dest->info))
+    return FALSE;
 
-    pal = liq_get_palette (res);
-    num_colours = pal->count;
+  if (ayuv_to_ayuv8p_exact (src, dest, max_colours, out_num_colours))
+    return TRUE;
 
-    /* Write out the palette */
-    for (i = 0; i < num_colours; i++) {
-      guint8 *c = dest_palette + out_index;
-      const liq_color *col = pal->entries + i;
+  GST_LOG ("image has more than %d colours, quantising with speed %d",
+      max_colours, speed);
 
-      c[0] = col->a;
-      c[1] = col->r;
-      c[2] = col->g;
-      c[3] = col->b;
+  dest_rows = malloc (height * sizeof (void *));
+  for (i = 0; i < height; i++) {
+    dest_rows[i] = (guint8 *) (dest->data[0]) + i * dest_stride;
+  }
 
-      out_index += 4;
-    }
+  attr = liq_attr_create ();
+  liq_set_max_colors (attr, max_colours);
+  liq_set_speed (attr, CLAMP (speed, 1, 10));
 
-    free (dest_rows);
-
-    liq_attr_destroy (attr);
-    liq_image_destroy (image);
-    liq_result_destroy (res);
-  } else {
-    guint8 *d = (guint8 *) (dest->data[0]);
-    guint8 *palette = (guint8 *) (dest->data[1]);
-    gint out_index = 0;
-
-    /* Write out the palette */
-    for (i = 0; i < num_colours; i++) {
-      h = &g_array_index (histogram, HistogramEntry, i);
-      GST_WRITE_UINT32_BE (palette + out_index, h->colour);
-      out_index += 4;
-    }
+  image = liq_image_create_custom (attr, image_get_rgba_row_callback, src,
+      GST_VIDEO_INFO_WIDTH (&src->info), GST_VIDEO_INFO_HEIGHT (&src->info), 0);
 
-    /* Write out the palette image. At this point, both the
-     * colours and histogram arrays are sorted in descending AYUV value,
-     * so walk them both and write out the current palette index */
-    out_index = 0;
-    for (i = 0; i < num_pixels; i++) {
-      c = &g_array_index (colours, ColourEntry, i);
-      h = &g_array_index (histogram, HistogramEntry, out_index);
-
-      if (c->colour != h->colour) {
-        out_index++;
-        h = &g_array_index (histogram, HistogramEntry, out_index);
-        g_assert (h->colour == c->colour);      /* We must be walking colours in the same order in both arrays */
-      }
-      d[c->pix_index] = out_index;
-    }
+  res = liq_quantize_image (attr, image);
+
+  liq_write_remapped_image_rows (res, image, dest_rows);
+
+  pal = liq_get_palette (res);
+  num_colours = pal->count;
+
+  /* Write out the palette */
+  for (i = 0; i < num_colours; i++) {
+    guint8 *c = dest_palette + out_index;
+    const liq_color *col = pal->entries + i;
+
+    c[0] = col->a;
+    c[1] = col->r;
+    c[2] = col->g;
+    c[3] = col->b;
+
+    out_index += 4;
   }
 
-  ret = TRUE;
+  free (dest_rows);
+
+  liq_attr_destroy (attr);
+  liq_image_destroy (image);
+  liq_result_destroy (res);
+
   if (out_num_colours)
     *out_num_colours = num_colours;
 
-  g_array_free (colours, TRUE);
-  g_array_free (histogram, TRUE);
-
-  return ret;
+  return TRUE;
 }
 
 typedef void (*EncodeRLEFunc) (GstByteWriter * b, const guint8 * pixels,
     const gint stride, const gint w, const gint h);
 
+/* Minimal MSB-first bit writer that appends complete bytes directly to
+ * the output GstByteWriter, instead of collecting each line in a separately
+ * allocated GstBitWriter and copying it over */
+typedef struct
+{
+  GstByteWriter *b;
+  guint32 acc;
+  guint n_bits;
+} RLEBitWriter;
+
+static inline void
+rle_bits_put (RLEBitWriter * bits, guint8 value, guint n_bits)
+{
+  bits->acc = (bits->acc << n_bits) | (value & ((1 << n_bits) - 1));
+  bits->n_bits += n_bits;
+
+  while (bits->n_bits >= 8) {
+    bits->n_bits -= 8;
+    gst_byte_writer_put_uint8 (bits->b, bits->acc >> bits->n_bits);
+  }
+}
+
+static inline void
+rle_bits_align (RLEBitWriter * bits)
+{
+  if (bits->n_bits > 0)
+    rle_bits_put (bits, 0, 8 - bits->n_bits);
+}
+
+/* Returns the number of pixels (at most max_len) that have the same value
+ * as the first one. Compares 8 pixels at a time while they all match */
+static inline gint
+find_run_length (const guint8 * pixels, gint max_len)
+{
+  const guint64 pattern = G_GUINT64_CONSTANT (0x0101010101010101) * pixels[0];
+  gint len = 1;
+
+  while (len + 8 <= max_len) {
+    guint64 v;
+
+    memcpy (&v, pixels + len, sizeof (v));
+    if (v != pattern)
+      break;
+    len += 8;
+  }
+
+  while (len < max_len && pixels[len] == pixels[0])
+    len++;
+
+  return len;
+}
+
 static void
 encode_rle2 (GstByteWriter * b, const guint8 * pixels,
     const gint stride, const gint w, const gint h)
 {
-  GstBitWriter bits;
-
+  RLEBitWriter bits = { b, 0, 0 };
   int y;
 
-  gst_bit_writer_init (&bits);
-
   for (y = 0; y < h; y++) {
     int x = 0;
-    guint size;
+    guint start = gst_byte_writer_get_pos (b);
 
     gst_byte_writer_put_uint8 (b, DVB_PIXEL_DATA_TYPE_2BIT);
 
     while (x < w) {
-      int x_end = x;
-      int run_length;
-      guint8 pix;
-
-      pix = pixels[x_end++];
-      while (x_end < w && pixels[x_end] == pix)
-        x_end++;
+      /* 284 is the largest run length we can encode */
+      int run_length = find_run_length (pixels + x, MIN (w - x, 284));
+      guint8 pix = pixels[x];
 
 #ifdef HACK_2BIT
       pix >>= 6;                /* HACK to convert 8 bit to 2 bit palette */
 #endif
 
-      /* 284 is the largest run length we can encode */
-      run_length = MIN (x_end - x, 284);
-
       if (run_length >= 29) {
         /* 000011LLLL = run 29 to 284 pixels */
-        if (run_length > 284)
-          run_length = 284;
-
-        gst_bit_writer_put_bits_uint8 (&bits, 0x03, 6);
-        gst_bit_writer_put_bits_uint8 (&bits, run_length - 29, 8);
-        gst_bit_writer_put_bits_uint8 (&bits, pix, 2);
+        rle_bits_put (&bits, 0x03, 6);
+        rle_bits_put (&bits, run_length - 29, 8);
+        rle_bits_put (&bits, pix, 2);
       } else if (run_length >= 12 && run_length <= 27) {
         /* 000010LLLL = run 12 to 27 pixels */
-        gst_bit_writer_put_bits_uint8 (&bits, 0x02, 6);
-        gst_bit_writer_put_bits_uint8 (&bits, run_length - 12, 4);
-        gst_bit_writer_put_bits_uint8 (&bits, pix, 2);
+        rle_bits_put (&bits, 0x02, 6);
+        rle_bits_put (&bits, run_length - 12, 4);
+        rle_bits_put (&bits, pix, 2);
       } else if (run_length >= 3 && run_length <= 10) {
         /* 001LL = run 3 to 10 pixels */
-        gst_bit_writer_put_bits_uint8 (&bits, 0, 2);
-        gst_bit_writer_put_bits_uint8 (&bits, 0x8 + run_length - 3, 4);
-        gst_bit_writer_put_bits_uint8 (&bits, pix, 2);
+        rle_bits_put (&bits, 0, 2);
+        rle_bits_put (&bits, 0x8 + run_length - 3, 4);
+        rle_bits_put (&bits, pix, 2);
       }
       /* Missed cases - 11 pixels, 28 pixels or a short length 1 or 2 pixels
        * - write out a single pixel if != 0, or 1 or 2 pixels of black */
       else if (pix != 0) {
-        gst_bit_writer_put_bits_uint8 (&bits, pix, 2);
+        rle_bits_put (&bits, pix, 2);
         run_length = 1;
       } else if (run_length == 2) {
         /* 0000 01 - 2 pixels colour 0 */
-        gst_bit_writer_put_bits_uint8 (&bits, 0x1, 6);
+        rle_bits_put (&bits, 0x1, 6);
         run_length = 2;
       } else {
         /* 0001 - single pixel colour 0 */
-        gst_bit_writer_put_bits_uint8 (&bits, 0x1, 4);
+        rle_bits_put (&bits, 0x1, 4);
         run_length = 1;
       }
 
       x += run_length;
-      GST_LOG ("%u pixels = colour %u", run_length, pix);
     }
 
     /* End of line 0x00 */
-    gst_bit_writer_put_bits_uint8 (&bits, 0x00, 8);
-
-    /* pad by 4 bits if needed to byte align, then
-     * write bit string to output */
-    gst_bit_writer_align_bytes (&bits, 0);
-    size = gst_bit_writer_get_size (&bits);
-
-    gst_byte_writer_put_data (b, gst_bit_writer_get_data (&bits), size / 8);
+    rle_bits_put (&bits, 0x00, 8);
 
-    gst_bit_writer_reset (&bits);
-    gst_bit_writer_init (&bits);
+    /* pad by 4 bits if needed to byte align */
+    rle_bits_align (&bits);
 
-    GST_LOG ("y %u 2-bit RLE string = %u bits", y, size);
+    GST_LOG ("y %u 2-bit RLE string = %u bytes", y,
+        gst_byte_writer_get_pos (b) - start - 1);
     gst_byte_writer_put_uint8 (b, DVB_PIXEL_DATA_TYPE_END_OF_LINE);
     pixels += stride;
   }
@@ -404,89 +430,66 @@ static void
 encode_rle4 (GstByteWriter * b, const guint8 * pixels,
     const gint stride, const gint w, const gint h)
 {
-  GstBitWriter bits;
-
+  RLEBitWriter bits = { b, 0, 0 };
   int y;
 
-  gst_bit_writer_init (&bits);
-
   for (y = 0; y < h; y++) {
     int x = 0;
-    guint size;
+    guint start = gst_byte_writer_get_pos (b);
 
     gst_byte_writer_put_uint8 (b, DVB_PIXEL_DATA_TYPE_4BIT);
 
     while (x < w) {
-      int x_end = x;
-      int run_length;
-      guint8 pix;
-
-      pix = pixels[x_end++];
-      while (x_end < w && pixels[x_end] == pix)
-        x_end++;
-
       /* 280 is the largest run length we can encode */
-      run_length = MIN (x_end - x, 280);
-
-      GST_LOG ("Encoding run %u pixels = colour %u", run_length, pix);
+      int run_length = find_run_length (pixels + x, MIN (w - x, 280));
+      guint8 pix = pixels[x];
 
 #ifdef HACK_4BIT
       pix >>= 4;                /* HACK to convert 8 bit to 4 palette */
 #endif
 
       if (pix == 0 && run_length >= 3 && run_length <= 9) {
-        gst_bit_writer_put_bits_uint8 (&bits, 0, 4);
-        gst_bit_writer_put_bits_uint8 (&bits, run_length - 2, 4);
+        rle_bits_put (&bits, 0, 4);
+        rle_bits_put (&bits, run_length - 2, 4);
       } else if (run_length >= 4 && run_length < 25) {
         /* 4 to 7 pixels encoding */
         if (run_length > 7)
           run_length = 7;
 
-        gst_bit_writer_put_bits_uint8 (&bits, 0, 4);
-        gst_bit_writer_put_bits_uint8 (&bits, 0x8 + run_length - 4, 4);
-        gst_bit_writer_put_bits_uint8 (&bits, pix, 4);
+        rle_bits_put (&bits, 0, 4);
+        rle_bits_put (&bits, 0x8 + run_length - 4, 4);
+        rle_bits_put (&bits, pix, 4);
       } else if (run_length >= 25) {
         /* Run length 25 to 280 pixels */
-        if (run_length > 280)
-          run_length = 280;
-
-        gst_bit_writer_put_bits_uint8 (&bits, 0x0f, 8);
-        gst_bit_writer_put_bits_uint8 (&bits, run_length - 25, 8);
-        gst_bit_writer_put_bits_uint8 (&bits, pix, 4);
+        rle_bits_put (&bits, 0x0f, 8);
+        rle_bits_put (&bits, run_length - 25, 8);
+        rle_bits_put (&bits, pix, 4);
       }
       /* Short length, 1, 2 or 3 pixels - write out a single pixel if != 0,
        * or 1 or 2 pixels of black */
       else if (pix != 0) {
-        gst_bit_writer_put_bits_uint8 (&bits, pix, 4);
+        rle_bits_put (&bits, pix, 4);
         run_length = 1;
       } else if (run_length > 1) {
         /* 0000 1101 */
-        gst_bit_writer_put_bits_uint8 (&bits, 0xd, 8);
+        rle_bits_put (&bits, 0xd, 8);
         run_length = 2;
       } else {
         /* 0000 1100 */
-        gst_bit_writer_put_bits_uint8 (&bits, 0xc, 8);
+        rle_bits_put (&bits, 0xc, 8);
         run_length = 1;
       }
       x += run_length;
-
-      GST_LOG ("Put %u pixels = colour %u", run_length, pix);
     }
 
     /* End of line 0x00 */
-    gst_bit_writer_put_bits_uint8 (&bits, 0x00, 8);
-
-    /* pad by 4 bits if needed to byte align, then
-     * write bit string to output */
-    gst_bit_writer_align_bytes (&bits, 0);
-    size = gst_bit_writer_get_size (&bits);
+    rle_bits_put (&bits, 0x00, 8);
 
-    gst_byte_writer_put_data (b, gst_bit_writer_get_data (&bits), size / 8);
+    /* pad by 4 bits if needed to byte align */
+    rle_bits_align (&bits);
 
-    gst_bit_writer_reset (&bits);
-    gst_bit_writer_init (&bits);
-
-    GST_LOG ("y %u 4-bit RLE string = %u bits", y, size);
+    GST_LOG ("y %u 4-bit RLE string = %u bytes", y,
+        gst_byte_writer_get_pos (b) - start - 1);
     gst_byte_writer_put_uint8 (b, DVB_PIXEL_DATA_TYPE_END_OF_LINE);
     pixels += stride;
   }
@@ -504,16 +507,9 @@ encode_rle8 (GstByteWriter * b, const guint8 * pixels,
     gst_byte_writer_put_uint8 (b, DVB_PIXEL_DATA_TYPE_8BIT);
 
     while (x < w) {
-      int x_end = x;
-      int run_length;
-      guint8 pix;
-
-      pix = pixels[x_end++];
-      while (x_end < w && pixels[x_end] == pix)
-        x_end++;
-
       /* 127 is the largest run length we can encode */
-      run_length = MIN (x_end - x, 127);
+      int run_length = find_run_length (pixels + x, MIN (w - x, 127));
+      guint8 pix = pixels[x];
 
       if (run_length == 1 && pix != 0) {
         /* a single non-zero pixel - encode directly */
@@ -721,6 +717,31 @@ dvbenc_write_region_segment (GstByteWriter * b, int object_version, int page_id,
   gst_byte_writer_set_pos (b, pos);
 }
 
+/* Cheap upper bound on the size of an encoded display set, so the output
+ * can be allocated once up front */
+static guint
+dvbenc_get_max_encoded_size (SubpictureRect * s, guint num_subpictures)
+{
+  /* PES prefix, page composition and end of display set segments and
+   * the end of PES marker */
+  guint size = 32;
+  guint i;
+
+  for (i = 0; i < num_subpictures; i++) {
+    gint w = GST_VIDEO_INFO_WIDTH (&s[i].frame->info);
+    gint h = GST_VIDEO_INFO_HEIGHT (&s[i].frame->info);
+
+    /* page composition entry, region and object segment headers, and
+     * a full 256 entry CLUT */
+    size += 64 + 6 * 256;
+    /* The 8-bit encoding is the least compact, and never takes more than
+     * 2 bytes per pixel plus 4 bytes per line */
+    size += h * (2 * w + 4);
+  }
+
+  return size;
+}
+
 GstBuffer *
 gst_dvbenc_encode (int object_version, int page_id, SubpictureRect * s,
     guint num_subpictures)
@@ -738,7 +759,8 @@ gst_dvbenc_encode (int object_version, int page_id, SubpictureRect * s,
   s->nb_colours = 16;
 #endif
 
-  gst_byte_writer_init (&b);
+  gst_byte_writer_init_with_size (&b,
+      dvbenc_get_max_encoded_size (s, num_subpictures), FALSE);
 
   /* GStreamer passes DVB subpictures as private PES packets with
    * 0x20 0x00 prefixed */
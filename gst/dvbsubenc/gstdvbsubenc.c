@@ -41,12 +41,18 @@
 
 #define DEFAULT_MAX_COLOURS 16
 #define DEFAULT_TS_OFFSET 0
+#define DEFAULT_SPEED 3
+
+/* Unchanged pages are not re-sent, except this often so that decoders
+ * never hit the page time-out (30 seconds) */
+#define PAGE_REFRESH_INTERVAL (10 * GST_SECOND)
 
 enum
 {
   PROP_0,
   PROP_MAX_COLOURS,
-  PROP_TS_OFFSET
+  PROP_TS_OFFSET,
+  PROP_SPEED
 };
 
 #define gst_dvb_sub_enc_parent_class parent_class
@@ -127,6 +133,21 @@ gst_dvb_sub_enc_class_init (GstDvbSubEncClass * klass)
           G_MININT64, G_MAXINT64, 0,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+ /**
+  * GstDvbSubEnc:speed
+  *
+  * Trade palette quality for encoding speed when an input subpicture
+  * has more colours than #GstDvbSubEnc:max-colours and needs to be
+  * quantised. 1 gives the best quality, 10 is the fastest. Inputs that
+  * already fit in the palette are never quantised.
+  *
+  * Since: 1.20
+  */
+  g_object_class_install_property (gobject_class, PROP_SPEED,
+      g_param_spec_int ("speed", "Speed",
+          "Quantisation speed/quality trade-off (1 = best quality, "
+          "10 = fastest)", 1, 10, DEFAULT_SPEED,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -151,14 +172,26 @@ gst_dvb_sub_enc_init (GstDvbSubEnc * enc)
 
   enc->max_colours = DEFAULT_MAX_COLOURS;
   enc->ts_offset = DEFAULT_TS_OFFSET;
+  enc->speed = DEFAULT_SPEED;
 
   enc->current_end_time = GST_CLOCK_TIME_NONE;
+  enc->page_pts = GST_CLOCK_TIME_NONE;
+}
+
+static void
+gst_dvb_sub_enc_reset_page (GstDvbSubEnc * enc)
+{
+  enc->page_displayed = FALSE;
+  enc->page_pts = GST_CLOCK_TIME_NONE;
+  gst_clear_buffer (&enc->page_region);
 }
 
 static void
 gst_dvb_sub_enc_finalize (GObject * gobject)
 {
-  //GstDvbSubEnc *enc = GST_DVB_SUB_ENC (gobject);
+  GstDvbSubEnc *enc = GST_DVB_SUB_ENC (gobject);
+
+  gst_dvb_sub_enc_reset_page (enc);
 
   G_OBJECT_CLASS (parent_class)->finalize (gobject);
 }
@@ -176,6 +209,9 @@ gst_dvb_sub_enc_get_property (GObject * object, guint prop_id,
     case PROP_TS_OFFSET:
       g_value_set_int64 (value, enc->ts_offset);
       break;
+    case PROP_SPEED:
+      g_value_set_int (value, enc->speed);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -196,6 +232,9 @@ gst_dvb_sub_enc_set_property (GObject * object, guint prop_id,
       enc->ts_offset = g_value_get_int64 (value);
       gst_pad_set_offset (enc->srcpad, enc->ts_offset);
       break;
+    case PROP_SPEED:
+      enc->speed = g_value_get_int (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -263,6 +302,58 @@ find_largest_subregion (guint8 * pixels, guint stride, guint pixel_stride,
   *out_bottom = bottom;
 }
 
+/* FNV-1a over 32-bit words of an AYUV subregion */
+static guint32
+hash_subregion (const guint8 * pixels, guint stride, guint row_size,
+    guint height)
+{
+  guint32 hash = 2166136261u;
+  guint x, y;
+
+  for (y = 0; y < height; y++) {
+    for (x = 0; x < row_size; x += 4)
+      hash = (hash ^ GST_READ_UINT32_LE (pixels + x)) * 16777619u;
+    pixels += stride;
+  }
+
+  return hash;
+}
+
+/* Check if a subregion of the input is identical to the last page we sent.
+ * The hash rejects almost all changed pages cheaply, the pixel comparison
+ * makes sure a collision never leaves a stale subtitle on screen */
+static gboolean
+subregion_is_unchanged (GstDvbSubEnc * enc, const guint8 * pixels,
+    guint stride, guint32 hash, guint left, guint top, guint width,
+    guint height)
+{
+  GstMapInfo map;
+  const guint8 *p;
+  guint row_size = width * 4;
+  guint y;
+  gboolean ret = TRUE;
+
+  if (enc->page_region == NULL || enc->page_hash != hash ||
+      enc->page_left != left || enc->page_top != top ||
+      enc->page_width != width || enc->page_height != height)
+    return FALSE;
+
+  if (!gst_buffer_map (enc->page_region, &map, GST_MAP_READ))
+    return FALSE;
+
+  /* The stored region is tightly packed AYUV */
+  p = map.data;
+  for (y = 0; y < height && ret; y++) {
+    ret = memcmp (p, pixels, row_size) == 0;
+    p += row_size;
+    pixels += stride;
+  }
+
+  gst_buffer_unmap (enc->page_region, &map);
+
+  return ret;
+}
+
 /* Create and map a new buffer containing the indicated subregion of the input
  * image, returning the result in the 'out' GstVideoFrame */
 static gboolean
@@ -324,21 +415,70 @@ process_largest_subregion (GstDvbSubEnc * enc, GstVideoFrame * vframe)
   guint8 *pixels = GST_VIDEO_FRAME_PLANE_DATA (vframe, 0);
   guint stride = GST_VIDEO_FRAME_PLANE_STRIDE (vframe, 0);
   guint pixel_stride = GST_VIDEO_FRAME_COMP_PSTRIDE (vframe, 0);
-  guint left, right, top, bottom;
-  GstBuffer *ayuv8p_buffer;
+  guint left, right, top, bottom, width, height;
+  guint32 hash;
+  GstBuffer *ayuv8p_buffer, *region;
   GstVideoInfo ayuv8p_info;
   GstVideoFrame cropped_frame, ayuv8p_frame;
   guint32 num_colours;
   GstClockTime end_ts = GST_CLOCK_TIME_NONE, duration;
+  GstClockTime pts = GST_BUFFER_PTS (vframe->buffer);
 
   find_largest_subregion (pixels, stride, pixel_stride, enc->in_info.width,
       enc->in_info.height, &left, &right, &top, &bottom);
 
+  /* Fully transparent frame, nothing to encode. A page that is still on
+   * screen gets removed by the end of page packet once it expires */
+  if (right < left || bottom < top) {
+    GST_LOG_OBJECT (enc, "Empty frame, nothing to encode");
+
+    if (GST_CLOCK_TIME_IS_VALID (pts))
+      gst_pad_push_event (enc->srcpad,
+          gst_event_new_gap (pts, GST_BUFFER_DURATION (vframe->buffer)));
+
+    return GST_FLOW_OK;
+  }
+
+  width = right - left + 1;
+  height = bottom - top + 1;
+
   GST_LOG_OBJECT (enc, "Found subregion %u,%u -> %u,%u w %u, %u", left, top,
-      right, bottom, right - left + 1, bottom - top + 1);
+      right, bottom, width, height);
+
+  duration = GST_BUFFER_DURATION (vframe->buffer);
+
+  if (GST_CLOCK_TIME_IS_VALID (duration)) {
+    end_ts = pts;
+    if (GST_CLOCK_TIME_IS_VALID (end_ts)) {
+      end_ts += duration;
+    }
+  }
+
+  /* Subtitles usually stay the same for many frames. If the page on screen
+   * already shows exactly this, just extend it instead of quantising and
+   * encoding it again */
+  hash = hash_subregion (pixels + top * stride + left * pixel_stride, stride,
+      width * pixel_stride, height);
+
+  if (enc->page_displayed && subregion_is_unchanged (enc,
+          pixels + top * stride + left * pixel_stride, stride, hash, left, top,
+          width, height)
+      && !(GST_CLOCK_TIME_IS_VALID (pts)
+          && GST_CLOCK_TIME_IS_VALID (enc->page_pts)
+          && pts >= enc->page_pts + PAGE_REFRESH_INTERVAL)) {
+    GST_LOG_OBJECT (enc, "Subpicture unchanged, extending current page");
+
+    if (GST_CLOCK_TIME_IS_VALID (end_ts))
+      enc->current_end_time = end_ts;
+
+    if (GST_CLOCK_TIME_IS_VALID (pts))
+      gst_pad_push_event (enc->srcpad, gst_event_new_gap (pts, duration));
+
+    return GST_FLOW_OK;
+  }
 
   if (!create_cropped_frame (enc, vframe, &cropped_frame, left, top,
-          right - left + 1, bottom - top + 1)) {
+          width, height)) {
     GST_WARNING_OBJECT (enc, "Failed to map frame conversion input buffer");
     goto fail;
   }
@@ -346,7 +486,7 @@ process_largest_subregion (GstDvbSubEnc * enc, GstVideoFrame * vframe)
   /* FIXME: RGB8P is the same size as what we're building, so this is fine,
    * but it'd be better if we had an explicit paletted format for YUV8P */
   gst_video_info_set_format (&ayuv8p_info, GST_VIDEO_FORMAT_RGB8P,
-      right - left + 1, bottom - top + 1);
+      width, height);
   ayuv8p_buffer =
       gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (&ayuv8p_info), NULL);
 
@@ -360,7 +500,7 @@ process_largest_subregion (GstDvbSubEnc * enc, GstVideoFrame * vframe)
   }
 
   if (!gst_dvbsubenc_ayuv_to_ayuv8p (&cropped_frame, &ayuv8p_frame,
-          enc->max_colours, &num_colours)) {
+          enc->max_colours, enc->speed, &num_colours)) {
     GST_ERROR_OBJECT (enc,
         "Failed to convert subpicture region to paletted 8-bit");
     gst_video_frame_unmap (&cropped_frame);
@@ -368,17 +508,10 @@ process_largest_subregion (GstDvbSubEnc * enc, GstVideoFrame * vframe)
     goto skip;
   }
 
+  /* Keep the cropped input around to detect unchanged pages */
+  region = gst_buffer_ref (cropped_frame.buffer);
   gst_video_frame_unmap (&cropped_frame);
 
-  duration = GST_BUFFER_DURATION (vframe->buffer);
-
-  if (GST_CLOCK_TIME_IS_VALID (duration)) {
-    end_ts = GST_BUFFER_PTS (vframe->buffer);
-    if (GST_CLOCK_TIME_IS_VALID (end_ts)) {
-      end_ts += duration;
-    }
-  }
-
   /* Encode output buffer and push it */
   {
     SubpictureRect s;
@@ -392,6 +525,7 @@ process_largest_subregion (GstDvbSubEnc * enc, GstVideoFrame * vframe)
     packet = gst_dvbenc_encode (enc->object_version & 0xF, 1, &s, 1);
     if (packet == NULL) {
       gst_video_frame_unmap (&ayuv8p_frame);
+      gst_buffer_unref (region);
       goto fail;
     }
 
@@ -403,6 +537,16 @@ process_largest_subregion (GstDvbSubEnc * enc, GstVideoFrame * vframe)
     if (!GST_BUFFER_DTS_IS_VALID (packet))
       GST_BUFFER_DTS (packet) = GST_BUFFER_PTS (packet);
 
+    gst_clear_buffer (&enc->page_region);
+    enc->page_region = region;
+    enc->page_hash = hash;
+    enc->page_left = left;
+    enc->page_top = top;
+    enc->page_width = width;
+    enc->page_height = height;
+    enc->page_pts = pts;
+    enc->page_displayed = TRUE;
+
     ret = gst_pad_push (enc->srcpad, packet);
   }
 
@@ -448,6 +592,7 @@ gst_dvb_sub_enc_generate_end_packet (GstDvbSubEnc * enc, GstClockTime pts)
 
   GST_BUFFER_DTS (packet) = GST_BUFFER_PTS (packet) = enc->current_end_time;
   enc->current_end_time = GST_CLOCK_TIME_NONE;
+  enc->page_displayed = FALSE;
 
   ret = gst_pad_push (enc->srcpad, packet);
 
@@ -502,9 +647,12 @@ gst_dvb_sub_enc_sink_setcaps (GstPad * pad, GstCaps * caps)
   GST_DEBUG_OBJECT (enc, "setcaps called with %" GST_PTR_FORMAT, caps);
   if (!gst_video_info_from_caps (&enc->in_info, caps)) {
     GST_ERROR_OBJECT (enc, "Failed to parse input caps");
+    gst_object_unref (enc);
     return FALSE;
   }
 
+  gst_dvb_sub_enc_reset_page (enc);
+
   out_caps = gst_caps_new_simple ("subpicture/x-dvb",
       "width", G_TYPE_INT, enc->in_info.width,
       "height", G_TYPE_INT, enc->in_info.height,
@@ -576,6 +724,7 @@ gst_dvb_sub_enc_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
     }
     case GST_EVENT_FLUSH_STOP:{
       enc->current_end_time = GST_CLOCK_TIME_NONE;
+      gst_dvb_sub_enc_reset_page (enc);
 
       ret = gst_pad_event_default (pad, parent, event);
       break;
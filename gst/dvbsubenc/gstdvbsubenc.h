@@ -53,9 +53,17 @@ struct _GstDvbSubEnc
   int object_version;
 
   int max_colours;
+  int speed;
   GstClockTimeDiff ts_offset;
 
   GstClockTime current_end_time;
+
+  /* The last encoded page, used to skip re-encoding unchanged input */
+  gboolean page_displayed;
+  GstClockTime page_pts;
+  guint32 page_hash;
+  guint page_left, page_top, page_width, page_height;
+  GstBuffer *page_region;
 };
 
 struct _GstDvbSubEncClass
@@ -65,6 +73,6 @@ struct _GstDvbSubEncClass
 
 GType gst_dvb_sub_enc_get_type (void);
 
-gboolean gst_dvbsubenc_ayuv_to_ayuv8p (GstVideoFrame * src, GstVideoFrame * dest, int max_colours, guint32 *out_num_colours);
+gboolean gst_dvbsubenc_ayuv_to_ayuv8p (GstVideoFrame * src, GstVideoFrame * dest, int max_colours, int speed, guint32 *out_num_colours);
 
 GstBuffer *gst_dvbenc_encode (int object_version, int page_id, SubpictureRect *s, guint num_subpictures);
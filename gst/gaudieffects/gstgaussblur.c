@@ -74,8 +74,8 @@ static void gst_gaussianblur_finalize (GObject * object);
 static gboolean gst_gaussianblur_set_info (GstVideoFilter * filter,
     GstCaps * incaps, GstVideoInfo * in_info, GstCaps * outcaps,
     GstVideoInfo * out_info);
-static GstFlowReturn gst_gaussianblur_transform_frame (GstVideoFilter * vfilter,
-    GstVideoFrame * in_frame, GstVideoFrame * out_frame);
+static GstFlowReturn gst_gaussianblur_transform_frame_ip (GstVideoFilter *
+    vfilter, GstVideoFrame * frame);
 
 static void gst_gaussianblur_set_property (GObject * object,
     guint prop_id, const GValue * value, GParamSpec * pspec);
@@ -115,14 +115,18 @@ enum
 };
 
 static gboolean make_gaussian_kernel (GstGaussianBlur * gb, float sigma);
-static void gaussian_smooth (GstGaussianBlur * gb, guint8 * image,
-    guint8 * out_image);
+static void gaussian_smooth (GstGaussianBlur * gb, guint8 * image);
 
 #define gst_gaussianblur_parent_class parent_class
 G_DEFINE_TYPE (GstGaussianBlur, gst_gaussianblur, GST_TYPE_VIDEO_FILTER);
 
 #define DEFAULT_SIGMA 1.2
 
+/* The kernel coefficients are in Q14 fixed point, the horizontally blurred
+ * rows are kept with TEMP_SHIFT bits of extra precision */
+#define KERNEL_SHIFT 14
+#define TEMP_SHIFT 4
+
 /* Initialize the gaussianblur's class. */
 static void
 gst_gaussianblur_class_init (GstGaussianBlurClass * klass)
@@ -152,8 +156,8 @@ gst_gaussianblur_class_init (GstGaussianBlurClass * klass)
           -20.0, 20.0, DEFAULT_SIGMA,
           G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
-  vfilter_class->transform_frame =
-      GST_DEBUG_FUNCPTR (gst_gaussianblur_transform_frame);
+  vfilter_class->transform_frame_ip =
+      GST_DEBUG_FUNCPTR (gst_gaussianblur_transform_frame_ip);
   vfilter_class->set_info = GST_DEBUG_FUNCPTR (gst_gaussianblur_set_info);
 }
 
@@ -162,15 +166,22 @@ gst_gaussianblur_set_info (GstVideoFilter * filter, GstCaps * incaps,
     GstVideoInfo * in_info, GstCaps * outcaps, GstVideoInfo * out_info)
 {
   GstGaussianBlur *gb = GST_GAUSSIANBLUR (filter);
-  guint32 n_elems;
 
   gb->width = GST_VIDEO_INFO_WIDTH (in_info);
   gb->height = GST_VIDEO_INFO_HEIGHT (in_info);
 
   /* get stride */
   gb->stride = GST_VIDEO_INFO_COMP_STRIDE (in_info, 0);
-  n_elems = gb->stride * gb->height;
-  gb->tempim = g_malloc (sizeof (gfloat) * n_elems);
+
+  /* the row buffer depends on the width, recreate it with the kernel */
+  g_free (gb->kernel);
+  gb->kernel = NULL;
+  g_free (gb->kernel_sum);
+  gb->kernel_sum = NULL;
+  g_free (gb->tempim);
+  gb->tempim = NULL;
+  g_free (gb->tempacc);
+  gb->tempacc = NULL;
 
   return TRUE;
 }
@@ -189,9 +200,8 @@ gst_gaussianblur_finalize (GObject * object)
 
   g_free (gb->tempim);
   gb->tempim = NULL;
-
-  g_free (gb->smoothedim);
-  gb->smoothedim = NULL;
+  g_free (gb->tempacc);
+  gb->tempacc = NULL;
 
   g_free (gb->kernel);
   gb->kernel = NULL;
@@ -202,17 +212,16 @@ gst_gaussianblur_finalize (GObject * object)
 }
 
 static GstFlowReturn
-gst_gaussianblur_transform_frame (GstVideoFilter * vfilter,
-    GstVideoFrame * in_frame, GstVideoFrame * out_frame)
+gst_gaussianblur_transform_frame_ip (GstVideoFilter * vfilter,
+    GstVideoFrame * frame)
 {
   GstGaussianBlur *filter = GST_GAUSSIANBLUR (vfilter);
   GstClockTime timestamp;
   gint64 stream_time;
   gfloat sigma;
-  guint8 *src, *dest;
 
   /* GstController: update the properties */
-  timestamp = GST_BUFFER_TIMESTAMP (in_frame->buffer);
+  timestamp = GST_BUFFER_TIMESTAMP (frame->buffer);
   stream_time =
       gst_segment_to_stream_time (&GST_BASE_TRANSFORM (filter)->segment,
       GST_FORMAT_TIME, timestamp);
@@ -245,110 +254,165 @@ gst_gaussianblur_transform_frame (GstVideoFilter * vfilter,
    * Perform gaussian smoothing on the image using the input standard
    * deviation.
    */
-  src = GST_VIDEO_FRAME_COMP_DATA (in_frame, 0);
-  dest = GST_VIDEO_FRAME_COMP_DATA (out_frame, 0);
-  gst_video_frame_copy (out_frame, in_frame);
-  if (filter->sigma != 0.0)
-    gaussian_smooth (filter, src, dest);
+  if (filter->windowsize > 1) {
+    filter->stride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
+    gaussian_smooth (filter, GST_VIDEO_FRAME_COMP_DATA (frame, 0));
+  }
 
   return GST_FLOW_OK;
 }
 
+/* Rounding division for the image borders, where the kernel is cut off and
+ * the result has to be normalized with the sum of the remaining part. That
+ * sum always includes the center coefficient and is positive. */
+static inline gint32
+div_round (gint32 num, gint32 den)
+{
+  if (num >= 0)
+    return (num + den / 2) / den;
+  else
+    return -((-num + den / 2) / den);
+}
+
+static inline gint32
+kernel_range_sum (GstGaussianBlur * gb, gint kmin, gint kmax)
+{
+  return gb->kernel_sum[kmax - 1] - (kmin ? gb->kernel_sum[kmin - 1] : 0);
+}
+
 static void
-blur_row_x (GstGaussianBlur * gb, guint8 * in_row, gfloat * out_row)
+blur_pixel_x_border (GstGaussianBlur * gb, const guint8 * in_row,
+    gint16 * out_row, gint c)
 {
-  int c, cc, center;
-  float dot[4], sum;
-  int k, kmin, kmax;
-
-  center = gb->windowsize / 2;
-
-  for (c = 0; c < gb->width; c++) {
-    /* Calculate min */
-    cc = center - c;
-    kmin = MAX (0, cc);
-    cc = kmin - cc;
-    /* Calc max */
-    kmax = MIN (gb->windowsize, gb->width - cc);
-    cc *= 4;
-
-    dot[0] = dot[1] = dot[2] = dot[3] = 0.0;
-    /* Calculate sum for range */
-    sum = gb->kernel_sum[kmax - 1];
-    sum -= kmin ? gb->kernel_sum[kmin - 1] : 0.0;
-
-    for (k = kmin; k < kmax; k++) {
-      float coeff = gb->kernel[k];
-      dot[0] += (float) in_row[cc++] * coeff;
-      dot[1] += (float) in_row[cc++] * coeff;
-      dot[2] += (float) in_row[cc++] * coeff;
-      dot[3] += (float) in_row[cc++] * coeff;
-    }
+  const gint32 *kernel = gb->kernel;
+  gint center = gb->windowsize / 2;
+  gint k, kmin, kmax;
+  gint32 dot[4] = { 0, };
+  gint32 sum;
+  const guint8 *in;
+
+  kmin = MAX (0, center - c);
+  kmax = MIN (gb->windowsize, gb->width - c + center);
+  sum = kernel_range_sum (gb, kmin, kmax);
+
+  in = in_row + (c - center + kmin) * 4;
+  for (k = kmin; k < kmax; k++, in += 4) {
+    gint32 coeff = kernel[k];
+
+    dot[0] += coeff * in[0];
+    dot[1] += coeff * in[1];
+    dot[2] += coeff * in[2];
+    dot[3] += coeff * in[3];
+  }
 
-    out_row[c * 4] = dot[0] / sum;
-    out_row[c * 4 + 1] = dot[1] / sum;
-    out_row[c * 4 + 2] = dot[2] / sum;
-    out_row[c * 4 + 3] = dot[3] / sum;
+  out_row += c * 4;
+  for (k = 0; k < 4; k++)
+    out_row[k] = div_round (dot[k] << TEMP_SHIFT, sum);
+}
+
+static void
+blur_row_x (GstGaussianBlur * gb, const guint8 * in_row, gint16 * out_row)
+{
+  const gint32 *kernel = gb->kernel;
+  gint32 *acc = gb->tempacc;
+  gint center = gb->windowsize / 2;
+  gint c, i, j, start, end;
+
+  /* Borders, where the kernel is cut off */
+  for (c = 0; c < MIN (center, gb->width); c++)
+    blur_pixel_x_border (gb, in_row, out_row, c);
+  for (c = MAX (center, gb->width - center); c < gb->width; c++)
+    blur_pixel_x_border (gb, in_row, out_row, c);
+
+  /* Everything else at once, making use of the kernel being symmetric */
+  start = center * 4;
+  end = (gb->width - center) * 4;
+  if (end <= start)
+    return;
+
+  for (j = start; j < end; j++)
+    acc[j] = kernel[center] * in_row[j];
+
+  for (i = 1; i <= center; i++) {
+    const guint8 *left = in_row - i * 4, *right = in_row + i * 4;
+    gint32 coeff = kernel[center + i];
+
+    for (j = start; j < end; j++)
+      acc[j] += coeff * (left[j] + right[j]);
   }
+
+  for (j = start; j < end; j++)
+    out_row[j] = (acc[j] + (1 << (KERNEL_SHIFT - TEMP_SHIFT - 1))) >>
+        (KERNEL_SHIFT - TEMP_SHIFT);
 }
 
+/* Blurs the image in place. Only windowsize horizontally blurred rows are
+ * kept around, an output row is written once all the input rows it depends
+ * on have been consumed. */
 static void
-gaussian_smooth (GstGaussianBlur * gb, guint8 * image, guint8 * out_image)
+gaussian_smooth (GstGaussianBlur * gb, guint8 * image)
 {
-  int r, c, rr, center;
-  float dot[4], sum;
-  int k, kmin, kmax;
-  guint8 *in_row = image;
-  float *tmp_out_row = gb->tempim;
-  float *tmp_in_pos;
+  const gint32 *kernel = gb->kernel;
+  gint windowsize = gb->windowsize;
+  gint center = windowsize / 2;
+  gint row_len = gb->width * 4;
+  const gint16 **rows = g_newa (const gint16 *, windowsize);
+  gint32 *acc = gb->tempacc;
+  gint r, j, i, k, kmin, kmax;
   gint y_avail = 0;
-  guint8 *out_row;
+  gint32 sum;
 
-  /* Apply the gaussian kernel */
-  center = gb->windowsize / 2;
-
-  /* Blur in the y - direction. */
   for (r = 0; r < gb->height; r++) {
-    /* Calculate input row range */
-    rr = center - r;
-    kmin = MAX (0, rr);
-    rr = kmin - rr;
-    /* Calc max */
-    kmax = MIN (gb->windowsize, gb->height - rr);
-
-    /* Precalculate sum for range */
-    sum = gb->kernel_sum[kmax - 1];
-    sum -= kmin ? gb->kernel_sum[kmin - 1] : 0.0;
+    guint8 *out_row = image + r * gb->stride;
 
     /* Blur more input rows (x direction blur) */
     while (y_avail <= (r + center) && y_avail < gb->height) {
-      blur_row_x (gb, in_row, tmp_out_row);
-      in_row += gb->stride;
-      tmp_out_row += gb->stride;
+      blur_row_x (gb, image + y_avail * gb->stride,
+          gb->tempim + (y_avail % windowsize) * row_len);
       y_avail++;
     }
 
-    tmp_in_pos = gb->tempim + (rr * gb->stride);
-    out_row = out_image + r * gb->stride;
+    /* Calculate input row range */
+    kmin = MAX (0, center - r);
+    kmax = MIN (windowsize, gb->height - r + center);
+    for (k = kmin; k < kmax; k++)
+      rows[k] = gb->tempim + ((r - center + k) % windowsize) * row_len;
+
+    /* Blur in the y - direction. Whole rows are accumulated at once, which
+     * compilers can vectorize */
+    if (kmin == 0 && kmax == windowsize) {
+      gint32 coeff = kernel[center];
+      const gint16 *row = rows[center];
+
+      for (j = 0; j < row_len; j++)
+        acc[j] = coeff * row[j];
+
+      for (i = 1; i <= center; i++) {
+        const gint16 *above = rows[center - i], *below = rows[center + i];
+
+        coeff = kernel[center + i];
+        for (j = 0; j < row_len; j++)
+          acc[j] += coeff * (above[j] + below[j]);
+      }
 
-    for (c = 0; c < gb->width; c++) {
-      float *tmp = tmp_in_pos;
+      for (j = 0; j < row_len; j++) {
+        gint32 dot = (acc[j] + (1 << (KERNEL_SHIFT + TEMP_SHIFT - 1))) >>
+            (KERNEL_SHIFT + TEMP_SHIFT);
 
-      dot[0] = dot[1] = dot[2] = dot[3] = 0.0;
-      for (k = kmin; k < kmax; k++, tmp += gb->stride) {
-        float kern = gb->kernel[k];
-        dot[0] += tmp[0] * kern;
-        dot[1] += tmp[1] * kern;
-        dot[2] += tmp[2] * kern;
-        dot[3] += tmp[3] * kern;
+        out_row[j] = CLAMP (dot, 0, 255);
       }
+    } else {
+      sum = kernel_range_sum (gb, kmin, kmax) << TEMP_SHIFT;
+
+      for (j = 0; j < row_len; j++) {
+        gint32 dot = 0;
 
-      *out_row++ = (guint8) CLAMP ((dot[0] / sum + 0.5), 0, 255);
-      *out_row++ = (guint8) CLAMP ((dot[1] / sum + 0.5), 0, 255);
-      *out_row++ = (guint8) CLAMP ((dot[2] / sum + 0.5), 0, 255);
-      *out_row++ = (guint8) CLAMP ((dot[3] / sum + 0.5), 0, 255);
+        for (k = kmin; k < kmax; k++)
+          dot += kernel[k] * rows[k][j];
 
-      tmp_in_pos += 4;
+        dot = div_round (dot, sum);
+        out_row[j] = CLAMP (dot, 0, 255);
+      }
     }
   }
 }
@@ -360,45 +424,59 @@ static gboolean
 make_gaussian_kernel (GstGaussianBlur * gb, float sigma)
 {
   int i, center, left, right;
-  float sum, sum2;
+  float sum;
+  gint32 sum2;
+  float *kernel;
   const float fe = -0.5 / (sigma * sigma);
   const float dx = 1.0 / (sigma * sqrt (2 * G_PI));
 
   center = ceil (2.5 * fabs (sigma));
   gb->windowsize = (int) (1 + 2 * center);
 
-  gb->kernel = g_new (float, gb->windowsize);
-  gb->kernel_sum = g_new (float, gb->windowsize);
-  if (gb->kernel == NULL || gb->kernel_sum == NULL)
+  gb->kernel = g_new (gint32, gb->windowsize);
+  gb->kernel_sum = g_new (gint32, gb->windowsize);
+  gb->tempim = g_renew (gint16, gb->tempim,
+      (gsize) gb->windowsize * gb->width * 4);
+  gb->tempacc = g_renew (gint32, gb->tempacc, gb->width * 4);
+  if (gb->kernel == NULL || gb->kernel_sum == NULL || gb->tempim == NULL
+      || gb->tempacc == NULL)
     return FALSE;
 
   if (gb->windowsize == 1) {
-    gb->kernel[0] = 1.0;
-    gb->kernel_sum[0] = 1.0;
+    gb->kernel[0] = 1 << KERNEL_SHIFT;
+    gb->kernel_sum[0] = 1 << KERNEL_SHIFT;
     return TRUE;
   }
 
+  kernel = g_newa (float, gb->windowsize);
+
   /* Center co-efficient */
-  sum = gb->kernel[center] = dx;
+  sum = kernel[center] = dx;
 
   /* Other coefficients */
   left = center - 1;
   right = center + 1;
   for (i = 1; i <= center; i++, left--, right++) {
     float fx = dx * pow (G_E, fe * i * i);
-    gb->kernel[right] = gb->kernel[left] = fx;
+    kernel[right] = kernel[left] = fx;
     sum += 2 * fx;
   }
 
   if (sigma < 0) {
     sum = -sum;
-    gb->kernel[center] += 2.0 * sum;
+    kernel[center] += 2.0 * sum;
   }
 
-  for (i = 0; i < gb->windowsize; i++)
-    gb->kernel[i] /= sum;
+  /* Convert to fixed point, the center co-efficient absorbs the rounding
+   * errors so that the kernel still sums up to exactly one */
+  sum2 = 0;
+  for (i = 0; i < gb->windowsize; i++) {
+    gb->kernel[i] = floor (kernel[i] / sum * (1 << KERNEL_SHIFT) + 0.5);
+    sum2 += gb->kernel[i];
+  }
+  gb->kernel[center] += (1 << KERNEL_SHIFT) - sum2;
 
-  sum2 = 0.0;
+  sum2 = 0;
   for (i = 0; i < gb->windowsize; i++) {
     sum2 += gb->kernel[i];
     gb->kernel_sum[i] = sum2;
@@ -407,13 +485,12 @@ make_gaussian_kernel (GstGaussianBlur * gb, float sigma)
 #if 0
   g_print ("Sigma %f: ", sigma);
   for (i = 0; i < gb->windowsize; i++)
-    g_print ("%f ", gb->kernel[i]);
+    g_print ("%d ", gb->kernel[i]);
   g_print ("\n");
   g_print ("sums: ");
   for (i = 0; i < gb->windowsize; i++)
-    g_print ("%f ", gb->kernel_sum[i]);
+    g_print ("%d ", gb->kernel_sum[i]);
   g_print ("\n");
-  g_print ("sum %f sum2 %f\n", sum, sum2);
 #endif
 
   return TRUE;
@@ -69,10 +69,12 @@ struct _GstGaussianBlur
   float cur_sigma, sigma;
   int windowsize;
 
-  float *kernel;
-  float *kernel_sum;
-  float *tempim;
-  gint16 *smoothedim;
+  /* fixed point kernel, see KERNEL_SHIFT */
+  gint32 *kernel;
+  gint32 *kernel_sum;
+  /* ring of windowsize horizontally blurred rows */
+  gint16 *tempim;
+  gint32 *tempacc;
 };
 
 struct _GstGaussianBlurClass
@@ -66,6 +66,7 @@ enum
   PROP_0,
   PROP_PARSE_PRIVATE_SECTIONS,
   PROP_IGNORE_PCR,
+  PROP_IGNORED_TABLE_IDS,
   /* FILL ME */
 };
 
@@ -158,6 +159,23 @@ mpegts_base_class_init (MpegTSBaseClass * klass)
           "Ignore PCR stream for timing", DEFAULT_IGNORE_PCR,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstMpegtsBase:ignored-table-ids:
+   *
+   * List of table_id whose sections are dropped as early as possible,
+   * before being reassembled. This is useful to avoid spending time on
+   * tables the application is not interested in, like the EIT schedule
+   * tables in full DVB multiplexes. The PAT and PMT can not be ignored.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_IGNORED_TABLE_IDS,
+      gst_param_spec_array ("ignored-table-ids", "Ignored table ids",
+          "List of section table_id to ignore",
+          g_param_spec_uint ("table-id", "Table id", "Section table_id",
+              0, 255, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS),
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   klass->sink_query = GST_DEBUG_FUNCPTR (mpegts_base_default_sink_query);
 
   gst_type_mark_as_plugin_api (GST_TYPE_MPEGTS_BASE, 0);
@@ -176,6 +194,30 @@ mpegts_base_set_property (GObject * object, guint prop_id,
     case PROP_IGNORE_PCR:
       base->ignore_pcr = g_value_get_boolean (value);
       break;
+    case PROP_IGNORED_TABLE_IDS:{
+      guint i, n = gst_value_array_get_size (value);
+
+      for (i = 0; i < 256; i++)
+        mpegts_packetizer_set_table_id_ignored (base->packetizer, i, FALSE);
+
+      for (i = 0; i < n; i++) {
+        const GValue *v = gst_value_array_get_value (value, i);
+        guint table_id;
+
+        g_return_if_fail (G_VALUE_HOLDS_UINT (v));
+        table_id = g_value_get_uint (v);
+
+        /* We always need those to figure out the streams */
+        if (table_id == GST_MTS_TABLE_ID_PROGRAM_ASSOCIATION ||
+            table_id == GST_MTS_TABLE_ID_TS_PROGRAM_MAP) {
+          GST_WARNING_OBJECT (base, "Can't ignore table_id 0x%02x", table_id);
+          continue;
+        }
+        mpegts_packetizer_set_table_id_ignored (base->packetizer, table_id,
+            TRUE);
+      }
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -194,6 +236,22 @@ mpegts_base_get_property (GObject * object, guint prop_id,
     case PROP_IGNORE_PCR:
       g_value_set_boolean (value, base->ignore_pcr);
       break;
+    case PROP_IGNORED_TABLE_IDS:{
+      guint i;
+
+      for (i = 0; i < 256; i++) {
+        GValue v = G_VALUE_INIT;
+
+        if (!mpegts_packetizer_get_table_id_ignored (base->packetizer, i))
+          continue;
+
+        g_value_init (&v, G_TYPE_UINT);
+        g_value_set_uint (&v, i);
+        gst_value_array_append_value (value, &v);
+        g_value_unset (&v);
+      }
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -61,6 +61,13 @@ static void record_pcr (MpegTSPacketizer2 * packetizer, MpegTSPCR * pcrtable,
 #define TABLE_ID_UNSET 0xFF
 #define PACKET_SYNC_BYTE 0x47
 
+static void
+pcr_offset_group_free (PCROffsetGroup * group)
+{
+  g_free (group->values);
+  g_slice_free (PCROffsetGroup, group);
+}
+
 static inline MpegTSPCR *
 get_pcr_table (MpegTSPacketizer2 * packetizer, guint16 pid)
 {
@@ -91,27 +98,22 @@ get_pcr_table (MpegTSPacketizer2 * packetizer, guint16 pid)
     res->prev_out_time = GST_CLOCK_TIME_NONE;
     res->pcroffset = 0;
 
+    res->groups =
+        g_ptr_array_new_with_free_func ((GDestroyNotify) pcr_offset_group_free);
+    res->groups_sorted_by_pcr = TRUE;
     res->current = g_slice_new0 (PCROffsetCurrent);
   }
 
   return res;
 }
 
-static void
-pcr_offset_group_free (PCROffsetGroup * group)
-{
-  g_free (group->values);
-  g_slice_free (PCROffsetGroup, group);
-}
-
 static void
 flush_observations (MpegTSPacketizer2 * packetizer)
 {
   gint i;
 
   for (i = 0; i < packetizer->lastobsid; i++) {
-    g_list_free_full (packetizer->observations[i]->groups,
-        (GDestroyNotify) pcr_offset_group_free);
+    g_ptr_array_unref (packetizer->observations[i]->groups);
     if (packetizer->observations[i]->current)
       g_slice_free (PCROffsetCurrent, packetizer->observations[i]->current);
     g_free (packetizer->observations[i]);
@@ -1085,6 +1087,20 @@ section_start:
       G_GSIZE_FORMAT ")", stream->pid, (gsize) (packet->data_end - data));
   GST_MEMDUMP ("section_start", data, packet->data_end - data);
   data_start = data;
+
+  /* Drop sections from ignored tables before doing any other work on them
+   * (accumulating, tracking versions, ...) */
+  if (G_UNLIKELY (MPEGTS_BIT_IS_SET (packetizer->ignored_table_ids, *data))) {
+    section_length = (GST_READ_UINT16_BE (data + 1) & 0xfff) + 3;
+    to_read = MIN (section_length, packet->data_end - data_start);
+    GST_LOG ("PID 0x%04x skipping ignored table_id:0x%02x", packet->pid,
+        *data);
+    data = data_start + to_read;
+    if (data == packet->data_end || *data == 0xff)
+      goto out;
+    goto section_start;
+  }
+
   /* Beginning of a new section */
   /*
    * section_syntax_indicator means that the header is of the following format:
@@ -1573,14 +1589,14 @@ _reevaluate_group_pcr_offset (MpegTSPCR * pcrtable, PCROffsetGroup * group)
 {
   PCROffsetGroup *prev = NULL;
 #ifndef GST_DISABLE_GST_DEBUG
-  PCROffsetGroup *first = pcrtable->groups->data;
+  PCROffsetGroup *first = g_ptr_array_index (pcrtable->groups, 0);
 #endif
   PCROffsetCurrent *current = pcrtable->current;
-  GList *tmp;
+  guint i;
 
   /* Go over all ESTIMATED groups until the target group */
-  for (tmp = pcrtable->groups; tmp; tmp = tmp->next) {
-    PCROffsetGroup *cur = (PCROffsetGroup *) tmp->data;
+  for (i = 0; i < pcrtable->groups->len; i++) {
+    PCROffsetGroup *cur = g_ptr_array_index (pcrtable->groups, i);
 
     /* Skip groups that don't need re-evaluation */
     if (!(cur->flags & PCR_GROUP_FLAG_ESTIMATED)) {
@@ -1788,32 +1804,101 @@ _insert_group_after (MpegTSPCR * pcrtable, PCROffsetGroup * group,
 {
   if (prev == NULL) {
     /* First group */
-    pcrtable->groups = g_list_prepend (pcrtable->groups, group);
+    g_ptr_array_insert (pcrtable->groups, 0, group);
   } else {
-    GList *tmp, *toinsert, *prevlist = NULL, *nextlist = NULL;
-    /* Insert before next and prev */
-    for (tmp = pcrtable->groups; tmp; tmp = tmp->next) {
-      if (tmp->data == prev) {
-        prevlist = tmp;
-        nextlist = tmp->next;
+    gint i;
+
+    /* Groups are mostly appended, look for prev from the end */
+    for (i = pcrtable->groups->len - 1; i >= 0; i--) {
+      if (g_ptr_array_index (pcrtable->groups, i) == prev)
         break;
-      }
     }
-    if (!prevlist) {
+    if (i < 0) {
       /* The non NULL prev given isn't in the list */
       GST_WARNING ("Request to insert before a group which isn't in the list");
-      pcrtable->groups = g_list_prepend (pcrtable->groups, group);
+      g_ptr_array_insert (pcrtable->groups, 0, group);
     } else {
-      toinsert = g_list_append (NULL, group);
-      toinsert->next = nextlist;
-      toinsert->prev = prevlist;
-      prevlist->next = toinsert;
-      if (nextlist)
-        nextlist->prev = toinsert;
+      g_ptr_array_insert (pcrtable->groups, i + 1, group);
+    }
+  }
+}
+
+/* Returns the number of groups starting at or before @offset.
+ * Groups are sorted by offset and don't overlap */
+static guint
+_groups_upper_bound_offset (GPtrArray * groups, guint64 offset)
+{
+  guint lo = 0, hi = groups->len;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    PCROffsetGroup *group = g_ptr_array_index (groups, mid);
+
+    if (group->first_offset <= offset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+/* Checks whether the groups are still sorted by pcr_offset. Must be called
+ * whenever a group is added or its pcr_offset is modified */
+static void
+_update_groups_pcr_order (MpegTSPCR * pcrtable)
+{
+  GPtrArray *groups = pcrtable->groups;
+  guint i;
+
+  pcrtable->groups_sorted_by_pcr = TRUE;
+  for (i = 1; i < groups->len; i++) {
+    PCROffsetGroup *prev = g_ptr_array_index (groups, i - 1);
+    PCROffsetGroup *cur = g_ptr_array_index (groups, i);
+
+    if (cur->pcr_offset < prev->pcr_offset) {
+      GST_DEBUG ("Group %p pcr_offset %" GST_TIME_FORMAT
+          " is before previous group %p pcr_offset %" GST_TIME_FORMAT, cur,
+          GST_TIME_ARGS (PCRTIME_TO_GSTTIME (cur->pcr_offset)), prev,
+          GST_TIME_ARGS (PCRTIME_TO_GSTTIME (prev->pcr_offset)));
+      pcrtable->groups_sorted_by_pcr = FALSE;
+      break;
     }
   }
 }
 
+/* Returns the number of groups before the first one whose pcr_offset is
+ * after @pcr. Groups don't overlap, but estimated pcr_offset might not be
+ * in order, in which case the groups are scanned linearly */
+static guint
+_groups_upper_bound_pcr_offset (MpegTSPCR * pcrtable, guint64 pcr)
+{
+  GPtrArray *groups = pcrtable->groups;
+  guint lo = 0, hi = groups->len;
+
+  if (G_UNLIKELY (!pcrtable->groups_sorted_by_pcr)) {
+    for (lo = 0; lo < groups->len; lo++) {
+      PCROffsetGroup *group = g_ptr_array_index (groups, lo);
+
+      if (group->pcr_offset > pcr)
+        break;
+    }
+    return lo;
+  }
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    PCROffsetGroup *group = g_ptr_array_index (groups, mid);
+
+    if (group->pcr_offset <= pcr)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
 static void
 _use_group (MpegTSPCR * pcrtable, PCROffsetGroup * group)
 {
@@ -1882,6 +1967,7 @@ _set_current_group (MpegTSPCR * pcrtable,
   _insert_group_after (pcrtable, group, prev);
   if (!contiguous)
     _reevaluate_group_pcr_offset (pcrtable, group);
+  _update_groups_pcr_order (pcrtable);
 }
 
 static inline void
@@ -1947,7 +2033,7 @@ record_pcr (MpegTSPacketizer2 * packetizer, MpegTSPCR * pcrtable,
   /* Check for current */
   if (G_UNLIKELY (current->group == NULL)) {
     PCROffsetGroup *prev = NULL;
-    GList *tmp;
+    guint i;
     /* No current estimator. This happens for the initial value, or after
      * discont and flushes. Figure out where we need to record this position.
      *
@@ -1962,8 +2048,8 @@ record_pcr (MpegTSPacketizer2 * packetizer, MpegTSPCR * pcrtable,
      *    Initialize current to that group
      */
     GST_DEBUG ("No current window estimator, Checking for group to use");
-    for (tmp = pcrtable->groups; tmp; tmp = tmp->next) {
-      PCROffsetGroup *group = (PCROffsetGroup *) tmp->data;
+    for (i = 0; i < pcrtable->groups->len; i++) {
+      PCROffsetGroup *group = g_ptr_array_index (pcrtable->groups, i);
 
       GST_DEBUG ("First PCR:%" GST_TIME_FORMAT " offset:%" G_GUINT64_FORMAT
           " PCR_offset:%" GST_TIME_FORMAT,
@@ -2144,7 +2230,6 @@ mpegts_packetizer_offset_to_ts (MpegTSPacketizer2 * packetizer,
 {
   PCROffsetGroup *last;
   MpegTSPCR *pcrtable;
-  GList *tmp;
   GstClockTime res;
   guint64 lastpcr, lastoffset;
 
@@ -2163,21 +2248,22 @@ mpegts_packetizer_offset_to_ts (MpegTSPacketizer2 * packetizer,
 
   pcrtable = get_pcr_table (packetizer, pid);
 
-  if (g_list_length (pcrtable->groups) < 1) {
+  if (pcrtable->groups->len < 1) {
     PACKETIZER_GROUP_UNLOCK (packetizer);
     GST_WARNING ("Not enough observations to return a duration estimate");
     return GST_CLOCK_TIME_NONE;
   }
 
-  if (g_list_length (pcrtable->groups) > 1) {
+  if (pcrtable->groups->len > 1) {
     GST_LOG ("Using last group");
 
     /* FIXME : Refine this later to use neighbouring groups */
-    tmp = g_list_last (pcrtable->groups);
-    last = tmp->data;
+    last = g_ptr_array_index (pcrtable->groups, pcrtable->groups->len - 1);
 
-    if (G_UNLIKELY (last->flags & PCR_GROUP_FLAG_ESTIMATED))
+    if (G_UNLIKELY (last->flags & PCR_GROUP_FLAG_ESTIMATED)) {
       _reevaluate_group_pcr_offset (pcrtable, last);
+      _update_groups_pcr_order (pcrtable);
+    }
 
     /* lastpcr is the full value in PCR from the first first chunk of data */
     lastpcr = last->values[last->last_value].pcr + last->pcr_offset;
@@ -2261,7 +2347,7 @@ mpegts_packetizer_pts_to_ts (MpegTSPacketizer2 * packetizer,
       else
         res = GST_CLOCK_TIME_NONE;
     }
-  } else if (packetizer->calculate_offset && pcrtable->groups) {
+  } else if (packetizer->calculate_offset && pcrtable->groups->len > 0) {
     gint64 refpcr = G_MAXINT64, refpcroffset;
     PCROffsetGroup *group = pcrtable->current->group;
 
@@ -2293,36 +2379,23 @@ mpegts_packetizer_pts_to_ts (MpegTSPacketizer2 * packetizer,
           refpcr = G_MAXINT64;
       }
     } else {
-      GList *tmp;
-      /* Otherwise, find a suitable group */
+      guint n;
+      /* Otherwise, find a suitable group: the last one starting before
+       * the current offset */
 
       GST_DEBUG ("Find group for current offset %" G_GUINT64_FORMAT,
           packetizer->offset);
 
-      for (tmp = pcrtable->groups; tmp; tmp = tmp->next) {
-        PCROffsetGroup *tgroup = tmp->data;
-        GST_DEBUG ("Trying First PCR:%" GST_TIME_FORMAT " offset:%"
+      n = _groups_upper_bound_offset (pcrtable->groups, packetizer->offset);
+      if (n > 0) {
+        group = g_ptr_array_index (pcrtable->groups, n - 1);
+        GST_DEBUG ("Found First PCR:%" GST_TIME_FORMAT " offset:%"
             G_GUINT64_FORMAT " PCR_offset:%" GST_TIME_FORMAT,
-            GST_TIME_ARGS (PCRTIME_TO_GSTTIME (tgroup->first_pcr)),
-            tgroup->first_offset,
-            GST_TIME_ARGS (PCRTIME_TO_GSTTIME (tgroup->pcr_offset)));
-        /* Gone too far ? */
-        if (tgroup->first_offset > packetizer->offset) {
-          /* If there isn't a pending reset, use that value */
-          if (group) {
-            GST_DEBUG ("PTS is %" GST_TIME_FORMAT " into group",
-                GST_TIME_ARGS (pts - PCRTIME_TO_GSTTIME (group->first_pcr)));
-          }
-          break;
-        }
-        group = tgroup;
-        /* In that group ? */
-        if (group->first_offset + group->values[group->last_value].offset >
-            packetizer->offset) {
-          GST_DEBUG ("PTS is %" GST_TIME_FORMAT " into group",
-              GST_TIME_ARGS (pts - PCRTIME_TO_GSTTIME (group->first_pcr)));
-          break;
-        }
+            GST_TIME_ARGS (PCRTIME_TO_GSTTIME (group->first_pcr)),
+            group->first_offset,
+            GST_TIME_ARGS (PCRTIME_TO_GSTTIME (group->pcr_offset)));
+        GST_DEBUG ("PTS is %" GST_TIME_FORMAT " into group",
+            GST_TIME_ARGS (pts - PCRTIME_TO_GSTTIME (group->first_pcr)));
       }
       if (group && !(group->flags & PCR_GROUP_FLAG_RESET)) {
         GST_DEBUG ("Using group !");
@@ -2362,7 +2435,7 @@ mpegts_packetizer_ts_to_offset (MpegTSPacketizer2 * packetizer,
   PCROffsetGroup *nextgroup = NULL, *prevgroup = NULL;
   guint64 querypcr, firstpcr, lastpcr, firstoffset, lastoffset;
   PCROffsetCurrent *current;
-  GList *tmp;
+  guint n;
 
   if (!packetizer->calculate_offset)
     return -1;
@@ -2370,7 +2443,7 @@ mpegts_packetizer_ts_to_offset (MpegTSPacketizer2 * packetizer,
   PACKETIZER_GROUP_LOCK (packetizer);
   pcrtable = get_pcr_table (packetizer, pcr_pid);
 
-  if (pcrtable->groups == NULL) {
+  if (pcrtable->groups->len == 0) {
     PACKETIZER_GROUP_UNLOCK (packetizer);
     return -1;
   }
@@ -2389,37 +2462,37 @@ mpegts_packetizer_ts_to_offset (MpegTSPacketizer2 * packetizer,
     goto calculate_points;
   }
 
-  /* Find the neighbouring groups */
-  for (tmp = pcrtable->groups; tmp; tmp = tmp->next) {
-    nextgroup = (PCROffsetGroup *) tmp->data;
-
-    GST_DEBUG ("Trying group PCR %" GST_TIME_FORMAT " (offset %"
-        G_GUINT64_FORMAT " pcr_offset %" GST_TIME_FORMAT,
-        GST_TIME_ARGS (PCRTIME_TO_GSTTIME (nextgroup->first_pcr)),
-        nextgroup->first_offset,
-        GST_TIME_ARGS (PCRTIME_TO_GSTTIME (nextgroup->pcr_offset)));
-
-    /* Check if we've gone too far */
-    if (nextgroup->pcr_offset > querypcr) {
-      GST_DEBUG ("pcr is before that group");
-      break;
-    }
-
-    if (tmp->next == NULL) {
-      GST_DEBUG ("pcr is beyond last group");
-      break;
-    }
-
-    prevgroup = nextgroup;
+  /* Find the neighbouring groups: the last group starting before the
+   * requested PCR and the one following it */
+  n = _groups_upper_bound_pcr_offset (pcrtable, querypcr);
+  if (n == 0) {
+    GST_DEBUG ("pcr is before first group");
+    nextgroup = g_ptr_array_index (pcrtable->groups, 0);
+  } else if (n == pcrtable->groups->len) {
+    GST_DEBUG ("pcr is beyond last group");
+    nextgroup = g_ptr_array_index (pcrtable->groups, n - 1);
+    if (n > 1)
+      prevgroup = g_ptr_array_index (pcrtable->groups, n - 2);
+  } else {
+    prevgroup = g_ptr_array_index (pcrtable->groups, n - 1);
 
     /* Maybe it's in this group */
-    if (nextgroup->values[nextgroup->last_value].pcr +
-        nextgroup->pcr_offset >= querypcr) {
+    if (prevgroup->values[prevgroup->last_value].pcr +
+        prevgroup->pcr_offset >= querypcr) {
       GST_DEBUG ("pcr is in that group");
-      break;
+      nextgroup = prevgroup;
+    } else {
+      GST_DEBUG ("pcr is before the next group");
+      nextgroup = g_ptr_array_index (pcrtable->groups, n);
     }
   }
 
+  GST_DEBUG ("Using group PCR %" GST_TIME_FORMAT " (offset %"
+      G_GUINT64_FORMAT " pcr_offset %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (PCRTIME_TO_GSTTIME (nextgroup->first_pcr)),
+      nextgroup->first_offset,
+      GST_TIME_ARGS (PCRTIME_TO_GSTTIME (nextgroup->pcr_offset)));
+
 calculate_points:
 
   GST_DEBUG ("nextgroup:%p, prevgroup:%p", nextgroup, prevgroup);
@@ -2479,6 +2552,23 @@ mpegts_packetizer_set_reference_offset (MpegTSPacketizer2 * packetizer,
   PACKETIZER_GROUP_UNLOCK (packetizer);
 }
 
+void
+mpegts_packetizer_set_table_id_ignored (MpegTSPacketizer2 * packetizer,
+    guint8 table_id, gboolean ignored)
+{
+  if (ignored)
+    MPEGTS_BIT_SET (packetizer->ignored_table_ids, table_id);
+  else
+    MPEGTS_BIT_UNSET (packetizer->ignored_table_ids, table_id);
+}
+
+gboolean
+mpegts_packetizer_get_table_id_ignored (MpegTSPacketizer2 * packetizer,
+    guint8 table_id)
+{
+  return MPEGTS_BIT_IS_SET (packetizer->ignored_table_ids, table_id) != 0;
+}
+
 void
 mpegts_packetizer_set_pcr_discont_threshold (MpegTSPacketizer2 * packetizer,
     GstClockTime threshold)
@@ -2496,7 +2586,7 @@ mpegts_packetizer_set_current_pcr_offset (MpegTSPacketizer2 * packetizer,
   gint64 delta;
   MpegTSPCR *pcrtable;
   PCROffsetGroup *group;
-  GList *tmp;
+  guint i;
   gboolean apply = FALSE;
 
   /* fast path */
@@ -2511,8 +2601,8 @@ mpegts_packetizer_set_current_pcr_offset (MpegTSPacketizer2 * packetizer,
   pcr_offset = GSTTIME_TO_PCRTIME (offset);
 
   /* Pick delta from *first* group */
-  if (pcrtable->groups)
-    group = pcrtable->groups->data;
+  if (pcrtable->groups->len > 0)
+    group = g_ptr_array_index (pcrtable->groups, 0);
   else
     group = pcrtable->current->group;
   GST_DEBUG ("Current group PCR %" GST_TIME_FORMAT " (offset %"
@@ -2533,8 +2623,8 @@ mpegts_packetizer_set_current_pcr_offset (MpegTSPacketizer2 * packetizer,
       " for new initial pcr_offset %" GST_TIME_FORMAT,
       GST_TIME_ARGS (PCRTIME_TO_GSTTIME (delta)), GST_TIME_ARGS (offset));
 
-  for (tmp = pcrtable->groups; tmp; tmp = tmp->next) {
-    PCROffsetGroup *tgroup = (tmp->data);
+  for (i = 0; i < pcrtable->groups->len; i++) {
+    PCROffsetGroup *tgroup = g_ptr_array_index (pcrtable->groups, i);
     if (tgroup == group)
       apply = TRUE;
     if (apply) {
@@ -2551,5 +2641,6 @@ mpegts_packetizer_set_current_pcr_offset (MpegTSPacketizer2 * packetizer,
           tgroup->first_offset,
           GST_TIME_ARGS (PCRTIME_TO_GSTTIME (tgroup->pcr_offset)));
   }
+  _update_groups_pcr_order (pcrtable);
   PACKETIZER_GROUP_UNLOCK (packetizer);
 }
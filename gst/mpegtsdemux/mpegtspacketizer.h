@@ -234,8 +234,11 @@ typedef struct _MpegTSPCR
   guint64 pcroffset;
 
   /* Used for bitrate calculation */
-  /* List of PCR/offset observations */
-  GList *groups;
+  /* Array of PCR/offset observations (PCROffsetGroup), sorted by offset */
+  GPtrArray *groups;
+  /* Whether the groups are also sorted by pcr_offset. This can stop being
+   * the case when the pcr_offset of ESTIMATED groups gets re-evaluated */
+  gboolean groups_sorted_by_pcr;
 
   /* Current PCR/offset observations (used to update pcroffsets) */
   PCROffsetCurrent *current;
@@ -283,6 +286,10 @@ struct _MpegTSPacketizer2 {
   MpegTSPCR *observations[MAX_PCR_OBS_CHANNELS];
   guint8 lastobsid;
   GstClockTime pcr_discont_threshold;
+
+  /* Bitfield of table_id whose sections are dropped before being
+   * reassembled. Use MPEGTS_BIT_* macros to check */
+  guint8 ignored_table_ids[32];
 };
 
 struct _MpegTSPacketizer2Class {
@@ -374,6 +381,12 @@ G_GNUC_INTERNAL void
 mpegts_packetizer_set_reference_offset (MpegTSPacketizer2 * packetizer,
 					guint64 refoffset);
 G_GNUC_INTERNAL void
+mpegts_packetizer_set_table_id_ignored (MpegTSPacketizer2 * packetizer,
+					guint8 table_id, gboolean ignored);
+G_GNUC_INTERNAL gboolean
+mpegts_packetizer_get_table_id_ignored (MpegTSPacketizer2 * packetizer,
+					guint8 table_id);
+G_GNUC_INTERNAL void
 mpegts_packetizer_set_pcr_discont_threshold (MpegTSPacketizer2 * packetizer,
 					GstClockTime threshold);
 G_END_DECLS
@@ -24,6 +24,8 @@
  * @title: removesilence
  *
  * Removes all silence periods from an audio stream, dropping silence buffers.
+ * With the "trim" property enabled, buffers are instead cut at the exact
+ * sample where silence begins or ends.
  * If the "silent" property is disabled, removesilence will generate
  * bus messages named "removesilence". 
  * The message's structure contains one of these fields:
@@ -60,6 +62,7 @@ GST_DEBUG_CATEGORY_STATIC (gst_remove_silence_debug);
 #define MINIMUM_SILENCE_TIME_MAX  10000000000
 #define MINIMUM_SILENCE_TIME_DEF  0
 #define DEFAULT_VAD_THRESHOLD -60
+#define DEFAULT_TRIM FALSE
 
 /* Filter signals and args */
 enum
@@ -77,25 +80,25 @@ enum
   PROP_SQUASH,
   PROP_SILENT,
   PROP_MINIMUM_SILENCE_BUFFERS,
-  PROP_MINIMUM_SILENCE_TIME
+  PROP_MINIMUM_SILENCE_TIME,
+  PROP_TRIM
 };
 
 
+#define CAPS "audio/x-raw, " \
+    "format = (string) { " GST_AUDIO_NE (S16) ", " GST_AUDIO_NE (F32) " }, " \
+    "layout = (string) interleaved, " \
+    "rate = (int) [ 1, MAX ], " "channels = (int) [ 1, MAX ]"
+
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("audio/x-raw, "
-        "format = (string) " GST_AUDIO_NE (S16) ", "
-        "layout = (string) interleaved, "
-        "rate = (int) [ 1, MAX ], " "channels = (int) 1"));
+    GST_STATIC_CAPS (CAPS));
 
 static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("audio/x-raw, "
-        "format = (string) " GST_AUDIO_NE (S16) ", "
-        "layout = (string) interleaved, "
-        "rate = (int) [ 1, MAX ], " "channels = (int) 1"));
+    GST_STATIC_CAPS (CAPS));
 
 
 #define DEBUG_INIT(bla) \
@@ -111,10 +114,14 @@ static void gst_remove_silence_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 
 static gboolean gst_remove_silence_start (GstBaseTransform * trans);
+static gboolean gst_remove_silence_set_caps (GstBaseTransform * trans,
+    GstCaps * incaps, GstCaps * outcaps);
 static gboolean gst_remove_silence_sink_event (GstBaseTransform * trans,
     GstEvent * event);
 static GstFlowReturn gst_remove_silence_transform_ip (GstBaseTransform * base,
     GstBuffer * buf);
+static GstFlowReturn gst_remove_silence_generate_output (GstBaseTransform *
+    trans, GstBuffer ** outbuf);
 static void gst_remove_silence_finalize (GObject * obj);
 
 /* GObject vmethod implementations */
@@ -177,6 +184,21 @@ gst_remove_silence_class_init (GstRemoveSilenceClass * klass)
           MINIMUM_SILENCE_TIME_MIN, MINIMUM_SILENCE_TIME_MAX,
           MINIMUM_SILENCE_TIME_DEF, G_PARAM_READWRITE));
 
+  /**
+   * GstRemoveSilence:trim
+   *
+   * Run the voice activity detection on every sample and cut buffers at the
+   * exact sample where silence begins or ends, instead of dropping whole
+   * buffers. The "minimum_silence_time" is then applied in samples and
+   * "minimum-silence-buffers" is ignored.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_TRIM,
+      g_param_spec_boolean ("trim", "Trim",
+          "Cut buffers at the exact sample where silence begins or ends",
+          DEFAULT_TRIM, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class,
       "RemoveSilence",
       "Filter/Effect/Audio",
@@ -189,12 +211,22 @@ gst_remove_silence_class_init (GstRemoveSilenceClass * klass)
   gst_element_class_add_static_pad_template (gstelement_class, &sink_template);
 
   base_transform_class->start = GST_DEBUG_FUNCPTR (gst_remove_silence_start);
+  base_transform_class->set_caps =
+      GST_DEBUG_FUNCPTR (gst_remove_silence_set_caps);
   base_transform_class->sink_event =
       GST_DEBUG_FUNCPTR (gst_remove_silence_sink_event);
   base_transform_class->transform_ip =
       GST_DEBUG_FUNCPTR (gst_remove_silence_transform_ip);
+  base_transform_class->generate_output =
+      GST_DEBUG_FUNCPTR (gst_remove_silence_generate_output);
 }
 
+typedef struct
+{
+  guint start, end;
+  guint64 removed_before;
+} KeptRange;
+
 static void
 gst_remove_silence_reset (GstRemoveSilence * filter)
 {
@@ -202,6 +234,11 @@ gst_remove_silence_reset (GstRemoveSilence * filter)
   filter->silence_detected = FALSE;
   filter->consecutive_silence_buffers = 0;
   filter->consecutive_silence_time = 0;
+  filter->consecutive_silence_samples = 0;
+  filter->removed_samples = 0;
+  g_array_set_size (filter->kept, 0);
+  filter->next_range = 0;
+  gst_buffer_replace (&filter->pending, NULL);
 }
 
 /* initialize the new element
@@ -218,7 +255,10 @@ gst_remove_silence_init (GstRemoveSilence * filter)
   filter->silent = TRUE;
   filter->minimum_silence_buffers = MINIMUM_SILENCE_BUFFERS_DEF;
   filter->minimum_silence_time = MINIMUM_SILENCE_TIME_DEF;
+  filter->trim = DEFAULT_TRIM;
 
+  gst_audio_info_init (&filter->info);
+  filter->kept = g_array_new (FALSE, FALSE, sizeof (KeptRange));
   gst_remove_silence_reset (filter);
 
   if (!filter->vad) {
@@ -238,6 +278,20 @@ gst_remove_silence_start (GstBaseTransform * trans)
   return TRUE;
 }
 
+static gboolean
+gst_remove_silence_set_caps (GstBaseTransform * trans, GstCaps * incaps,
+    GstCaps * outcaps)
+{
+  GstRemoveSilence *filter = GST_REMOVE_SILENCE (trans);
+
+  if (!gst_audio_info_from_caps (&filter->info, incaps)) {
+    GST_ERROR_OBJECT (filter, "invalid caps %" GST_PTR_FORMAT, incaps);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
 static gboolean
 gst_remove_silence_sink_event (GstBaseTransform * trans, GstEvent * event)
 {
@@ -260,6 +314,10 @@ gst_remove_silence_finalize (GObject * obj)
   GST_DEBUG ("Destroying VAD");
   vad_destroy (filter->vad);
   filter->vad = NULL;
+  g_free (filter->mono);
+  filter->mono = NULL;
+  g_array_free (filter->kept, TRUE);
+  gst_buffer_replace (&filter->pending, NULL);
   GST_DEBUG ("VAD Destroyed");
   G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
@@ -292,6 +350,9 @@ gst_remove_silence_set_property (GObject * object, guint prop_id,
     case PROP_MINIMUM_SILENCE_TIME:
       filter->minimum_silence_time = g_value_get_uint64 (value);
       break;
+    case PROP_TRIM:
+      filter->trim = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -326,12 +387,253 @@ gst_remove_silence_get_property (GObject * object, guint prop_id,
     case PROP_MINIMUM_SILENCE_TIME:
       g_value_set_uint64 (value, filter->minimum_silence_time);
       break;
+    case PROP_TRIM:
+      g_value_set_boolean (value, filter->trim);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+/* The VAD works on S16 mono. Other input is downmixed by averaging the
+ * channels into a scratch buffer */
+static const gint16 *
+gst_remove_silence_get_mono (GstRemoveSilence * filter, const guint8 * data,
+    guint n_frames)
+{
+  const gint channels = GST_AUDIO_INFO_CHANNELS (&filter->info);
+  guint i;
+  gint c;
+
+  if (GST_AUDIO_INFO_FORMAT (&filter->info) == GST_AUDIO_FORMAT_S16
+      && channels == 1)
+    return (const gint16 *) data;
+
+  if (filter->mono_len < n_frames) {
+    g_free (filter->mono);
+    filter->mono = g_new (gint16, n_frames);
+    filter->mono_len = n_frames;
+  }
+
+  if (GST_AUDIO_INFO_FORMAT (&filter->info) == GST_AUDIO_FORMAT_S16) {
+    const gint16 *in = (const gint16 *) data;
+
+    for (i = 0; i < n_frames; i++) {
+      gint sum = 0;
+
+      for (c = 0; c < channels; c++)
+        sum += *in++;
+      filter->mono[i] = sum / channels;
+    }
+  } else {
+    const gfloat *in = (const gfloat *) data;
+
+    for (i = 0; i < n_frames; i++) {
+      gfloat sum = 0.0;
+
+      for (c = 0; c < channels; c++)
+        sum += *in++;
+      filter->mono[i] = CLAMP (sum * 32767.0f / channels, -32768.0f, 32767.0f);
+    }
+  }
+
+  return filter->mono;
+}
+
+static void
+gst_remove_silence_post_message (GstRemoveSilence * filter,
+    const gchar * field, GstClockTime pts)
+{
+  GstStructure *s;
+  GstMessage *m;
+
+  s = gst_structure_new ("removesilence", field, G_TYPE_UINT64, pts, NULL);
+  m = gst_message_new_element (GST_OBJECT (filter), s);
+  gst_element_post_message (GST_ELEMENT (filter), m);
+}
+
+static void
+gst_remove_silence_set_range_metadata (GstRemoveSilence * filter,
+    GstBuffer * buf, GstClockTime pts, guint64 offset, const KeptRange * r)
+{
+  const gint rate = GST_AUDIO_INFO_RATE (&filter->info);
+
+  if (GST_CLOCK_TIME_IS_VALID (pts)) {
+    GstClockTime start = pts + gst_util_uint64_scale_int (r->start,
+        GST_SECOND, rate);
+
+    if (filter->squash)
+      start -= MIN (start, gst_util_uint64_scale_int (r->removed_before,
+              GST_SECOND, rate));
+    GST_BUFFER_PTS (buf) = start;
+  }
+  GST_BUFFER_DURATION (buf) =
+      gst_util_uint64_scale_int (r->end - r->start, GST_SECOND, rate);
+
+  if (offset != GST_BUFFER_OFFSET_NONE) {
+    GST_BUFFER_OFFSET (buf) = offset + r->start;
+    GST_BUFFER_OFFSET_END (buf) = offset + r->end;
+  }
+}
+
+/* Sample accurate mode: evaluate the VAD on every sample, and collect the
+ * ranges of the buffer that are not removed as silence */
+static void
+gst_remove_silence_trim (GstRemoveSilence * filter, GstBuffer * inbuf)
+{
+  const gint rate = GST_AUDIO_INFO_RATE (&filter->info);
+  const gint bpf = GST_AUDIO_INFO_BPF (&filter->info);
+  GstClockTime pts = GST_BUFFER_PTS (inbuf);
+  guint64 min_silence_samples;
+  const gint16 *samples;
+  GstMapInfo map;
+  guint n_frames, pos = 0, scan = 0;
+
+  min_silence_samples = gst_util_uint64_scale_int_ceil
+      (filter->minimum_silence_time, rate, GST_SECOND);
+
+  g_array_set_size (filter->kept, 0);
+  filter->next_range = 0;
+  filter->pending_pts = pts;
+  filter->pending_offset = GST_BUFFER_OFFSET (inbuf);
+
+  gst_buffer_map (inbuf, &map, GST_MAP_READ);
+  n_frames = map.size / bpf;
+  samples = gst_remove_silence_get_mono (filter, map.data, n_frames);
+
+  while (pos < n_frames) {
+    gint state = vad_get_state (filter->vad);
+    guint end = n_frames, len, keep;
+
+    /* The sample that changes the state is the first one of the new state.
+     * It was already fed to the VAD when the next range starts with it */
+    if (scan < n_frames) {
+      scan += vad_update_until_change (filter->vad, samples + scan,
+          n_frames - scan);
+      end = vad_get_state (filter->vad) != state ? scan - 1 : scan;
+      if (end == pos)
+        continue;
+    }
+
+    len = keep = end - pos;
+
+    if (state == VAD_SILENCE) {
+      if (filter->consecutive_silence_samples < min_silence_samples)
+        keep = MIN (len, min_silence_samples -
+            filter->consecutive_silence_samples);
+      else
+        keep = 0;
+      filter->consecutive_silence_samples += len;
+
+      if (keep < len && !filter->silence_detected) {
+        if (!filter->silent && GST_CLOCK_TIME_IS_VALID (pts))
+          gst_remove_silence_post_message (filter, "silence_detected",
+              pts + gst_util_uint64_scale_int (pos + keep, GST_SECOND, rate)
+              - filter->ts_offset);
+        filter->silence_detected = TRUE;
+      }
+    } else {
+      filter->consecutive_silence_samples = 0;
+
+      if (filter->silence_detected) {
+        if (!filter->silent && GST_CLOCK_TIME_IS_VALID (pts))
+          gst_remove_silence_post_message (filter, "silence_finished",
+              pts + gst_util_uint64_scale_int (pos, GST_SECOND, rate)
+              - filter->ts_offset);
+        filter->silence_detected = FALSE;
+      }
+    }
+
+    if (!filter->remove)
+      keep = len;
+
+    if (keep > 0) {
+      KeptRange *last = filter->kept->len > 0 ?
+          &g_array_index (filter->kept, KeptRange, filter->kept->len - 1) :
+          NULL;
+
+      if (last && last->end == pos) {
+        last->end = pos + keep;
+      } else {
+        KeptRange r = { pos, pos + keep, filter->removed_samples };
+
+        g_array_append_val (filter->kept, r);
+      }
+    }
+
+    if (keep < len) {
+      filter->removed_samples += len - keep;
+      if (filter->squash)
+        filter->ts_offset = gst_util_uint64_scale_int (filter->removed_samples,
+            GST_SECOND, rate);
+    }
+
+    pos = end;
+  }
+
+  gst_buffer_unmap (inbuf, &map);
+}
+
+/* In trim mode an input buffer results in one output buffer for each of its
+ * kept ranges, which are returned here one at a time */
+static GstFlowReturn
+gst_remove_silence_generate_output (GstBaseTransform * trans,
+    GstBuffer ** outbuf)
+{
+  GstRemoveSilence *filter = GST_REMOVE_SILENCE (trans);
+  const gint bpf = GST_AUDIO_INFO_BPF (&filter->info);
+  const KeptRange *r;
+  GstBuffer *buf;
+
+  if (!filter->trim)
+    return GST_BASE_TRANSFORM_CLASS (parent_class)->generate_output (trans,
+        outbuf);
+
+  *outbuf = NULL;
+
+  if (trans->queued_buf) {
+    gst_buffer_replace (&filter->pending, NULL);
+    filter->pending = trans->queued_buf;
+    trans->queued_buf = NULL;
+    gst_remove_silence_trim (filter, filter->pending);
+
+    if (filter->kept->len == 0)
+      GST_DEBUG_OBJECT (filter, "Removing silent buffer");
+  }
+
+  if (!filter->pending)
+    return GST_FLOW_OK;
+
+  if (filter->next_range == filter->kept->len) {
+    gst_buffer_replace (&filter->pending, NULL);
+    return GST_FLOW_OK;
+  }
+
+  r = &g_array_index (filter->kept, KeptRange, filter->next_range);
+
+  if (filter->kept->len == 1
+      && r->end - r->start == gst_buffer_get_size (filter->pending) / bpf) {
+    /* nothing was removed, output the input buffer itself */
+    buf = gst_buffer_make_writable (filter->pending);
+    filter->pending = NULL;
+  } else {
+    GST_LOG_OBJECT (filter, "Outputting samples %u-%u", r->start, r->end);
+    buf = gst_buffer_copy_region (filter->pending, GST_BUFFER_COPY_ALL,
+        r->start * bpf, (r->end - r->start) * bpf);
+    if (filter->next_range > 0)
+      GST_BUFFER_FLAG_UNSET (buf, GST_BUFFER_FLAG_DISCONT);
+  }
+
+  gst_remove_silence_set_range_metadata (filter, buf, filter->pending_pts,
+      filter->pending_offset, r);
+  filter->next_range++;
+
+  *outbuf = buf;
+
+  return GST_FLOW_OK;
+}
+
 static GstFlowReturn
 gst_remove_silence_transform_ip (GstBaseTransform * trans, GstBuffer * inbuf)
 {
@@ -339,12 +641,15 @@ gst_remove_silence_transform_ip (GstBaseTransform * trans, GstBuffer * inbuf)
   int frame_type;
   GstMapInfo map;
   gboolean consecutive_silence_reached;
+  guint n_frames;
 
   filter = GST_REMOVE_SILENCE (trans);
 
   gst_buffer_map (inbuf, &map, GST_MAP_READ);
-  frame_type =
-      vad_update (filter->vad, (gint16 *) map.data, map.size / sizeof (gint16));
+  n_frames = map.size / GST_AUDIO_INFO_BPF (&filter->info);
+  frame_type = vad_update (filter->vad,
+      (gint16 *) gst_remove_silence_get_mono (filter, map.data, n_frames),
+      n_frames);
   gst_buffer_unmap (inbuf, &map);
 
   if (frame_type == VAD_SILENCE) {
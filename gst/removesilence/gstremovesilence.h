@@ -25,6 +25,7 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstbasetransform.h>
+#include <gst/audio/audio.h>
 #include "vad_private.h"
 
 G_BEGIN_DECLS
@@ -46,13 +47,27 @@ typedef struct _GstRemoveSilence {
   gboolean remove;
   gboolean squash;
   gboolean silent;
+  gboolean trim;
   guint16 minimum_silence_buffers;
   guint64 minimum_silence_time;
   /* filter params protected by STREAM_LOCK */
+  GstAudioInfo info;
   guint64 ts_offset;
   gboolean silence_detected;
   guint64 consecutive_silence_buffers;
   guint64 consecutive_silence_time;
+  /* sample accurate trimming state */
+  guint64 consecutive_silence_samples;
+  guint64 removed_samples;
+  /* ranges of the pending input buffer that are output one by one */
+  GArray *kept;
+  guint next_range;
+  GstBuffer *pending;
+  GstClockTime pending_pts;
+  guint64 pending_offset;
+  /* input downmixed to S16 mono for the VAD */
+  gint16 *mono;
+  guint mono_len;
 } GstRemoveSilence;
 
 typedef struct _GstRemoveSilenceClass {
@@ -80,7 +80,9 @@ vad_reset (VADFilter * vad)
   vad->cqueue.base.s = vad->vad_buffer;
   vad->cqueue.tail.a = vad->cqueue.head.a = 0;
   vad->cqueue.size = VAD_BUFFER_SIZE;
-  vad->vad_state = VAD_SILENCE;
+  /* Without any history there is no reason to consider the input silence
+   * yet, it only becomes silence after the hysteresis */
+  vad->vad_state = VAD_VOICE;
 }
 
 void
@@ -114,35 +116,46 @@ vad_get_threshold_as_db (struct _vad_s *p)
   return (gint) (10 * log10 (p->threshold / 4294967295.0));
 }
 
-gint
-vad_update (struct _vad_s * p, gint16 * data, gint len)
+#define VAD_SIGN_CHANGE(a,b) \
+    ((((a) & 0x8000) != ((b) & 0x8000)) ? 1 : -1)
+
+/* Adds one sample to the power estimate and to the zero crossing window.
+ * The zero crossing rate over the window is kept up to date incrementally:
+ * the pair formed with the previous sample is added, and once the window
+ * is full the pair at its oldest end is dropped again */
+static inline void
+vad_push_sample (struct _vad_s *p, gint16 sample)
 {
-  guint64 tail;
-  gint frame_type;
-  gint16 sample;
-  gint i;
+  guint64 mask = p->cqueue.size - 1;
+  guint64 head = p->cqueue.head.a;
 
-  for (i = 0; i < len; i++) {
-    p->vad_power = VAD_POWER_ALPHA * ((data[i] * data[i] >> 14) & 0xFFFF) +
-        (0xFFFF - VAD_POWER_ALPHA) * (p->vad_power >> 16) +
-        ((0xFFFF - VAD_POWER_ALPHA) * (p->vad_power & 0xFFFF) >> 16);
-    /* Update VAD buffer */
-    p->cqueue.base.s[p->cqueue.head.a] = data[i];
-    p->cqueue.head.a = (p->cqueue.head.a + 1) & (p->cqueue.size - 1);
-    if (p->cqueue.head.a == p->cqueue.tail.a)
-      p->cqueue.tail.a = (p->cqueue.tail.a + 1) & (p->cqueue.size - 1);
-  }
+  p->vad_power = VAD_POWER_ALPHA * ((sample * sample >> 14) & 0xFFFF) +
+      (0xFFFF - VAD_POWER_ALPHA) * (p->vad_power >> 16) +
+      ((0xFFFF - VAD_POWER_ALPHA) * (p->vad_power & 0xFFFF) >> 16);
 
-  tail = p->cqueue.tail.a;
-  p->vad_zcr = 0;
-  for (;;) {
-    sample = p->cqueue.base.s[tail];
-    tail = (tail + 1) & (p->cqueue.size - 1);
-    if (tail == p->cqueue.head.a)
-      break;
+  if (head != p->cqueue.tail.a)
     p->vad_zcr +=
-        ((sample & 0x8000) != (p->cqueue.base.s[tail] & 0x8000)) ? 1 : -1;
+        VAD_SIGN_CHANGE (p->cqueue.base.s[(head - 1) & mask], sample);
+
+  /* Update VAD buffer */
+  p->cqueue.base.s[head] = sample;
+  head = (head + 1) & mask;
+  p->cqueue.head.a = head;
+  if (head == p->cqueue.tail.a) {
+    guint64 tail = p->cqueue.tail.a;
+
+    p->vad_zcr -= VAD_SIGN_CHANGE (p->cqueue.base.s[tail],
+        p->cqueue.base.s[(tail + 1) & mask]);
+    p->cqueue.tail.a = (tail + 1) & mask;
   }
+}
+
+/* Runs the hysteresis for a decision covering @len samples and returns
+ * whether the VAD state changed */
+static inline gboolean
+vad_decide (struct _vad_s *p, gint len)
+{
+  gint frame_type;
 
   frame_type = (p->vad_power > p->threshold
       && p->vad_zcr < VAD_ZCR_THRESHOLD) ? VAD_VOICE : VAD_SILENCE;
@@ -154,14 +167,49 @@ vad_update (struct _vad_s * p, gint16 * data, gint len)
       if (p->vad_samples >= p->hysteresis) {
         p->vad_state = frame_type;
         p->vad_samples = 0;
+        return TRUE;
       }
     } else {
       p->vad_state = frame_type;
       p->vad_samples = 0;
+      return TRUE;
     }
   } else {
     p->vad_samples = 0;
   }
 
+  return FALSE;
+}
+
+gint
+vad_update (struct _vad_s * p, gint16 * data, gint len)
+{
+  gint i;
+
+  for (i = 0; i < len; i++)
+    vad_push_sample (p, data[i]);
+
+  vad_decide (p, len);
+
+  return p->vad_state;
+}
+
+gint
+vad_update_until_change (VADFilter * p, const gint16 * data, gint len)
+{
+  gint i;
+
+  for (i = 0; i < len; i++) {
+    vad_push_sample (p, data[i]);
+    if (vad_decide (p, 1))
+      return i + 1;
+  }
+
+  return len;
+}
+
+gint
+vad_get_state (VADFilter * p)
+{
   return p->vad_state;
 }
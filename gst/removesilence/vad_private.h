@@ -31,6 +31,13 @@ typedef struct _vad_s VADFilter;
 
 gint vad_update(VADFilter *p, gint16 *data, gint len);
 
+/* Evaluates the VAD after every sample and stops right after the sample
+ * that changed its state. Returns the number of samples consumed, including
+ * the one that changed the state */
+gint vad_update_until_change(VADFilter *p, const gint16 *data, gint len);
+
+gint vad_get_state(VADFilter *p);
+
 void vad_set_hysteresis(VADFilter *p, guint64 hysteresis);
 
 guint64 vad_get_hysteresis(VADFilter *p);
@@ -54,6 +54,11 @@
 GST_DEBUG_CATEGORY_STATIC (timecodestamper_debug);
 #define GST_CAT_DEFAULT timecodestamper_debug
 
+/* Only format timecodes into strings for logging if they end up being
+ * logged, this is done for every frame otherwise */
+#define TC_LOG_ENABLED(level) \
+    (gst_debug_category_get_threshold (GST_CAT_DEFAULT) >= (level))
+
 /* GstTimeCodeStamper properties */
 enum
 {
@@ -1067,15 +1072,78 @@ gst_timecodestamper_update_latency (GstTimeCodeStamper * timecodestamper,
 }
 #endif
 
+/* Increments @tc by one frame. Within a second this only needs to increment
+ * the frame number for integer and NTSC-style framerates; only at second
+ * boundaries, where drop-frame timecodes skip frame numbers, the generic
+ * (and more expensive) frame count based code is needed. */
+static void
+gst_timecodestamper_increment_frame (GstVideoTimeCode * tc)
+{
+  guint frames_per_second = 0;
+
+  if (tc->config.fps_d == 1)
+    frames_per_second = tc->config.fps_n;
+  else if (tc->config.fps_d == 1001 && tc->config.fps_n % 1000 == 0)
+    frames_per_second = tc->config.fps_n / 1000;
+
+  if (frames_per_second > 0 && tc->frames + 1 < frames_per_second &&
+      !((tc->config.flags & GST_VIDEO_TIME_CODE_FLAGS_DROP_FRAME)
+          && tc->seconds == 0 && tc->frames < 2)) {
+    tc->frames++;
+    return;
+  }
+
+  gst_video_time_code_increment_frame (tc);
+}
+
+/* Calculates the wall clock time corresponding to the frame at @running_time.
+ * Must be called without the object lock */
+static GDateTime *
+gst_timecodestamper_get_frame_date_time (GstTimeCodeStamper * timecodestamper,
+    GstClockTime running_time)
+{
+  GstClockTime base_time, clock_time, clock_time_now;
+  GstClock *clock;
+  GDateTime *dt_now, *dt_frame;
+
+  base_time = gst_element_get_base_time (GST_ELEMENT (timecodestamper));
+  clock = gst_element_get_clock (GST_ELEMENT (timecodestamper));
+  if (clock) {
+    clock_time_now = gst_clock_get_time (clock);
+    gst_object_unref (clock);
+  } else {
+    clock_time_now = GST_CLOCK_TIME_NONE;
+  }
+
+  dt_now = g_date_time_new_now_local ();
+
+  if (clock_time_now != GST_CLOCK_TIME_NONE) {
+    gdouble seconds_diff;
+
+    clock_time = running_time + base_time;
+    if (clock_time_now > clock_time) {
+      seconds_diff = (clock_time_now - clock_time) / -1000000000.0;
+    } else {
+      seconds_diff = (clock_time - clock_time_now) / 1000000000.0;
+    }
+    dt_frame = g_date_time_add_seconds (dt_now, seconds_diff);
+    g_date_time_unref (dt_now);
+  } else {
+    /* If we have no clock we can't really know the time of the frame */
+    dt_frame = dt_now;
+  }
+
+  return dt_frame;
+}
+
 static GstFlowReturn
 gst_timecodestamper_transform_ip (GstBaseTransform * vfilter,
     GstBuffer * buffer)
 {
   GstTimeCodeStamper *timecodestamper = GST_TIME_CODE_STAMPER (vfilter);
-  GstClockTime running_time, base_time, clock_time;
-  GstClock *clock;
-  GstClockTime clock_time_now;
-  GDateTime *dt_now, *dt_frame;
+  GstClockTime running_time;
+  GDateTime *dt_frame = NULL;
+  gboolean need_dt_frame;
   GstVideoTimeCode *tc = NULL;
   gboolean free_tc = FALSE;
   GstVideoTimeCodeMeta *tc_meta;
@@ -1096,36 +1164,22 @@ gst_timecodestamper_transform_ip (GstBaseTransform * vfilter,
   }
 #endif
 
-  /* Collect all the current times */
-  base_time = gst_element_get_base_time (GST_ELEMENT (timecodestamper));
-  clock = gst_element_get_clock (GST_ELEMENT (timecodestamper));
-  if (clock) {
-    clock_time_now = gst_clock_get_time (clock);
-    gst_object_unref (clock);
-  } else {
-    clock_time_now = GST_CLOCK_TIME_NONE;
-  }
-
-  dt_now = g_date_time_new_now_local ();
-
   running_time =
       gst_segment_to_running_time (&vfilter->segment, GST_FORMAT_TIME,
       GST_BUFFER_PTS (buffer));
 
-  if (clock_time_now != GST_CLOCK_TIME_NONE) {
-    gdouble seconds_diff;
+  /* The wall clock time of the frame is only needed for RTC timecodes and
+   * for initializing the internal timecode, and is expensive to get */
+  GST_OBJECT_LOCK (timecodestamper);
+  need_dt_frame =
+      timecodestamper->tc_source == GST_TIME_CODE_STAMPER_SOURCE_RTC
+      || !timecodestamper->internal_tc
+      || timecodestamper->reset_internal_tc_from_seek;
+  GST_OBJECT_UNLOCK (timecodestamper);
 
-    clock_time = running_time + base_time;
-    if (clock_time_now > clock_time) {
-      seconds_diff = (clock_time_now - clock_time) / -1000000000.0;
-    } else {
-      seconds_diff = (clock_time - clock_time_now) / 1000000000.0;
-    }
-    dt_frame = g_date_time_add_seconds (dt_now, seconds_diff);
-  } else {
-    /* If we have no clock we can't really know the time of the frame */
-    dt_frame = g_date_time_ref (dt_now);
-  }
+  if (need_dt_frame)
+    dt_frame =
+        gst_timecodestamper_get_frame_date_time (timecodestamper, running_time);
 
   GST_DEBUG_OBJECT (timecodestamper,
       "Handling video frame with running time %" GST_TIME_FORMAT,
@@ -1185,13 +1239,14 @@ gst_timecodestamper_transform_ip (GstBaseTransform * vfilter,
         tc_str);
     g_free (tc_str);
   } else {
-    gchar *tc_str;
-
-    gst_video_time_code_increment_frame (timecodestamper->internal_tc);
-    tc_str = gst_video_time_code_to_string (timecodestamper->internal_tc);
-    GST_DEBUG_OBJECT (timecodestamper, "Incremented internal timecode to %s",
-        tc_str);
-    g_free (tc_str);
+    gst_timecodestamper_increment_frame (timecodestamper->internal_tc);
+    if (TC_LOG_ENABLED (GST_LEVEL_DEBUG)) {
+      gchar *tc_str =
+          gst_video_time_code_to_string (timecodestamper->internal_tc);
+      GST_DEBUG_OBJECT (timecodestamper, "Incremented internal timecode to %s",
+          tc_str);
+      g_free (tc_str);
+    }
   }
 
   /* If we have a new timecode on the incoming frame, update our last known
@@ -1223,22 +1278,30 @@ gst_timecodestamper_transform_ip (GstBaseTransform * vfilter,
         timecodestamper->last_tc_running_time = GST_CLOCK_TIME_NONE;
         GST_DEBUG_OBJECT (timecodestamper, "Upstream timecode timed out");
       } else {
-        gchar *tc_str;
-
-        gst_video_time_code_increment_frame (timecodestamper->last_tc);
-
-        tc_str = gst_video_time_code_to_string (timecodestamper->last_tc);
-        GST_DEBUG_OBJECT (timecodestamper,
-            "Incremented upstream timecode to %s", tc_str);
-        g_free (tc_str);
+        gst_timecodestamper_increment_frame (timecodestamper->last_tc);
+
+        if (TC_LOG_ENABLED (GST_LEVEL_DEBUG)) {
+          gchar *tc_str =
+              gst_video_time_code_to_string (timecodestamper->last_tc);
+          GST_DEBUG_OBJECT (timecodestamper,
+              "Incremented upstream timecode to %s", tc_str);
+          g_free (tc_str);
+        }
       }
     } else {
       GST_DEBUG_OBJECT (timecodestamper, "Never saw an upstream timecode");
     }
   }
 
-  /* Update RTC-based timecode */
-  {
+  /* Update RTC-based timecode, only if it is going to be used. It will be
+   * initialized again from the wall clock once it is selected */
+  if (timecodestamper->tc_source != GST_TIME_CODE_STAMPER_SOURCE_RTC
+      || !dt_frame) {
+    if (timecodestamper->rtc_tc) {
+      gst_video_time_code_free (timecodestamper->rtc_tc);
+      timecodestamper->rtc_tc = NULL;
+    }
+  } else {
     GstVideoTimeCode rtc_timecode_now;
     gchar *tc_str, *dt_str;
 
@@ -1248,13 +1311,15 @@ gst_timecodestamper_transform_ip (GstBaseTransform * vfilter,
         timecodestamper->vinfo.fps_n, timecodestamper->vinfo.fps_d, dt_frame,
         tc_flags, 0);
 
-    tc_str = gst_video_time_code_to_string (&rtc_timecode_now);
-    dt_str = g_date_time_format (dt_frame, "%F %R %z");
-    GST_DEBUG_OBJECT (timecodestamper,
-        "Created RTC timecode %s for %s (%06u us)", tc_str, dt_str,
-        g_date_time_get_microsecond (dt_frame));
-    g_free (dt_str);
-    g_free (tc_str);
+    if (TC_LOG_ENABLED (GST_LEVEL_DEBUG)) {
+      tc_str = gst_video_time_code_to_string (&rtc_timecode_now);
+      dt_str = g_date_time_format (dt_frame, "%F %R %z");
+      GST_DEBUG_OBJECT (timecodestamper,
+          "Created RTC timecode %s for %s (%06u us)", tc_str, dt_str,
+          g_date_time_get_microsecond (dt_frame));
+      g_free (dt_str);
+      g_free (tc_str);
+    }
 
     /* If we don't have an RTC timecode yet, directly initialize with this one */
     if (!timecodestamper->rtc_tc) {
@@ -1268,7 +1333,7 @@ gst_timecodestamper_transform_ip (GstBaseTransform * vfilter,
       GstClockTime rtc_diff;
 
       /* Increment the old RTC timecode to this frame */
-      gst_video_time_code_increment_frame (timecodestamper->rtc_tc);
+      gst_timecodestamper_increment_frame (timecodestamper->rtc_tc);
 
       /* Otherwise check if we drifted too much and need to resync */
       rtc_tc_time =
@@ -1405,13 +1470,15 @@ gst_timecodestamper_transform_ip (GstBaseTransform * vfilter,
         ltc_tc->timecode.config.fps_d = timecodestamper->vinfo.fps_d;
       }
 
-      tc_str = gst_video_time_code_to_string (&ltc_tc->timecode);
-      GST_INFO_OBJECT (timecodestamper,
-          "Retrieved LTC timecode %s at %" GST_TIME_FORMAT
-          " (%u timecodes queued)", tc_str,
-          GST_TIME_ARGS (ltc_tc->running_time),
-          g_queue_get_length (&timecodestamper->ltc_current_tcs));
-      g_free (tc_str);
+      if (TC_LOG_ENABLED (GST_LEVEL_INFO)) {
+        tc_str = gst_video_time_code_to_string (&ltc_tc->timecode);
+        GST_INFO_OBJECT (timecodestamper,
+            "Retrieved LTC timecode %s at %" GST_TIME_FORMAT
+            " (%u timecodes queued)", tc_str,
+            GST_TIME_ARGS (ltc_tc->running_time),
+            g_queue_get_length (&timecodestamper->ltc_current_tcs));
+        g_free (tc_str);
+      }
 
       if (!gst_video_time_code_is_valid (&ltc_tc->timecode)) {
         tc_str = gst_video_time_code_to_string (&ltc_tc->timecode);
@@ -1467,7 +1534,7 @@ gst_timecodestamper_transform_ip (GstBaseTransform * vfilter,
     /* If we didn't update from LTC above, increment our internal timecode
      * for this frame */
     if (!updated_internal && timecodestamper->ltc_internal_tc) {
-      gst_video_time_code_increment_frame (timecodestamper->ltc_internal_tc);
+      gst_timecodestamper_increment_frame (timecodestamper->ltc_internal_tc);
     }
 
     if (timecodestamper->ltc_internal_tc) {
@@ -1483,7 +1550,7 @@ gst_timecodestamper_transform_ip (GstBaseTransform * vfilter,
         timecodestamper->ltc_internal_tc = NULL;
         GST_DEBUG_OBJECT (timecodestamper, "LTC timecode timed out");
         timecodestamper->ltc_internal_running_time = GST_CLOCK_TIME_NONE;
-      } else {
+      } else if (TC_LOG_ENABLED (GST_LEVEL_DEBUG)) {
         tc_str =
             gst_video_time_code_to_string (timecodestamper->ltc_internal_tc);
         GST_DEBUG_OBJECT (timecodestamper, "Updated LTC timecode to %s",
@@ -1556,9 +1623,11 @@ gst_timecodestamper_transform_ip (GstBaseTransform * vfilter,
           gst_video_time_code_add_frames (tc, timecodestamper->timecode_offset);
         }
 
-        tc_str = gst_video_time_code_to_string (tc);
-        GST_DEBUG_OBJECT (timecodestamper, "Storing timecode %s", tc_str);
-        g_free (tc_str);
+        if (TC_LOG_ENABLED (GST_LEVEL_DEBUG)) {
+          tc_str = gst_video_time_code_to_string (tc);
+          GST_DEBUG_OBJECT (timecodestamper, "Storing timecode %s", tc_str);
+          g_free (tc_str);
+        }
 
         gst_buffer_add_video_time_code_meta (buffer, tc);
       }
@@ -1576,9 +1645,11 @@ gst_timecodestamper_transform_ip (GstBaseTransform * vfilter,
           gst_video_time_code_add_frames (tc, timecodestamper->timecode_offset);
         }
 
-        tc_str = gst_video_time_code_to_string (tc);
-        GST_DEBUG_OBJECT (timecodestamper, "Storing timecode %s", tc_str);
-        g_free (tc_str);
+        if (TC_LOG_ENABLED (GST_LEVEL_DEBUG)) {
+          tc_str = gst_video_time_code_to_string (tc);
+          GST_DEBUG_OBJECT (timecodestamper, "Storing timecode %s", tc_str);
+          g_free (tc_str);
+        }
 
         gst_buffer_add_video_time_code_meta (buffer, tc);
       }
@@ -1613,8 +1684,6 @@ gst_timecodestamper_transform_ip (GstBaseTransform * vfilter,
 out:
 #endif
 
-  if (dt_now)
-    g_date_time_unref (dt_now);
   if (dt_frame)
     g_date_time_unref (dt_frame);
   if (free_tc && tc)
@@ -6,6 +6,7 @@
 #ifdef HAVE_GETRUSAGE
 #include "gst-cpu-throttling-clock.h"
 
+#include <math.h>
 #include <unistd.h>
 #include <sys/resource.h>
 
@@ -31,11 +32,16 @@ struct _GstCpuThrottlingClockPrivate
   GstClockTime current_wait_time;
   GstPoll *timer;
   struct rusage last_usage;
+  gint64 last_eval;
+  gint measured_cpu_usage;
 
   GstClockID evaluate_wait_time;
   GstClockTime time_between_evals;
 };
 
+/* Smallest wait time used when starting to throttle */
+#define MIN_WAIT_TIME (GST_MSECOND / 10)
+
 #define parent_class gst_cpu_throttling_clock_parent_class
 G_DEFINE_TYPE_WITH_CODE (GstCpuThrottlingClock, gst_cpu_throttling_clock, GST_TYPE_CLOCK, G_ADD_PRIVATE(GstCpuThrottlingClock))
 
@@ -43,6 +49,7 @@ enum
 {
   PROP_FIRST,
   PROP_CPU_USAGE,
+  PROP_MEASURED_CPU_USAGE,
   PROP_LAST
 };
 
@@ -59,6 +66,10 @@ gst_cpu_throttling_clock_get_property (GObject * object,
     case PROP_CPU_USAGE:
       g_value_set_uint (value, self->priv->wanted_cpu_usage);
       break;
+    case PROP_MEASURED_CPU_USAGE:
+      g_value_set_uint (value,
+          g_atomic_int_get (&self->priv->measured_cpu_usage));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -88,30 +99,61 @@ gst_transcoder_adjust_wait_time (GstClock * sync_clock, GstClockTime time,
     GstClockID id, GstCpuThrottlingClock * self)
 {
   struct rusage ru;
-  float delta_usage, usage, coef;
+  gint64 now;
+  GstClockTime delta_usage, elapsed, wait_time;
+  gfloat usage, ratio;
+  guint wanted_cpu_usage;
 
   GstCpuThrottlingClockPrivate *priv = self->priv;
 
+  wanted_cpu_usage = priv->wanted_cpu_usage;
+
   getrusage (RUSAGE_SELF, &ru);
-  delta_usage = GST_TIMEVAL_TO_TIME (ru.ru_utime) -
-      GST_TIMEVAL_TO_TIME (self->priv->last_usage.ru_utime);
-  usage =
-      ((float) delta_usage / self->priv->time_between_evals * 100) /
-      g_get_num_processors ();
+  now = g_get_monotonic_time ();
 
-  self->priv->last_usage = ru;
+  /* Time spent in the kernel on behalf of the pipeline counts as well */
+  delta_usage = GST_TIMEVAL_TO_TIME (ru.ru_utime) +
+      GST_TIMEVAL_TO_TIME (ru.ru_stime) -
+      GST_TIMEVAL_TO_TIME (priv->last_usage.ru_utime) -
+      GST_TIMEVAL_TO_TIME (priv->last_usage.ru_stime);
 
-  coef = GST_MSECOND / 10;
-  if (usage < (gfloat) priv->wanted_cpu_usage) {
-    coef = -coef;
-  }
+  /* Periodic callbacks can be late, use the time that actually elapsed */
+  elapsed = (now - priv->last_eval) * GST_USECOND;
+  if (elapsed == 0)
+    elapsed = priv->time_between_evals;
+
+  usage = ((gfloat) delta_usage / elapsed * 100) / g_get_num_processors ();
+
+  priv->last_usage = ru;
+  priv->last_eval = now;
+  g_atomic_int_set (&priv->measured_cpu_usage, (gint) MIN (usage, 100));
+
+  /* Scale the wait time by how far off the wanted usage we are, instead of
+   * moving it by a fixed step, so that it converges within a few
+   * evaluations whatever the load */
+  if (wanted_cpu_usage == 0)
+    ratio = 2.0f;
+  else
+    ratio = usage / wanted_cpu_usage;
+
+  if (!isfinite (ratio))
+    ratio = 2.0f;
+  ratio = CLAMP (ratio, 0.5f, 2.0f);
 
-  priv->current_wait_time = CLAMP (0,
-      (GstClockTime) priv->current_wait_time + coef, GST_SECOND);
+  wait_time = priv->current_wait_time;
+  if (ratio > 1.0f)
+    wait_time = MAX (wait_time, MIN_WAIT_TIME) * ratio;
+  else
+    wait_time = wait_time * ratio;
+
+  if (wait_time < MIN_WAIT_TIME && ratio < 1.0f)
+    wait_time = 0;
+
+  priv->current_wait_time = MIN (wait_time, GST_SECOND);
 
   GST_DEBUG_OBJECT (self,
-      "Avg is %f (wanted %d) => %" GST_TIME_FORMAT, usage,
-      self->priv->wanted_cpu_usage, GST_TIME_ARGS (priv->current_wait_time));
+      "Avg is %f (wanted %d) => %" GST_TIME_FORMAT, usage, wanted_cpu_usage,
+      GST_TIME_ARGS (priv->current_wait_time));
 
   return TRUE;
 }
@@ -190,6 +232,20 @@ gst_cpu_throttling_clock_class_init (GstCpuThrottlingClockClass * klass)
       "pipeline driven by the clock", 0, 100,
       100, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * GstCpuThrottlingClock:measured-cpu-usage:
+   *
+   * The CPU usage of the process measured at the last evaluation, in
+   * percent of all the CPUs of the machine.
+   *
+   * Since: 1.20
+   */
+  param_specs[PROP_MEASURED_CPU_USAGE] =
+      g_param_spec_uint ("measured-cpu-usage", "Measured CPU usage",
+      "The percentage of CPU measured to be used by the processus running "
+      "the pipeline driven by the clock", 0, 100,
+      0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties (oclass, PROP_LAST, param_specs);
 
   clock_klass->wait = GST_DEBUG_FUNCPTR (_wait);
@@ -207,8 +263,8 @@ gst_cpu_throttling_clock_init (GstCpuThrottlingClock * self)
   self->priv->time_between_evals = GST_SECOND / 4;
   self->priv->sclock = GST_CLOCK (gst_system_clock_obtain ());
 
-
   getrusage (RUSAGE_SELF, &self->priv->last_usage);
+  self->priv->last_eval = g_get_monotonic_time ();
 }
 
 GstCpuThrottlingClock *
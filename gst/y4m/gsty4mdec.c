@@ -57,6 +57,10 @@ static void gst_y4m_dec_finalize (GObject * object);
 
 static GstFlowReturn gst_y4m_dec_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer);
+static gboolean gst_y4m_dec_sink_activate (GstPad * pad, GstObject * parent);
+static gboolean gst_y4m_dec_sink_activate_mode (GstPad * pad,
+    GstObject * parent, GstPadMode mode, gboolean active);
+static void gst_y4m_dec_loop (GstPad * pad);
 static gboolean gst_y4m_dec_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 
@@ -127,6 +131,10 @@ gst_y4m_dec_init (GstY4mDec * y4mdec)
       GST_DEBUG_FUNCPTR (gst_y4m_dec_sink_event));
   gst_pad_set_chain_function (y4mdec->sinkpad,
       GST_DEBUG_FUNCPTR (gst_y4m_dec_chain));
+  gst_pad_set_activate_function (y4mdec->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_y4m_dec_sink_activate));
+  gst_pad_set_activatemode_function (y4mdec->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_y4m_dec_sink_activate_mode));
   gst_element_add_pad (GST_ELEMENT (y4mdec), y4mdec->sinkpad);
 
   y4mdec->srcpad = gst_pad_new_from_static_template (&gst_y4m_dec_src_template,
@@ -225,6 +233,9 @@ gst_y4m_dec_change_state (GstElement * element, GstStateChange transition)
         gst_object_unref (y4mdec->pool);
       }
       y4mdec->pool = NULL;
+      y4mdec->have_header = FALSE;
+      y4mdec->have_new_segment = FALSE;
+      gst_adapter_clear (y4mdec->adapter);
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
       break;
@@ -248,11 +259,19 @@ gst_y4m_dec_frames_to_timestamp (GstY4mDec * y4mdec, gint64 frame_index)
 static gint64
 gst_y4m_dec_timestamp_to_frames (GstY4mDec * y4mdec, GstClockTime timestamp)
 {
+  gint64 frame_index;
+
   if (timestamp == -1)
     return -1;
 
-  return gst_util_uint64_scale (timestamp, y4mdec->info.fps_n,
+  /* Frame timestamps are rounded down, make sure they map back to the
+   * same frame and not the previous one */
+  frame_index = gst_util_uint64_scale (timestamp, y4mdec->info.fps_n,
       GST_SECOND * y4mdec->info.fps_d);
+  if (gst_y4m_dec_frames_to_timestamp (y4mdec, frame_index + 1) <= timestamp)
+    frame_index++;
+
+  return frame_index;
 }
 
 static gint64
@@ -481,13 +500,189 @@ error:
   return FALSE;
 }
 
+#define MAX_HEADER_LENGTH 80
+
+/* Parses the stream header and configures the source pad and pool. @header
+ * must contain at least MAX_HEADER_LENGTH bytes */
+static GstFlowReturn
+gst_y4m_dec_handle_header (GstY4mDec * y4mdec, char *header)
+{
+  gboolean ret;
+  GstCaps *caps;
+  GstQuery *query;
+  int i;
+
+  header[MAX_HEADER_LENGTH - 1] = 0;
+  for (i = 0; i < MAX_HEADER_LENGTH; i++) {
+    if (header[i] == 0x0a)
+      header[i] = 0;
+  }
+
+  ret = gst_y4m_dec_parse_header (y4mdec, header);
+  if (!ret) {
+    GST_ELEMENT_ERROR (y4mdec, STREAM, DECODE,
+        ("Failed to parse YUV4MPEG header"), (NULL));
+    return GST_FLOW_ERROR;
+  }
+
+  y4mdec->header_size = strlen (header) + 1;
+
+  caps = gst_video_info_to_caps (&y4mdec->info);
+  ret = gst_pad_set_caps (y4mdec->srcpad, caps);
+
+  query = gst_query_new_allocation (caps, FALSE);
+  y4mdec->video_meta = FALSE;
+
+  if (y4mdec->pool) {
+    gst_buffer_pool_set_active (y4mdec->pool, FALSE);
+    gst_object_unref (y4mdec->pool);
+  }
+  y4mdec->pool = NULL;
+
+  if (gst_pad_peer_query (y4mdec->srcpad, query)) {
+    y4mdec->video_meta =
+        gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+
+    /* We only need a pool if we need to do stride conversion for downstream */
+    if (!y4mdec->video_meta && memcmp (&y4mdec->info, &y4mdec->out_info,
+            sizeof (y4mdec->info)) != 0) {
+      GstBufferPool *pool = NULL;
+      GstAllocator *allocator = NULL;
+      GstAllocationParams params;
+      GstStructure *config;
+      guint size, min, max;
+
+      if (gst_query_get_n_allocation_params (query) > 0) {
+        gst_query_parse_nth_allocation_param (query, 0, &allocator, &params);
+      } else {
+        allocator = NULL;
+        gst_allocation_params_init (&params);
+      }
+
+      if (gst_query_get_n_allocation_pools (query) > 0) {
+        gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min,
+            &max);
+        size = MAX (size, y4mdec->out_info.size);
+      } else {
+        pool = NULL;
+        size = y4mdec->out_info.size;
+        min = max = 0;
+      }
+
+      if (pool == NULL) {
+        pool = gst_video_buffer_pool_new ();
+      }
+
+      config = gst_buffer_pool_get_config (pool);
+      gst_buffer_pool_config_set_params (config, caps, size, min, max);
+      gst_buffer_pool_config_set_allocator (config, allocator, &params);
+      gst_buffer_pool_set_config (pool, config);
+
+      if (allocator)
+        gst_object_unref (allocator);
+
+      y4mdec->pool = pool;
+    }
+  } else if (memcmp (&y4mdec->info, &y4mdec->out_info,
+          sizeof (y4mdec->info)) != 0) {
+    GstBufferPool *pool;
+    GstStructure *config;
+
+    /* No pool, create our own if we need to do stride conversion */
+    pool = gst_video_buffer_pool_new ();
+    config = gst_buffer_pool_get_config (pool);
+    gst_buffer_pool_config_set_params (config, caps, y4mdec->out_info.size, 0,
+        0);
+    gst_buffer_pool_set_config (pool, config);
+    y4mdec->pool = pool;
+  }
+  if (y4mdec->pool) {
+    gst_buffer_pool_set_active (y4mdec->pool, TRUE);
+  }
+  gst_query_unref (query);
+  gst_caps_unref (caps);
+  if (!ret) {
+    GST_DEBUG_OBJECT (y4mdec, "Couldn't set caps on src pad");
+    return GST_FLOW_ERROR;
+  }
+
+  y4mdec->have_header = TRUE;
+
+  return GST_FLOW_OK;
+}
+
+/* Timestamps @buffer, which must contain exactly one frame, converts it to
+ * the output layout if needed and pushes it downstream */
+static GstFlowReturn
+gst_y4m_dec_push_frame (GstY4mDec * y4mdec, GstBuffer * buffer)
+{
+  GstFlowReturn flow_ret;
+
+  GST_BUFFER_TIMESTAMP (buffer) =
+      gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index);
+  GST_BUFFER_DURATION (buffer) =
+      gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index + 1) -
+      GST_BUFFER_TIMESTAMP (buffer);
+
+  y4mdec->frame_index++;
+
+  if (y4mdec->video_meta) {
+    gst_buffer_add_video_meta_full (buffer, 0, y4mdec->info.finfo->format,
+        y4mdec->info.width, y4mdec->info.height, y4mdec->info.finfo->n_planes,
+        y4mdec->info.offset, y4mdec->info.stride);
+  } else if (memcmp (&y4mdec->info, &y4mdec->out_info,
+          sizeof (y4mdec->info)) != 0) {
+    GstBuffer *outbuf;
+    GstVideoFrame iframe, oframe;
+    gint i, j;
+    gint w, h, istride, ostride;
+    guint8 *src, *dest;
+
+    /* Allocate a new buffer and do stride conversion */
+    g_assert (y4mdec->pool != NULL);
+
+    flow_ret = gst_buffer_pool_acquire_buffer (y4mdec->pool, &outbuf, NULL);
+    if (flow_ret != GST_FLOW_OK) {
+      gst_buffer_unref (buffer);
+      return flow_ret;
+    }
+
+    gst_video_frame_map (&iframe, &y4mdec->info, buffer, GST_MAP_READ);
+    gst_video_frame_map (&oframe, &y4mdec->out_info, outbuf, GST_MAP_WRITE);
+
+    for (i = 0; i < 3; i++) {
+      w = GST_VIDEO_FRAME_COMP_WIDTH (&iframe, i);
+      h = GST_VIDEO_FRAME_COMP_HEIGHT (&iframe, i);
+      istride = GST_VIDEO_FRAME_COMP_STRIDE (&iframe, i);
+      ostride = GST_VIDEO_FRAME_COMP_STRIDE (&oframe, i);
+      src = GST_VIDEO_FRAME_COMP_DATA (&iframe, i);
+      dest = GST_VIDEO_FRAME_COMP_DATA (&oframe, i);
+
+      for (j = 0; j < h; j++) {
+        memcpy (dest, src, w);
+
+        dest += ostride;
+        src += istride;
+      }
+    }
+
+    gst_video_frame_unmap (&iframe);
+    gst_video_frame_unmap (&oframe);
+    gst_buffer_copy_into (outbuf, buffer,
+        GST_BUFFER_COPY_TIMESTAMPS | GST_BUFFER_COPY_FLAGS, 0, -1);
+    gst_buffer_unref (buffer);
+    buffer = outbuf;
+  }
+
+  return gst_pad_push (y4mdec->srcpad, buffer);
+}
+
 static GstFlowReturn
 gst_y4m_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 {
   GstY4mDec *y4mdec;
   int n_avail;
   GstFlowReturn flow_ret = GST_FLOW_OK;
-#define MAX_HEADER_LENGTH 80
   char header[MAX_HEADER_LENGTH];
   int i;
   int len;
@@ -505,111 +700,16 @@ gst_y4m_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   n_avail = gst_adapter_available (y4mdec->adapter);
 
   if (!y4mdec->have_header) {
-    gboolean ret;
-    GstCaps *caps;
-    GstQuery *query;
-
     if (n_avail < MAX_HEADER_LENGTH)
       return GST_FLOW_OK;
 
     gst_adapter_copy (y4mdec->adapter, (guint8 *) header, 0, MAX_HEADER_LENGTH);
 
-    header[MAX_HEADER_LENGTH - 1] = 0;
-    for (i = 0; i < MAX_HEADER_LENGTH; i++) {
-      if (header[i] == 0x0a)
-        header[i] = 0;
-    }
-
-    ret = gst_y4m_dec_parse_header (y4mdec, header);
-    if (!ret) {
-      GST_ELEMENT_ERROR (y4mdec, STREAM, DECODE,
-          ("Failed to parse YUV4MPEG header"), (NULL));
-      return GST_FLOW_ERROR;
-    }
+    flow_ret = gst_y4m_dec_handle_header (y4mdec, header);
+    if (flow_ret != GST_FLOW_OK)
+      return flow_ret;
 
-    y4mdec->header_size = strlen (header) + 1;
     gst_adapter_flush (y4mdec->adapter, y4mdec->header_size);
-
-    caps = gst_video_info_to_caps (&y4mdec->info);
-    ret = gst_pad_set_caps (y4mdec->srcpad, caps);
-
-    query = gst_query_new_allocation (caps, FALSE);
-    y4mdec->video_meta = FALSE;
-
-    if (y4mdec->pool) {
-      gst_buffer_pool_set_active (y4mdec->pool, FALSE);
-      gst_object_unref (y4mdec->pool);
-    }
-    y4mdec->pool = NULL;
-
-    if (gst_pad_peer_query (y4mdec->srcpad, query)) {
-      y4mdec->video_meta =
-          gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
-
-      /* We only need a pool if we need to do stride conversion for downstream */
-      if (!y4mdec->video_meta && memcmp (&y4mdec->info, &y4mdec->out_info,
-              sizeof (y4mdec->info)) != 0) {
-        GstBufferPool *pool = NULL;
-        GstAllocator *allocator = NULL;
-        GstAllocationParams params;
-        GstStructure *config;
-        guint size, min, max;
-
-        if (gst_query_get_n_allocation_params (query) > 0) {
-          gst_query_parse_nth_allocation_param (query, 0, &allocator, &params);
-        } else {
-          allocator = NULL;
-          gst_allocation_params_init (&params);
-        }
-
-        if (gst_query_get_n_allocation_pools (query) > 0) {
-          gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min,
-              &max);
-          size = MAX (size, y4mdec->out_info.size);
-        } else {
-          pool = NULL;
-          size = y4mdec->out_info.size;
-          min = max = 0;
-        }
-
-        if (pool == NULL) {
-          pool = gst_video_buffer_pool_new ();
-        }
-
-        config = gst_buffer_pool_get_config (pool);
-        gst_buffer_pool_config_set_params (config, caps, size, min, max);
-        gst_buffer_pool_config_set_allocator (config, allocator, &params);
-        gst_buffer_pool_set_config (pool, config);
-
-        if (allocator)
-          gst_object_unref (allocator);
-
-        y4mdec->pool = pool;
-      }
-    } else if (memcmp (&y4mdec->info, &y4mdec->out_info,
-            sizeof (y4mdec->info)) != 0) {
-      GstBufferPool *pool;
-      GstStructure *config;
-
-      /* No pool, create our own if we need to do stride conversion */
-      pool = gst_video_buffer_pool_new ();
-      config = gst_buffer_pool_get_config (pool);
-      gst_buffer_pool_config_set_params (config, caps, y4mdec->out_info.size, 0,
-          0);
-      gst_buffer_pool_set_config (pool, config);
-      y4mdec->pool = pool;
-    }
-    if (y4mdec->pool) {
-      gst_buffer_pool_set_active (y4mdec->pool, TRUE);
-    }
-    gst_query_unref (query);
-    gst_caps_unref (caps);
-    if (!ret) {
-      GST_DEBUG_OBJECT (y4mdec, "Couldn't set caps on src pad");
-      return GST_FLOW_ERROR;
-    }
-
-    y4mdec->have_header = TRUE;
   }
 
   if (y4mdec->have_new_segment) {
@@ -668,69 +768,270 @@ gst_y4m_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 
     buffer = gst_adapter_take_buffer (y4mdec->adapter, y4mdec->info.size);
 
-    GST_BUFFER_TIMESTAMP (buffer) =
-        gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index);
-    GST_BUFFER_DURATION (buffer) =
-        gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index + 1) -
-        GST_BUFFER_TIMESTAMP (buffer);
+    flow_ret = gst_y4m_dec_push_frame (y4mdec, buffer);
+    if (flow_ret != GST_FLOW_OK)
+      break;
+  }
+
+  GST_DEBUG ("returning %d", flow_ret);
 
-    y4mdec->frame_index++;
+  return flow_ret;
+}
 
-    if (y4mdec->video_meta) {
-      gst_buffer_add_video_meta_full (buffer, 0, y4mdec->info.finfo->format,
-          y4mdec->info.width, y4mdec->info.height, y4mdec->info.finfo->n_planes,
-          y4mdec->info.offset, y4mdec->info.stride);
-    } else if (memcmp (&y4mdec->info, &y4mdec->out_info,
-            sizeof (y4mdec->info)) != 0) {
-      GstBuffer *outbuf;
-      GstVideoFrame iframe, oframe;
-      gint i, j;
-      gint w, h, istride, ostride;
-      guint8 *src, *dest;
-
-      /* Allocate a new buffer and do stride conversion */
-      g_assert (y4mdec->pool != NULL);
-
-      flow_ret = gst_buffer_pool_acquire_buffer (y4mdec->pool, &outbuf, NULL);
-      if (flow_ret != GST_FLOW_OK) {
-        gst_buffer_unref (buffer);
-        break;
-      }
+static GstFlowReturn
+gst_y4m_dec_pull_header (GstY4mDec * y4mdec)
+{
+  GstFlowReturn flow_ret;
+  GstBuffer *buffer = NULL;
+  GstEvent *event;
+  char header[MAX_HEADER_LENGTH];
+  gchar *stream_id;
+  gint64 upstream_size;
+
+  flow_ret = gst_pad_pull_range (y4mdec->sinkpad, 0, MAX_HEADER_LENGTH,
+      &buffer);
+  if (flow_ret != GST_FLOW_OK)
+    return flow_ret;
+
+  /* Nothing upstream sends stream-start in pull mode, and it has to come
+   * before the caps that are set from the header */
+  stream_id = gst_pad_create_stream_id (y4mdec->srcpad,
+      GST_ELEMENT_CAST (y4mdec), NULL);
+  event = gst_event_new_stream_start (stream_id);
+  gst_event_set_group_id (event, gst_util_group_id_next ());
+  gst_pad_push_event (y4mdec->srcpad, event);
+  g_free (stream_id);
+
+  memset (header, 0, sizeof (header));
+  gst_buffer_extract (buffer, 0, header, MAX_HEADER_LENGTH);
+  gst_buffer_unref (buffer);
+
+  flow_ret = gst_y4m_dec_handle_header (y4mdec, header);
+  if (flow_ret != GST_FLOW_OK)
+    return flow_ret;
+
+  y4mdec->offset = y4mdec->header_size;
+  y4mdec->frame_index = 0;
+  y4mdec->frame_params = FALSE;
+
+  gst_segment_init (&y4mdec->segment, GST_FORMAT_TIME);
+  if (gst_pad_peer_query_duration (y4mdec->sinkpad, GST_FORMAT_BYTES,
+          &upstream_size)) {
+    y4mdec->segment.duration = gst_y4m_dec_frames_to_timestamp (y4mdec,
+        gst_y4m_dec_bytes_to_frames (y4mdec, upstream_size));
+  }
+  y4mdec->have_new_segment = TRUE;
+
+  return GST_FLOW_OK;
+}
+
+/* Reads the frame at the current offset. The frame data is returned as a
+ * sub-buffer of what upstream provided, without any copying */
+static GstFlowReturn
+gst_y4m_dec_pull_frame (GstY4mDec * y4mdec, GstBuffer ** frame)
+{
+  GstFlowReturn flow_ret;
+  GstBuffer *buffer = NULL;
+  GstMapInfo map;
+  gsize frame_size = y4mdec->info.size;
+  gsize len, max_len;
+
+  /* Frame headers are almost always just "FRAME\n", so try to get the
+   * header and the frame data with a single read */
+  flow_ret = gst_pad_pull_range (y4mdec->sinkpad, y4mdec->offset,
+      frame_size + 6, &buffer);
+  if (flow_ret != GST_FLOW_OK)
+    return flow_ret;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  if (map.size < 6) {
+    GST_DEBUG_OBJECT (y4mdec, "Ignoring %" G_GSIZE_FORMAT " trailing bytes",
+        map.size);
+    gst_buffer_unmap (buffer, &map);
+    gst_buffer_unref (buffer);
+    return GST_FLOW_EOS;
+  }
 
-      gst_video_frame_map (&iframe, &y4mdec->info, buffer, GST_MAP_READ);
-      gst_video_frame_map (&oframe, &y4mdec->out_info, outbuf, GST_MAP_WRITE);
+  max_len = MIN (map.size, MAX_HEADER_LENGTH);
+  for (len = 5; len < max_len && map.data[len] != 0x0a; len++);
 
-      for (i = 0; i < 3; i++) {
-        w = GST_VIDEO_FRAME_COMP_WIDTH (&iframe, i);
-        h = GST_VIDEO_FRAME_COMP_HEIGHT (&iframe, i);
-        istride = GST_VIDEO_FRAME_COMP_STRIDE (&iframe, i);
-        ostride = GST_VIDEO_FRAME_COMP_STRIDE (&oframe, i);
-        src = GST_VIDEO_FRAME_COMP_DATA (&iframe, i);
-        dest = GST_VIDEO_FRAME_COMP_DATA (&oframe, i);
+  if (memcmp (map.data, "FRAME", 5) != 0 || len == MAX_HEADER_LENGTH) {
+    gst_buffer_unmap (buffer, &map);
+    gst_buffer_unref (buffer);
+    GST_ELEMENT_ERROR (y4mdec, STREAM, DECODE,
+        ("Failed to parse YUV4MPEG frame"), (NULL));
+    return GST_FLOW_ERROR;
+  }
+  gst_buffer_unmap (buffer, &map);
 
-        for (j = 0; j < h; j++) {
-          memcpy (dest, src, w);
+  /* include the newline */
+  len++;
+  if (len != 6)
+    y4mdec->frame_params = TRUE;
 
-          dest += ostride;
-          src += istride;
-        }
-      }
+  if (len + frame_size > gst_buffer_get_size (buffer)) {
+    gboolean short_read = (len == 6 || len > max_len);
+
+    gst_buffer_unref (buffer);
+    buffer = NULL;
 
-      gst_video_frame_unmap (&iframe);
-      gst_video_frame_unmap (&oframe);
-      gst_buffer_copy_into (outbuf, buffer, GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+    if (short_read) {
+      GST_DEBUG_OBJECT (y4mdec, "Ignoring incomplete last frame");
+      return GST_FLOW_EOS;
+    }
+
+    /* Frame header with parameters, read again now that we know its size */
+    flow_ret = gst_pad_pull_range (y4mdec->sinkpad, y4mdec->offset,
+        len + frame_size, &buffer);
+    if (flow_ret != GST_FLOW_OK)
+      return flow_ret;
+
+    if (gst_buffer_get_size (buffer) < len + frame_size) {
+      GST_DEBUG_OBJECT (y4mdec, "Ignoring incomplete last frame");
       gst_buffer_unref (buffer);
-      buffer = outbuf;
+      return GST_FLOW_EOS;
     }
+  }
+
+  *frame = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_MEMORY, len,
+      frame_size);
+  gst_buffer_unref (buffer);
 
-    flow_ret = gst_pad_push (y4mdec->srcpad, buffer);
+  y4mdec->offset += len + frame_size;
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_y4m_dec_loop (GstPad * pad)
+{
+  GstY4mDec *y4mdec = GST_Y4M_DEC (GST_PAD_PARENT (pad));
+  GstFlowReturn flow_ret;
+  GstBuffer *buffer = NULL;
+  GstClockTime timestamp;
+
+  if (!y4mdec->have_header) {
+    flow_ret = gst_y4m_dec_pull_header (y4mdec);
     if (flow_ret != GST_FLOW_OK)
-      break;
+      goto pause;
   }
 
-  GST_DEBUG ("returning %d", flow_ret);
+  if (y4mdec->have_new_segment) {
+    gst_pad_push_event (y4mdec->srcpad,
+        gst_event_new_segment (&y4mdec->segment));
+    y4mdec->have_new_segment = FALSE;
+  }
 
-  return flow_ret;
+  timestamp = gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index);
+  if (GST_CLOCK_TIME_IS_VALID (y4mdec->segment.stop)
+      && timestamp >= y4mdec->segment.stop) {
+    flow_ret = GST_FLOW_EOS;
+    goto pause;
+  }
+
+  flow_ret = gst_y4m_dec_pull_frame (y4mdec, &buffer);
+  if (flow_ret != GST_FLOW_OK)
+    goto pause;
+
+  if (y4mdec->discont) {
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+    y4mdec->discont = FALSE;
+  }
+  y4mdec->segment.position = timestamp;
+
+  flow_ret = gst_y4m_dec_push_frame (y4mdec, buffer);
+  if (flow_ret != GST_FLOW_OK)
+    goto pause;
+
+  return;
+
+pause:
+  {
+    GST_DEBUG_OBJECT (y4mdec, "pausing task, reason %s",
+        gst_flow_get_name (flow_ret));
+    gst_pad_pause_task (pad);
+
+    if (flow_ret == GST_FLOW_EOS) {
+      if (y4mdec->segment.flags & GST_SEEK_FLAG_SEGMENT) {
+        GstClockTime stop = y4mdec->segment.stop;
+
+        if (!GST_CLOCK_TIME_IS_VALID (stop))
+          stop = y4mdec->segment.duration;
+
+        gst_element_post_message (GST_ELEMENT_CAST (y4mdec),
+            gst_message_new_segment_done (GST_OBJECT_CAST (y4mdec),
+                GST_FORMAT_TIME, stop));
+        gst_pad_push_event (y4mdec->srcpad,
+            gst_event_new_segment_done (GST_FORMAT_TIME, stop));
+      } else {
+        gst_pad_push_event (y4mdec->srcpad, gst_event_new_eos ());
+      }
+    } else if (flow_ret == GST_FLOW_NOT_LINKED || flow_ret < GST_FLOW_EOS) {
+      GST_ELEMENT_FLOW_ERROR (y4mdec, flow_ret);
+      gst_pad_push_event (y4mdec->srcpad, gst_event_new_eos ());
+    }
+  }
+}
+
+static gboolean
+gst_y4m_dec_sink_activate (GstPad * sinkpad, GstObject * parent)
+{
+  GstQuery *query;
+  gboolean pull_mode;
+
+  query = gst_query_new_scheduling ();
+
+  if (!gst_pad_peer_query (sinkpad, query)) {
+    gst_query_unref (query);
+    goto activate_push;
+  }
+
+  pull_mode = gst_query_has_scheduling_mode_with_flags (query,
+      GST_PAD_MODE_PULL, GST_SCHEDULING_FLAG_SEEKABLE);
+  gst_query_unref (query);
+
+  if (!pull_mode)
+    goto activate_push;
+
+  GST_DEBUG_OBJECT (sinkpad, "going to pull mode");
+  return gst_pad_activate_mode (sinkpad, GST_PAD_MODE_PULL, TRUE);
+
+activate_push:
+  {
+    GST_DEBUG_OBJECT (sinkpad, "going to push (streaming) mode");
+    return gst_pad_activate_mode (sinkpad, GST_PAD_MODE_PUSH, TRUE);
+  }
+}
+
+static gboolean
+gst_y4m_dec_sink_activate_mode (GstPad * sinkpad, GstObject * parent,
+    GstPadMode mode, gboolean active)
+{
+  GstY4mDec *y4mdec = GST_Y4M_DEC (parent);
+  gboolean res;
+
+  switch (mode) {
+    case GST_PAD_MODE_PUSH:
+      y4mdec->pull_mode = FALSE;
+      res = TRUE;
+      break;
+    case GST_PAD_MODE_PULL:
+      if (active) {
+        y4mdec->pull_mode = TRUE;
+        y4mdec->offset = 0;
+        y4mdec->discont = TRUE;
+        res = gst_pad_start_task (sinkpad, (GstTaskFunction) gst_y4m_dec_loop,
+            sinkpad, NULL);
+      } else {
+        res = gst_pad_stop_task (sinkpad);
+      }
+      break;
+    default:
+      res = FALSE;
+      break;
+  }
+
+  return res;
 }
 
 static gboolean
@@ -779,6 +1080,155 @@ gst_y4m_dec_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
   return res;
 }
 
+/* Reads the frame header at @offset and returns its size including the
+ * newline in @len */
+static GstFlowReturn
+gst_y4m_dec_pull_frame_header (GstY4mDec * y4mdec, guint64 offset, gsize * len)
+{
+  GstFlowReturn flow_ret;
+  GstBuffer *buffer = NULL;
+  GstMapInfo map;
+  gsize i;
+
+  flow_ret = gst_pad_pull_range (y4mdec->sinkpad, offset, MAX_HEADER_LENGTH,
+      &buffer);
+  if (flow_ret != GST_FLOW_OK)
+    return flow_ret;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  for (i = 0; i < map.size && map.data[i] != 0x0a; i++);
+  if (map.size < 6 || memcmp (map.data, "FRAME", 5) != 0 || i == map.size)
+    flow_ret = GST_FLOW_ERROR;
+  *len = i + 1;
+  gst_buffer_unmap (buffer, &map);
+  gst_buffer_unref (buffer);
+
+  return flow_ret;
+}
+
+/* Finds the offset of frame @framenum. Frames are at fixed offsets unless
+ * frame headers have parameters, in which case the headers are read one by
+ * one from the closest known position */
+static guint64
+gst_y4m_dec_frame_offset (GstY4mDec * y4mdec, gint64 framenum)
+{
+  guint64 offset;
+  gint64 i;
+  gsize len;
+
+  if (!y4mdec->frame_params) {
+    offset = gst_y4m_dec_frames_to_bytes (y4mdec, framenum);
+
+    if (gst_y4m_dec_pull_frame_header (y4mdec, offset, &len) == GST_FLOW_OK
+        && len == 6)
+      return offset;
+
+    GST_DEBUG_OBJECT (y4mdec, "No plain frame header at offset %"
+        G_GUINT64_FORMAT ", scanning", offset);
+  }
+
+  if (framenum >= y4mdec->frame_index) {
+    i = y4mdec->frame_index;
+    offset = y4mdec->offset;
+  } else {
+    i = 0;
+    offset = y4mdec->header_size;
+  }
+
+  for (; i < framenum; i++) {
+    /* past the end or broken, reading from there will tell */
+    if (gst_y4m_dec_pull_frame_header (y4mdec, offset, &len) != GST_FLOW_OK)
+      break;
+    if (len != 6)
+      y4mdec->frame_params = TRUE;
+    offset += len + y4mdec->info.size;
+  }
+
+  return offset;
+}
+
+/* Seeking in pull mode, frames are usually at fixed offsets so we can
+ * directly start reading from the right frame */
+static gboolean
+gst_y4m_dec_do_seek (GstY4mDec * y4mdec, GstEvent * event)
+{
+  gdouble rate;
+  GstFormat format;
+  GstSeekFlags flags;
+  GstSeekType start_type, stop_type;
+  gint64 start, stop;
+  gboolean flush, update;
+  guint32 seqnum;
+  GstSegment seeksegment;
+  gint64 framenum;
+  GstEvent *flush_event;
+
+  gst_event_parse_seek (event, &rate, &format, &flags, &start_type,
+      &start, &stop_type, &stop);
+  seqnum = gst_event_get_seqnum (event);
+
+  if (format != GST_FORMAT_TIME || rate <= 0.0) {
+    GST_DEBUG_OBJECT (y4mdec, "Only forward seeks in time are supported");
+    return FALSE;
+  }
+
+  if (!y4mdec->have_header) {
+    GST_DEBUG_OBJECT (y4mdec, "Can't seek before having parsed the header");
+    return FALSE;
+  }
+
+  flush = ! !(flags & GST_SEEK_FLAG_FLUSH);
+
+  if (flush) {
+    flush_event = gst_event_new_flush_start ();
+    gst_event_set_seqnum (flush_event, seqnum);
+    gst_pad_push_event (y4mdec->srcpad, flush_event);
+  } else {
+    gst_pad_pause_task (y4mdec->sinkpad);
+  }
+
+  GST_PAD_STREAM_LOCK (y4mdec->sinkpad);
+
+  seeksegment = y4mdec->segment;
+  gst_segment_do_seek (&seeksegment, rate, format, flags, start_type, start,
+      stop_type, stop, &update);
+
+  framenum = gst_y4m_dec_timestamp_to_frames (y4mdec, seeksegment.position);
+  if (flags & GST_SEEK_FLAG_KEY_UNIT) {
+    /* every frame is a keyframe, start the segment with the frame */
+    seeksegment.start = seeksegment.position = seeksegment.time =
+        gst_y4m_dec_frames_to_timestamp (y4mdec, framenum);
+  }
+
+  GST_DEBUG_OBJECT (y4mdec, "seeking to frame %" G_GINT64_FORMAT, framenum);
+
+  y4mdec->offset = gst_y4m_dec_frame_offset (y4mdec, framenum);
+  y4mdec->frame_index = framenum;
+
+  if (flush) {
+    flush_event = gst_event_new_flush_stop (TRUE);
+    gst_event_set_seqnum (flush_event, seqnum);
+    gst_pad_push_event (y4mdec->srcpad, flush_event);
+  }
+
+  y4mdec->segment = seeksegment;
+  y4mdec->have_new_segment = TRUE;
+  y4mdec->discont = TRUE;
+
+  if (y4mdec->segment.flags & GST_SEEK_FLAG_SEGMENT) {
+    gst_element_post_message (GST_ELEMENT_CAST (y4mdec),
+        gst_message_new_segment_start (GST_OBJECT_CAST (y4mdec),
+            GST_FORMAT_TIME, y4mdec->segment.position));
+  }
+
+  gst_pad_start_task (y4mdec->sinkpad, (GstTaskFunction) gst_y4m_dec_loop,
+      y4mdec->sinkpad, NULL);
+
+  GST_PAD_STREAM_UNLOCK (y4mdec->sinkpad);
+
+  return TRUE;
+}
+
 static gboolean
 gst_y4m_dec_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
@@ -800,6 +1250,12 @@ gst_y4m_dec_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
       gint64 framenum;
       guint64 byte;
 
+      if (y4mdec->pull_mode) {
+        res = gst_y4m_dec_do_seek (y4mdec, event);
+        gst_event_unref (event);
+        break;
+      }
+
       gst_event_parse_seek (event, &rate, &format, &flags, &start_type,
           &start, &stop_type, &stop);
 
@@ -882,6 +1338,22 @@ gst_y4m_dec_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
       gst_query_unref (peer_query);
       break;
     }
+    case GST_QUERY_SEEKING:
+    {
+      GstFormat format;
+
+      gst_query_parse_seeking (query, &format, NULL, NULL, NULL);
+
+      if (format == GST_FORMAT_TIME && y4mdec->pull_mode
+          && y4mdec->have_header) {
+        gst_query_set_seeking (query, GST_FORMAT_TIME, TRUE, 0,
+            y4mdec->segment.duration);
+        res = TRUE;
+      } else {
+        res = gst_pad_query_default (pad, parent, query);
+      }
+      break;
+    }
     default:
       res = gst_pad_query_default (pad, parent, query);
       break;
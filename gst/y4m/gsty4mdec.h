@@ -47,6 +47,14 @@ struct _GstY4mDec
   int frame_index;
   int header_size;
 
+  /* pull mode */
+  gboolean pull_mode;
+  guint64 offset;
+  gboolean discont;
+  /* frame headers with parameters were seen, frame offsets can't be
+   * calculated from the frame number */
+  gboolean frame_params;
+
   gboolean have_new_segment;
   GstSegment segment;
 
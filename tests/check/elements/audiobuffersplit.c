@@ -0,0 +1,297 @@
+/* GStreamer
+ *
+ * unit test for audiobuffersplit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+/* S16LE mono */
+#define BPF 2
+
+typedef struct
+{
+  guint n_lists;
+  guint n_list_buffers;
+} ListCount;
+
+static GstPadProbeReturn
+count_lists (GstPad * pad, GstPadProbeInfo * info, ListCount * count)
+{
+  GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+
+  count->n_lists++;
+  count->n_list_buffers += gst_buffer_list_length (list);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstHarness *
+setup_audiobuffersplit (gint rate, ListCount * count)
+{
+  GstHarness *h;
+  GstPad *srcpad;
+  gchar *caps;
+
+  h = gst_harness_new_parse
+      ("audiobuffersplit output-buffer-duration=1/1000");
+
+  srcpad = gst_element_get_static_pad (h->element, "src");
+  gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      (GstPadProbeCallback) count_lists, count, NULL);
+  gst_object_unref (srcpad);
+
+  caps = g_strdup_printf ("audio/x-raw,format=S16LE,rate=%d,channels=1,"
+      "layout=interleaved", rate);
+  gst_harness_set_src_caps_str (h, caps);
+  g_free (caps);
+
+  return h;
+}
+
+/* Each sample holds the lower 16 bits of its position in the stream */
+static GstBuffer *
+make_input (gint rate, guint64 offset, guint n_samples)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, n_samples * BPF, NULL);
+  GstMapInfo map;
+  guint i;
+
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  for (i = 0; i < n_samples; i++)
+    GST_WRITE_UINT16_LE (map.data + i * BPF, (offset + i) & 0xffff);
+  gst_buffer_unmap (buf, &map);
+
+  GST_BUFFER_PTS (buf) = gst_util_uint64_scale (offset, GST_SECOND, rate);
+  GST_BUFFER_DURATION (buf) =
+      gst_util_uint64_scale (offset + n_samples, GST_SECOND, rate) -
+      GST_BUFFER_PTS (buf);
+
+  return buf;
+}
+
+/* Pulls all output and checks that it continues the stream at @offset
+ * without gaps, in buffers of the sizes expected for 1 ms. Timestamps are
+ * expected relative to the stream position @base of the last resync.
+ * Returns the offset after the last buffer */
+static guint64
+check_output (GstHarness * h, gint rate, guint64 base, guint64 offset,
+    gboolean discont, gboolean allow_short_last)
+{
+  GstClockTime base_pts = gst_util_uint64_scale (base, GST_SECOND, rate);
+  GstBuffer *buf;
+  guint64 expected_samples, accumulated = 0;
+
+  while ((buf = gst_harness_try_pull (h))) {
+    GstMapInfo map;
+    guint n_samples, i;
+    GstClockTime pts, end;
+
+    fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+    n_samples = map.size / BPF;
+
+    /* rate / 1000 samples, plus one whenever the fractional part adds up
+     * to a full sample */
+    expected_samples = (accumulated + rate) / 1000 - accumulated / 1000;
+    accumulated += rate;
+    if (!(allow_short_last && gst_harness_buffers_in_queue (h) == 0))
+      fail_unless_equals_int (n_samples, expected_samples);
+
+    for (i = 0; i < n_samples; i++)
+      fail_unless_equals_int (GST_READ_UINT16_LE (map.data + i * BPF),
+          (offset + i) & 0xffff);
+    gst_buffer_unmap (buf, &map);
+
+    pts = base_pts + gst_util_uint64_scale (offset - base, GST_SECOND, rate);
+    end = base_pts + gst_util_uint64_scale (offset + n_samples - base,
+        GST_SECOND, rate);
+    fail_unless_equals_clocktime (GST_BUFFER_PTS (buf), pts);
+    fail_unless_equals_clocktime (GST_BUFFER_DURATION (buf), end - pts);
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET (buf),
+        GST_BUFFER_OFFSET_NONE);
+
+    fail_unless_equals_int (GST_BUFFER_IS_DISCONT (buf), discont);
+    discont = FALSE;
+
+    offset += n_samples;
+    gst_buffer_unref (buf);
+  }
+
+  return offset;
+}
+
+static void
+check_misaligned_split (gint rate)
+{
+  const guint in_samples = 1024, n_inputs = 20;
+  ListCount count = { 0, };
+  GstHarness *h;
+  guint64 offset;
+  guint i;
+
+  h = setup_audiobuffersplit (rate, &count);
+
+  for (i = 0; i < n_inputs; i++)
+    fail_unless_equals_int (gst_harness_push (h, make_input (rate,
+                i * in_samples, in_samples)), GST_FLOW_OK);
+
+  /* every input buffer contains many outputs, which are pushed downstream
+   * at once as a single list */
+  fail_unless_equals_int (count.n_lists, n_inputs);
+  fail_unless_equals_int (count.n_list_buffers,
+      gst_harness_buffers_in_queue (h));
+
+  offset = check_output (h, rate, 0, 0, TRUE, FALSE);
+
+  /* the remainder comes out at EOS */
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+  offset = check_output (h, rate, 0, offset, FALSE, TRUE);
+  fail_unless_equals_uint64 (offset, n_inputs * in_samples);
+
+  gst_harness_teardown (h);
+}
+
+GST_START_TEST (test_split_misaligned_48000)
+{
+  /* 1024 sample input buffers into 48 sample (1 ms, AES67) output */
+  check_misaligned_split (48000);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_split_misaligned_44100)
+{
+  /* 44.1 samples per output buffer, 44 or 45 in practice */
+  check_misaligned_split (44100);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_split_discont)
+{
+  const gint rate = 48000;
+  ListCount count = { 0, };
+  GstHarness *h;
+  GstBuffer *buf;
+  guint64 offset;
+
+  h = setup_audiobuffersplit (rate, &count);
+
+  fail_unless_equals_int (gst_harness_push (h, make_input (rate, 0, 100)),
+      GST_FLOW_OK);
+  /* 2 full buffers, 4 samples left in the adapter */
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 2);
+  offset = check_output (h, rate, 0, 0, TRUE, FALSE);
+  fail_unless_equals_uint64 (offset, 96);
+
+  /* jump ahead by 100 ms */
+  buf = make_input (rate, 100 + rate / 10, 100);
+  GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+
+  /* the remaining samples from before the discont are drained first */
+  buf = gst_harness_pull (h);
+  fail_unless_equals_int (gst_buffer_get_size (buf), 4 * BPF);
+  fail_unless_equals_clocktime (GST_BUFFER_PTS (buf),
+      gst_util_uint64_scale (96, GST_SECOND, rate));
+  fail_if (GST_BUFFER_IS_DISCONT (buf));
+  gst_buffer_unref (buf);
+
+  /* and the new data restarts at the new timestamp, flagged discont */
+  offset = check_output (h, rate, 100 + rate / 10, 100 + rate / 10, TRUE,
+      FALSE);
+  fail_unless_equals_uint64 (offset, 100 + rate / 10 + 96);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_split_shares_memory)
+{
+  const gint rate = 48000;
+  const guint in_samples = 1024;
+  ListCount count = { 0, };
+  GstHarness *h;
+  GstBuffer *inputs[4], *buf;
+  const guint8 *in_data[4];
+  guint64 offset = 0;
+  guint i;
+
+  h = setup_audiobuffersplit (rate, &count);
+
+  for (i = 0; i < G_N_ELEMENTS (inputs); i++) {
+    GstMapInfo map;
+
+    inputs[i] = make_input (rate, i * in_samples, in_samples);
+    fail_unless (gst_buffer_map (inputs[i], &map, GST_MAP_READ));
+    in_data[i] = map.data;
+    gst_buffer_unmap (inputs[i], &map);
+
+    fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (inputs[i])),
+        GST_FLOW_OK);
+  }
+
+  /* Every memory of the output points into the input memory that holds
+   * its samples, and output spanning two inputs has one memory of each */
+  while ((buf = gst_harness_try_pull (h))) {
+    for (i = 0; i < gst_buffer_n_memory (buf); i++) {
+      GstMemory *mem = gst_buffer_peek_memory (buf, i);
+      guint in_offset = offset % in_samples;
+      GstMapInfo map;
+
+      fail_unless (gst_memory_map (mem, &map, GST_MAP_READ));
+      fail_unless (map.data == in_data[offset / in_samples] + in_offset * BPF);
+      fail_unless (in_offset + map.size / BPF <= in_samples);
+      offset += map.size / BPF;
+      gst_memory_unmap (mem, &map);
+    }
+    gst_buffer_unref (buf);
+  }
+
+  fail_unless_equals_uint64 (offset,
+      G_N_ELEMENTS (inputs) * in_samples / 48 * 48);
+
+  for (i = 0; i < G_N_ELEMENTS (inputs); i++)
+    gst_buffer_unref (inputs[i]);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+audiobuffersplit_suite (void)
+{
+  Suite *s = suite_create ("audiobuffersplit");
+  TCase *tc = tcase_create ("general");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_split_misaligned_48000);
+  tcase_add_test (tc, test_split_misaligned_44100);
+  tcase_add_test (tc, test_split_discont);
+  tcase_add_test (tc, test_split_shares_memory);
+
+  return s;
+}
+
+GST_CHECK_MAIN (audiobuffersplit);
@@ -448,6 +448,72 @@ GST_START_TEST (convert_cea708_cc_data_cea708_cdp)
 
 GST_END_TEST;
 
+GST_START_TEST (convert_cea708_cc_data_cea708_cdp_many_frames)
+{
+  /* converts a long run of frames, as done for whole files, checking that
+   * output buffers are recycled and always carry exactly one complete
+   * packet */
+  const guint8 in[] = { 0xfc, 0x80, 0x80, 0xfe, 0x80, 0x80 };
+  /* the same as in convert_cea708_cc_data_cea708_cdp, apart from the
+   * sequence counters and the checksum */
+  const guint8 out[] =
+      { 0x96, 0x69, 0x2b, 0x8f, 0x43, 0x00, 0x00, 0x72, 0xea, 0xfc, 0x80, 0x80,
+    0xfe, 0x80, 0x80, 0xfa, 0x00, 0x00, 0xfa, 0x00, 0x00, 0xfa, 0x00, 0x00,
+    0xfa, 0x00, 0x00, 0xfa, 0x00, 0x00, 0xfa, 0x00, 0x00, 0xfa, 0x00, 0x00,
+    0xfa, 0x00, 0x00, 0x74, 0x00, 0x00, 0x6a
+  };
+  const guint n_frames = 2000;
+  GstHarness *h;
+  GstBuffer *buffer, *first = NULL;
+  GstMapInfo map;
+  guint i, j;
+
+  h = gst_harness_new ("ccconverter");
+
+  gst_harness_set_src_caps_str (h,
+      "closedcaption/x-cea-708,format=(string)cc_data,framerate=(fraction)60/1");
+  gst_harness_set_sink_caps_str (h,
+      "closedcaption/x-cea-708,format=(string)cdp");
+
+  for (i = 0; i < n_frames; i++) {
+    guint8 checksum = 0;
+
+    buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+        (gpointer) in, sizeof (in), 0, sizeof (in), NULL, NULL);
+    fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_OK);
+
+    fail_unless_equals_int (gst_harness_buffers_in_queue (h), 1);
+    buffer = gst_harness_pull (h);
+    fail_unless (buffer != NULL);
+
+    /* each output buffer is released before the next frame, so the same
+     * pooled buffer comes back every time, restored to its full size */
+    fail_unless (buffer->pool != NULL);
+    if (first == NULL)
+      first = buffer;
+    fail_unless (buffer == first);
+
+    fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+    fail_unless_equals_int (map.size, sizeof (out));
+    fail_unless (memcmp (map.data, out, 5) == 0);
+    fail_unless (memcmp (&map.data[7], &out[7], 40 - 7) == 0);
+    /* cdp header and footer sequence counters */
+    fail_unless_equals_int (GST_READ_UINT16_BE (&map.data[5]), i & 0xffff);
+    fail_unless_equals_int (GST_READ_UINT16_BE (&map.data[40]), i & 0xffff);
+    for (j = 0; j < map.size; j++)
+      checksum += map.data[j];
+    fail_unless_equals_int (checksum, 0);
+    gst_buffer_unmap (buffer, &map);
+    gst_buffer_unref (buffer);
+  }
+
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (convert_cea708_cdp_cea608_raw)
 {
   const guint8 in[] =
@@ -974,6 +1040,7 @@ ccextractor_suite (void)
   tcase_add_test (tc, convert_cea708_cc_data_cea608_raw);
   tcase_add_test (tc, convert_cea708_cc_data_cea608_s334_1a);
   tcase_add_test (tc, convert_cea708_cc_data_cea708_cdp);
+  tcase_add_test (tc, convert_cea708_cc_data_cea708_cdp_many_frames);
   tcase_add_test (tc, convert_cea708_cdp_cea608_raw);
   tcase_add_test (tc, convert_cea708_cdp_cea608_s334_1a);
   tcase_add_test (tc, convert_cea708_cdp_cea708_cc_data);
@@ -0,0 +1,244 @@
+/* GStreamer
+ *
+ * unit test for checksumsink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+static GstHarness *
+setup_checksumsink (const gchar * hash, gboolean planes, const gchar * caps,
+    GstBus ** bus)
+{
+  GstHarness *h = gst_harness_new ("checksumsink");
+
+  gst_util_set_object_arg (G_OBJECT (h->element), "hash", hash);
+  g_object_set (h->element, "planes", planes, "post-messages", TRUE, NULL);
+
+  *bus = gst_bus_new ();
+  gst_element_set_bus (h->element, *bus);
+
+  gst_harness_set_src_caps_str (h, caps);
+
+  return h;
+}
+
+static void
+teardown_checksumsink (GstHarness * h, GstBus * bus)
+{
+  gst_bus_set_flushing (bus, TRUE);
+  gst_object_unref (bus);
+  gst_harness_teardown (h);
+}
+
+/* Pushes @data and returns the "checksum" message that was posted for it */
+static GstStructure *
+push_data (GstHarness * h, GstBus * bus, const guint8 * data, gsize size,
+    GstClockTime pts)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, size, NULL);
+  GstMessage *msg;
+  GstStructure *s;
+  GstClockTime timestamp;
+
+  gst_buffer_fill (buf, 0, data, size);
+  GST_BUFFER_PTS (buf) = pts;
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT);
+  fail_unless (msg != NULL);
+  fail_unless (gst_message_has_name (msg, "checksum"));
+
+  s = gst_structure_copy (gst_message_get_structure (msg));
+  gst_message_unref (msg);
+
+  fail_unless (gst_structure_get_clock_time (s, "timestamp", &timestamp));
+  fail_unless_equals_clocktime (timestamp, pts);
+
+  return s;
+}
+
+/* Bitwise CRC-32C, to check the table driven implementation against */
+static guint32
+reference_crc32c (const guint8 * data, gsize size)
+{
+  guint32 crc = 0xffffffff;
+  gsize i;
+  gint j;
+
+  for (i = 0; i < size; i++) {
+    crc ^= data[i];
+    for (j = 0; j < 8; j++)
+      crc = (crc >> 1) ^ ((crc & 1) ? 0x82f63b78 : 0);
+  }
+
+  return ~crc;
+}
+
+GST_START_TEST (test_crc32c)
+{
+  GstHarness *h;
+  GstBus *bus;
+  GstStructure *s;
+  guint8 data[1021];
+  gsize sizes[] = { 0, 1, 7, 8, 9, 64, 1021 };
+  gsize i;
+
+  h = setup_checksumsink ("crc32c", FALSE, "application/octet-stream", &bus);
+
+  /* standard check value */
+  s = push_data (h, bus, (const guint8 *) "123456789", 9, 0);
+  fail_unless_equals_string (gst_structure_get_string (s, "checksum"),
+      "e3069283");
+  gst_structure_free (s);
+
+  /* sizes around the 8 byte blocks of the fast path */
+  for (i = 0; i < sizeof (data); i++)
+    data[i] = (i * 7 + 3) & 0xff;
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+    gchar *expected = g_strdup_printf ("%08x",
+        reference_crc32c (data, sizes[i]));
+
+    s = push_data (h, bus, data, sizes[i], i * GST_SECOND);
+    fail_unless_equals_string (gst_structure_get_string (s, "checksum"),
+        expected);
+    fail_if (gst_structure_has_field (s, "planes"));
+    gst_structure_free (s);
+    g_free (expected);
+  }
+
+  teardown_checksumsink (h, bus);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_planes_skip_padding)
+{
+  /* 3x2 GRAY8 has lines of 4 bytes, the last one is padding */
+  static const guint8 frame1[] = { 1, 2, 3, 0, 4, 5, 6, 0 };
+  static const guint8 frame2[] = { 1, 2, 3, 0xaa, 4, 5, 6, 0x55 };
+  static const guint8 visible[] = { 1, 2, 3, 4, 5, 6 };
+  GstHarness *h;
+  GstBus *bus;
+  GstStructure *s1, *s2;
+  const GValue *planes;
+  gchar *expected;
+
+  h = setup_checksumsink ("md5", TRUE,
+      "video/x-raw,format=GRAY8,width=3,height=2,framerate=25/1", &bus);
+
+  s1 = push_data (h, bus, frame1, sizeof (frame1), 0);
+  s2 = push_data (h, bus, frame2, sizeof (frame2), 40 * GST_MSECOND);
+
+  expected = g_compute_checksum_for_data (G_CHECKSUM_MD5, visible,
+      sizeof (visible));
+
+  planes = gst_structure_get_value (s1, "planes");
+  fail_unless (planes != NULL);
+  fail_unless_equals_int (gst_value_array_get_size (planes), 1);
+  fail_unless_equals_string (g_value_get_string (gst_value_array_get_value
+          (planes, 0)), expected);
+  fail_unless_equals_string (gst_structure_get_string (s1, "checksum"),
+      expected);
+
+  /* different padding, same checksum */
+  fail_unless_equals_string (gst_structure_get_string (s2, "checksum"),
+      expected);
+
+  g_free (expected);
+  gst_structure_free (s1);
+  gst_structure_free (s2);
+
+  teardown_checksumsink (h, bus);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_planes_i420)
+{
+  /* 2x2 I420: 4 stride aligned luma lines of 4 bytes, and chroma planes of
+   * a single pixel with 3 bytes of padding each */
+  guint8 frame[4 * 2 + 4 + 4];
+  static const guint8 y[] = { 10, 11, 12, 13 };
+  GstHarness *h;
+  GstBus *bus;
+  GstStructure *s;
+  const GValue *planes;
+  gchar *expected[3];
+  gchar *joined;
+  gint i;
+
+  memset (frame, 0xff, sizeof (frame));
+  memcpy (frame, y, 2);
+  memcpy (frame + 4, y + 2, 2);
+  frame[8] = 20;
+  frame[12] = 30;
+
+  h = setup_checksumsink ("sha1", TRUE,
+      "video/x-raw,format=I420,width=2,height=2,framerate=25/1", &bus);
+
+  s = push_data (h, bus, frame, sizeof (frame), 0);
+
+  expected[0] = g_compute_checksum_for_data (G_CHECKSUM_SHA1, y, 4);
+  expected[1] = g_compute_checksum_for_data (G_CHECKSUM_SHA1, frame + 8, 1);
+  expected[2] = g_compute_checksum_for_data (G_CHECKSUM_SHA1, frame + 12, 1);
+
+  planes = gst_structure_get_value (s, "planes");
+  fail_unless (planes != NULL);
+  fail_unless_equals_int (gst_value_array_get_size (planes), 3);
+  for (i = 0; i < 3; i++)
+    fail_unless_equals_string (g_value_get_string (gst_value_array_get_value
+            (planes, i)), expected[i]);
+
+  /* the checksum field lists the planes separated by spaces */
+  joined = g_strjoin (" ", expected[0], expected[1], expected[2], NULL);
+  fail_unless_equals_string (gst_structure_get_string (s, "checksum"),
+      joined);
+
+  g_free (joined);
+  for (i = 0; i < 3; i++)
+    g_free (expected[i]);
+  gst_structure_free (s);
+
+  teardown_checksumsink (h, bus);
+}
+
+GST_END_TEST;
+
+static Suite *
+checksumsink_suite (void)
+{
+  Suite *s = suite_create ("checksumsink");
+  TCase *tc = tcase_create ("general");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_crc32c);
+  tcase_add_test (tc, test_planes_skip_padding);
+  tcase_add_test (tc, test_planes_i420);
+
+  return s;
+}
+
+GST_CHECK_MAIN (checksumsink);
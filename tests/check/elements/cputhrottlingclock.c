@@ -0,0 +1,146 @@
+/* GStreamer
+ *
+ * unit test for the CPU throttling clock of uritranscodebin
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+
+#include "../../../gst/transcode/gst-cpu-throttling-clock.h"
+
+/* The wait time is evaluated every 250 ms */
+#define EVALUATION_INTERVAL (GST_SECOND / 4)
+
+static gpointer
+burn_cpu (gpointer user_data)
+{
+  gint64 end = g_get_monotonic_time () + GPOINTER_TO_INT (user_data);
+  volatile guint counter = 0;
+
+  while (g_get_monotonic_time () < end)
+    counter++;
+
+  return NULL;
+}
+
+/* Keeps every CPU of the machine busy for @duration */
+static void
+load_cpus (GstClockTime duration)
+{
+  guint i, n_threads = g_get_num_processors ();
+  GThread **threads = g_new (GThread *, n_threads);
+
+  for (i = 0; i < n_threads; i++)
+    threads[i] = g_thread_new ("burn-cpu", burn_cpu,
+        GINT_TO_POINTER (GST_TIME_AS_USECONDS (duration)));
+  for (i = 0; i < n_threads; i++)
+    g_thread_join (threads[i]);
+
+  g_free (threads);
+}
+
+/* Returns how long a wait on @clock blocked. The throttling clock waits
+ * for its current wait time whatever the time of the entry */
+static GstClockTime
+timed_wait (GstClock * clock)
+{
+  GstClockID id = gst_clock_new_single_shot_id (clock, 0);
+  gint64 start = g_get_monotonic_time ();
+
+  gst_clock_id_wait (id, NULL);
+  gst_clock_id_unref (id);
+
+  return (g_get_monotonic_time () - start) * GST_USECOND;
+}
+
+static guint
+get_measured_cpu_usage (GstClock * clock)
+{
+  guint usage;
+
+  g_object_get (clock, "measured-cpu-usage", &usage, NULL);
+
+  return usage;
+}
+
+GST_START_TEST (test_measured_cpu_usage)
+{
+  GstClock *clock = GST_CLOCK (gst_cpu_throttling_clock_new (100));
+
+  fail_unless_equals_int (get_measured_cpu_usage (clock), 0);
+
+  /* the first wait starts the evaluations */
+  timed_wait (clock);
+
+  load_cpus (3 * EVALUATION_INTERVAL);
+  fail_unless (get_measured_cpu_usage (clock) > 0);
+
+  /* an idle process is measured as such again */
+  g_usleep (GST_TIME_AS_USECONDS (3 * EVALUATION_INTERVAL));
+  fail_unless (get_measured_cpu_usage (clock) < 10);
+
+  gst_object_unref (clock);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_proportional_wait)
+{
+  GstClock *clock = GST_CLOCK (gst_cpu_throttling_clock_new (10));
+  GstClockTime loaded_wait, idle_wait;
+
+  timed_wait (clock);
+
+  /* far above the wanted usage, the wait time doubles on every evaluation
+   * from 1 ms, instead of growing by a fixed step */
+  load_cpus (6 * EVALUATION_INTERVAL);
+  loaded_wait = timed_wait (clock);
+  GST_INFO ("wait time under load %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (loaded_wait));
+  fail_unless (loaded_wait >= 10 * GST_MSECOND);
+  fail_unless (loaded_wait <= 2 * GST_SECOND);
+
+  /* and far below it, the wait time halves until it is dropped */
+  g_usleep (GST_TIME_AS_USECONDS (10 * EVALUATION_INTERVAL));
+  idle_wait = timed_wait (clock);
+  GST_INFO ("wait time when idle %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (idle_wait));
+  fail_unless (idle_wait < loaded_wait / 4);
+
+  gst_object_unref (clock);
+}
+
+GST_END_TEST;
+
+static Suite *
+cputhrottlingclock_suite (void)
+{
+  Suite *s = suite_create ("cputhrottlingclock");
+  TCase *tc = tcase_create ("general");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_measured_cpu_usage);
+  tcase_add_test (tc, test_proportional_wait);
+
+  return s;
+}
+
+GST_CHECK_MAIN (cputhrottlingclock);
@@ -99,6 +99,7 @@ GST_START_TEST (dash_mpdparser_validsimplempd)
 
   /* check that unset elements with default values are properly configured */
   assert_equals_int (mpdclient->mpd_root_node->type, GST_MPD_FILE_TYPE_STATIC);
+  assert_equals_int (mpdclient->has_external_resources, FALSE);
 
   gst_mpd_client_free (mpdclient);
 }
@@ -5864,6 +5865,7 @@ GST_START_TEST (dash_mpdparser_xlink_period)
   period_list = mpdclient->mpd_root_node->Periods;
   /* only count periods on initial mpd (external xml does not parsed yet) */
   assert_equals_int (g_list_length (period_list), 4);
+  assert_equals_int (mpdclient->has_external_resources, TRUE);
 
   /* process the xml data */
   ret = gst_mpd_client_setup_media_presentation (mpdclient, GST_CLOCK_TIME_NONE,
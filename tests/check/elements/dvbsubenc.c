@@ -0,0 +1,640 @@
+/* GStreamer
+ *
+ * unit test for dvbsubenc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/base/gstbitwriter.h>
+#include <gst/base/gstbytewriter.h>
+
+#define WIDTH 64
+#define HEIGHT 32
+
+#define SEGMENT_TYPE_PAGE_COMPOSITION 0x10
+#define SEGMENT_TYPE_REGION_COMPOSITION 0x11
+#define SEGMENT_TYPE_CLUT_DEFINITION 0x12
+#define SEGMENT_TYPE_OBJECT_DATA 0x13
+
+#define PIXEL_DATA_TYPE_2BIT 0x10
+#define PIXEL_DATA_TYPE_4BIT 0x11
+#define PIXEL_DATA_TYPE_8BIT 0x12
+#define PIXEL_DATA_TYPE_END_OF_LINE 0xF0
+
+/* AYUV colours of the three vertical bars of the test subpicture */
+static const guint8 bar_colours[][4] = {
+  {0xff, 0xeb, 0x80, 0x80},
+  {0xff, 0x10, 0x80, 0x80},
+  {0x80, 0x51, 0x5a, 0xf0},
+};
+
+/* The subpicture covers 30x10 pixels at 8,20 of an otherwise transparent
+ * frame, and is shifted right by @shift pixels */
+#define BAR_X 8
+#define BAR_Y 20
+#define BAR_WIDTH 10
+#define BAR_HEIGHT 10
+
+static GstBuffer *
+make_frame (gboolean empty, guint shift, GstClockTime pts)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, WIDTH * HEIGHT * 4, NULL);
+  GstMapInfo map;
+  guint x, y;
+
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  memset (map.data, 0, map.size);
+  if (!empty) {
+    for (y = BAR_Y; y < BAR_Y + BAR_HEIGHT; y++) {
+      for (x = 0; x < G_N_ELEMENTS (bar_colours) * BAR_WIDTH; x++)
+        memcpy (map.data + (y * WIDTH + BAR_X + shift + x) * 4,
+            bar_colours[x / BAR_WIDTH], 4);
+    }
+  }
+  gst_buffer_unmap (buf, &map);
+
+  GST_BUFFER_PTS (buf) = pts;
+  GST_BUFFER_DURATION (buf) = GST_SECOND;
+
+  return buf;
+}
+
+static GstHarness *
+setup_dvbsubenc (gint width, gint height)
+{
+  GstHarness *h = gst_harness_new ("dvbsubenc");
+  gchar *caps;
+
+  caps = g_strdup_printf ("video/x-raw,format=AYUV,width=%d,height=%d,"
+      "framerate=1/1", width, height);
+  gst_harness_set_src_caps_str (h, caps);
+  g_free (caps);
+
+  return h;
+}
+
+/* Returns the payload of the first segment of @type in a subtitle packet */
+static const guint8 *
+find_segment (const guint8 * data, gsize size, guint8 type, guint * seg_size)
+{
+  gsize pos = 2;
+
+  /* data identifier and subtitle stream id */
+  fail_unless (size > 2 && data[0] == 0x20 && data[1] == 0x00);
+
+  while (pos + 6 <= size && data[pos] == 0x0f) {
+    guint len = GST_READ_UINT16_BE (data + pos + 4);
+
+    fail_unless (pos + 6 + len <= size);
+    if (data[pos + 1] == type) {
+      *seg_size = len;
+      return data + pos + 6;
+    }
+    pos += 6 + len;
+  }
+
+  return NULL;
+}
+
+/* Pulls the events up to the next GAP event and checks its timestamp */
+static void
+check_gap (GstHarness * h, GstClockTime pts)
+{
+  GstEvent *event;
+  GstClockTime timestamp, duration;
+
+  while ((event = gst_harness_try_pull_event (h))) {
+    if (GST_EVENT_TYPE (event) == GST_EVENT_GAP)
+      break;
+    gst_event_unref (event);
+  }
+
+  fail_unless (event != NULL, "no gap event at %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (pts));
+  gst_event_parse_gap (event, &timestamp, &duration);
+  fail_unless_equals_clocktime (timestamp, pts);
+  fail_unless_equals_clocktime (duration, GST_SECOND);
+  gst_event_unref (event);
+}
+
+static void
+check_page (GstHarness * h, GstClockTime pts, guint shift)
+{
+  GstBuffer *buf = gst_harness_pull (h);
+  GstMapInfo map;
+  const guint8 *seg;
+  guint seg_size;
+
+  fail_unless_equals_clocktime (GST_BUFFER_PTS (buf), pts);
+
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+
+  /* a single region at the position of the bars */
+  seg = find_segment (map.data, map.size, SEGMENT_TYPE_PAGE_COMPOSITION,
+      &seg_size);
+  fail_unless (seg != NULL);
+  fail_unless_equals_int (seg_size, 2 + 6);
+  fail_unless_equals_int (GST_READ_UINT16_BE (seg + 4), BAR_X + shift);
+  fail_unless_equals_int (GST_READ_UINT16_BE (seg + 6), BAR_Y);
+
+  seg = find_segment (map.data, map.size, SEGMENT_TYPE_REGION_COMPOSITION,
+      &seg_size);
+  fail_unless (seg != NULL);
+  fail_unless_equals_int (GST_READ_UINT16_BE (seg + 2),
+      G_N_ELEMENTS (bar_colours) * BAR_WIDTH);
+  fail_unless_equals_int (GST_READ_UINT16_BE (seg + 4), BAR_HEIGHT);
+
+  gst_buffer_unmap (buf, &map);
+  gst_buffer_unref (buf);
+}
+
+GST_START_TEST (test_exact_palette)
+{
+  GstHarness *h;
+  GstBuffer *buf;
+  GstMapInfo map;
+  const guint8 *clut;
+  guint seg_size, i, j;
+
+  h = setup_dvbsubenc (WIDTH, HEIGHT);
+
+  fail_unless_equals_int (gst_harness_push (h, make_frame (FALSE, 0, 0)),
+      GST_FLOW_OK);
+  buf = gst_harness_pull (h);
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+
+  /* A few colours are used as they are instead of being quantised, so the
+   * CLUT holds exactly the input colours, as Y, V, U and transparency */
+  clut = find_segment (map.data, map.size, SEGMENT_TYPE_CLUT_DEFINITION,
+      &seg_size);
+  fail_unless (clut != NULL);
+  fail_unless_equals_int ((seg_size - 2) / 6, G_N_ELEMENTS (bar_colours));
+
+  for (i = 0; i < G_N_ELEMENTS (bar_colours); i++) {
+    const guint8 *c = bar_colours[i];
+    gboolean found = FALSE;
+
+    for (j = 0; j < G_N_ELEMENTS (bar_colours) && !found; j++) {
+      const guint8 *entry = clut + 2 + j * 6;
+
+      found = entry[2] == c[1] && entry[3] == c[3] && entry[4] == c[2] &&
+          entry[5] == 255 - c[0];
+    }
+    fail_unless (found, "colour %u not in the CLUT", i);
+  }
+
+  gst_buffer_unmap (buf, &map);
+  gst_buffer_unref (buf);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_skip_unchanged_page)
+{
+  GstHarness *h;
+
+  h = setup_dvbsubenc (WIDTH, HEIGHT);
+
+  /* nothing to show yet */
+  fail_unless_equals_int (gst_harness_push (h, make_frame (TRUE, 0, 0)),
+      GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+  check_gap (h, 0);
+
+  fail_unless_equals_int (gst_harness_push (h, make_frame (FALSE, 0,
+              GST_SECOND)), GST_FLOW_OK);
+  check_page (h, GST_SECOND, 0);
+
+  /* the same subpicture only extends the page on screen */
+  fail_unless_equals_int (gst_harness_push (h, make_frame (FALSE, 0,
+              2 * GST_SECOND)), GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_push (h, make_frame (FALSE, 0,
+              3 * GST_SECOND)), GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+  check_gap (h, 2 * GST_SECOND);
+  check_gap (h, 3 * GST_SECOND);
+
+  /* while a moved one is sent as a new page */
+  fail_unless_equals_int (gst_harness_push (h, make_frame (FALSE, 4,
+              4 * GST_SECOND)), GST_FLOW_OK);
+  check_page (h, 4 * GST_SECOND, 4);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_refresh_unchanged_page)
+{
+  GstHarness *h;
+  guint i;
+
+  h = setup_dvbsubenc (WIDTH, HEIGHT);
+
+  for (i = 0; i <= 20; i++)
+    fail_unless_equals_int (gst_harness_push (h, make_frame (FALSE, 0,
+                i * GST_SECOND)), GST_FLOW_OK);
+
+  /* An unchanged page is still sent every 10 seconds so that decoders don't
+   * time it out */
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 3);
+  check_page (h, 0, 0);
+  check_page (h, 10 * GST_SECOND, 0);
+  check_page (h, 20 * GST_SECOND, 0);
+
+  for (i = 1; i < 20; i++) {
+    if (i != 10)
+      check_gap (h, i * GST_SECOND);
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+/* The run-length encoders as they were before they were optimised, to check
+ * that the encoder output didn't change */
+typedef void (*EncodeRLEFunc) (GstByteWriter * b, const guint8 * pixels,
+    const gint stride, const gint w, const gint h);
+
+static void
+reference_encode_rle2 (GstByteWriter * b, const guint8 * pixels,
+    const gint stride, const gint w, const gint h)
+{
+  GstBitWriter bits;
+  int y;
+
+  gst_bit_writer_init (&bits);
+
+  for (y = 0; y < h; y++) {
+    int x = 0;
+    guint size;
+
+    gst_byte_writer_put_uint8 (b, PIXEL_DATA_TYPE_2BIT);
+
+    while (x < w) {
+      int x_end = x;
+      int run_length;
+      guint8 pix;
+
+      pix = pixels[x_end++];
+      while (x_end < w && pixels[x_end] == pix)
+        x_end++;
+
+      run_length = MIN (x_end - x, 284);
+
+      if (run_length >= 29) {
+        gst_bit_writer_put_bits_uint8 (&bits, 0x03, 6);
+        gst_bit_writer_put_bits_uint8 (&bits, run_length - 29, 8);
+        gst_bit_writer_put_bits_uint8 (&bits, pix, 2);
+      } else if (run_length >= 12 && run_length <= 27) {
+        gst_bit_writer_put_bits_uint8 (&bits, 0x02, 6);
+        gst_bit_writer_put_bits_uint8 (&bits, run_length - 12, 4);
+        gst_bit_writer_put_bits_uint8 (&bits, pix, 2);
+      } else if (run_length >= 3 && run_length <= 10) {
+        gst_bit_writer_put_bits_uint8 (&bits, 0, 2);
+        gst_bit_writer_put_bits_uint8 (&bits, 0x8 + run_length - 3, 4);
+        gst_bit_writer_put_bits_uint8 (&bits, pix, 2);
+      } else if (pix != 0) {
+        gst_bit_writer_put_bits_uint8 (&bits, pix, 2);
+        run_length = 1;
+      } else if (run_length == 2) {
+        gst_bit_writer_put_bits_uint8 (&bits, 0x1, 6);
+        run_length = 2;
+      } else {
+        gst_bit_writer_put_bits_uint8 (&bits, 0x1, 4);
+        run_length = 1;
+      }
+
+      x += run_length;
+    }
+
+    gst_bit_writer_put_bits_uint8 (&bits, 0x00, 8);
+
+    gst_bit_writer_align_bytes (&bits, 0);
+    size = gst_bit_writer_get_size (&bits);
+
+    gst_byte_writer_put_data (b, gst_bit_writer_get_data (&bits), size / 8);
+
+    gst_bit_writer_reset (&bits);
+    gst_bit_writer_init (&bits);
+
+    gst_byte_writer_put_uint8 (b, PIXEL_DATA_TYPE_END_OF_LINE);
+    pixels += stride;
+  }
+}
+
+static void
+reference_encode_rle4 (GstByteWriter * b, const guint8 * pixels,
+    const gint stride, const gint w, const gint h)
+{
+  GstBitWriter bits;
+  int y;
+
+  gst_bit_writer_init (&bits);
+
+  for (y = 0; y < h; y++) {
+    int x = 0;
+    guint size;
+
+    gst_byte_writer_put_uint8 (b, PIXEL_DATA_TYPE_4BIT);
+
+    while (x < w) {
+      int x_end = x;
+      int run_length;
+      guint8 pix;
+
+      pix = pixels[x_end++];
+      while (x_end < w && pixels[x_end] == pix)
+        x_end++;
+
+      run_length = MIN (x_end - x, 280);
+
+      if (pix == 0 && run_length >= 3 && run_length <= 9) {
+        gst_bit_writer_put_bits_uint8 (&bits, 0, 4);
+        gst_bit_writer_put_bits_uint8 (&bits, run_length - 2, 4);
+      } else if (run_length >= 4 && run_length < 25) {
+        if (run_length > 7)
+          run_length = 7;
+
+        gst_bit_writer_put_bits_uint8 (&bits, 0, 4);
+        gst_bit_writer_put_bits_uint8 (&bits, 0x8 + run_length - 4, 4);
+        gst_bit_writer_put_bits_uint8 (&bits, pix, 4);
+      } else if (run_length >= 25) {
+        gst_bit_writer_put_bits_uint8 (&bits, 0x0f, 8);
+        gst_bit_writer_put_bits_uint8 (&bits, run_length - 25, 8);
+        gst_bit_writer_put_bits_uint8 (&bits, pix, 4);
+      } else if (pix != 0) {
+        gst_bit_writer_put_bits_uint8 (&bits, pix, 4);
+        run_length = 1;
+      } else if (run_length > 1) {
+        gst_bit_writer_put_bits_uint8 (&bits, 0xd, 8);
+        run_length = 2;
+      } else {
+        gst_bit_writer_put_bits_uint8 (&bits, 0xc, 8);
+        run_length = 1;
+      }
+      x += run_length;
+    }
+
+    gst_bit_writer_put_bits_uint8 (&bits, 0x00, 8);
+
+    gst_bit_writer_align_bytes (&bits, 0);
+    size = gst_bit_writer_get_size (&bits);
+
+    gst_byte_writer_put_data (b, gst_bit_writer_get_data (&bits), size / 8);
+
+    gst_bit_writer_reset (&bits);
+    gst_bit_writer_init (&bits);
+
+    gst_byte_writer_put_uint8 (b, PIXEL_DATA_TYPE_END_OF_LINE);
+    pixels += stride;
+  }
+}
+
+static void
+reference_encode_rle8 (GstByteWriter * b, const guint8 * pixels,
+    const gint stride, const gint w, const gint h)
+{
+  int y;
+
+  for (y = 0; y < h; y++) {
+    int x = 0;
+
+    gst_byte_writer_put_uint8 (b, PIXEL_DATA_TYPE_8BIT);
+
+    while (x < w) {
+      int x_end = x;
+      int run_length;
+      guint8 pix;
+
+      pix = pixels[x_end++];
+      while (x_end < w && pixels[x_end] == pix)
+        x_end++;
+
+      run_length = MIN (x_end - x, 127);
+
+      if (run_length == 1 && pix != 0) {
+        gst_byte_writer_put_uint8 (b, pix);
+      } else if (pix == 0) {
+        gst_byte_writer_put_uint8 (b, 0);
+        gst_byte_writer_put_uint8 (b, run_length);
+      } else if (run_length > 2) {
+        gst_byte_writer_put_uint8 (b, 0);
+        gst_byte_writer_put_uint8 (b, 0x80 | run_length);
+        gst_byte_writer_put_uint8 (b, pix);
+      } else {
+        if (run_length == 2)
+          gst_byte_writer_put_uint8 (b, pix);
+        gst_byte_writer_put_uint8 (b, pix);
+      }
+      x += run_length;
+    }
+
+    gst_byte_writer_put_uint8 (b, 0x00);
+    gst_byte_writer_put_uint8 (b, 0x00);
+    gst_byte_writer_put_uint8 (b, PIXEL_DATA_TYPE_END_OF_LINE);
+    pixels += stride;
+  }
+}
+
+#define RLE_WIDTH 720
+
+/* Builds lines of palette indices, each starting with a run of one of
+ * @run_lengths in colour 0, 1 or the last colour, followed by single pixels
+ * cycling through all colours, and some lines of random runs */
+static guint8 *
+make_indexed_bitmap (guint n_colours, const guint * run_lengths,
+    guint n_run_lengths, guint * out_height)
+{
+  const guint n_random_lines = 16;
+  guint run_colours[] = { 0, 1, n_colours - 1 };
+  guint height = n_run_lengths * G_N_ELEMENTS (run_colours) + n_random_lines;
+  guint8 *bitmap = g_malloc (RLE_WIDTH * height);
+  guint8 *line = bitmap;
+  GRand *rand = g_rand_new_with_seed (n_colours);
+  guint i, j, x;
+
+  for (i = 0; i < n_run_lengths; i++) {
+    for (j = 0; j < G_N_ELEMENTS (run_colours); j++) {
+      guint colour = run_colours[j];
+
+      for (x = 0; x < run_lengths[i]; x++)
+        line[x] = colour;
+      for (; x < RLE_WIDTH; x++)
+        line[x] = ++colour % n_colours;
+      line += RLE_WIDTH;
+    }
+  }
+
+  for (i = 0; i < n_random_lines; i++) {
+    x = 0;
+    while (x < RLE_WIDTH) {
+      guint len = g_rand_int_range (rand, 1, 300);
+      guint8 colour = g_rand_int_range (rand, 0, n_colours);
+
+      for (; len > 0 && x < RLE_WIDTH; len--)
+        line[x++] = colour;
+    }
+    line += RLE_WIDTH;
+  }
+
+  g_rand_free (rand);
+
+  *out_height = height;
+  return bitmap;
+}
+
+/* Encodes a bitmap of @n_colours colours through the element and checks
+ * that the object data matches the reference encoder */
+static void
+check_rle (guint n_colours, EncodeRLEFunc reference, const guint * run_lengths,
+    guint n_run_lengths)
+{
+  GstHarness *h;
+  GstBuffer *buf;
+  GstMapInfo map;
+  GstByteWriter b;
+  guint8 *bitmap, *expected;
+  const guint8 *obj;
+  guint height, seg_size, top_size, bottom_size, expected_size, i;
+
+  bitmap = make_indexed_bitmap (n_colours, run_lengths, n_run_lengths,
+      &height);
+
+  /* Opaque colours, so the whole frame is encoded. The palette is sorted
+   * by decreasing colour value, so that Y decreasing with the index keeps
+   * the palette indices as they are */
+  buf = gst_buffer_new_allocate (NULL, RLE_WIDTH * height * 4, NULL);
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_WRITE));
+  for (i = 0; i < RLE_WIDTH * height; i++) {
+    map.data[i * 4] = 0xff;
+    map.data[i * 4 + 1] = 0xf0 - bitmap[i];
+    map.data[i * 4 + 2] = 0x80;
+    map.data[i * 4 + 3] = 0x80;
+  }
+  gst_buffer_unmap (buf, &map);
+  GST_BUFFER_PTS (buf) = 0;
+  GST_BUFFER_DURATION (buf) = GST_SECOND;
+
+  h = setup_dvbsubenc (RLE_WIDTH, height);
+  g_object_set (h->element, "max-colours", 256, NULL);
+
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  buf = gst_harness_pull (h);
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+
+  obj = find_segment (map.data, map.size, SEGMENT_TYPE_OBJECT_DATA,
+      &seg_size);
+  fail_unless (obj != NULL);
+  top_size = GST_READ_UINT16_BE (obj + 3);
+  bottom_size = GST_READ_UINT16_BE (obj + 5);
+  fail_unless (7 + top_size + bottom_size <= seg_size);
+
+  /* top field, even lines */
+  gst_byte_writer_init (&b);
+  reference (&b, bitmap, RLE_WIDTH * 2, RLE_WIDTH, (height + 1) / 2);
+  expected_size = gst_byte_writer_get_size (&b);
+  expected = gst_byte_writer_reset_and_get_data (&b);
+  fail_unless_equals_int (top_size, expected_size);
+  fail_unless (memcmp (obj + 7, expected, expected_size) == 0);
+  g_free (expected);
+
+  /* bottom field, odd lines */
+  gst_byte_writer_init (&b);
+  reference (&b, bitmap + RLE_WIDTH, RLE_WIDTH * 2, RLE_WIDTH, height / 2);
+  expected_size = gst_byte_writer_get_size (&b);
+  expected = gst_byte_writer_reset_and_get_data (&b);
+  fail_unless_equals_int (bottom_size, expected_size);
+  fail_unless (memcmp (obj + 7 + top_size, expected, expected_size) == 0);
+  g_free (expected);
+
+  gst_buffer_unmap (buf, &map);
+  gst_buffer_unref (buf);
+  g_free (bitmap);
+
+  gst_harness_teardown (h);
+}
+
+GST_START_TEST (test_rle_2bit)
+{
+  /* around the limits of the 3-10, 12-27 and 29-284 pixel codes */
+  static const guint run_lengths[] = {
+    1, 2, 3, 10, 11, 12, 27, 28, 29, 284, 285, 300
+  };
+
+  check_rle (4, reference_encode_rle2, run_lengths,
+      G_N_ELEMENTS (run_lengths));
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rle_4bit)
+{
+  /* around the limits of the 3-9 pixel colour 0, 4-7 and 25-280 pixel
+   * codes */
+  static const guint run_lengths[] = {
+    1, 2, 3, 4, 7, 8, 9, 10, 24, 25, 280, 281, 300
+  };
+
+  check_rle (16, reference_encode_rle4, run_lengths,
+      G_N_ELEMENTS (run_lengths));
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rle_8bit)
+{
+  /* around the limits of the 3-127 pixel code */
+  static const guint run_lengths[] = {
+    1, 2, 3, 126, 127, 128, 254, 255, 300
+  };
+
+  check_rle (32, reference_encode_rle8, run_lengths,
+      G_N_ELEMENTS (run_lengths));
+}
+
+GST_END_TEST;
+
+static Suite *
+dvbsubenc_suite (void)
+{
+  Suite *s = suite_create ("dvbsubenc");
+  TCase *tc = tcase_create ("general");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_exact_palette);
+  tcase_add_test (tc, test_skip_unchanged_page);
+  tcase_add_test (tc, test_refresh_unchanged_page);
+  tcase_add_test (tc, test_rle_2bit);
+  tcase_add_test (tc, test_rle_4bit);
+  tcase_add_test (tc, test_rle_8bit);
+
+  return s;
+}
+
+GST_CHECK_MAIN (dvbsubenc);
@@ -0,0 +1,252 @@
+/* GStreamer
+ *
+ * unit test for gaussianblur
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+/* AYUV */
+#define BPP 4
+
+static GstHarness *
+setup_gaussianblur (gint width, gint height, gdouble sigma)
+{
+  GstHarness *h;
+  gchar *caps;
+
+  h = gst_harness_new ("gaussianblur");
+  g_object_set (h->element, "sigma", sigma, NULL);
+
+  caps = g_strdup_printf ("video/x-raw,format=AYUV,width=%d,height=%d,"
+      "framerate=30/1", width, height);
+  gst_harness_set_src_caps_str (h, caps);
+  g_free (caps);
+
+  return h;
+}
+
+static guint8 *
+make_image (gint width, gint height, guint32 seed)
+{
+  guint8 *image = g_malloc (width * height * BPP);
+  GRand *rand = g_rand_new_with_seed (seed);
+  gint i;
+
+  /* gradients plus some noise, so that there are edges of all strengths */
+  for (i = 0; i < width * height * BPP; i++) {
+    gint x = (i / BPP) % width, y = (i / BPP) / width;
+
+    image[i] = (x * 3 + y * 5 + g_rand_int_range (rand, 0, 40)) & 0xff;
+  }
+
+  g_rand_free (rand);
+
+  return image;
+}
+
+/* Separable floating point blur with the same kernel, where the kernel is
+ * cut off at the image borders and renormalized with what is left of it */
+static guint8 *
+reference_blur (const guint8 * in, gint width, gint height, gdouble sigma)
+{
+  gint center = ceil (2.5 * fabs (sigma));
+  gint windowsize = 2 * center + 1;
+  gdouble *kernel = g_new (gdouble, windowsize);
+  gdouble *temp = g_new (gdouble, width * height * BPP);
+  guint8 *out = g_malloc (width * height * BPP);
+  gdouble sum = 0;
+  gint x, y, c, k;
+
+  for (k = 0; k < windowsize; k++) {
+    kernel[k] = exp (-0.5 * (k - center) * (k - center) / (sigma * sigma));
+    sum += kernel[k];
+  }
+  for (k = 0; k < windowsize; k++)
+    kernel[k] /= sum;
+
+  /* negative sigma sharpens: 2 * identity - blur */
+  if (sigma < 0) {
+    for (k = 0; k < windowsize; k++)
+      kernel[k] = -kernel[k];
+    kernel[center] += 2.0;
+  }
+
+  for (y = 0; y < height; y++) {
+    for (x = 0; x < width; x++) {
+      for (c = 0; c < BPP; c++) {
+        gdouble dot = 0, ksum = 0;
+
+        for (k = 0; k < windowsize; k++) {
+          gint xx = x + k - center;
+
+          if (xx < 0 || xx >= width)
+            continue;
+          dot += kernel[k] * in[(y * width + xx) * BPP + c];
+          ksum += kernel[k];
+        }
+        temp[(y * width + x) * BPP + c] = dot / ksum;
+      }
+    }
+  }
+
+  for (y = 0; y < height; y++) {
+    for (x = 0; x < width; x++) {
+      for (c = 0; c < BPP; c++) {
+        gdouble dot = 0, ksum = 0;
+        gint v;
+
+        for (k = 0; k < windowsize; k++) {
+          gint yy = y + k - center;
+
+          if (yy < 0 || yy >= height)
+            continue;
+          dot += kernel[k] * temp[(yy * width + x) * BPP + c];
+          ksum += kernel[k];
+        }
+        v = floor (dot / ksum + 0.5);
+        out[(y * width + x) * BPP + c] = CLAMP (v, 0, 255);
+      }
+    }
+  }
+
+  g_free (kernel);
+  g_free (temp);
+
+  return out;
+}
+
+static void
+check_blur (gint width, gint height, gdouble sigma)
+{
+  GstHarness *h;
+  GstBuffer *buf;
+  GstMapInfo map;
+  guint8 *in, *expected;
+  gsize size = width * height * BPP;
+  gsize i;
+  gint max_diff = 0;
+
+  GST_DEBUG ("checking %dx%d with sigma %f", width, height, sigma);
+
+  h = setup_gaussianblur (width, height, sigma);
+
+  in = make_image (width, height, width * 1000 + height);
+  expected = reference_blur (in, width, height, sigma);
+
+  buf = gst_buffer_new_allocate (NULL, size, NULL);
+  gst_buffer_fill (buf, 0, in, size);
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+
+  buf = gst_harness_pull (h);
+  fail_unless (buf != NULL);
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+  fail_unless_equals_int (map.size, size);
+
+  /* the fixed point implementation may be off by one from the exact
+   * result because of rounding */
+  for (i = 0; i < size; i++)
+    max_diff = MAX (max_diff, ABS (map.data[i] - expected[i]));
+  fail_unless (max_diff <= 1,
+      "%dx%d sigma %f differs by %d from the reference", width, height,
+      sigma, max_diff);
+
+  gst_buffer_unmap (buf, &map);
+  gst_buffer_unref (buf);
+
+  g_free (in);
+  g_free (expected);
+
+  gst_harness_teardown (h);
+}
+
+static const gdouble sigmas[] = { 0.3, 1.0, 1.2, 3.0, 10.0, -1.0, -3.0 };
+
+GST_START_TEST (test_blur_reference)
+{
+  gint i;
+
+  for (i = 0; i < G_N_ELEMENTS (sigmas); i++)
+    check_blur (64, 48, sigmas[i]);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_blur_small_frames)
+{
+  /* frames narrower and/or shorter than the kernel, where it is cut off on
+   * both sides */
+  static const gint sizes[][2] = { {1, 1}, {2, 9}, {7, 5}, {3, 200},
+  {200, 3}
+  };
+  gint i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+    for (j = 0; j < G_N_ELEMENTS (sigmas); j++)
+      check_blur (sizes[i][0], sizes[i][1], sigmas[j]);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_blur_zero_sigma_passthrough)
+{
+  GstHarness *h;
+  GstBuffer *buf;
+  guint8 *in;
+  gsize size = 16 * 16 * BPP;
+
+  h = setup_gaussianblur (16, 16, 0.0);
+
+  in = make_image (16, 16, 0);
+  buf = gst_buffer_new_allocate (NULL, size, NULL);
+  gst_buffer_fill (buf, 0, in, size);
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+
+  buf = gst_harness_pull (h);
+  fail_unless (buf != NULL);
+  fail_unless (gst_buffer_memcmp (buf, 0, in, size) == 0);
+  gst_buffer_unref (buf);
+
+  g_free (in);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+gaussianblur_suite (void)
+{
+  Suite *s = suite_create ("gaussianblur");
+  TCase *tc = tcase_create ("general");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_blur_reference);
+  tcase_add_test (tc, test_blur_small_frames);
+  tcase_add_test (tc, test_blur_zero_sigma_passthrough);
+
+  return s;
+}
+
+GST_CHECK_MAIN (gaussianblur);
@@ -19,6 +19,7 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <gst/check/gsttestclock.h>
 #include "adaptive_demux_common.h"
 
 #define DEMUX_ELEMENT_NAME "hlsdemux"
@@ -176,28 +177,43 @@ gst_hlsdemux_test_set_input_data (const GstHlsDemuxTestCase * test_case,
   }
 }
 
+/* fragments can be requested from several threads when prefetching */
+static GMutex test_case_state_lock;
+
 static gboolean
 gst_hlsdemux_test_src_start (GstTestHTTPSrc * src,
     const gchar * uri, GstTestHTTPSrcInput * input_data, gpointer user_data)
 {
   const GstHlsDemuxTestCase *test_case =
       (const GstHlsDemuxTestCase *) user_data;
+  const gchar *fail_once_uri;
   guint fail_count = 0;
   guint i;
 
   GST_DEBUG ("src_start %s", uri);
+  g_mutex_lock (&test_case_state_lock);
+  fail_once_uri =
+      gst_structure_get_string (test_case->state, "fail-once-uri");
+  if (fail_once_uri && strcmp (fail_once_uri, uri) == 0) {
+    GST_DEBUG ("failing first request of %s", uri);
+    gst_structure_remove_field (test_case->state, "fail-once-uri");
+    goto fail;
+  }
   for (i = 0; test_case->input[i].uri; ++i) {
     if (strcmp (test_case->input[i].uri, uri) == 0) {
       gst_hlsdemux_test_set_input_data (test_case, &test_case->input[i],
           input_data);
+      g_mutex_unlock (&test_case_state_lock);
       GST_DEBUG ("open URI %s", uri);
       return TRUE;
     }
   }
+fail:
   gst_structure_get_uint (test_case->state, "failure-count", &fail_count);
   fail_count++;
   gst_structure_set (test_case->state, "failure-count", G_TYPE_UINT,
       fail_count, NULL);
+  g_mutex_unlock (&test_case_state_lock);
   return FALSE;
 }
 
@@ -726,6 +742,692 @@ GST_START_TEST (testFragmentDownloadError)
 
 GST_END_TEST;
 
+#define TEST_N_FRAGMENTS 4
+#define TEST_SEGMENT_SIZE (30 * TS_PACKET_LEN)
+
+/* Tracks which fragments come out of the demuxer. The first byte after
+ * the header of every packet identifies the variant (upper 4 bits) and
+ * the fragment (lower 4 bits) the packet belongs to */
+typedef struct _GstHlsDemuxTestFragmentContext
+{
+  GByteArray *data;             /* all fragments, variant after variant */
+  guint n_variants;
+
+  /* fragment currently being received */
+  guint variant;
+  guint fragment;
+  guint64 position;
+  guint n_fragments_received;
+  guint variants[TEST_N_FRAGMENTS];     /* variant each fragment came from */
+
+  /* used by the seek test */
+  GstAdaptiveDemuxTestEngine *engine;
+  GstEvent *seek_event;
+  guint seek_after_fragments;
+  GThread *seek_thread;
+  gboolean seeked;
+
+  /* used by the bitrate switch test */
+  guint switch_after_fragments;
+  guint n_switches;
+
+  /* used by the rate adaptation tests */
+  const gchar *bandwidth_estimator;
+  GstClockTime buffer_target_time;
+} GstHlsDemuxTestFragmentContext;
+
+static void
+fragment_context_init (GstHlsDemuxTestFragmentContext * context,
+    guint n_variants)
+{
+  guint v, f, pos;
+
+  memset (context, 0, sizeof (GstHlsDemuxTestFragmentContext));
+  context->n_variants = n_variants;
+  context->data = g_byte_array_new ();
+
+  for (v = 0; v < n_variants; v++) {
+    for (f = 0; f < TEST_N_FRAGMENTS; f++) {
+      GByteArray *fragment = generate_transport_stream (TEST_SEGMENT_SIZE);
+
+      for (pos = 0; pos < TEST_SEGMENT_SIZE; pos += TS_PACKET_LEN)
+        fragment->data[pos + 4] = (v << 4) | f;
+      g_byte_array_append (context->data, fragment->data, fragment->len);
+      g_byte_array_free (fragment, TRUE);
+    }
+  }
+}
+
+static void
+fragment_context_clear (GstHlsDemuxTestFragmentContext * context)
+{
+  if (context->seek_thread)
+    g_thread_join (context->seek_thread);
+  gst_event_replace (&context->seek_event, NULL);
+  g_byte_array_free (context->data, TRUE);
+}
+
+static const guint8 *
+get_fragment_data (GstHlsDemuxTestFragmentContext * context,
+    guint variant, guint fragment)
+{
+  return context->data->data +
+      (variant * TEST_N_FRAGMENTS + fragment) * TEST_SEGMENT_SIZE;
+}
+
+static gpointer
+prefetch_seek_thread (GstHlsDemuxTestFragmentContext * context)
+{
+  GST_DEBUG ("seeking");
+  fail_unless (gst_element_send_event (context->engine->pipeline,
+          gst_event_ref (context->seek_event)));
+
+  return NULL;
+}
+
+static void
+prefetch_pre_test (GstAdaptiveDemuxTestEngine * engine, gpointer user_data)
+{
+  GstHlsDemuxTestFragmentContext *context = user_data;
+
+  g_object_set (engine->demux, "prefetch-fragments", 2, NULL);
+  if (context->switch_after_fragments)
+    g_object_set (engine->demux, "connection-speed", 10000, NULL);
+}
+
+/* Checks that fragments are output whole and in order */
+static gboolean
+check_fragment_order (GstAdaptiveDemuxTestEngine * engine,
+    GstAdaptiveDemuxTestOutputStream * stream, GstBuffer * buffer,
+    gpointer user_data)
+{
+  GstHlsDemuxTestFragmentContext *context = user_data;
+  GstMapInfo map;
+  gsize offset = 0;
+
+  fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+  while (offset < map.size) {
+    gsize size;
+
+    if (context->position == 0) {
+      guint variant, fragment;
+
+      /* start of a fragment */
+      fail_unless (map.size - offset > 4);
+      variant = map.data[offset + 4] >> 4;
+      fragment = map.data[offset + 4] & 0xf;
+      GST_DEBUG ("fragment %u of variant %u starts", fragment, variant);
+
+      fail_unless (variant < context->n_variants);
+      fail_unless_equals_int (fragment, context->fragment);
+      if (variant != context->variant) {
+        /* switches only ever go to variants listed later */
+        fail_unless (variant > context->variant);
+        context->n_switches++;
+        context->variant = variant;
+      }
+      context->variants[fragment] = variant;
+    }
+
+    size = MIN (map.size - offset, TEST_SEGMENT_SIZE - context->position);
+    fail_unless (memcmp (map.data + offset,
+            get_fragment_data (context, context->variant,
+                context->fragment) + context->position, size) == 0,
+        "unexpected data in fragment %u", context->fragment);
+    offset += size;
+    context->position += size;
+
+    if (context->position == TEST_SEGMENT_SIZE) {
+      context->position = 0;
+      context->fragment++;
+      context->n_fragments_received++;
+
+      if (context->seek_event && !context->seek_thread &&
+          context->n_fragments_received == context->seek_after_fragments) {
+        context->engine = engine;
+        context->seek_thread = g_thread_new ("seek",
+            (GThreadFunc) prefetch_seek_thread, context);
+      }
+      if (context->n_fragments_received == context->switch_after_fragments) {
+        /* makes the next fragment come from the lowest bitrate */
+        g_object_set (engine->demux, "connection-speed", 1, NULL);
+      }
+    }
+  }
+  gst_buffer_unmap (buffer, &map);
+
+  return TRUE;
+}
+
+static void
+fragment_appsink_event (GstAdaptiveDemuxTestEngine * engine,
+    GstAdaptiveDemuxTestOutputStream * stream, GstEvent * event,
+    gpointer user_data)
+{
+  GstHlsDemuxTestFragmentContext *context = user_data;
+
+  /* data restarts at the first fragment after the seek, and anything
+   * received up to now has been flushed */
+  if (context->seek_event && GST_EVENT_TYPE (event) == GST_EVENT_SEGMENT &&
+      gst_event_get_seqnum (event) ==
+      gst_event_get_seqnum (context->seek_event)) {
+    GST_DEBUG ("seek segment received");
+    context->seeked = TRUE;
+    context->fragment = 0;
+    context->position = 0;
+  }
+}
+
+static void
+fragment_appsink_eos (GstAdaptiveDemuxTestEngine * engine,
+    GstAdaptiveDemuxTestOutputStream * stream, gpointer user_data)
+{
+  GstHlsDemuxTestFragmentContext *context = user_data;
+
+  /* fragments are never cut short */
+  fail_unless_equals_uint64 (context->position, 0);
+
+  /* switching variants exposes new pads, after EOS on the old ones */
+  if (context->fragment < TEST_N_FRAGMENTS) {
+    GST_DEBUG ("EOS on a replaced pad");
+    return;
+  }
+
+  g_main_loop_quit (engine->loop);
+}
+
+static void
+run_prefetch_test (GstHlsDemuxTestFragmentContext * context,
+    GstHlsDemuxTestInputData * inputTestData, GstHlsDemuxTestCase * hlsTestCase)
+{
+  GstTestHTTPSrcCallbacks http_src_callbacks = { 0 };
+  GstAdaptiveDemuxTestCallbacks engine_callbacks = { 0 };
+
+  http_src_callbacks.src_start = gst_hlsdemux_test_src_start;
+  http_src_callbacks.src_create = gst_hlsdemux_test_src_create;
+  engine_callbacks.pre_test = prefetch_pre_test;
+  engine_callbacks.appsink_received_data = check_fragment_order;
+  engine_callbacks.appsink_event = fragment_appsink_event;
+  engine_callbacks.appsink_eos = fragment_appsink_eos;
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, hlsTestCase);
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME, inputTestData[0].uri,
+      &engine_callbacks, context);
+}
+
+/* Returns how many times @uri was requested */
+static guint
+count_requests (GstHlsDemuxTestCase * hlsTestCase, const gchar * uri)
+{
+  const GValue *requests;
+  guint i, count = 0;
+
+  requests = gst_structure_get_value (hlsTestCase->state, "requests");
+  fail_unless (requests != NULL);
+  for (i = 0; i < gst_value_array_get_size (requests); i++) {
+    if (strcmp (g_value_get_string (gst_value_array_get_value (requests, i)),
+            uri) == 0)
+      count++;
+  }
+
+  return count;
+}
+
+static const gchar *prefetch_media_playlist =
+    "#EXTM3U \n"
+    "#EXT-X-TARGETDURATION:1\n"
+    "#EXTINF:1,Test\n" "001.ts\n"
+    "#EXTINF:1,Test\n" "002.ts\n"
+    "#EXTINF:1,Test\n" "003.ts\n"
+    "#EXTINF:1,Test\n" "004.ts\n" "#EXT-X-ENDLIST\n";
+
+/*
+ * Test that prefetched fragments are output in order, and that each of
+ * them is only downloaded once
+ */
+GST_START_TEST (testPrefetch)
+{
+  GstHlsDemuxTestFragmentContext context;
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/media.m3u8", (guint8 *) prefetch_media_playlist, 0},
+    {"http://unit.test/001.ts", NULL, TEST_SEGMENT_SIZE},
+    {"http://unit.test/002.ts", NULL, TEST_SEGMENT_SIZE},
+    {"http://unit.test/003.ts", NULL, TEST_SEGMENT_SIZE},
+    {"http://unit.test/004.ts", NULL, TEST_SEGMENT_SIZE},
+    {NULL, NULL, 0},
+  };
+  GstHlsDemuxTestCase hlsTestCase = { inputTestData, NULL };
+  guint i;
+
+  fragment_context_init (&context, 1);
+  for (i = 0; i < TEST_N_FRAGMENTS; i++)
+    inputTestData[i + 1].payload = get_fragment_data (&context, 0, i);
+  hlsTestCase.state = gst_structure_new_empty (__FUNCTION__);
+
+  run_prefetch_test (&context, inputTestData, &hlsTestCase);
+
+  fail_unless_equals_int (context.n_fragments_received, TEST_N_FRAGMENTS);
+  for (i = 1; inputTestData[i].uri; i++)
+    fail_unless_equals_int (count_requests (&hlsTestCase,
+            inputTestData[i].uri), 1);
+
+  fragment_context_clear (&context);
+  gst_structure_free (hlsTestCase.state);
+}
+
+GST_END_TEST;
+
+/*
+ * Test that a fragment whose prefetch failed is downloaded again the
+ * usual way
+ */
+GST_START_TEST (testPrefetchFailure)
+{
+  GstHlsDemuxTestFragmentContext context;
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/media.m3u8", (guint8 *) prefetch_media_playlist, 0},
+    {"http://unit.test/001.ts", NULL, TEST_SEGMENT_SIZE},
+    {"http://unit.test/002.ts", NULL, TEST_SEGMENT_SIZE},
+    {"http://unit.test/003.ts", NULL, TEST_SEGMENT_SIZE},
+    {"http://unit.test/004.ts", NULL, TEST_SEGMENT_SIZE},
+    {NULL, NULL, 0},
+  };
+  GstHlsDemuxTestCase hlsTestCase = { inputTestData, NULL };
+  guint i, failure_count = 0;
+
+  fragment_context_init (&context, 1);
+  for (i = 0; i < TEST_N_FRAGMENTS; i++)
+    inputTestData[i + 1].payload = get_fragment_data (&context, 0, i);
+  /* 003.ts is first requested by the prefetch, while 001.ts is being
+   * downloaded */
+  hlsTestCase.state = gst_structure_new (__FUNCTION__,
+      "fail-once-uri", G_TYPE_STRING, "http://unit.test/003.ts", NULL);
+
+  run_prefetch_test (&context, inputTestData, &hlsTestCase);
+
+  fail_unless_equals_int (context.n_fragments_received, TEST_N_FRAGMENTS);
+  fail_unless (gst_structure_get_uint (hlsTestCase.state, "failure-count",
+          &failure_count));
+  fail_unless_equals_int (failure_count, 1);
+  fail_unless_equals_int (count_requests (&hlsTestCase,
+          "http://unit.test/003.ts"), 1);
+
+  fragment_context_clear (&context);
+  gst_structure_free (hlsTestCase.state);
+}
+
+GST_END_TEST;
+
+/*
+ * Test that fragments prefetched before a seek are not output after it
+ */
+GST_START_TEST (testPrefetchSeek)
+{
+  GstHlsDemuxTestFragmentContext context;
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/media.m3u8", (guint8 *) prefetch_media_playlist, 0},
+    {"http://unit.test/001.ts", NULL, TEST_SEGMENT_SIZE},
+    {"http://unit.test/002.ts", NULL, TEST_SEGMENT_SIZE},
+    {"http://unit.test/003.ts", NULL, TEST_SEGMENT_SIZE},
+    {"http://unit.test/004.ts", NULL, TEST_SEGMENT_SIZE},
+    {NULL, NULL, 0},
+  };
+  GstHlsDemuxTestCase hlsTestCase = { inputTestData, NULL };
+  guint i;
+
+  fragment_context_init (&context, 1);
+  for (i = 0; i < TEST_N_FRAGMENTS; i++)
+    inputTestData[i + 1].payload = get_fragment_data (&context, 0, i);
+  hlsTestCase.state = gst_structure_new_empty (__FUNCTION__);
+
+  /* FIXME hack to avoid having a 0 seqnum */
+  gst_util_seqnum_next ();
+
+  /* Go back to the start once the first fragment was output, while the
+   * following ones are being prefetched */
+  context.seek_after_fragments = 1;
+  context.seek_event = gst_event_new_seek (1.0, GST_FORMAT_TIME,
+      GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT, GST_SEEK_TYPE_SET, 0,
+      GST_SEEK_TYPE_NONE, 0);
+
+  run_prefetch_test (&context, inputTestData, &hlsTestCase);
+
+  fail_unless (context.seeked);
+  fail_unless (count_requests (&hlsTestCase, "http://unit.test/001.ts") >= 2);
+
+  fragment_context_clear (&context);
+  gst_structure_free (hlsTestCase.state);
+}
+
+GST_END_TEST;
+
+/*
+ * Test that fragments prefetched from the previous variant are not output
+ * after a bitrate switch
+ */
+GST_START_TEST (testPrefetchBitrateSwitch)
+{
+  const gchar *master_playlist =
+      "#EXTM3U\n"
+      "#EXT-X-VERSION:4\n"
+      "#EXT-X-STREAM-INF:PROGRAM-ID=1, BANDWIDTH=2000000\n"
+      "high.m3u8\n"
+      "#EXT-X-STREAM-INF:PROGRAM-ID=1, BANDWIDTH=200000\n" "low.m3u8\n";
+  const gchar *high_playlist =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXTINF:1,Test\n" "high-001.ts\n"
+      "#EXTINF:1,Test\n" "high-002.ts\n"
+      "#EXTINF:1,Test\n" "high-003.ts\n"
+      "#EXTINF:1,Test\n" "high-004.ts\n" "#EXT-X-ENDLIST\n";
+  const gchar *low_playlist =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXTINF:1,Test\n" "low-001.ts\n"
+      "#EXTINF:1,Test\n" "low-002.ts\n"
+      "#EXTINF:1,Test\n" "low-003.ts\n"
+      "#EXTINF:1,Test\n" "low-004.ts\n" "#EXT-X-ENDLIST\n";
+  GstHlsDemuxTestFragmentContext context;
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/master.m3u8", (guint8 *) master_playlist, 0},
+    {"http://unit.test/high.m3u8", (guint8 *) high_playlist, 0},
+    {"http://unit.test/low.m3u8", (guint8 *) low_playlist, 0},
+    {"http://unit.test/high-001.ts", NULL, TEST_SEGMENT_SIZE},
+    {"http://unit.test/high-002.ts", NULL, TEST_SEGMENT_SIZE},
+    {"http://unit.test/high-003.ts", NULL, TEST_SEGMENT_SIZE},
+    {"http://unit.test/high-004.ts", NULL, TEST_SEGMENT_SIZE},
+    {"http://unit.test/low-001.ts", NULL, TEST_SEGMENT_SIZE},
+    {"http://unit.test/low-002.ts", NULL, TEST_SEGMENT_SIZE},
+    {"http://unit.test/low-003.ts", NULL, TEST_SEGMENT_SIZE},
+    {"http://unit.test/low-004.ts", NULL, TEST_SEGMENT_SIZE},
+    {NULL, NULL, 0},
+  };
+  GstHlsDemuxTestCase hlsTestCase = { inputTestData, NULL };
+  guint i;
+
+  fragment_context_init (&context, 2);
+  for (i = 0; i < 2 * TEST_N_FRAGMENTS; i++) {
+    inputTestData[i + 3].payload = get_fragment_data (&context,
+        i / TEST_N_FRAGMENTS, i % TEST_N_FRAGMENTS);
+  }
+  hlsTestCase.state = gst_structure_new_empty (__FUNCTION__);
+
+  /* start on the high variant and drop the connection speed once the
+   * first fragment was output */
+  context.switch_after_fragments = 1;
+
+  run_prefetch_test (&context, inputTestData, &hlsTestCase);
+
+  fail_unless_equals_int (context.n_fragments_received, TEST_N_FRAGMENTS);
+  fail_unless_equals_int (context.n_switches, 1);
+  fail_unless_equals_int (context.variant, 1);
+
+  fragment_context_clear (&context);
+  gst_structure_free (hlsTestCase.state);
+}
+
+GST_END_TEST;
+
+typedef struct _GstHlsDemuxTestAbrCase
+{
+  GstHlsDemuxTestCase test_case;        /* must be first */
+
+  /* how long each fragment takes to download, by fragment index */
+  const GstClockTime *download_times;
+} GstHlsDemuxTestAbrCase;
+
+/* A fragment of TEST_SEGMENT_SIZE bytes downloaded in that time is
+ * measured at the given bitrate */
+#define DOWNLOAD_TIME(bps) \
+    gst_util_uint64_scale (TEST_SEGMENT_SIZE * 8, GST_SECOND, bps)
+
+/* The tests install a GstTestClock as the system clock, which the
+ * demuxer measures download times and the buffer level with. Time only
+ * passes when a fragment download starts */
+static GstFlowReturn
+abr_src_create (GstTestHTTPSrc * src, guint64 offset, guint length,
+    GstBuffer ** retbuf, gpointer context, gpointer user_data)
+{
+  GstHlsDemuxTestAbrCase *abr_case = user_data;
+  GstHlsDemuxTestInputData *input = context;
+
+  if (offset == 0 && g_str_has_suffix (input->uri, ".ts")) {
+    GstClock *clock = gst_system_clock_obtain ();
+
+    gst_test_clock_advance_time (GST_TEST_CLOCK (clock),
+        abr_case->download_times[input->payload[4] & 0xf]);
+    gst_object_unref (clock);
+  }
+
+  return gst_hlsdemux_test_src_create (src, offset, length, retbuf, context,
+      &abr_case->test_case);
+}
+
+static void
+abr_pre_test (GstAdaptiveDemuxTestEngine * engine, gpointer user_data)
+{
+  GstHlsDemuxTestFragmentContext *context = user_data;
+
+  if (context->bandwidth_estimator) {
+    gst_util_set_object_arg (G_OBJECT (engine->demux), "bandwidth-estimator",
+        context->bandwidth_estimator);
+  }
+  g_object_set (engine->demux, "buffer-target-time",
+      context->buffer_target_time, NULL);
+}
+
+static gboolean
+abr_check_received_data (GstAdaptiveDemuxTestEngine * engine,
+    GstAdaptiveDemuxTestOutputStream * stream, GstBuffer * buffer,
+    gpointer user_data)
+{
+  guint i;
+
+  /* The buffer level is only known once the demuxer is PLAYING. The sink
+   * gets there first, so hold the first fragment until the demuxer
+   * follows, before its download finishes and a variant is selected */
+  for (i = 0; GST_STATE (engine->demux) != GST_STATE_PLAYING; i++) {
+    fail_unless (i < 1000, "demuxer did not reach PLAYING");
+    g_usleep (G_USEC_PER_SEC / 100);
+  }
+
+  return check_fragment_order (engine, stream, buffer, user_data);
+}
+
+/* Plays a master playlist with one variant for each of @bandwidths, in
+ * that order, each with TEST_N_FRAGMENTS fragments of @duration seconds.
+ * The first listed variant is the initial one */
+static void
+run_abr_test (GstHlsDemuxTestFragmentContext * context,
+    const guint * bandwidths, guint duration,
+    const GstClockTime * download_times)
+{
+  GstTestHTTPSrcCallbacks http_src_callbacks = { 0 };
+  GstAdaptiveDemuxTestCallbacks engine_callbacks = { 0 };
+  GstHlsDemuxTestInputData *inputTestData;
+  GstHlsDemuxTestAbrCase abr_case = { {NULL, NULL}, download_times };
+  GPtrArray *strings;
+  GString *master;
+  GstClock *clock;
+  gchar *str;
+  guint v, f, n = 0;
+
+  /* all the URIs and playlists, to free them at the end */
+  strings = g_ptr_array_new_with_free_func (g_free);
+  inputTestData = g_new0 (GstHlsDemuxTestInputData,
+      2 + context->n_variants * (1 + TEST_N_FRAGMENTS));
+
+  master = g_string_new ("#EXTM3U\n#EXT-X-VERSION:4\n");
+  inputTestData[n++].uri = "http://unit.test/master.m3u8";
+
+  for (v = 0; v < context->n_variants; v++) {
+    GString *media = g_string_new ("#EXTM3U \n");
+
+    g_string_append_printf (master,
+        "#EXT-X-STREAM-INF:PROGRAM-ID=1, BANDWIDTH=%u\nv%u.m3u8\n",
+        bandwidths[v], v);
+
+    g_string_append_printf (media, "#EXT-X-TARGETDURATION:%u\n", duration);
+    for (f = 0; f < TEST_N_FRAGMENTS; f++) {
+      g_string_append_printf (media, "#EXTINF:%u,Test\nv%u-%03u.ts\n",
+          duration, v, f + 1);
+
+      str = g_strdup_printf ("http://unit.test/v%u-%03u.ts", v, f + 1);
+      g_ptr_array_add (strings, str);
+      inputTestData[n].uri = str;
+      inputTestData[n].payload = get_fragment_data (context, v, f);
+      inputTestData[n++].size = TEST_SEGMENT_SIZE;
+    }
+    g_string_append (media, "#EXT-X-ENDLIST\n");
+
+    str = g_strdup_printf ("http://unit.test/v%u.m3u8", v);
+    g_ptr_array_add (strings, str);
+    inputTestData[n].uri = str;
+    str = g_string_free (media, FALSE);
+    g_ptr_array_add (strings, str);
+    inputTestData[n++].payload = (const guint8 *) str;
+  }
+
+  str = g_string_free (master, FALSE);
+  g_ptr_array_add (strings, str);
+  inputTestData[0].payload = (const guint8 *) str;
+
+  abr_case.test_case.input = inputTestData;
+  abr_case.test_case.state = gst_structure_new_empty (__FUNCTION__);
+
+  clock = gst_test_clock_new ();
+  gst_system_clock_set_default (clock);
+
+  http_src_callbacks.src_start = gst_hlsdemux_test_src_start;
+  http_src_callbacks.src_create = abr_src_create;
+  engine_callbacks.pre_test = abr_pre_test;
+  engine_callbacks.appsink_received_data = abr_check_received_data;
+  engine_callbacks.appsink_eos = fragment_appsink_eos;
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &abr_case);
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME, inputTestData[0].uri,
+      &engine_callbacks, context);
+
+  gst_system_clock_set_default (NULL);
+  gst_object_unref (clock);
+
+  fail_unless_equals_int (context->n_fragments_received, TEST_N_FRAGMENTS);
+
+  gst_structure_free (abr_case.test_case.state);
+  g_ptr_array_unref (strings);
+  g_free (inputTestData);
+}
+
+/*
+ * Test that each bandwidth estimator picks the variant its estimate
+ * allows, after a fast and a slow fragment download
+ */
+GST_START_TEST (testBandwidthEstimator)
+{
+  const guint bandwidths[] = { 5000000, 1000000, 500000 };
+  const GstClockTime download_times[] = {
+    DOWNLOAD_TIME (10000000), DOWNLOAD_TIME (1000000),
+    DOWNLOAD_TIME (1000000), DOWNLOAD_TIME (1000000)
+  };
+  const struct
+  {
+    const gchar *estimator;
+    guint variant;
+  } expected[] = {
+    /* the minimum of the last fragment and the 5.5 Mbps average */
+    {"moving-average", 2},
+    /* 2 / (1 / 10 Mbps + 1 / 1 Mbps) = 1.8 Mbps */
+    {"harmonic-mean", 1},
+    /* the second fragment is too small to move the estimate much */
+    {"ewma", 0},
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (expected); i++) {
+    GstHlsDemuxTestFragmentContext context;
+
+    GST_DEBUG ("testing %s", expected[i].estimator);
+    fragment_context_init (&context, G_N_ELEMENTS (bandwidths));
+    context.bandwidth_estimator = expected[i].estimator;
+
+    run_abr_test (&context, bandwidths, 1, download_times);
+
+    /* 10 Mbps is enough for the first variant with any estimator */
+    fail_unless_equals_int (context.variants[1], 0);
+    fail_unless_equals_int (context.variants[2], expected[i].variant);
+
+    fragment_context_clear (&context);
+  }
+}
+
+GST_END_TEST;
+
+/*
+ * Test that a full buffer lets the whole estimated bandwidth be used
+ */
+GST_START_TEST (testBufferTargetFull)
+{
+  const guint bandwidths[] = { 100000, 1000000 };
+  /* above the second variant, but not with the default bitrate-limit */
+  const GstClockTime download_times[] = {
+    DOWNLOAD_TIME (1100000), DOWNLOAD_TIME (1100000),
+    DOWNLOAD_TIME (1100000), DOWNLOAD_TIME (1100000)
+  };
+  GstHlsDemuxTestFragmentContext context;
+  guint i;
+
+  /* without a buffer target, the download rate is never enough */
+  fragment_context_init (&context, G_N_ELEMENTS (bandwidths));
+  run_abr_test (&context, bandwidths, 10, download_times);
+  fail_unless_equals_int (context.n_switches, 0);
+  fragment_context_clear (&context);
+
+  /* 10 s fragments, downloaded in a few ms, keep the buffer full */
+  fragment_context_init (&context, G_N_ELEMENTS (bandwidths));
+  context.buffer_target_time = 5 * GST_SECOND;
+  run_abr_test (&context, bandwidths, 10, download_times);
+  for (i = 1; i < TEST_N_FRAGMENTS; i++)
+    fail_unless_equals_int (context.variants[i], 1);
+  fragment_context_clear (&context);
+}
+
+GST_END_TEST;
+
+/*
+ * Test that a nearly drained buffer makes the selection follow the last
+ * download rate
+ */
+GST_START_TEST (testBufferTargetDrained)
+{
+  const guint bandwidths[] = { 1000000, 10000 };
+  /* 1 s fragments: the second one takes 1.9 s to download, after which
+   * only 0.1 s are buffered, and the following ones keep it there */
+  const GstClockTime download_times[] = {
+    DOWNLOAD_TIME (10000000), 1900 * GST_MSECOND,
+    GST_SECOND, GST_SECOND
+  };
+  GstHlsDemuxTestFragmentContext context;
+
+  /* the fast first download keeps the average high */
+  fragment_context_init (&context, G_N_ELEMENTS (bandwidths));
+  context.bandwidth_estimator = "ewma";
+  run_abr_test (&context, bandwidths, 1, download_times);
+  fail_unless_equals_int (context.n_switches, 0);
+  fragment_context_clear (&context);
+
+  /* below a quarter of the target, the last measurement is used */
+  fragment_context_init (&context, G_N_ELEMENTS (bandwidths));
+  context.bandwidth_estimator = "ewma";
+  context.buffer_target_time = GST_SECOND;
+  run_abr_test (&context, bandwidths, 1, download_times);
+  fail_unless_equals_int (context.variants[1], 0);
+  fail_unless_equals_int (context.variants[2], 1);
+  fail_unless_equals_int (context.variants[3], 1);
+  fragment_context_clear (&context);
+}
+
+GST_END_TEST;
+
 static Suite *
 hls_demux_suite (void)
 {
@@ -745,6 +1447,13 @@ hls_demux_suite (void)
   tcase_add_test (tc_basicTest, testSeekSnapAfterPosition);
   tcase_add_test (tc_basicTest, testReverseSeekSnapBeforePosition);
   tcase_add_test (tc_basicTest, testReverseSeekSnapAfterPosition);
+  tcase_add_test (tc_basicTest, testPrefetch);
+  tcase_add_test (tc_basicTest, testPrefetchFailure);
+  tcase_add_test (tc_basicTest, testPrefetchSeek);
+  tcase_add_test (tc_basicTest, testPrefetchBitrateSwitch);
+  tcase_add_test (tc_basicTest, testBandwidthEstimator);
+  tcase_add_test (tc_basicTest, testBufferTargetFull);
+  tcase_add_test (tc_basicTest, testBufferTargetDrained);
 
   tcase_add_unchecked_fixture (tc_basicTest, gst_adaptive_demux_test_setup,
       gst_adaptive_demux_test_teardown);
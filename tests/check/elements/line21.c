@@ -21,6 +21,8 @@
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <string.h>
+
 #include <gst/gst.h>
 #include <gst/check/gstcheck.h>
 #include <gst/check/gstharness.h>
@@ -89,6 +91,192 @@ GST_START_TEST (basic)
 
 GST_END_TEST;
 
+#define WIDTH 720
+#define HEIGHT 525
+/* the encoder puts field 1 on line 21, followed by field 2 */
+#define CC_LINE 21
+
+static GstCaps *
+make_caps (void)
+{
+  return gst_caps_new_simple ("video/x-raw",
+      "format", G_TYPE_STRING, "I420",
+      "width", G_TYPE_INT, WIDTH,
+      "height", G_TYPE_INT, HEIGHT,
+      "interlace-mode", G_TYPE_STRING, "interleaved", NULL);
+}
+
+/* A black frame */
+static GstBuffer *
+make_frame (void)
+{
+  GstVideoInfo info;
+  GstBuffer *buf;
+  GstMapInfo map;
+  GstCaps *caps = make_caps ();
+
+  gst_video_info_from_caps (&info, caps);
+  gst_caps_unref (caps);
+
+  buf = gst_buffer_new_and_alloc (info.size);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  memset (map.data, 16, GST_VIDEO_INFO_PLANE_OFFSET (&info, 1));
+  memset (map.data + GST_VIDEO_INFO_PLANE_OFFSET (&info, 1), 128,
+      info.size - GST_VIDEO_INFO_PLANE_OFFSET (&info, 1));
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+/* Returns the two luma lines that line21encoder produces for @cc_data */
+static guint8 *
+encode_cc_lines (const guint8 * cc_data)
+{
+  GstHarness *h;
+  GstBuffer *buf;
+  GstCaps *caps = make_caps ();
+  guint8 *lines = g_malloc (2 * WIDTH);
+
+  h = gst_harness_new ("line21encoder");
+  gst_harness_set_caps (h, gst_caps_ref (caps), caps);
+
+  buf = make_frame ();
+  gst_buffer_add_video_caption_meta (buf, GST_VIDEO_CAPTION_TYPE_CEA608_S334_1A,
+      cc_data, 6);
+  buf = gst_harness_push_and_pull (h, buf);
+  fail_unless (buf != NULL);
+  gst_buffer_extract (buf, CC_LINE * WIDTH, lines, 2 * WIDTH);
+  gst_buffer_unref (buf);
+
+  gst_harness_teardown (h);
+
+  return lines;
+}
+
+/* Puts the CC @lines on @line and the next one. A glitched copy keeps the
+ * clock run-in but loses everything from the start bits on */
+static void
+put_cc_lines (GstBuffer * buf, guint line, const guint8 * lines,
+    gboolean glitch)
+{
+  gst_buffer_fill (buf, line * WIDTH, lines, 2 * WIDTH);
+
+  if (glitch) {
+    gst_buffer_memset (buf, line * WIDTH + 240, 16, WIDTH - 240);
+    gst_buffer_memset (buf, (line + 1) * WIDTH + 240, 16, WIDTH - 240);
+  }
+}
+
+/* Decodes @buf and checks that it has CC @cc_data from @line, or no CC at
+ * all if @cc_data is %NULL */
+static void
+check_decode (GstHarness * h, GstBuffer * buf, const guint8 * cc_data,
+    guint line)
+{
+  GstVideoCaptionMeta *meta;
+  guint i;
+
+  buf = gst_harness_push_and_pull (h, buf);
+  fail_unless (buf != NULL);
+
+  meta = gst_buffer_get_video_caption_meta (buf);
+  if (cc_data == NULL) {
+    fail_unless (meta == NULL);
+  } else {
+    fail_unless (meta != NULL);
+    fail_unless_equals_int (meta->size, 6);
+    /* line offset from line 9 of the first field */
+    fail_unless_equals_int (meta->data[0], 0x80 | (line - 9));
+    for (i = 1; i < 6; i++)
+      fail_unless_equals_int (meta->data[i], cc_data[i]);
+  }
+
+  gst_buffer_unref (buf);
+}
+
+GST_START_TEST (no_run_in)
+{
+  const guint8 cc_data[] = { 0x8c, 0x42, 0x43, 0x0, 0x44, 0x45 };
+  GstHarness *h;
+  GstBuffer *buf;
+  GstCaps *caps = make_caps ();
+  guint8 *lines;
+  guint line;
+
+  lines = encode_cc_lines (cc_data);
+
+  h = gst_harness_new ("line21decoder");
+  gst_harness_set_caps (h, gst_caps_ref (caps), caps);
+
+  /* picture content with hard edges but no clock run-in on every line that
+   * is scanned */
+  buf = make_frame ();
+  for (line = 0; line < 42; line++) {
+    gst_buffer_memset (buf, line * WIDTH + 100, 235, 60);
+    gst_buffer_memset (buf, line * WIDTH + 400, 235, 200);
+  }
+  check_decode (h, gst_buffer_copy_deep (buf), NULL, 0);
+
+  /* and the CC lines are still found among them */
+  put_cc_lines (buf, CC_LINE, lines, FALSE);
+  check_decode (h, buf, cc_data, CC_LINE);
+
+  /* a glitched line on its own isn't decoded */
+  buf = make_frame ();
+  put_cc_lines (buf, CC_LINE, lines, TRUE);
+  check_decode (h, buf, NULL, 0);
+
+  g_free (lines);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (keep_lock_over_glitch)
+{
+  const guint8 cc_data1[] = { 0x8c, 0x42, 0x43, 0x0, 0x44, 0x45 };
+  const guint8 cc_data2[] = { 0x82, 0x46, 0x47, 0x0, 0x48, 0x49 };
+  const guint other_line = 11;
+  GstHarness *h;
+  GstBuffer *buf;
+  GstCaps *caps = make_caps ();
+  guint8 *lines1, *lines2;
+
+  lines1 = encode_cc_lines (cc_data1);
+  lines2 = encode_cc_lines (cc_data2);
+
+  h = gst_harness_new ("line21decoder");
+  gst_harness_set_caps (h, gst_caps_ref (caps), caps);
+
+  /* lock on line 21 */
+  buf = make_frame ();
+  put_cc_lines (buf, CC_LINE, lines1, FALSE);
+  check_decode (h, buf, cc_data1, CC_LINE);
+
+  /* A glitch on the locked line, which still has its run-in, is skipped
+   * for one frame instead of rescanning, which would find other CC lines
+   * earlier in the frame */
+  buf = make_frame ();
+  put_cc_lines (buf, other_line, lines2, FALSE);
+  put_cc_lines (buf, CC_LINE, lines1, TRUE);
+  check_decode (h, gst_buffer_copy_deep (buf), NULL, 0);
+
+  /* but not for a second frame in a row */
+  check_decode (h, buf, cc_data2, other_line);
+
+  /* Once the run-in is gone from the locked line, the rescan happens right
+   * away */
+  buf = make_frame ();
+  put_cc_lines (buf, CC_LINE, lines1, FALSE);
+  check_decode (h, buf, cc_data1, CC_LINE);
+
+  g_free (lines1);
+  g_free (lines2);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static Suite *
 line21_suite (void)
 {
@@ -98,6 +286,8 @@ line21_suite (void)
   suite_add_tcase (s, tc);
 
   tcase_add_test (tc, basic);
+  tcase_add_test (tc, no_run_in);
+  tcase_add_test (tc, keep_lock_over_glitch);
 
   return s;
 }
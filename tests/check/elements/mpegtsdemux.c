@@ -21,6 +21,7 @@
 #include <gst/gst.h>
 #include <gst/check/gstcheck.h>
 #include <gst/check/gstharness.h>
+#include <gst/mpegts/mpegts.h>
 
 #define PACKETSIZE 188
 
@@ -152,6 +153,12 @@ static const guint8 padding_ts[] = {
 
 G_STATIC_ASSERT (sizeof padding_ts == PACKETSIZE);
 
+/* Time and Date Table packet (short section, table_id 0x70, on PID 0x14) */
+static const guint8 tdt_header[] = {
+  0x47, 0x40, 0x14, 0x10, 0x00,
+  0x70, 0x70, 0x05, 0xc0, 0x79, 0x12, 0x45, 0x00
+};
+
 GST_START_TEST (test_tsparse_simple)
 {
   GstHarness *h = gst_harness_new ("tsparse");
@@ -335,6 +342,135 @@ GST_START_TEST (test_tsparse_padding)
 
 GST_END_TEST;
 
+static GstBuffer *
+make_tdt_packet (void)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, PACKETSIZE, NULL);
+
+  gst_buffer_memset (buf, 0, 0xff, PACKETSIZE);
+  gst_buffer_fill (buf, 0, tdt_header, sizeof tdt_header);
+
+  return buf;
+}
+
+static void
+set_ignored_table_ids (GstElement * element, const guint * table_ids,
+    guint n_table_ids)
+{
+  GValue array = G_VALUE_INIT;
+  guint i;
+
+  g_value_init (&array, GST_TYPE_ARRAY);
+  for (i = 0; i < n_table_ids; i++) {
+    GValue v = G_VALUE_INIT;
+
+    g_value_init (&v, G_TYPE_UINT);
+    g_value_set_uint (&v, table_ids[i]);
+    gst_value_array_append_value (&array, &v);
+    g_value_unset (&v);
+  }
+  g_object_set_property (G_OBJECT (element), "ignored-table-ids", &array);
+  g_value_unset (&array);
+}
+
+/* Pushes the PAT/PMT/audio stream followed by a TDT through tsparse and
+ * returns which table_id were posted as section messages */
+static void
+collect_tsparse_sections (const guint * ignored, guint n_ignored,
+    gboolean * seen_pat, gboolean * seen_tdt)
+{
+  GstHarness *h = gst_harness_new ("tsparse");
+  GstBus *bus;
+  GstBuffer *buf;
+  GstMessage *msg;
+
+  if (n_ignored)
+    set_ignored_table_ids (h->element, ignored, n_ignored);
+
+  bus = gst_bus_new ();
+  gst_element_set_bus (h->element, bus);
+
+  gst_harness_set_src_caps_str (h, "video/mpegts,systemstream=true");
+  gst_harness_set_sink_caps_str (h,
+      "video/mpegts,systemstream=true,packetsize=" G_STRINGIFY (PACKETSIZE));
+
+  buf =
+      gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY, (guint8 *) aac_ts,
+      sizeof aac_ts, 0, sizeof aac_ts, NULL, NULL);
+  buf = gst_buffer_append (buf, make_tdt_packet ());
+  buf = gst_buffer_append (buf,
+      gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+          (guint8 *) padding_ts, sizeof padding_ts, 0, sizeof padding_ts,
+          NULL, NULL));
+  fail_unless (gst_harness_push (h, buf) == GST_FLOW_OK);
+  gst_harness_push_event (h, gst_event_new_eos ());
+
+  *seen_pat = *seen_tdt = FALSE;
+  while ((msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT))) {
+    GstMpegtsSection *section = gst_message_parse_mpegts_section (msg);
+
+    if (section) {
+      if (section->table_id == GST_MTS_TABLE_ID_PROGRAM_ASSOCIATION)
+        *seen_pat = TRUE;
+      else if (section->table_id == GST_MTS_TABLE_ID_TIME_DATE)
+        *seen_tdt = TRUE;
+      gst_mpegts_section_unref (section);
+    }
+    gst_message_unref (msg);
+  }
+
+  /* sections of ignored tables are still passed through */
+  buf = gst_harness_take_all_data_as_buffer (h);
+  fail_unless_equals_int (gst_buffer_get_size (buf), sizeof aac_ts +
+      2 * PACKETSIZE);
+  gst_buffer_unref (buf);
+
+  gst_bus_set_flushing (bus, TRUE);
+  gst_object_unref (bus);
+  gst_harness_teardown (h);
+}
+
+GST_START_TEST (test_tsparse_ignored_table_ids)
+{
+  static const guint ignored[] = { GST_MTS_TABLE_ID_TIME_DATE,
+    GST_MTS_TABLE_ID_PROGRAM_ASSOCIATION
+  };
+  GstElement *tsparse;
+  GValue array = G_VALUE_INIT;
+  gboolean seen_pat, seen_tdt;
+
+  gst_mpegts_initialize ();
+
+  collect_tsparse_sections (NULL, 0, &seen_pat, &seen_tdt);
+  fail_unless (seen_pat);
+  fail_unless (seen_tdt);
+
+  /* The TDT is dropped, but the PAT can't be ignored */
+  collect_tsparse_sections (ignored, G_N_ELEMENTS (ignored), &seen_pat,
+      &seen_tdt);
+  fail_unless (seen_pat);
+  fail_if (seen_tdt);
+
+  tsparse = gst_element_factory_make ("tsparse", NULL);
+  set_ignored_table_ids (tsparse, ignored, G_N_ELEMENTS (ignored));
+  g_value_init (&array, GST_TYPE_ARRAY);
+  g_object_get_property (G_OBJECT (tsparse), "ignored-table-ids", &array);
+  fail_unless_equals_int (gst_value_array_get_size (&array), 1);
+  fail_unless_equals_int (g_value_get_uint (gst_value_array_get_value (&array,
+              0)), GST_MTS_TABLE_ID_TIME_DATE);
+  g_value_unset (&array);
+
+  /* Setting an empty list clears it */
+  set_ignored_table_ids (tsparse, NULL, 0);
+  g_value_init (&array, GST_TYPE_ARRAY);
+  g_object_get_property (G_OBJECT (tsparse), "ignored-table-ids", &array);
+  fail_unless_equals_int (gst_value_array_get_size (&array), 0);
+  g_value_unset (&array);
+  gst_object_unref (tsparse);
+}
+
+GST_END_TEST;
+
 static void
 tsdemux_simple_pad_added (GstElement * tsdemux, GstPad * pad, GstHarness * h)
 {
@@ -390,6 +526,7 @@ mpegtsdemux_suite (void)
   tcase_add_test (tc, test_tsparse_align_fuse);
   tcase_add_test (tc, test_tsparse_align_split);
   tcase_add_test (tc, test_tsparse_padding);
+  tcase_add_test (tc, test_tsparse_ignored_table_ids);
 
   tc = tcase_create ("tsdemux");
   suite_add_tcase (s, tc);
@@ -0,0 +1,256 @@
+/* GStreamer
+ *
+ * unit test for removesilence
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/audio/audio.h>
+
+#define RATE 48000
+#define BUFFER_SAMPLES 1024
+
+/* 100 ms of tone, 200 ms of silence and another 100 ms of tone */
+#define TONE_SAMPLES 4800
+#define SILENCE_SAMPLES 9600
+#define N_SAMPLES (TONE_SAMPLES + SILENCE_SAMPLES + TONE_SAMPLES)
+
+/* End of the first tone, plus the decay of the power estimate and the
+ * default hysteresis of 480 samples */
+#define SILENCE_START 5626
+/* The first sample of the second tone switches the VAD back to voice */
+#define VOICE_RESTART (TONE_SAMPLES + SILENCE_SAMPLES)
+
+#define REMOVED_SAMPLES (VOICE_RESTART - SILENCE_START)
+
+/* 500 Hz square wave, which crosses zero rarely enough to count as voice */
+static gint16
+tone_sample (guint i)
+{
+  if (i >= TONE_SAMPLES && i < TONE_SAMPLES + SILENCE_SAMPLES)
+    return 0;
+
+  return (i / 48) % 2 ? -8192 : 8192;
+}
+
+static GstBuffer *
+make_input (gboolean f32, gint channels, guint offset, guint n_samples)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+  guint i;
+  gint c;
+
+  buf = gst_buffer_new_allocate (NULL, n_samples * channels *
+      (f32 ? sizeof (gfloat) : sizeof (gint16)), NULL);
+
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  for (i = 0; i < n_samples; i++) {
+    for (c = 0; c < channels; c++) {
+      if (f32)
+        ((gfloat *) map.data)[i * channels + c] =
+            tone_sample (offset + i) / 32768.0f;
+      else
+        ((gint16 *) map.data)[i * channels + c] = tone_sample (offset + i);
+    }
+  }
+  gst_buffer_unmap (buf, &map);
+
+  GST_BUFFER_PTS (buf) = gst_util_uint64_scale_int (offset, GST_SECOND, RATE);
+  GST_BUFFER_DURATION (buf) =
+      gst_util_uint64_scale_int (n_samples, GST_SECOND, RATE);
+  GST_BUFFER_OFFSET (buf) = offset;
+  GST_BUFFER_OFFSET_END (buf) = offset + n_samples;
+
+  return buf;
+}
+
+static void
+check_data (GstBuffer * buf, gboolean f32, gint channels, guint offset,
+    guint n_samples)
+{
+  GstBuffer *expected = make_input (f32, channels, offset, n_samples);
+  GstMapInfo map;
+
+  fail_unless (gst_buffer_map (expected, &map, GST_MAP_READ));
+  fail_unless (gst_buffer_memcmp (buf, 0, map.data, map.size) == 0);
+  gst_buffer_unmap (expected, &map);
+  gst_buffer_unref (expected);
+}
+
+/* Timestamp that the element computes for @sample, which lies in the input
+ * buffer starting at @buffer_start */
+static GstClockTime
+sample_pts (guint buffer_start, guint sample, guint64 removed,
+    gboolean squash)
+{
+  GstClockTime pts;
+
+  pts = gst_util_uint64_scale_int (buffer_start, GST_SECOND, RATE) +
+      gst_util_uint64_scale_int (sample - buffer_start, GST_SECOND, RATE);
+  if (squash)
+    pts -= gst_util_uint64_scale_int (removed, GST_SECOND, RATE);
+
+  return pts;
+}
+
+static void
+check_message (GstBus * bus, const gchar * field, GstClockTime expected)
+{
+  GstMessage *msg;
+  const GstStructure *s;
+  guint64 pts;
+
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT);
+  fail_unless (msg != NULL);
+
+  s = gst_message_get_structure (msg);
+  fail_unless (gst_structure_has_name (s, "removesilence"));
+  fail_unless (gst_structure_get_uint64 (s, field, &pts),
+      "expected %s in %" GST_PTR_FORMAT, field, s);
+  fail_unless_equals_clocktime (pts, expected);
+
+  gst_message_unref (msg);
+}
+
+static void
+check_trim (gboolean f32, gint channels, gboolean squash)
+{
+  /* the samples that are not removed as silence */
+  static const guint kept[][2] = {
+    {0, SILENCE_START},
+    {VOICE_RESTART, N_SAMPLES}
+  };
+  GstHarness *h;
+  GstBus *bus;
+  GstBuffer *buf;
+  gchar *caps;
+  guint offset, n_output = 0;
+  gint bpf = channels * (f32 ? sizeof (gfloat) : sizeof (gint16));
+
+  h = gst_harness_new ("removesilence");
+  g_object_set (h->element, "remove", TRUE, "trim", TRUE, "silent", FALSE,
+      "squash", squash, NULL);
+
+  bus = gst_bus_new ();
+  gst_element_set_bus (h->element, bus);
+
+  caps = g_strdup_printf ("audio/x-raw,format=%s,rate=%d,channels=%d,"
+      "layout=interleaved", f32 ? GST_AUDIO_NE (F32) : GST_AUDIO_NE (S16),
+      RATE, channels);
+  gst_harness_set_src_caps_str (h, caps);
+  g_free (caps);
+
+  for (offset = 0; offset < N_SAMPLES; offset += BUFFER_SAMPLES) {
+    guint n_samples = MIN (BUFFER_SAMPLES, N_SAMPLES - offset);
+    guint i;
+
+    fail_unless_equals_int (gst_harness_push (h, make_input (f32, channels,
+                offset, n_samples)), GST_FLOW_OK);
+
+    /* one output buffer for each kept range within this input buffer */
+    for (i = 0; i < G_N_ELEMENTS (kept); i++) {
+      guint start = MAX (offset, kept[i][0]);
+      guint end = MIN (offset + n_samples, kept[i][1]);
+      guint64 removed = i == 0 ? 0 : REMOVED_SAMPLES;
+
+      if (start >= end)
+        continue;
+
+      buf = gst_harness_pull (h);
+      fail_unless_equals_int (gst_buffer_get_size (buf), (end - start) * bpf);
+      fail_unless_equals_clocktime (GST_BUFFER_PTS (buf),
+          sample_pts (offset, start, removed, squash));
+      fail_unless_equals_clocktime (GST_BUFFER_DURATION (buf),
+          gst_util_uint64_scale_int (end - start, GST_SECOND, RATE));
+      fail_unless_equals_uint64 (GST_BUFFER_OFFSET (buf), start);
+      fail_unless_equals_uint64 (GST_BUFFER_OFFSET_END (buf), end);
+      check_data (buf, f32, channels, start, end - start);
+      gst_buffer_unref (buf);
+
+      n_output += end - start;
+    }
+
+    fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+  }
+
+  fail_unless_equals_int (n_output, N_SAMPLES - REMOVED_SAMPLES);
+
+  /* nothing is considered silence before the VAD has seen any */
+  check_message (bus, "silence_detected",
+      sample_pts (SILENCE_START - SILENCE_START % BUFFER_SAMPLES,
+          SILENCE_START, 0, squash));
+  check_message (bus, "silence_finished",
+      sample_pts (VOICE_RESTART - VOICE_RESTART % BUFFER_SAMPLES,
+          VOICE_RESTART, REMOVED_SAMPLES, squash));
+  fail_unless (gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT) == NULL);
+
+  gst_bus_set_flushing (bus, TRUE);
+  gst_object_unref (bus);
+
+  gst_harness_teardown (h);
+}
+
+GST_START_TEST (test_trim_s16_mono)
+{
+  check_trim (FALSE, 1, FALSE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_trim_s16_mono_squash)
+{
+  check_trim (FALSE, 1, TRUE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_trim_f32_stereo)
+{
+  check_trim (TRUE, 2, FALSE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_trim_f32_stereo_squash)
+{
+  check_trim (TRUE, 2, TRUE);
+}
+
+GST_END_TEST;
+
+static Suite *
+removesilence_suite (void)
+{
+  Suite *s = suite_create ("removesilence");
+  TCase *tc = tcase_create ("general");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_trim_s16_mono);
+  tcase_add_test (tc, test_trim_s16_mono_squash);
+  tcase_add_test (tc, test_trim_f32_stereo);
+  tcase_add_test (tc, test_trim_f32_stereo_squash);
+
+  return s;
+}
+
+GST_CHECK_MAIN (removesilence);
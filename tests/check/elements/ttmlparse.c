@@ -0,0 +1,208 @@
+/* GStreamer
+ *
+ * unit test for ttmlparse
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+/* Only for the structure definitions, the meta API type is looked up by name
+ * as it is registered by the plugin */
+#include "../../ext/ttml/subtitlemeta.h"
+
+/* Two paragraphs, from 1 to 2 s and from 3 to 4 s, styled with @color */
+static gchar *
+make_document (const gchar * color, gboolean comment, const gchar * first,
+    const gchar * second)
+{
+  return g_strdup_printf ("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+      "<tt xmlns=\"http://www.w3.org/ns/ttml\" "
+      "xmlns:tts=\"http://www.w3.org/ns/ttml#styling\" xml:lang=\"en\">\n"
+      "  <head>\n"
+      "    <styling>\n"
+      "      <style xml:id=\"s1\" tts:color=\"%s\"/>\n"
+      "    </styling>\n"
+      "    <layout>\n"
+      "      <region xml:id=\"r1\" tts:origin=\"10%% 80%%\" "
+      "tts:extent=\"80%% 10%%\"/>\n"
+      "    </layout>\n"
+      "  </head>\n"
+      "  %s<body region=\"r1\" style=\"s1\">\n"
+      "    <div>\n"
+      "      <p begin=\"00:00:01.000\" end=\"00:00:02.000\">%s</p>\n"
+      "      <p begin=\"00:00:03.000\" end=\"00:00:04.000\">%s</p>\n"
+      "    </div>\n"
+      "  </body>\n"
+      "</tt>\n", color, comment ? "<!-- comment -->" : "", first, second);
+}
+
+static GstHarness *
+setup_ttmlparse (void)
+{
+  GstHarness *h = gst_harness_new ("ttmlparse");
+
+  gst_harness_set_src_caps_str (h, "application/ttml+xml");
+
+  return h;
+}
+
+static void
+push_document (GstHarness * h, const gchar * doc, gsize chunk_size)
+{
+  gsize len = strlen (doc), offset;
+
+  for (offset = 0; offset < len; offset += chunk_size) {
+    gsize size = MIN (chunk_size, len - offset);
+    GstBuffer *buf = gst_buffer_new_allocate (NULL, size, NULL);
+
+    /* nothing is output before the end of the document */
+    fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+
+    gst_buffer_fill (buf, 0, doc + offset, size);
+    GST_BUFFER_PTS (buf) = 0;
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  }
+}
+
+/* Pulls the subtitle for one paragraph and checks its text and colour */
+static void
+check_subtitle (GstHarness * h, GstClockTime pts, const gchar * text,
+    guint8 r, guint8 g, guint8 b)
+{
+  GstBuffer *buf = gst_harness_pull (h);
+  GstSubtitleMeta *meta;
+  GstSubtitleRegion *region;
+  GstSubtitleBlock *block;
+  GstSubtitleElement *element;
+  GstMemory *mem;
+  GstMapInfo map;
+
+  fail_unless_equals_clocktime (GST_BUFFER_PTS (buf), pts);
+  fail_unless_equals_clocktime (GST_BUFFER_DURATION (buf), GST_SECOND);
+
+  meta = (GstSubtitleMeta *) gst_buffer_get_meta (buf,
+      g_type_from_name ("GstSubtitleMetaAPI"));
+  fail_unless (meta != NULL);
+  fail_unless_equals_int (meta->regions->len, 1);
+
+  region = g_ptr_array_index (meta->regions, 0);
+  fail_unless_equals_int (region->blocks->len, 1);
+  block = g_ptr_array_index (region->blocks, 0);
+  fail_unless_equals_int (block->elements->len, 1);
+  element = g_ptr_array_index (block->elements, 0);
+
+  fail_unless_equals_int (element->style_set->color.r, r);
+  fail_unless_equals_int (element->style_set->color.g, g);
+  fail_unless_equals_int (element->style_set->color.b, b);
+
+  mem = gst_buffer_peek_memory (buf, element->text_index);
+  fail_unless (gst_memory_map (mem, &map, GST_MAP_READ));
+  fail_unless_equals_string ((const gchar *) map.data, text);
+  gst_memory_unmap (mem, &map);
+
+  gst_buffer_unref (buf);
+}
+
+GST_START_TEST (test_parse_split_document)
+{
+  /* single bytes split the end tag over several buffers */
+  static const gsize chunk_sizes[] = { 1, 7, 64 };
+  GstHarness *h;
+  gchar *doc;
+  guint i;
+
+  doc = make_document ("#ff0000", FALSE, "First", "Second");
+
+  for (i = 0; i < G_N_ELEMENTS (chunk_sizes); i++) {
+    h = setup_ttmlparse ();
+
+    push_document (h, doc, chunk_sizes[i]);
+
+    fail_unless_equals_int (gst_harness_buffers_in_queue (h), 2);
+    check_subtitle (h, GST_SECOND, "First", 0xff, 0, 0);
+    check_subtitle (h, 3 * GST_SECOND, "Second", 0xff, 0, 0);
+
+    gst_harness_teardown (h);
+  }
+
+  g_free (doc);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_parse_repeated_head)
+{
+  GstHarness *h;
+  gchar *doc;
+
+  h = setup_ttmlparse ();
+
+  doc = make_document ("#ff0000", FALSE, "First", "Second");
+  push_document (h, doc, strlen (doc));
+  g_free (doc);
+  check_subtitle (h, GST_SECOND, "First", 0xff, 0, 0);
+  check_subtitle (h, 3 * GST_SECOND, "Second", 0xff, 0, 0);
+
+  /* same head, the styles of the previous document are reused */
+  doc = make_document ("#ff0000", FALSE, "Third", "Fourth");
+  push_document (h, doc, 10);
+  g_free (doc);
+  check_subtitle (h, GST_SECOND, "Third", 0xff, 0, 0);
+  check_subtitle (h, 3 * GST_SECOND, "Fourth", 0xff, 0, 0);
+
+  /* a different head must not pick up the previous styles */
+  doc = make_document ("#0000ff", FALSE, "Fifth", "Sixth");
+  push_document (h, doc, strlen (doc));
+  g_free (doc);
+  check_subtitle (h, GST_SECOND, "Fifth", 0, 0, 0xff);
+  check_subtitle (h, 3 * GST_SECOND, "Sixth", 0, 0, 0xff);
+
+  /* nor must a comment before the body, which isn't cached at all */
+  doc = make_document ("#00ff00", TRUE, "Seventh", "Eighth");
+  push_document (h, doc, strlen (doc));
+  g_free (doc);
+  check_subtitle (h, GST_SECOND, "Seventh", 0, 0xff, 0);
+  check_subtitle (h, 3 * GST_SECOND, "Eighth", 0, 0xff, 0);
+
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+ttmlparse_suite (void)
+{
+  Suite *s = suite_create ("ttmlparse");
+  TCase *tc = tcase_create ("general");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_parse_split_document);
+  tcase_add_test (tc, test_parse_repeated_head);
+
+  return s;
+}
+
+GST_CHECK_MAIN (ttmlparse);
@@ -0,0 +1,180 @@
+/* GStreamer
+ *
+ * unit test for ttmlrender
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+#define WIDTH 320
+#define HEIGHT 240
+#define STRIDE (WIDTH * 4)
+
+#define VIDEO_CAPS "video/x-raw,format=BGRx,width=320,height=240," \
+    "framerate=1/1"
+
+/* Uses ttmlparse to create a one second subtitle starting at @pts, with
+ * @text in a region at the top left quarter of the frame that has a
+ * @color background */
+static GstBuffer *
+make_subtitle (const gchar * color, const gchar * text, GstClockTime pts)
+{
+  GstHarness *h;
+  GstBuffer *buf;
+  gchar *doc;
+
+  doc = g_strdup_printf ("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+      "<tt xmlns=\"http://www.w3.org/ns/ttml\" "
+      "xmlns:tts=\"http://www.w3.org/ns/ttml#styling\" xml:lang=\"en\">\n"
+      "  <head>\n"
+      "    <layout>\n"
+      "      <region xml:id=\"r1\" tts:origin=\"0%% 0%%\" "
+      "tts:extent=\"50%% 50%%\" tts:backgroundColor=\"%s\"/>\n"
+      "    </layout>\n"
+      "  </head>\n"
+      "  <body region=\"r1\">\n"
+      "    <div>\n"
+      "      <p begin=\"00:00:00.000\" end=\"00:00:01.000\">%s</p>\n"
+      "    </div>\n"
+      "  </body>\n"
+      "</tt>\n", color, text);
+
+  h = gst_harness_new ("ttmlparse");
+  gst_harness_set_src_caps_str (h, "application/ttml+xml");
+
+  buf = gst_buffer_new_wrapped (doc, strlen (doc));
+  GST_BUFFER_PTS (buf) = 0;
+  GST_BUFFER_DURATION (buf) = GST_SECOND;
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 1);
+  buf = gst_buffer_make_writable (gst_harness_pull (h));
+  fail_unless_equals_clocktime (GST_BUFFER_DURATION (buf), GST_SECOND);
+  GST_BUFFER_PTS (buf) = pts;
+
+  gst_harness_teardown (h);
+
+  return buf;
+}
+
+/* Renders a subtitle onto a black frame covering the same second */
+static GstBuffer *
+render_frame (GstHarness * h, GstHarness * text_h, const gchar * color,
+    const gchar * text, GstClockTime pts)
+{
+  GstBuffer *buf;
+
+  fail_unless_equals_int (gst_harness_push (text_h, make_subtitle (color,
+              text, pts)), GST_FLOW_OK);
+
+  buf = gst_buffer_new_allocate (NULL, STRIDE * HEIGHT, NULL);
+  gst_buffer_memset (buf, 0, 0, STRIDE * HEIGHT);
+  GST_BUFFER_PTS (buf) = pts;
+  GST_BUFFER_DURATION (buf) = GST_SECOND;
+
+  return gst_harness_push_and_pull (h, buf);
+}
+
+/* Checks the colour of the region background in a corner of the region */
+static void
+check_background (GstBuffer * buf, guint8 r, guint8 g, guint8 b)
+{
+  GstMapInfo map;
+  const guint8 *pixel;
+
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+  pixel = map.data + 2 * STRIDE + 2 * 4;
+  fail_unless_equals_int (pixel[0], b);
+  fail_unless_equals_int (pixel[1], g);
+  fail_unless_equals_int (pixel[2], r);
+  gst_buffer_unmap (buf, &map);
+}
+
+static gboolean
+buffers_equal (GstBuffer * a, GstBuffer * b)
+{
+  GstMapInfo map;
+  gboolean ret;
+
+  fail_unless (gst_buffer_map (a, &map, GST_MAP_READ));
+  ret = gst_buffer_get_size (b) == map.size &&
+      gst_buffer_memcmp (b, 0, map.data, map.size) == 0;
+  gst_buffer_unmap (a, &map);
+
+  return ret;
+}
+
+GST_START_TEST (test_render_repeated_scenes)
+{
+  GstHarness *h, *text_h;
+  GstBuffer *first, *buf;
+
+  h = gst_harness_new_with_padnames ("ttmlrender", "video_sink", "src");
+  text_h = gst_harness_new_with_element (h->element, "text_sink", NULL);
+
+  gst_harness_set_src_caps_str (text_h, "text/x-raw(meta:GstSubtitleMeta)");
+  gst_harness_set_src_caps_str (h, VIDEO_CAPS);
+  gst_harness_set_sink_caps_str (h, VIDEO_CAPS);
+
+  first = render_frame (h, text_h, "#ff0000", "Hello", 0);
+  check_background (first, 0xff, 0, 0);
+
+  /* an identical scene reuses the cached text and region, and must look
+   * exactly the same */
+  buf = render_frame (h, text_h, "#ff0000", "Hello", GST_SECOND);
+  fail_unless (buffers_equal (first, buf));
+  gst_buffer_unref (buf);
+
+  /* the same text in a changed region must not reuse the previous one */
+  buf = render_frame (h, text_h, "#0000ff", "Hello", 2 * GST_SECOND);
+  check_background (buf, 0, 0, 0xff);
+  fail_if (buffers_equal (first, buf));
+  gst_buffer_unref (buf);
+
+  /* and going back renders the first scene again */
+  buf = render_frame (h, text_h, "#ff0000", "Hello", 3 * GST_SECOND);
+  fail_unless (buffers_equal (first, buf));
+  gst_buffer_unref (buf);
+
+  gst_buffer_unref (first);
+
+  gst_harness_teardown (text_h);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+ttmlrender_suite (void)
+{
+  Suite *s = suite_create ("ttmlrender");
+  TCase *tc = tcase_create ("general");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_render_repeated_scenes);
+
+  return s;
+}
+
+GST_CHECK_MAIN (ttmlrender);
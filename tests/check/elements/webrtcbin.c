@@ -1055,6 +1055,48 @@ GST_START_TEST (test_payload_types)
 
 GST_END_TEST;
 
+static guint64
+_get_rtpstorage_size_time (GstElement * webrtc, guint session_id)
+{
+  GstElement *rtpbin;
+  GObject *storage = NULL;
+  guint64 size_time;
+
+  rtpbin = gst_bin_get_by_name (GST_BIN (webrtc), "rtpbin");
+  fail_unless (rtpbin != NULL);
+  g_signal_emit_by_name (rtpbin, "get-storage", session_id, &storage);
+  fail_unless (storage != NULL);
+
+  g_object_get (storage, "size-time", &size_time, NULL);
+
+  g_object_unref (storage);
+  gst_object_unref (rtpbin);
+
+  return size_time;
+}
+
+GST_START_TEST (test_rtpstorage_without_fec)
+{
+  struct test_webrtc *t = create_audio_test ();
+  VAL_SDP_INIT (offer, _count_num_sdp_media, GUINT_TO_POINTER (1), NULL);
+  VAL_SDP_INIT (answer, _count_num_sdp_media, GUINT_TO_POINTER (1), NULL);
+
+  /* without ULPFEC nothing ever reads the stored packets back, so the
+   * storage must not keep any */
+  test_validate_sdp (t, &offer, &answer);
+
+  fail_unless_equals_uint64 (_get_rtpstorage_size_time (t->webrtc1, 0), 0);
+  fail_unless_equals_uint64 (_get_rtpstorage_size_time (t->webrtc2, 0), 0);
+
+  /* and changing the latency must not enable it either */
+  g_object_set (t->webrtc1, "latency", 500, NULL);
+  fail_unless_equals_uint64 (_get_rtpstorage_size_time (t->webrtc1, 0), 0);
+
+  test_webrtc_free (t);
+}
+
+GST_END_TEST;
+
 static void
 on_sdp_media_setup (struct test_webrtc *t, GstElement * element,
     GstWebRTCSessionDescription * desc, gpointer user_data)
@@ -1814,6 +1856,326 @@ GST_START_TEST (test_data_channel_transfer_data)
 
 GST_END_TEST;
 
+static GstElement *
+_new_webrtcbin_with_shared_ice_thread (void)
+{
+  GstPluginFeature *feature;
+  GstElement *webrtc;
+
+  feature = gst_plugin_feature_load (GST_PLUGIN_FEATURE
+      (gst_element_factory_find ("webrtcbin")));
+  fail_unless (feature != NULL);
+  webrtc =
+      g_object_new (gst_element_factory_get_element_type (GST_ELEMENT_FACTORY
+          (feature)), "shared-ice-thread", TRUE, NULL);
+  gst_object_unref (feature);
+
+  return gst_object_ref_sink (webrtc);
+}
+
+GST_START_TEST (test_shared_ice_thread)
+{
+  GstElement *webrtc1, *webrtc2;
+  GObject *ice1, *ice2;
+  gboolean shared;
+
+  webrtc1 = _new_webrtcbin_with_shared_ice_thread ();
+  webrtc2 = _new_webrtcbin_with_shared_ice_thread ();
+
+  g_object_get (webrtc1, "shared-ice-thread", &shared, "ice-agent", &ice1,
+      NULL);
+  fail_unless (shared);
+  g_object_get (ice1, "shared-thread", &shared, NULL);
+  fail_unless (shared);
+  g_object_get (webrtc2, "ice-agent", &ice2, NULL);
+  fail_unless (ice1 != ice2);
+  g_object_unref (ice1);
+  g_object_unref (ice2);
+
+  fail_if (gst_element_set_state (webrtc1,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+  fail_if (gst_element_set_state (webrtc2,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+
+  /* dropping the first user must leave the thread running for the other */
+  gst_element_set_state (webrtc1, GST_STATE_NULL);
+  gst_object_unref (webrtc1);
+  gst_element_set_state (webrtc2, GST_STATE_NULL);
+  gst_object_unref (webrtc2);
+
+  /* and a new user starts it again */
+  webrtc1 = _new_webrtcbin_with_shared_ice_thread ();
+  gst_object_unref (webrtc1);
+}
+
+GST_END_TEST;
+
+#define N_BURST_MESSAGES 100
+
+static void
+on_message_data_burst (GObject * channel, GBytes * data,
+    struct test_webrtc *t)
+{
+  guint expected = GPOINTER_TO_UINT (g_object_get_data (channel, "expected"));
+  const guint8 *d;
+  gsize size;
+
+  d = g_bytes_get_data (data, &size);
+  fail_unless_equals_int (size, 4);
+  fail_unless_equals_int (GST_READ_UINT32_LE (d), expected);
+
+  expected++;
+  g_object_set_data (channel, "expected", GUINT_TO_POINTER (expected));
+  if (expected == N_BURST_MESSAGES)
+    test_webrtc_signal_state (t, STATE_CUSTOM);
+}
+
+static void
+have_data_channel_transfer_burst (struct test_webrtc *t, GstElement * element,
+    GObject * our, gpointer user_data)
+{
+  GObject *other = user_data;
+  guint8 buf[4];
+  GBytes *data;
+  guint i;
+
+  g_object_set_data (our, "expected", GUINT_TO_POINTER (0));
+  g_signal_connect (our, "on-message-data",
+      G_CALLBACK (on_message_data_burst), t);
+
+  g_signal_connect (other, "on-error",
+      G_CALLBACK (on_channel_error_not_reached), NULL);
+  for (i = 0; i < N_BURST_MESSAGES; i++) {
+    GST_WRITE_UINT32_LE (buf, i);
+    data = g_bytes_new (buf, sizeof (buf));
+    g_signal_emit_by_name (other, "send-data", data);
+    g_bytes_unref (data);
+  }
+}
+
+GST_START_TEST (test_data_channel_transfer_burst)
+{
+  struct test_webrtc *t = test_webrtc_new ();
+  GObject *channel = NULL;
+  VAL_SDP_INIT (offer, on_sdp_has_datachannel, NULL, NULL);
+  VAL_SDP_INIT (answer, on_sdp_has_datachannel, NULL, NULL);
+
+  t->on_negotiation_needed = NULL;
+  t->on_ice_candidate = NULL;
+  t->on_data_channel = have_data_channel_transfer_burst;
+
+  fail_if (gst_element_set_state (t->webrtc1,
+          GST_STATE_READY) == GST_STATE_CHANGE_FAILURE);
+  fail_if (gst_element_set_state (t->webrtc2,
+          GST_STATE_READY) == GST_STATE_CHANGE_FAILURE);
+
+  g_signal_emit_by_name (t->webrtc1, "create-data-channel", "label", NULL,
+      &channel);
+  g_assert_nonnull (channel);
+  t->data_channel_data = channel;
+  g_signal_connect (channel, "on-error",
+      G_CALLBACK (on_channel_error_not_reached), NULL);
+
+  fail_if (gst_element_set_state (t->webrtc1,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+  fail_if (gst_element_set_state (t->webrtc2,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+
+  test_validate_sdp_full (t, &offer, &answer, 1 << STATE_CUSTOM, FALSE);
+
+  g_object_unref (channel);
+  test_webrtc_free (t);
+}
+
+GST_END_TEST;
+
+typedef struct
+{
+  GObject *other;
+  GMutex lock;
+  GCond cond;
+  GstPad *dec_sinkpad;
+  guint data_chunks;
+  guint n_buffers;
+  guint n_lists;
+  guint n_list_buffers;
+} BurstListState;
+
+static gint
+_compare_factory_name (const GValue * value, const gchar * name)
+{
+  GstElement *element = g_value_get_object (value);
+  GstElementFactory *factory = gst_element_get_factory (element);
+
+  return factory
+      && g_strcmp0 (GST_OBJECT_NAME (factory), name) == 0 ? 0 : 1;
+}
+
+static GstElement *
+_find_element_by_factory (GstElement * bin, const gchar * name)
+{
+  GstIterator *it = gst_bin_iterate_recurse (GST_BIN (bin));
+  GValue value = G_VALUE_INIT;
+  GstElement *element = NULL;
+
+  if (gst_iterator_find_custom (it, (GCompareFunc) _compare_factory_name,
+          &value, (gpointer) name)) {
+    element = g_value_dup_object (&value);
+    g_value_unset (&value);
+  }
+  gst_iterator_free (it);
+
+  return element;
+}
+
+/* Counts the DATA chunks of every SCTP packet going into sctpdec */
+static GstPadProbeReturn
+count_data_chunks (GstPad * pad, GstPadProbeInfo * info,
+    BurstListState * state)
+{
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  GstMapInfo map;
+  gsize offset = 12;
+
+  fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+  g_mutex_lock (&state->lock);
+  while (offset + 4 <= map.size) {
+    guint16 len = GST_READ_UINT16_BE (map.data + offset + 2);
+
+    if (len < 4)
+      break;
+    if (map.data[offset] == 0)
+      state->data_chunks++;
+    offset += GST_ROUND_UP_4 (len);
+  }
+  g_cond_broadcast (&state->cond);
+  g_mutex_unlock (&state->lock);
+  gst_buffer_unmap (buffer, &map);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn
+count_output (GstPad * pad, GstPadProbeInfo * info, BurstListState * state)
+{
+  g_mutex_lock (&state->lock);
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    state->n_lists++;
+    state->n_list_buffers +=
+        gst_buffer_list_length (GST_PAD_PROBE_INFO_BUFFER_LIST (info));
+  } else {
+    state->n_buffers++;
+  }
+  g_mutex_unlock (&state->lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* Holds the sctpdec output task on the first message until the whole burst
+ * went through sctpdec, so that everything else is queued up behind it */
+static GstPadProbeReturn
+hold_first_message (GstPad * pad, GstPadProbeInfo * info,
+    BurstListState * state)
+{
+  gint64 end_time = g_get_monotonic_time () + 10 * G_TIME_SPAN_SECOND;
+
+  g_mutex_lock (&state->lock);
+  while (state->data_chunks < N_BURST_MESSAGES)
+    fail_unless (g_cond_wait_until (&state->cond, &state->lock, end_time));
+  g_mutex_unlock (&state->lock);
+
+  /* the probe runs before the last packet is handled, which is done once
+   * the stream lock of the sink pad is free again */
+  GST_PAD_STREAM_LOCK (state->dec_sinkpad);
+  GST_PAD_STREAM_UNLOCK (state->dec_sinkpad);
+
+  return GST_PAD_PROBE_REMOVE;
+}
+
+static void
+have_data_channel_transfer_burst_list (struct test_webrtc *t,
+    GstElement * element, GObject * our, gpointer user_data)
+{
+  BurstListState *state = user_data;
+  GstElement *sctpdec;
+  GstIterator *it;
+  GValue value = G_VALUE_INIT;
+  GstPad *srcpad;
+
+  sctpdec = _find_element_by_factory (element, "sctpdec");
+  fail_unless (sctpdec != NULL);
+
+  /* the pad of the one stream that was opened */
+  it = gst_element_iterate_src_pads (sctpdec);
+  fail_unless_equals_int (gst_iterator_next (it, &value), GST_ITERATOR_OK);
+  srcpad = g_value_dup_object (&value);
+  g_value_unset (&value);
+  gst_iterator_free (it);
+
+  state->dec_sinkpad = gst_element_get_static_pad (sctpdec, "sink");
+  gst_pad_add_probe (state->dec_sinkpad, GST_PAD_PROBE_TYPE_BUFFER,
+      (GstPadProbeCallback) count_data_chunks, state, NULL);
+  gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_BUFFER |
+      GST_PAD_PROBE_TYPE_BUFFER_LIST, (GstPadProbeCallback) count_output,
+      state, NULL);
+  gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_BUFFER,
+      (GstPadProbeCallback) hold_first_message, state, NULL);
+  gst_object_unref (srcpad);
+  gst_object_unref (sctpdec);
+
+  have_data_channel_transfer_burst (t, element, our, state->other);
+}
+
+GST_START_TEST (test_data_channel_transfer_burst_list)
+{
+  struct test_webrtc *t = test_webrtc_new ();
+  BurstListState state = { NULL, };
+  VAL_SDP_INIT (offer, on_sdp_has_datachannel, NULL, NULL);
+  VAL_SDP_INIT (answer, on_sdp_has_datachannel, NULL, NULL);
+
+  g_mutex_init (&state.lock);
+  g_cond_init (&state.cond);
+
+  t->on_negotiation_needed = NULL;
+  t->on_ice_candidate = NULL;
+  t->on_data_channel = have_data_channel_transfer_burst_list;
+
+  fail_if (gst_element_set_state (t->webrtc1,
+          GST_STATE_READY) == GST_STATE_CHANGE_FAILURE);
+  fail_if (gst_element_set_state (t->webrtc2,
+          GST_STATE_READY) == GST_STATE_CHANGE_FAILURE);
+
+  g_signal_emit_by_name (t->webrtc1, "create-data-channel", "label", NULL,
+      &state.other);
+  g_assert_nonnull (state.other);
+  t->data_channel_data = &state;
+  g_signal_connect (state.other, "on-error",
+      G_CALLBACK (on_channel_error_not_reached), NULL);
+
+  fail_if (gst_element_set_state (t->webrtc1,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+  fail_if (gst_element_set_state (t->webrtc2,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+
+  test_validate_sdp_full (t, &offer, &answer, 1 << STATE_CUSTOM, FALSE);
+
+  /* the held first message, and then all the others in a single list */
+  g_mutex_lock (&state.lock);
+  fail_unless_equals_int (state.n_buffers, 1);
+  fail_unless_equals_int (state.n_lists, 1);
+  fail_unless_equals_int (state.n_list_buffers, N_BURST_MESSAGES - 1);
+  g_mutex_unlock (&state.lock);
+
+  test_webrtc_free (t);
+
+  gst_object_unref (state.dec_sinkpad);
+  g_object_unref (state.other);
+  g_mutex_clear (&state.lock);
+  g_cond_clear (&state.cond);
+}
+
+GST_END_TEST;
+
 static void
 have_data_channel_create_data_channel (struct test_webrtc *t,
     GstElement * element, GObject * our, gpointer user_data)
@@ -2904,6 +3266,7 @@ webrtcbin_suite (void)
     tcase_add_test (tc, test_add_recvonly_transceiver);
     tcase_add_test (tc, test_recvonly_sendonly);
     tcase_add_test (tc, test_payload_types);
+    tcase_add_test (tc, test_rtpstorage_without_fec);
     tcase_add_test (tc, test_bundle_audio_video_max_bundle_max_bundle);
     tcase_add_test (tc, test_bundle_audio_video_max_bundle_none);
     tcase_add_test (tc, test_bundle_audio_video_max_compat_max_bundle);
@@ -2914,11 +3277,14 @@ webrtcbin_suite (void)
     tcase_add_test (tc, test_bundle_max_compat_max_bundle_renego_add_stream);
     tcase_add_test (tc, test_renego_transceiver_set_direction);
     tcase_add_test (tc, test_renego_lose_media_fails);
+    tcase_add_test (tc, test_shared_ice_thread);
     if (sctpenc && sctpdec) {
       tcase_add_test (tc, test_data_channel_create);
       tcase_add_test (tc, test_data_channel_remote_notify);
       tcase_add_test (tc, test_data_channel_transfer_string);
       tcase_add_test (tc, test_data_channel_transfer_data);
+      tcase_add_test (tc, test_data_channel_transfer_burst);
+      tcase_add_test (tc, test_data_channel_transfer_burst_list);
       tcase_add_test (tc, test_data_channel_create_after_negotiate);
       tcase_add_test (tc, test_data_channel_low_threshold);
       tcase_add_test (tc, test_data_channel_max_message_size);
@@ -0,0 +1,486 @@
+/* GStreamer
+ *
+ * unit test for y4mdec
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <glib/gstdio.h>
+#include <gst/check/gstcheck.h>
+#include <gst/video/video.h>
+
+/* I420, the Y4M layout matches the default GstVideoInfo layout */
+#define WIDTH 16
+#define HEIGHT 8
+#define FRAME_SIZE (WIDTH * HEIGHT * 3 / 2)
+
+/* Chroma lines of 9 bytes, which the default layout pads to 12 */
+#define PADDED_WIDTH 18
+
+/* NTSC frame rate, where frame timestamps are not whole nanoseconds */
+#define FPS_N 30000
+#define FPS_D 1001
+
+#define N_FRAMES 30
+
+typedef struct
+{
+  GMutex lock;
+  GList *buffers;
+  GstSegment segment;
+  gboolean have_segment;
+  gboolean have_stream_start;
+  gboolean caps_after_stream_start;
+} Output;
+
+static GstClockTime
+frame_ts (gint64 frame)
+{
+  return gst_util_uint64_scale (frame, GST_SECOND * FPS_D, FPS_N);
+}
+
+/* Writes a Y4M file of @width where every byte of frame n is n. The header
+ * of @param_frame carries parameters, and a truncated frame of half the
+ * size is appended if @truncated is set */
+static gchar *
+write_y4m (gint width, gint n_frames, gint param_frame, gboolean truncated)
+{
+  GString *s = g_string_new (NULL);
+  GError *error = NULL;
+  gsize frame_size = width * HEIGHT + 2 * ((width + 1) / 2) * (HEIGHT / 2);
+  gchar *filename;
+  gint fd, i;
+
+  g_string_append_printf (s, "YUV4MPEG2 W%d H%d F%d:%d Ip A1:1 C420\n",
+      width, HEIGHT, FPS_N, FPS_D);
+
+  for (i = 0; i < (truncated ? n_frames + 1 : n_frames); i++) {
+    gsize len = i < n_frames ? frame_size : frame_size / 2;
+
+    if (i == param_frame)
+      g_string_append (s, "FRAME Ip XYZ\n");
+    else
+      g_string_append (s, "FRAME\n");
+
+    g_string_set_size (s, s->len + len);
+    memset (s->str + s->len - len, i & 0xff, len);
+  }
+
+  fd = g_file_open_tmp ("y4mdec-XXXXXX.y4m", &filename, &error);
+  fail_unless (fd != -1, "%s", error ? error->message : "");
+  g_close (fd, NULL);
+
+  fail_unless (g_file_set_contents (filename, s->str, s->len, NULL));
+  g_string_free (s, TRUE);
+
+  return filename;
+}
+
+static GstPadProbeReturn
+collect_output (GstPad * pad, GstPadProbeInfo * info, Output * output)
+{
+  g_mutex_lock (&output->lock);
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER) {
+    output->buffers = g_list_append (output->buffers,
+        gst_buffer_ref (GST_PAD_PROBE_INFO_BUFFER (info)));
+  } else {
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_SEGMENT) {
+      gst_event_copy_segment (event, &output->segment);
+      output->have_segment = TRUE;
+    } else if (GST_EVENT_TYPE (event) == GST_EVENT_STREAM_START) {
+      output->have_stream_start = TRUE;
+    } else if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS) {
+      output->caps_after_stream_start = output->have_stream_start;
+    }
+  }
+  g_mutex_unlock (&output->lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+clear_output (Output * output)
+{
+  g_mutex_lock (&output->lock);
+  g_list_free_full (output->buffers, (GDestroyNotify) gst_buffer_unref);
+  output->buffers = NULL;
+  output->have_segment = FALSE;
+  g_mutex_unlock (&output->lock);
+}
+
+static GstElement *
+setup_pipeline (const gchar * filename, Output * output)
+{
+  GstElement *pipeline, *sink;
+  GstPad *pad;
+  gchar *desc;
+
+  desc = g_strdup_printf ("filesrc location=\"%s\" ! y4mdec ! "
+      "fakesink name=sink sync=false", filename);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  fail_unless (pipeline != NULL);
+
+  g_mutex_init (&output->lock);
+  output->buffers = NULL;
+  output->have_segment = FALSE;
+  output->have_stream_start = FALSE;
+  output->caps_after_stream_start = FALSE;
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  pad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER |
+      GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      (GstPadProbeCallback) collect_output, output, NULL);
+  gst_object_unref (pad);
+  gst_object_unref (sink);
+
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_ASYNC);
+  fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE), GST_STATE_CHANGE_SUCCESS);
+
+  return pipeline;
+}
+
+static void
+teardown_pipeline (GstElement * pipeline, Output * output, gchar * filename)
+{
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  clear_output (output);
+  g_mutex_clear (&output->lock);
+
+  g_unlink (filename);
+  g_free (filename);
+}
+
+static GstMessage *
+run_until (GstElement * pipeline, GstMessageType type)
+{
+  GstBus *bus = gst_element_get_bus (pipeline);
+  GstMessage *msg;
+
+  fail_unless (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+
+  msg = gst_bus_timed_pop_filtered (bus, 10 * GST_SECOND,
+      type | GST_MESSAGE_ERROR);
+  fail_unless (msg != NULL);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), type);
+  gst_object_unref (bus);
+
+  return msg;
+}
+
+static void
+seek (GstElement * pipeline, GstSeekFlags flags, GstClockTime start,
+    GstClockTime stop)
+{
+  fail_unless (gst_element_seek (pipeline, 1.0, GST_FORMAT_TIME, flags,
+          GST_SEEK_TYPE_SET, start,
+          stop == GST_CLOCK_TIME_NONE ? GST_SEEK_TYPE_NONE : GST_SEEK_TYPE_SET,
+          stop));
+  fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE), GST_STATE_CHANGE_SUCCESS);
+}
+
+/* Checks that the output is exactly the frames from @first to @last - 1 */
+static void
+check_frames (Output * output, gint first, gint last)
+{
+  GList *l;
+  gint frame = first;
+
+  g_mutex_lock (&output->lock);
+  fail_unless_equals_int (g_list_length (output->buffers), last - first);
+
+  for (l = output->buffers; l; l = l->next, frame++) {
+    GstBuffer *buf = l->data;
+    GstMapInfo map;
+    gsize i;
+
+    fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+    fail_unless_equals_int (map.size, FRAME_SIZE);
+    for (i = 0; i < map.size; i++)
+      fail_unless_equals_int (map.data[i], frame & 0xff);
+    gst_buffer_unmap (buf, &map);
+
+    fail_unless_equals_clocktime (GST_BUFFER_PTS (buf), frame_ts (frame));
+    fail_unless_equals_clocktime (GST_BUFFER_DURATION (buf),
+        frame_ts (frame + 1) - frame_ts (frame));
+    fail_unless_equals_int (GST_BUFFER_IS_DISCONT (buf), frame == first);
+  }
+  g_mutex_unlock (&output->lock);
+}
+
+GST_START_TEST (test_y4mdec_play)
+{
+  gchar *filename = write_y4m (WIDTH, N_FRAMES, -1, FALSE);
+  Output output;
+  GstElement *pipeline;
+
+  pipeline = setup_pipeline (filename, &output);
+  gst_message_unref (run_until (pipeline, GST_MESSAGE_EOS));
+  check_frames (&output, 0, N_FRAMES);
+
+  /* nothing upstream sends stream-start in pull mode */
+  g_mutex_lock (&output.lock);
+  fail_unless (output.have_stream_start);
+  fail_unless (output.caps_after_stream_start);
+  g_mutex_unlock (&output.lock);
+
+  teardown_pipeline (pipeline, &output, filename);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_y4mdec_frame_params_and_truncated)
+{
+  /* the header of frame 2 carries parameters and is longer than what is
+   * read for a plain header, the truncated frame at the end is dropped */
+  gchar *filename = write_y4m (WIDTH, 5, 2, TRUE);
+  Output output;
+  GstElement *pipeline;
+
+  pipeline = setup_pipeline (filename, &output);
+  gst_message_unref (run_until (pipeline, GST_MESSAGE_EOS));
+  check_frames (&output, 0, 5);
+
+  teardown_pipeline (pipeline, &output, filename);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_y4mdec_frame_params_seek)
+{
+  /* the parameters of frame 5 move all following frames */
+  gchar *filename = write_y4m (WIDTH, N_FRAMES, 5, FALSE);
+  Output output;
+  GstElement *pipeline;
+
+  pipeline = setup_pipeline (filename, &output);
+
+  /* the header of frame 5 wasn't read yet, so the calculated offset of
+   * frame 20 has to be rejected and the frame headers scanned */
+  clear_output (&output);
+  seek (pipeline, GST_SEEK_FLAG_FLUSH, frame_ts (20), GST_CLOCK_TIME_NONE);
+  gst_message_unref (run_until (pipeline, GST_MESSAGE_EOS));
+  check_frames (&output, 20, N_FRAMES);
+
+  /* and backwards, once the parameters are known */
+  clear_output (&output);
+  seek (pipeline, GST_SEEK_FLAG_FLUSH, frame_ts (10), GST_CLOCK_TIME_NONE);
+  gst_message_unref (run_until (pipeline, GST_MESSAGE_EOS));
+  check_frames (&output, 10, N_FRAMES);
+
+  teardown_pipeline (pipeline, &output, filename);
+}
+
+GST_END_TEST;
+
+/* Checks the timestamps and flags of frames that were converted to the
+ * default layout */
+static void
+check_padded_frames (Output * output, gint first, gint last)
+{
+  GstVideoInfo info;
+  GList *l;
+  gint frame = first;
+
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_I420, PADDED_WIDTH,
+      HEIGHT);
+
+  g_mutex_lock (&output->lock);
+  fail_unless_equals_int (g_list_length (output->buffers), last - first);
+
+  for (l = output->buffers; l; l = l->next, frame++) {
+    GstBuffer *buf = l->data;
+    guint8 value;
+
+    fail_unless_equals_int (gst_buffer_get_size (buf), info.size);
+    fail_unless_equals_int (gst_buffer_extract (buf, 0, &value, 1), 1);
+    fail_unless_equals_int (value, frame & 0xff);
+
+    fail_unless_equals_clocktime (GST_BUFFER_PTS (buf), frame_ts (frame));
+    fail_unless_equals_int (GST_BUFFER_IS_DISCONT (buf), frame == first);
+  }
+  g_mutex_unlock (&output->lock);
+}
+
+GST_START_TEST (test_y4mdec_stride_conversion)
+{
+  gchar *filename = write_y4m (PADDED_WIDTH, N_FRAMES, -1, FALSE);
+  Output output;
+  GstElement *pipeline;
+
+  pipeline = setup_pipeline (filename, &output);
+  gst_message_unref (run_until (pipeline, GST_MESSAGE_EOS));
+  check_padded_frames (&output, 0, N_FRAMES);
+
+  /* the converted frame keeps the discont flag after a seek */
+  clear_output (&output);
+  seek (pipeline, GST_SEEK_FLAG_FLUSH, frame_ts (20), GST_CLOCK_TIME_NONE);
+  gst_message_unref (run_until (pipeline, GST_MESSAGE_EOS));
+  check_padded_frames (&output, 20, N_FRAMES);
+
+  teardown_pipeline (pipeline, &output, filename);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_y4mdec_flush_seek)
+{
+  gchar *filename = write_y4m (WIDTH, N_FRAMES, -1, FALSE);
+  Output output;
+  GstElement *pipeline;
+
+  pipeline = setup_pipeline (filename, &output);
+
+  clear_output (&output);
+  seek (pipeline, GST_SEEK_FLAG_FLUSH, frame_ts (20), GST_CLOCK_TIME_NONE);
+
+  g_mutex_lock (&output.lock);
+  fail_unless (output.have_segment);
+  fail_unless_equals_clocktime (output.segment.start, frame_ts (20));
+  g_mutex_unlock (&output.lock);
+
+  gst_message_unref (run_until (pipeline, GST_MESSAGE_EOS));
+  check_frames (&output, 20, N_FRAMES);
+
+  teardown_pipeline (pipeline, &output, filename);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_y4mdec_key_unit_seek)
+{
+  gchar *filename = write_y4m (WIDTH, N_FRAMES, -1, FALSE);
+  Output output;
+  GstElement *pipeline;
+
+  pipeline = setup_pipeline (filename, &output);
+
+  /* in the middle of frame 10, which starts the segment because every
+   * frame is a keyframe */
+  clear_output (&output);
+  seek (pipeline, GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT,
+      (frame_ts (10) + frame_ts (11)) / 2, GST_CLOCK_TIME_NONE);
+
+  g_mutex_lock (&output.lock);
+  fail_unless (output.have_segment);
+  fail_unless_equals_clocktime (output.segment.start, frame_ts (10));
+  fail_unless_equals_clocktime (output.segment.time, frame_ts (10));
+  g_mutex_unlock (&output.lock);
+
+  gst_message_unref (run_until (pipeline, GST_MESSAGE_EOS));
+  check_frames (&output, 10, N_FRAMES);
+
+  teardown_pipeline (pipeline, &output, filename);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_y4mdec_seek_rounding)
+{
+  gchar *filename = write_y4m (WIDTH, N_FRAMES, -1, FALSE);
+  Output output;
+  GstElement *pipeline;
+  gint frame;
+
+  pipeline = setup_pipeline (filename, &output);
+
+  /* frame timestamps are rounded down, seeking to them must still land on
+   * the frame itself and not on the one before */
+  for (frame = 1; frame < N_FRAMES; frame++) {
+    GstBuffer *buf;
+    guint8 value;
+
+    clear_output (&output);
+    seek (pipeline, GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE,
+        frame_ts (frame), GST_CLOCK_TIME_NONE);
+
+    g_mutex_lock (&output.lock);
+    fail_unless (output.buffers != NULL);
+    buf = output.buffers->data;
+    fail_unless_equals_clocktime (GST_BUFFER_PTS (buf), frame_ts (frame));
+    fail_unless_equals_int (gst_buffer_extract (buf, 0, &value, 1), 1);
+    fail_unless_equals_int (value, frame);
+    g_mutex_unlock (&output.lock);
+  }
+
+  teardown_pipeline (pipeline, &output, filename);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_y4mdec_segment_seek)
+{
+  gchar *filename = write_y4m (WIDTH, N_FRAMES, -1, FALSE);
+  Output output;
+  GstElement *pipeline;
+  GstMessage *msg;
+  GstFormat format;
+  gint64 position;
+
+  pipeline = setup_pipeline (filename, &output);
+
+  clear_output (&output);
+  seek (pipeline, GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_SEGMENT, frame_ts (5),
+      frame_ts (10));
+
+  msg = run_until (pipeline, GST_MESSAGE_SEGMENT_DONE);
+  gst_message_parse_segment_done (msg, &format, &position);
+  fail_unless_equals_int (format, GST_FORMAT_TIME);
+  fail_unless_equals_clocktime (position, frame_ts (10));
+  gst_message_unref (msg);
+
+  check_frames (&output, 5, 10);
+
+  teardown_pipeline (pipeline, &output, filename);
+}
+
+GST_END_TEST;
+
+static Suite *
+y4mdec_suite (void)
+{
+  Suite *s = suite_create ("y4mdec");
+  TCase *tc = tcase_create ("general");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, test_y4mdec_play);
+  tcase_add_test (tc, test_y4mdec_frame_params_and_truncated);
+  tcase_add_test (tc, test_y4mdec_frame_params_seek);
+  tcase_add_test (tc, test_y4mdec_stride_conversion);
+  tcase_add_test (tc, test_y4mdec_flush_seek);
+  tcase_add_test (tc, test_y4mdec_key_unit_seek);
+  tcase_add_test (tc, test_y4mdec_seek_rounding);
+  tcase_add_test (tc, test_y4mdec_segment_seek);
+
+  return s;
+}
+
+GST_CHECK_MAIN (y4mdec);
@@ -245,6 +245,65 @@ GST_START_TEST (isoff_moof_parse_with_tfdt)
 
 GST_END_TEST;
 
+static GstMoofBox *
+parse_moof_with_default_samples (guint32 sample_count)
+{
+  /* INDENT-OFF */
+  guint8 data[] = {
+    0, 0, 0, 64, 'm', 'o', 'o', 'f',
+      0, 0, 0, 16, 'm', 'f', 'h', 'd',
+        0, 0, 0, 0,
+        0, 0, 0, 1,
+      0, 0, 0, 40, 't', 'r', 'a', 'f',
+        0, 0, 0, 16, 't', 'f', 'h', 'd',
+          0, 0, 0, 0,
+          0, 0, 0, 1,
+        0, 0, 0, 16, 't', 'r', 'u', 'n',
+          0, 0, 0, 0,
+          0, 0, 0, 0,
+  };
+  /* INDENT-ON */
+  GstByteReader reader = GST_BYTE_READER_INIT (data, sizeof (data));
+  guint32 type;
+  guint header_size;
+  guint64 size;
+
+  /* no per-sample fields, all samples use the tfhd defaults */
+  GST_WRITE_UINT32_BE (data + sizeof (data) - 4, sample_count);
+
+  fail_unless (gst_isoff_parse_box_header (&reader, &type, NULL,
+          &header_size, &size));
+  fail_unless (type == GST_ISOFF_FOURCC_MOOF);
+  fail_unless_equals_uint64 (size, sizeof (data));
+
+  return gst_isoff_moof_box_parse (&reader);
+}
+
+GST_START_TEST (isoff_moof_parse_trun_sample_count)
+{
+  GstMoofBox *moof;
+  GstTrafBox *traf;
+  GstTrunBox *trun;
+
+  moof = parse_moof_with_default_samples (16);
+  fail_unless (moof != NULL);
+
+  fail_unless_equals_int (moof->traf->len, 1);
+  traf = &g_array_index (moof->traf, GstTrafBox, 0);
+  fail_unless_equals_int (traf->trun->len, 1);
+  trun = &g_array_index (traf->trun, GstTrunBox, 0);
+  fail_unless_equals_int (trun->sample_count, 16);
+  fail_unless_equals_int (trun->samples->len, 16);
+
+  gst_isoff_moof_box_free (moof);
+
+  /* a bogus sample count must fail instead of allocating gigabytes */
+  moof = parse_moof_with_default_samples (G_MAXUINT32);
+  fail_unless (moof == NULL);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (isoff_moof_parse_with_tfxd_tfrf)
 {
   GstByteReader reader =
@@ -338,6 +397,122 @@ GST_START_TEST (isoff_moov_parse)
 
 GST_END_TEST;
 
+/* INDENT-OFF */
+static const guint8 sidx_box[] = {
+  0x00, 0x00, 0x00, 0x44, 's', 'i', 'd', 'x',
+  0x00, 0x00, 0x00, 0x00,       /* version, flags */
+  0x00, 0x00, 0x00, 0x01,       /* reference_ID */
+  0x00, 0x01, 0x5f, 0x90,       /* timescale: 90000 */
+  0x00, 0x00, 0x00, 0x00,       /* earliest_presentation_time */
+  0x00, 0x00, 0x00, 0x00,       /* first_offset */
+  0x00, 0x00, 0x00, 0x03,       /* reserved, reference_count */
+  0x00, 0x00, 0x03, 0xe8, 0x00, 0x01, 0x5f, 0x90, 0x90, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x07, 0xd0, 0x00, 0x01, 0x5f, 0x90, 0x90, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x0b, 0xb8, 0x00, 0x00, 0xaf, 0xc8, 0x90, 0x00, 0x00, 0x00,
+};
+/* INDENT-ON */
+
+static GstBuffer *
+buffer_new_fragmented (const guint8 * data, gsize size, gsize chunk_size)
+{
+  GstBuffer *buffer = gst_buffer_new ();
+  gsize offset;
+
+  for (offset = 0; offset < size; offset += chunk_size) {
+    gsize len = MIN (chunk_size, size - offset);
+
+    gst_buffer_append_memory (buffer,
+        gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+            (gpointer) (data + offset), len, 0, len, NULL, NULL));
+  }
+
+  return buffer;
+}
+
+static void
+check_sidx_entries (GstSidxParser * parser)
+{
+  GstSidxBox *sidx = &parser->sidx;
+
+  fail_unless_equals_int (sidx->ref_id, 1);
+  fail_unless_equals_int (sidx->timescale, 90000);
+  fail_unless_equals_int (sidx->entries_count, 3);
+
+  fail_unless_equals_int (sidx->entries[0].size, 1000);
+  fail_unless_equals_uint64 (sidx->entries[0].offset, 0);
+  fail_unless_equals_uint64 (sidx->entries[0].pts, 0);
+  fail_unless_equals_uint64 (sidx->entries[0].duration, GST_SECOND);
+  fail_unless (sidx->entries[0].starts_with_sap);
+  fail_unless_equals_int (sidx->entries[0].sap_type, 1);
+
+  fail_unless_equals_int (sidx->entries[1].size, 2000);
+  fail_unless_equals_uint64 (sidx->entries[1].offset, 1000);
+  fail_unless_equals_uint64 (sidx->entries[1].pts, GST_SECOND);
+
+  fail_unless_equals_int (sidx->entries[2].size, 3000);
+  fail_unless_equals_uint64 (sidx->entries[2].offset, 3000);
+  fail_unless_equals_uint64 (sidx->entries[2].pts, 2 * GST_SECOND);
+  fail_unless_equals_uint64 (sidx->entries[2].duration, GST_SECOND / 2);
+}
+
+GST_START_TEST (isoff_sidx_parse_fragmented_buffer)
+{
+  GstSidxParser parser;
+  GstBuffer *buffer;
+  guint consumed;
+  gsize chunk_size;
+
+  /* Every chunk size makes records straddle memory boundaries differently */
+  for (chunk_size = 1; chunk_size <= sizeof (sidx_box); chunk_size++) {
+    gst_isoff_sidx_parser_init (&parser);
+
+    buffer = buffer_new_fragmented (sidx_box, sizeof (sidx_box), chunk_size);
+    fail_unless_equals_int (gst_isoff_sidx_parser_add_buffer (&parser, buffer,
+            &consumed), GST_ISOFF_PARSER_DONE);
+    fail_unless_equals_int (consumed, sizeof (sidx_box));
+    fail_unless_equals_int (gst_buffer_n_memory (buffer),
+        (sizeof (sidx_box) + chunk_size - 1) / chunk_size);
+    gst_buffer_unref (buffer);
+
+    check_sidx_entries (&parser);
+    gst_isoff_sidx_parser_clear (&parser);
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (isoff_sidx_parse_incremental)
+{
+  GstSidxParser parser;
+  GstBuffer *buffer;
+  guint consumed;
+  gsize offset = 0, available = 0;
+  GstIsoffParserResult res = GST_ISOFF_PARSER_OK;
+
+  gst_isoff_sidx_parser_init (&parser);
+
+  /* Feed the box 7 bytes at a time, passing unconsumed bytes again */
+  while (res == GST_ISOFF_PARSER_OK) {
+    fail_unless (offset + available < sizeof (sidx_box));
+    available = MIN (available + 7, sizeof (sidx_box) - offset);
+
+    buffer = buffer_new_fragmented (sidx_box + offset, available, 5);
+    res = gst_isoff_sidx_parser_add_buffer (&parser, buffer, &consumed);
+    gst_buffer_unref (buffer);
+
+    fail_unless (consumed <= available);
+    offset += consumed;
+    available -= consumed;
+  }
+
+  fail_unless_equals_int (res, GST_ISOFF_PARSER_DONE);
+  fail_unless_equals_int (offset, sizeof (sidx_box));
+  check_sidx_entries (&parser);
+  gst_isoff_sidx_parser_clear (&parser);
+}
+
+GST_END_TEST;
+
 static Suite *
 dash_isoff_suite (void)
 {
@@ -345,6 +520,7 @@ dash_isoff_suite (void)
   TCase *tc_isoff_box = tcase_create ("isoff-box-parsing");
   TCase *tc_moof = tcase_create ("moof");
   TCase *tc_moov = tcase_create ("moov");
+  TCase *tc_sidx = tcase_create ("sidx");
 
   tcase_add_test (tc_isoff_box, isoff_box_header_minimal);
   tcase_add_test (tc_isoff_box, isoff_box_header_long_size);
@@ -356,11 +532,16 @@ dash_isoff_suite (void)
   tcase_add_test (tc_moof, isoff_moof_parse);
   tcase_add_test (tc_moof, isoff_moof_parse_with_tfdt);
   tcase_add_test (tc_moof, isoff_moof_parse_with_tfxd_tfrf);
+  tcase_add_test (tc_moof, isoff_moof_parse_trun_sample_count);
   suite_add_tcase (s, tc_moof);
 
   tcase_add_test (tc_moov, isoff_moov_parse);
   suite_add_tcase (s, tc_moov);
 
+  tcase_add_test (tc_sidx, isoff_sidx_parse_fragmented_buffer);
+  tcase_add_test (tc_sidx, isoff_sidx_parse_incremental);
+  suite_add_tcase (s, tc_sidx);
+
   return s;
 }
 